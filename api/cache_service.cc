@@ -209,7 +209,11 @@ void set_cache_service(http_context& ctx, routes& r) {
 
     cs::get_row_capacity.set(r, [&ctx] (std::unique_ptr<request> req) {
         return ctx.db.map_reduce0([](database& db) -> uint64_t {
-            return db.row_cache_tracker().region().occupancy().used_space();
+            uint64_t used = 0;
+            db.for_each_row_cache_tracker([&] (cache_tracker& tracker) {
+                used += tracker.region().occupancy().used_space();
+            });
+            return used;
         }, uint64_t(0), std::plus<uint64_t>()).then([](const int64_t& res) {
             return make_ready_future<json::json_return_type>(res);
         });
@@ -254,7 +258,11 @@ void set_cache_service(http_context& ctx, routes& r) {
         // In origin row size is the weighted size.
         // We currently do not support weights, so we use num entries instead
         return ctx.db.map_reduce0([](database& db) -> uint64_t {
-            return db.row_cache_tracker().partitions();
+            uint64_t partitions = 0;
+            db.for_each_row_cache_tracker([&] (cache_tracker& tracker) {
+                partitions += tracker.partitions();
+            });
+            return partitions;
         }, uint64_t(0), std::plus<uint64_t>()).then([](const int64_t& res) {
             return make_ready_future<json::json_return_type>(res);
         });
@@ -262,12 +270,40 @@ void set_cache_service(http_context& ctx, routes& r) {
 
     cs::get_row_entries.set(r, [&ctx] (std::unique_ptr<request> req) {
         return ctx.db.map_reduce0([](database& db) -> uint64_t {
-            return db.row_cache_tracker().partitions();
+            uint64_t partitions = 0;
+            db.for_each_row_cache_tracker([&] (cache_tracker& tracker) {
+                partitions += tracker.partitions();
+            });
+            return partitions;
         }, uint64_t(0), std::plus<uint64_t>()).then([](const int64_t& res) {
             return make_ready_future<json::json_return_type>(res);
         });
     });
 
+    cs::get_cf_row_hits.set(r, [&ctx] (std::unique_ptr<request> req) {
+        return map_reduce_cf(ctx, req->param["name"], uint64_t(0), [](const column_family& cf) {
+            return cf.get_row_cache().stats().hits.count();
+        }, std::plus<uint64_t>());
+    });
+
+    cs::get_cf_row_misses.set(r, [&ctx] (std::unique_ptr<request> req) {
+        return map_reduce_cf(ctx, req->param["name"], uint64_t(0), [](const column_family& cf) {
+            return cf.get_row_cache().stats().misses.count();
+        }, std::plus<uint64_t>());
+    });
+
+    cs::get_cf_row_evictions.set(r, [&ctx] (std::unique_ptr<request> req) {
+        return map_reduce_cf(ctx, req->param["name"], uint64_t(0), [](const column_family& cf) {
+            return cf.get_row_cache().partition_evictions();
+        }, std::plus<uint64_t>());
+    });
+
+    cs::get_cf_row_quota.set(r, [&ctx] (std::unique_ptr<request> req) {
+        return map_reduce_cf(ctx, req->param["name"], uint64_t(0), [](const column_family& cf) {
+            return uint64_t(cf.get_row_cache().get_cache_tracker().memory_quota());
+        }, std::plus<uint64_t>());
+    });
+
     cs::get_counter_capacity.set(r, [] (std::unique_ptr<request> req) {
         // TBD
         // FIXME
@@ -831,7 +831,7 @@ void cache_flat_mutation_reader::maybe_set_static_row_continuous() {
 
 inline
 bool cache_flat_mutation_reader::can_populate() const {
-    return _snp->at_latest_version() && _read_context.cache().phase_of(_read_context.key()) == _read_context.phase();
+    return _read_context.admitted() && _snp->at_latest_version() && _read_context.cache().phase_of(_read_context.key()) == _read_context.phase();
 }
 
 } // namespace cache
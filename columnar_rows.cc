@@ -0,0 +1,454 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "columnar_rows.hh"
+
+#include <algorithm>
+
+#include "schema.hh"
+#include "utils/fragment_range.hh"
+
+namespace {
+
+enum row_flags : uint8_t {
+    has_marker = 1,
+    expiring = 2,
+};
+
+// The write timestamp and TTL shared by all the cells and the marker of a row.
+struct row_liveness {
+    api::timestamp_type timestamp = api::missing_timestamp;
+    gc_clock::duration ttl{};
+    gc_clock::time_point expiry{};
+    bool marker = false;
+    bool expiring = false;
+};
+
+// Returns the liveness of row, or std::nullopt if the row can't be stored in columnar_rows.
+std::optional<row_liveness> liveness_of(const schema& s, const deletable_row& row) {
+    if (row.deleted_at()) {
+        return std::nullopt;
+    }
+    row_liveness l;
+    bool first = true;
+    auto merge = [&] (api::timestamp_type ts, bool expiring, gc_clock::duration ttl, gc_clock::time_point expiry) {
+        if (first) {
+            l.timestamp = ts;
+            l.expiring = expiring;
+            l.ttl = ttl;
+            l.expiry = expiry;
+            first = false;
+            return true;
+        }
+        return ts == l.timestamp && expiring == l.expiring && (!expiring || (ttl == l.ttl && expiry == l.expiry));
+    };
+    auto& marker = row.marker();
+    if (!marker.is_missing()) {
+        if (!marker.is_live()) {
+            return std::nullopt;
+        }
+        l.marker = true;
+        const bool expiring = marker.is_expiring();
+        merge(marker.timestamp(), expiring, expiring ? marker.ttl() : gc_clock::duration(), expiring ? marker.expiry() : gc_clock::time_point());
+    }
+    bool ok = true;
+    row.cells().for_each_cell([&] (column_id id, const atomic_cell_or_collection& c) {
+        auto& col = s.regular_column_at(id);
+        if (!ok || !col.is_atomic() || col.is_counter()) {
+            ok = false;
+            return;
+        }
+        auto cell = c.as_atomic_cell(col);
+        if (!cell.is_live()) {
+            ok = false;
+            return;
+        }
+        const bool expiring = cell.is_live_and_has_ttl();
+        ok = merge(cell.timestamp(), expiring, expiring ? cell.ttl() : gc_clock::duration(), expiring ? cell.expiry() : gc_clock::time_point());
+    });
+    if (!ok || first) {
+        return std::nullopt;
+    }
+    return l;
+}
+
+void append(managed_vector<char>& out, const char* data, size_t size) {
+    const auto old_size = out.size();
+    if (old_size + size > out.capacity()) {
+        out.reserve(std::max<size_t>(out.capacity() * 2, old_size + size));
+    }
+    out.resize(old_size + size);
+    std::copy_n(data, size, out.data() + old_size);
+}
+
+void append_varint(managed_vector<char>& out, uint64_t v) {
+    char buf[10];
+    size_t n = 0;
+    do {
+        const uint8_t b = v & 0x7f;
+        v >>= 7;
+        buf[n++] = char(b | (v ? 0x80 : 0));
+    } while (v);
+    append(out, buf, n);
+}
+
+void append_signed_varint(managed_vector<char>& out, int64_t v) {
+    append_varint(out, (uint64_t(v) << 1) ^ uint64_t(v >> 63));
+}
+
+void append_view(managed_vector<char>& out, managed_bytes_view v) {
+    while (v.size_bytes()) {
+        auto frag = v.current_fragment();
+        append(out, reinterpret_cast<const char*>(frag.data()), frag.size());
+        v.remove_current();
+    }
+}
+
+uint64_t read_varint(const char*& p) {
+    uint64_t v = 0;
+    unsigned shift = 0;
+    uint8_t b;
+    do {
+        b = *p++;
+        v |= uint64_t(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return v;
+}
+
+int64_t read_signed_varint(const char*& p) {
+    const auto v = read_varint(p);
+    return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
+} // anonymous namespace
+
+columnar_rows::chunk::chunk(size_t columns) {
+    cells.resize(columns);
+}
+
+size_t columnar_rows::chunk::memory_usage() const noexcept {
+    size_t size = keys.capacity() + liveness.capacity() + cells.capacity() * sizeof(managed_vector<char>);
+    for (auto& c : cells) {
+        size += c.capacity();
+    }
+    return size;
+}
+
+bool columnar_rows::can_append(const schema& s, const mutation_partition& mp) const {
+    if (mp.partition_tombstone() || !mp.static_row().empty() || !mp.row_tombstones().empty() || mp.clustered_rows().empty()) {
+        return false;
+    }
+    if (_last_key) {
+        auto& first = *mp.clustered_rows().begin();
+        if (first.dummy() || clustering_key_prefix::tri_compare(s)(*_last_key, first.key()) >= 0) {
+            return false;
+        }
+    }
+    return std::all_of(mp.clustered_rows().begin(), mp.clustered_rows().end(), [&] (const rows_entry& e) {
+        return !e.dummy() && e.key().size(s) == s.clustering_key_size() && liveness_of(s, e.row());
+    });
+}
+
+void columnar_rows::append(const schema& s, const mutation_partition& mp) {
+    const auto columns = s.regular_columns_count();
+
+    // Remember where every stream of the last chunk ends, to restore them on failure.
+    const auto old_chunks = _chunks.size();
+    const uint32_t old_rows = _chunks.empty() ? 0 : _chunks.back().rows;
+    std::vector<size_t> old_sizes;
+    if (!_chunks.empty()) {
+        auto& c = _chunks.back();
+        old_sizes.reserve(columns + 2);
+        old_sizes.push_back(c.keys.size());
+        old_sizes.push_back(c.liveness.size());
+        for (auto& col : c.cells) {
+            old_sizes.push_back(col.size());
+        }
+    }
+    const auto old_last_timestamp = _chunks.empty() ? 0 : _chunks.back().last_timestamp;
+    const auto old_last_expiry = _chunks.empty() ? 0 : _chunks.back().last_expiry;
+
+    try {
+        // The key each key is stored relative to, i.e. the previous key of its chunk.
+        std::optional<clustering_key_prefix> last_key;
+        if (!_chunks.empty() && _chunks.back().rows < max_chunk_rows) {
+            last_key = _last_key;
+        }
+        size_t rows = 0;
+        for (const rows_entry& e : mp.clustered_rows()) {
+            if (_chunks.empty() || _chunks.back().rows == max_chunk_rows) {
+                _chunks.emplace_back(columns);
+                last_key = std::nullopt;
+            }
+            auto& c = _chunks.back();
+            const auto l = *liveness_of(s, e.row());
+
+            // Keys are compared and stored in their serialized form, which for
+            // keys of increasing integers or timestamps shares a long prefix.
+            auto key = e.key().representation();
+            size_t shared = 0;
+            if (last_key) {
+                auto prev = linearized(last_key->representation());
+                with_linearized(key, [&] (bytes_view k) {
+                    auto mismatch = std::mismatch(prev.begin(), prev.end(), k.begin(), k.end());
+                    shared = mismatch.first - prev.begin();
+                });
+            }
+            append_varint(c.keys, shared);
+            append_varint(c.keys, key.size_bytes() - shared);
+            auto suffix = key;
+            suffix.remove_prefix(shared);
+            append_view(c.keys, suffix);
+
+            append_signed_varint(c.liveness, l.timestamp - c.last_timestamp);
+            c.last_timestamp = l.timestamp;
+            const uint8_t flags = (l.marker ? has_marker : 0) | (l.expiring ? expiring : 0);
+            append(c.liveness, reinterpret_cast<const char*>(&flags), 1);
+            if (l.expiring) {
+                append_varint(c.liveness, l.ttl.count());
+                const int64_t expiry = l.expiry.time_since_epoch().count();
+                append_signed_varint(c.liveness, expiry - c.last_expiry);
+                c.last_expiry = expiry;
+            }
+
+            for (column_id id = 0; id < columns; ++id) {
+                auto cell = e.row().cells().find_cell(id);
+                if (!cell) {
+                    append_varint(c.cells[id], 0);
+                    continue;
+                }
+                auto value = cell->as_atomic_cell(s.regular_column_at(id)).value();
+                append_varint(c.cells[id], value.size_bytes() + 1);
+                append_view(c.cells[id], value);
+            }
+
+            ++c.rows;
+            ++rows;
+            last_key = e.key();
+        }
+        _last_key = std::move(last_key);
+        _rows += rows;
+    } catch (...) {
+        while (_chunks.size() > old_chunks) {
+            _chunks.pop_back();
+        }
+        if (!_chunks.empty()) {
+            auto& c = _chunks.back();
+            c.rows = old_rows;
+            c.keys.resize(old_sizes[0]);
+            c.liveness.resize(old_sizes[1]);
+            for (size_t i = 0; i < c.cells.size(); ++i) {
+                c.cells[i].resize(old_sizes[i + 2]);
+            }
+            c.last_timestamp = old_last_timestamp;
+            c.last_expiry = old_last_expiry;
+        }
+        throw;
+    }
+}
+
+namespace {
+
+// Calls func for each row of chunk c, which is a columnar_rows::chunk or a copy of it.
+template <typename Chunk, typename Func>
+stop_iteration for_each_row_in_chunk(const schema& s, const Chunk& c, Func&& func) {
+    const auto columns = s.regular_columns_count();
+    std::vector<const char*> cell_pos(columns);
+    bytes key;
+    const char* key_pos = c.keys.data();
+    const char* liveness_pos = c.liveness.data();
+    for (column_id id = 0; id < columns; ++id) {
+        cell_pos[id] = c.cells[id].data();
+    }
+    api::timestamp_type timestamp = 0;
+    int64_t expiry = 0;
+    for (uint32_t i = 0; i < c.rows; ++i) {
+        const auto shared = read_varint(key_pos);
+        const auto suffix = read_varint(key_pos);
+        key.resize(shared + suffix);
+        std::copy_n(reinterpret_cast<const bytes::value_type*>(key_pos), suffix, key.begin() + shared);
+        key_pos += suffix;
+
+        timestamp += read_signed_varint(liveness_pos);
+        const uint8_t flags = *liveness_pos++;
+        row_liveness l{timestamp};
+        l.marker = flags & has_marker;
+        l.expiring = flags & expiring;
+        if (l.expiring) {
+            l.ttl = gc_clock::duration(read_varint(liveness_pos));
+            expiry += read_signed_varint(liveness_pos);
+            l.expiry = gc_clock::time_point(gc_clock::duration(expiry));
+        }
+
+        // Called with the key and a function which builds the row, so that
+        // rows which are not needed are skipped without decoding their cells.
+        auto build = [&] {
+            clustering_row cr(clustering_key_prefix::from_bytes(bytes_view(key)));
+            if (l.marker) {
+                cr.marker() = l.expiring ? row_marker(l.timestamp, l.ttl, l.expiry) : row_marker(l.timestamp);
+            }
+            for (column_id id = 0; id < columns; ++id) {
+                const auto len = read_varint(cell_pos[id]);
+                if (!len) {
+                    continue;
+                }
+                auto& col = s.regular_column_at(id);
+                auto value = bytes_view(reinterpret_cast<const bytes::value_type*>(cell_pos[id]), len - 1);
+                cr.cells().append_cell(id, l.expiring
+                        ? atomic_cell::make_live(*col.type, l.timestamp, value, l.expiry, l.ttl)
+                        : atomic_cell::make_live(*col.type, l.timestamp, value));
+                cell_pos[id] += len - 1;
+            }
+            return cr;
+        };
+        auto skip = [&] {
+            for (column_id id = 0; id < columns; ++id) {
+                const auto len = read_varint(cell_pos[id]);
+                cell_pos[id] += len ? len - 1 : 0;
+            }
+        };
+        if (func(bytes_view(key), build, skip) == stop_iteration::yes) {
+            return stop_iteration::yes;
+        }
+    }
+    return stop_iteration::no;
+}
+
+// The first key of a chunk doesn't share a prefix with any other key.
+template <typename Chunk>
+bytes_view first_key(const Chunk& c) {
+    const char* p = c.keys.data();
+    read_varint(p);
+    const auto size = read_varint(p);
+    return bytes_view(reinterpret_cast<const bytes::value_type*>(p), size);
+}
+
+std::vector<char> copy_stream(const managed_vector<char>& v) {
+    return std::vector<char>(v.data(), v.data() + v.size());
+}
+
+} // anonymous namespace
+
+template <typename Func>
+void columnar_rows::for_each_row(const schema& s, Func&& func) const {
+    for (auto& c : _chunks) {
+        if (for_each_row_in_chunk(s, c, func) == stop_iteration::yes) {
+            return;
+        }
+    }
+}
+
+columnar_rows_cursor columnar_rows::read(schema_ptr s, const query::clustering_row_ranges& ranges, bool reversed) const {
+    columnar_rows_cursor cursor;
+    auto cmp = clustering_key_prefix::prefix_equal_tri_compare(*s);
+    for (size_t i = 0; i < _chunks.size(); ++i) {
+        auto& c = _chunks[i];
+        // Keys of the chunk are not smaller than its first key, and are smaller than the first key of the next chunk.
+        auto first = clustering_key_prefix::from_bytes(first_key(c));
+        if (std::all_of(ranges.begin(), ranges.end(), [&] (auto& r) { return r.after(first, cmp); })) {
+            break;
+        }
+        if (i + 1 < _chunks.size()) {
+            auto next = clustering_key_prefix::from_bytes(first_key(_chunks[i + 1]));
+            if (std::all_of(ranges.begin(), ranges.end(), [&] (auto& r) { return r.before(next, cmp); })) {
+                continue;
+            }
+        }
+        columnar_rows_cursor::chunk copy;
+        copy.rows = c.rows;
+        copy.keys = copy_stream(c.keys);
+        copy.liveness = copy_stream(c.liveness);
+        copy.cells.reserve(c.cells.size());
+        size_t size = sizeof(copy) + copy.keys.size() + copy.liveness.size() + c.cells.size() * sizeof(std::vector<char>);
+        for (auto& col : c.cells) {
+            copy.cells.push_back(copy_stream(col));
+            size += col.size();
+        }
+        if (reversed) {
+            cursor._chunks.push_front(std::move(copy));
+        } else {
+            cursor._chunks.push_back(std::move(copy));
+        }
+        cursor._memory_usage += size;
+    }
+    if (!cursor._chunks.empty()) {
+        cursor._schema = std::move(s);
+        cursor._ranges = ranges;
+        cursor._reversed = reversed;
+    }
+    return cursor;
+}
+
+std::deque<clustering_row> columnar_rows_cursor::next_chunk() {
+    auto c = std::move(_chunks.front());
+    _chunks.pop_front();
+    _memory_usage -= sizeof(c) + c.keys.size() + c.liveness.size() + c.cells.size() * sizeof(std::vector<char>);
+    for (auto& col : c.cells) {
+        _memory_usage -= col.size();
+    }
+
+    std::deque<clustering_row> rows;
+    auto cmp = clustering_key_prefix::prefix_equal_tri_compare(*_schema);
+    for_each_row_in_chunk(*_schema, c, [&] (bytes_view key_bytes, auto&& build, auto&& skip) {
+        auto key = clustering_key_prefix::from_bytes(key_bytes);
+        // Rows are in clustering order, so once all ranges end before the key, no other row is needed.
+        bool after_all = true;
+        bool contained = false;
+        for (auto& r : _ranges) {
+            contained |= r.contains(key, cmp);
+            after_all &= r.after(key, cmp);
+        }
+        if (after_all) {
+            return stop_iteration::yes;
+        }
+        if (contained) {
+            if (_reversed) {
+                rows.push_front(build());
+            } else {
+                rows.push_back(build());
+            }
+        } else {
+            skip();
+        }
+        return stop_iteration::no;
+    });
+    return rows;
+}
+
+void columnar_rows::apply_to(const schema& s, mutation_partition& mp) const {
+    for_each_row(s, [&] (bytes_view, auto&& build, auto&&) {
+        auto cr = build();
+        mp.clustered_row(s, std::move(cr.key())).apply(s, std::move(cr).as_deletable_row());
+        return stop_iteration::no;
+    });
+}
+
+size_t columnar_rows::external_memory_usage() const noexcept {
+    size_t size = _chunks.capacity() * sizeof(chunk);
+    for (auto& c : _chunks) {
+        size += c.memory_usage();
+    }
+    if (_last_key) {
+        size += _last_key->external_memory_usage();
+    }
+    return size;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "mutation_fragment.hh"
+#include "mutation_partition.hh"
+#include "query-request.hh"
+#include "schema_fwd.hh"
+#include "utils/managed_vector.hh"
+
+// The rows of a columnar_rows within some clustering ranges, copied in their
+// encoded form, so that they can be read after the columnar_rows is changed or
+// destroyed. The rows are decoded one chunk at a time, as they are read.
+class columnar_rows_cursor {
+    friend class columnar_rows;
+    struct chunk {
+        uint32_t rows = 0;
+        std::vector<char> keys;
+        std::vector<char> liveness;
+        std::vector<std::vector<char>> cells;
+    };
+    schema_ptr _schema;
+    query::clustering_row_ranges _ranges;
+    bool _reversed = false;
+    // In the order of the read.
+    std::deque<chunk> _chunks;
+    size_t _memory_usage = 0;
+public:
+    columnar_rows_cursor() = default;
+
+    bool empty() const noexcept { return _chunks.empty(); }
+
+    // Memory taken by the encoded rows which are left.
+    size_t memory_usage() const noexcept { return _memory_usage; }
+
+    // Decodes the rows of the next chunk which are within the ranges, and drops the chunk.
+    // The rows are in clustering order, or in reverse clustering order for a reversed
+    // cursor. They may be none even if other chunks follow. Must not be called when empty().
+    std::deque<clustering_row> next_chunk();
+};
+
+// Rows of a memtable partition stored column by column, for tables whose rows are
+// written once, in clustering order, such as time-series tables.
+//
+// Rows are grouped in chunks of up to max_chunk_rows rows. Within a chunk, each
+// clustering key is stored as the suffix which differs from the previous key,
+// write timestamps and expiry times as differences from the previous row, and
+// the values of each regular column in a separate stream. This takes a fraction
+// of the memory of the same rows in a mutation_partition, which needs a tree node
+// per row and a separately allocated object per cell.
+//
+// Only rows which are inserted after all rows already stored, and whose cells
+// all share the write timestamp and the TTL of the row, can be appended (see
+// can_append()). Rows are converted to clustering_rows only when read.
+//
+// The rows are encoded for a particular schema version. They have to be applied
+// to a mutation_partition with apply_to() before the owner is upgraded to
+// another schema.
+//
+// The object may be allocated in LSA. All methods must then be called with
+// the region's allocator as the current allocator, except read(), which
+// only allocates the returned cursor, in the current allocator.
+class columnar_rows {
+public:
+    static constexpr size_t max_chunk_rows = 128;
+private:
+    struct chunk {
+        uint32_t rows = 0;
+        // Per row: the length of the prefix shared with the previous key of the
+        // chunk and the rest of the key.
+        managed_vector<char> keys;
+        // Per row: the difference of the write timestamp from the previous row,
+        // flags, and for expiring rows the TTL and the difference of the expiry
+        // time from the previous expiring row.
+        managed_vector<char> liveness;
+        // One stream per regular column. Per row: 0 for no value, or the length
+        // of the value plus 1, followed by the value.
+        managed_vector<managed_vector<char>> cells;
+        api::timestamp_type last_timestamp = 0;
+        int64_t last_expiry = 0;
+
+        explicit chunk(size_t columns);
+        chunk(chunk&&) noexcept = default;
+        size_t memory_usage() const noexcept;
+    };
+
+    managed_vector<chunk> _chunks;
+    // Key of the last row, which the next row has to follow.
+    std::optional<clustering_key_prefix> _last_key;
+    size_t _rows = 0;
+private:
+    template <typename Func>
+    void for_each_row(const schema& s, Func&& func) const;
+public:
+    columnar_rows() = default;
+    columnar_rows(columnar_rows&&) noexcept = default;
+
+    bool empty() const noexcept { return !_rows; }
+    size_t size() const noexcept { return _rows; }
+
+    // Returns true if all of mp can be appended, that is if it has rows only,
+    // which follow the rows already stored, and which have a live marker or cells,
+    // all of them atomic, live and written with the same timestamp and TTL.
+    bool can_append(const schema& s, const mutation_partition& mp) const;
+
+    // Appends the rows of mp, for which can_append() has to be true.
+    // Provides the strong exception guarantee.
+    void append(const schema& s, const mutation_partition& mp);
+
+    // Returns a cursor over the rows within ranges, in clustering order, or in
+    // reverse clustering order if reversed is set.
+    columnar_rows_cursor read(schema_ptr s, const query::clustering_row_ranges& ranges, bool reversed) const;
+
+    // Applies all rows to mp.
+    void apply_to(const schema& s, mutation_partition& mp) const;
+
+    // Memory taken by the rows, not including the object itself.
+    size_t external_memory_usage() const noexcept;
+};
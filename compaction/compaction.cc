@@ -94,6 +94,7 @@ static const std::unordered_map<compaction_type, sstring> compaction_types = {
     { compaction_type::Reshard, "RESHARD" },
     { compaction_type::Upgrade, "UPGRADE" },
     { compaction_type::Reshape, "RESHAPE" },
+    { compaction_type::Purge, "PURGE" },
 };
 
 sstring compaction_name(compaction_type type) {
@@ -123,6 +124,7 @@ static std::string_view to_string(compaction_type type) {
     case compaction_type::Reshard: return "Reshard";
     case compaction_type::Upgrade: return "Upgrade";
     case compaction_type::Reshape: return "Reshape";
+    case compaction_type::Purge: return "Purge";
     }
     on_internal_error_noexcept(clogger, format("Invalid compaction type {}", int(type)));
     return "(invalid)";
@@ -467,6 +469,8 @@ class compaction {
     sstables::compaction_type _type;
     uint64_t _max_sstable_size;
     uint32_t _sstable_level;
+    // The output is repaired only if all of the input is, as of the oldest repair.
+    uint64_t _repaired_at = 0;
     uint64_t _start_size = 0;
     uint64_t _end_size = 0;
     uint64_t _estimated_partitions = 0;
@@ -477,10 +481,16 @@ class compaction {
     compaction_sstable_replacer_fn _replacer;
     utils::UUID _run_identifier;
     ::io_priority_class _io_priority;
+    unsigned _parallelism;
+    // Token sub-ranges of the input which are compacted concurrently. Readers keep a
+    // reference to their range, so they're stored here for the compaction's lifetime.
+    dht::partition_range_vector _sub_ranges;
     // optional clone of sstable set to be used for expiration purposes, so it will be set if expiration is enabled.
     std::optional<sstable_set> _sstable_set;
     // used to incrementally calculate max purgeable timestamp, as we iterate through decorated keys.
-    std::optional<sstable_set::incremental_selector> _selector;
+    // select() must be called in token order, so each sub-range, which is compacted concurrently
+    // with the others, has a selector of its own.
+    std::vector<sstable_set::incremental_selector> _selectors;
     std::unordered_set<shared_sstable> _compacting_for_max_purgeable_func;
     // Garbage collected sstables that are sealed but were not added to SSTable set yet.
     std::vector<shared_sstable> _unused_garbage_collected_sstables;
@@ -506,13 +516,18 @@ class compaction {
         , _replacer(std::move(descriptor.replacer))
         , _run_identifier(descriptor.run_identifier)
         , _io_priority(descriptor.io_priority)
+        , _parallelism(descriptor.parallelism)
         , _sstable_set(std::move(descriptor.all_sstables_snapshot))
-        , _selector(_sstable_set ? _sstable_set->make_incremental_selector() : std::optional<sstable_set::incremental_selector>{})
         , _compacting_for_max_purgeable_func(std::unordered_set<shared_sstable>(_sstables.begin(), _sstables.end()))
     {
         for (auto& sst : _sstables) {
             _stats_collector.update(sst->get_encoding_stats_for_compaction());
         }
+        if (!_sstables.empty() && std::all_of(_sstables.begin(), _sstables.end(), std::mem_fn(&sstable::is_repaired))) {
+            _repaired_at = (*std::min_element(_sstables.begin(), _sstables.end(), [] (const shared_sstable& a, const shared_sstable& b) {
+                return a->get_repaired_at() < b->get_repaired_at();
+            }))->get_repaired_at();
+        }
         std::unordered_set<utils::UUID> ssts_run_ids;
         _contains_multi_fragment_runs = std::any_of(_sstables.begin(), _sstables.end(), [&ssts_run_ids] (shared_sstable& sst) {
             return !ssts_run_ids.insert(sst->run_identifier()).second;
@@ -523,6 +538,8 @@ class compaction {
         // some tests use _max_sstable_size == 0 for force many one partition per sstable
         auto max_sstable_size = std::max<uint64_t>(_max_sstable_size, 1);
         uint64_t estimated_sstables = std::max(1UL, uint64_t(ceil(double(_start_size) / max_sstable_size)));
+        // Each sub-range is written to sstables of its own.
+        estimated_sstables = std::max(estimated_sstables, uint64_t(_sub_ranges.size()));
         return std::min(uint64_t(ceil(double(_estimated_partitions) / estimated_sstables)),
                         _table_s.get_compaction_strategy().adjust_partition_estimate(_ms_metadata, _estimated_partitions));
     }
@@ -554,6 +571,7 @@ class compaction {
         cfg.run_identifier = _run_identifier;
         cfg.replay_position = _rp;
         cfg.sstable_level = _sstable_level;
+        cfg.repaired_at = _repaired_at;
         return cfg;
     }
 
@@ -634,7 +652,31 @@ class compaction {
     }
 private:
     // Default range sstable reader that will only return mutation that belongs to current shard.
-    virtual flat_mutation_reader_v2 make_sstable_reader() const = 0;
+    virtual flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range) const = 0;
+
+    // Whether the input can be split into sub-ranges compacted concurrently. That's only
+    // possible if nothing depends on the output being written in token order.
+    virtual bool can_split_into_sub_ranges() const {
+        return false;
+    }
+
+    // Splits the token span of the input into up to _parallelism sub-ranges of equal
+    // token width. As tokens are hashes, the data is spread about evenly among them.
+    // All sub-ranges write to the same run identifier, and since they don't overlap,
+    // their output sstables form a single run, as if written by a single stream.
+    dht::partition_range_vector make_sub_ranges() const {
+        auto ssts = _compacting->all();
+        if (_parallelism <= 1 || !can_split_into_sub_ranges() || ssts->empty()) {
+            return { query::full_partition_range };
+        }
+        auto first = std::numeric_limits<int64_t>::max();
+        auto last = std::numeric_limits<int64_t>::min();
+        for (auto& sst : *ssts) {
+            first = std::min(first, dht::token::to_int64(sst->get_first_decorated_key().token()));
+            last = std::max(last, dht::token::to_int64(sst->get_last_decorated_key().token()));
+        }
+        return dht::split_range_to_equal_token_spans(dht::token::from_int64(first), dht::token::from_int64(last), _parallelism);
+    }
 
     virtual sstables::sstable_set make_sstable_set_for_input() const {
         return _table_s.get_compaction_strategy().make_sstable_set(_schema);
@@ -694,7 +736,7 @@ class compaction {
     // This consumer will perform mutation compaction on producer side using
     // compacting_reader. It's useful for allowing data from different buckets
     // to be compacted together.
-    future<> consume_without_gc_writer(gc_clock::time_point compaction_time) {
+    future<> consume_without_gc_writer(size_t sub_range, gc_clock::time_point compaction_time) {
         auto consumer = make_interposer_consumer([this] (flat_mutation_reader reader) mutable {
             return seastar::async([this, reader = std::move(reader)] () mutable {
                 auto close_reader = deferred_close(reader);
@@ -702,26 +744,39 @@ class compaction {
                 reader.consume_in_thread(std::move(cfc));
             });
         });
-        return consumer(make_compacting_reader(downgrade_to_v1(make_sstable_reader()), compaction_time, max_purgeable_func()));
+        return consumer(make_compacting_reader(downgrade_to_v1(make_sstable_reader(_sub_ranges[sub_range])), compaction_time,
+                max_purgeable_func(sub_range)));
     }
 
     future<> consume() {
         auto now = gc_clock::now();
+        _sub_ranges = make_sub_ranges();
+        reset_selectors();
+        if (_sub_ranges.size() == 1) {
+            return consume(0, now);
+        }
+        log_debug("Compacting {} token sub-ranges concurrently", _sub_ranges.size());
+        return parallel_for_each(boost::irange(size_t(0), _sub_ranges.size()), [this, now] (size_t sub_range) {
+            return consume(sub_range, now);
+        });
+    }
+
+    future<> consume(size_t sub_range, gc_clock::time_point now) {
         // consume_without_gc_writer(), which uses compacting_reader, is ~3% slower.
         // let's only use it when GC writer is disabled and interposer consumer is enabled, as we
         // wouldn't like others to pay the penalty for something they don't need.
         if (!enable_garbage_collected_sstable_writer() && use_interposer_consumer()) {
-            return consume_without_gc_writer(now);
+            return consume_without_gc_writer(sub_range, now);
         }
-        auto consumer = make_interposer_consumer([this, now] (flat_mutation_reader reader) mutable
+        auto consumer = make_interposer_consumer([this, now, sub_range] (flat_mutation_reader reader) mutable
         {
-            return seastar::async([this, reader = std::move(reader), now] () mutable {
+            return seastar::async([this, reader = std::move(reader), now, sub_range] () mutable {
                 auto close_reader = deferred_close(reader);
 
                 if (enable_garbage_collected_sstable_writer()) {
                     using compact_mutations = compact_for_compaction<compacted_fragments_writer, compacted_fragments_writer>;
                     auto cfc = make_stable_flattened_mutations_consumer<compact_mutations>(*schema(), now,
-                        max_purgeable_func(),
+                        max_purgeable_func(sub_range),
                         get_compacted_fragments_writer(),
                         get_gc_compacted_fragments_writer());
 
@@ -730,14 +785,14 @@ class compaction {
                 }
                 using compact_mutations = compact_for_compaction<compacted_fragments_writer, noop_compacted_fragments_consumer>;
                 auto cfc = make_stable_flattened_mutations_consumer<compact_mutations>(*schema(), now,
-                    max_purgeable_func(),
+                    max_purgeable_func(sub_range),
                     get_compacted_fragments_writer(),
                     noop_compacted_fragments_consumer());
 
                 reader.consume_in_thread(std::move(cfc));
             });
         });
-        return consumer(downgrade_to_v1(make_sstable_reader()));
+        return consumer(downgrade_to_v1(make_sstable_reader(_sub_ranges[sub_range])));
     }
 
     virtual reader_consumer make_interposer_consumer(reader_consumer end_consumer) {
@@ -780,17 +835,29 @@ class compaction {
     virtual std::string_view report_start_desc() const = 0;
     virtual std::string_view report_finish_desc() const = 0;
 
-    std::function<api::timestamp_type(const dht::decorated_key&)> max_purgeable_func() {
+    std::function<api::timestamp_type(const dht::decorated_key&)> max_purgeable_func(size_t sub_range) {
         if (!tombstone_expiration_enabled()) {
             return [] (const dht::decorated_key& dk) {
                 return api::min_timestamp;
             };
         }
-        return [this] (const dht::decorated_key& dk) {
-            return get_max_purgeable_timestamp(_table_s, *_selector, _compacting_for_max_purgeable_func, dk);
+        // _selectors may be rebuilt while compacting, so look the selector up on each call.
+        return [this, sub_range] (const dht::decorated_key& dk) {
+            return get_max_purgeable_timestamp(_table_s, _selectors[sub_range], _compacting_for_max_purgeable_func, dk);
         };
     }
 
+    void reset_selectors() {
+        _selectors.clear();
+        if (!_sstable_set) {
+            return;
+        }
+        _selectors.reserve(_sub_ranges.size());
+        for (size_t i = 0; i < _sub_ranges.size(); ++i) {
+            _selectors.emplace_back(_sstable_set->make_incremental_selector());
+        }
+    }
+
     virtual void on_new_partition() {}
 
     virtual void on_end_of_compaction() {};
@@ -919,10 +986,10 @@ class reshape_compaction : public compaction {
         return sstables::make_partitioned_sstable_set(_schema, make_lw_shared<sstable_list>(sstable_list{}), false);
     }
 
-    flat_mutation_reader_v2 make_sstable_reader() const override {
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range) const override {
         return _compacting->make_local_shard_sstable_reader(_schema,
                 _permit,
-                query::full_partition_range,
+                range,
                 _schema->full_slice(),
                 _io_priority,
                 tracing::trace_state_ptr(),
@@ -931,6 +998,10 @@ class reshape_compaction : public compaction {
                 default_read_monitor_generator());
     }
 
+    bool can_split_into_sub_ranges() const override {
+        return true;
+    }
+
     std::string_view report_start_desc() const override {
         return "Reshaping";
     }
@@ -965,10 +1036,10 @@ class regular_compaction : public compaction {
     {
     }
 
-    flat_mutation_reader_v2 make_sstable_reader() const override {
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range) const override {
         return _compacting->make_local_shard_sstable_reader(_schema,
                 _permit,
-                query::full_partition_range,
+                range,
                 _schema->full_slice(),
                 _io_priority,
                 tracing::trace_state_ptr(),
@@ -977,6 +1048,11 @@ class regular_compaction : public compaction {
                 _monitor_generator);
     }
 
+    // Early replacement of exhausted sstables relies on the output being written in token order.
+    bool can_split_into_sub_ranges() const override {
+        return !enable_garbage_collected_sstable_writer();
+    }
+
     std::string_view report_start_desc() const override {
         return "Compacting";
     }
@@ -1081,11 +1157,33 @@ class regular_compaction : public compaction {
                 _sstable_set->insert(sst);
             }
         }
-        _selector.emplace(_sstable_set->make_incremental_selector());
+        reset_selectors();
         _cdata.pending_replacements.clear();
     }
 };
 
+// Rewrites a single sstable to drop its purgeable tombstones, keeping its level and
+// run identifier so that the structure maintained by the compaction strategy is left
+// untouched. Partitions without purgeable tombstones are written back unchanged.
+class purge_compaction final : public regular_compaction {
+public:
+    purge_compaction(table_state& table_s, compaction_descriptor descriptor, compaction_data& cdata)
+        : regular_compaction(table_s, std::move(descriptor), cdata)
+    {
+        if (!tombstone_expiration_enabled()) {
+            on_internal_error(clogger, "purge compaction requires a snapshot of the sstable set");
+        }
+    }
+
+    std::string_view report_start_desc() const override {
+        return "Purging tombstones of";
+    }
+
+    std::string_view report_finish_desc() const override {
+        return "Purged tombstones of";
+    }
+};
+
 class cleanup_compaction final : public regular_compaction {
     class incremental_owned_ranges_checker {
         const dht::token_range_vector& _sorted_owned_ranges;
@@ -1160,8 +1258,13 @@ class cleanup_compaction final : public regular_compaction {
     cleanup_compaction(table_state& table_s, compaction_descriptor descriptor, compaction_data& cdata, compaction_type_options::upgrade opts)
         : cleanup_compaction(table_s, std::move(descriptor), cdata, opts.owned_ranges) {}
 
-    flat_mutation_reader_v2 make_sstable_reader() const override {
-        return make_filtering_reader(regular_compaction::make_sstable_reader(), make_partition_filter());
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range) const override {
+        return make_filtering_reader(regular_compaction::make_sstable_reader(range), make_partition_filter());
+    }
+
+    // The owned ranges checker expects partitions in token order.
+    bool can_split_into_sub_ranges() const override {
+        return false;
     }
 
     std::string_view report_start_desc() const override {
@@ -1451,11 +1554,17 @@ class scrub_compaction final : public regular_compaction {
         return _scrub_finish_description;
     }
 
-    flat_mutation_reader_v2 make_sstable_reader() const override {
+    // Scrub is never split into sub-ranges: the crawling reader reads the whole input
+    // in on-disk order, whatever the range, so that out-of-order data is found too.
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range&) const override {
         auto crawling_reader = downgrade_to_v1(_compacting->make_crawling_reader(_schema, _permit, _io_priority, nullptr));
         return upgrade_to_v2(make_flat_mutation_reader<reader>(std::move(crawling_reader), _options.operation_mode));
     }
 
+    bool can_split_into_sub_ranges() const override {
+        return false;
+    }
+
     uint64_t partitions_per_sstable() const override {
         const auto original_estimate = compaction::partitions_per_sstable();
         if (_bucket_count <= 1) {
@@ -1537,10 +1646,10 @@ class resharding_compaction final : public compaction {
     ~resharding_compaction() { }
 
     // Use reader that makes sure no non-local mutation will not be filtered out.
-    flat_mutation_reader_v2 make_sstable_reader() const override {
+    flat_mutation_reader_v2 make_sstable_reader(const dht::partition_range& range) const override {
         return _compacting->make_range_sstable_reader(_schema,
                 _permit,
-                query::full_partition_range,
+                range,
                 _schema->full_slice(),
                 _io_priority,
                 nullptr,
@@ -1612,6 +1721,7 @@ compaction_type compaction_type_options::type() const {
         compaction_type::Scrub,
         compaction_type::Reshard,
         compaction_type::Reshape,
+        compaction_type::Purge,
     };
     static_assert(std::variant_size_v<compaction_type_options::options_variant> == std::size(index_to_type));
     return index_to_type[_options.index()];
@@ -1641,6 +1751,9 @@ static std::unique_ptr<compaction> make_compaction(table_state& table_s, sstable
         std::unique_ptr<compaction> operator()(compaction_type_options::scrub scrub_options) {
             return std::make_unique<scrub_compaction>(table_s, std::move(descriptor), cdata, scrub_options);
         }
+        std::unique_ptr<compaction> operator()(compaction_type_options::purge) {
+            return std::make_unique<purge_compaction>(table_s, std::move(descriptor), cdata);
+        }
     } visitor_factory{table_s, std::move(descriptor), cdata};
 
     return descriptor.options.visit(visitor_factory);
@@ -44,6 +44,7 @@ enum class compaction_type {
     Reshard = 5,
     Upgrade = 6,
     Reshape = 7,
+    Purge = 8, // rewrites an sstable on its own to drop its purgeable tombstones
 };
 
 std::ostream& operator<<(std::ostream& os, compaction_type type);
@@ -92,8 +93,10 @@ class compaction_type_options {
     };
     struct reshape {
     };
+    struct purge {
+    };
 private:
-    using options_variant = std::variant<regular, cleanup, upgrade, scrub, reshard, reshape>;
+    using options_variant = std::variant<regular, cleanup, upgrade, scrub, reshard, reshape, purge>;
 
 private:
     options_variant _options;
@@ -127,6 +130,10 @@ class compaction_type_options {
         return compaction_type_options(scrub{mode});
     }
 
+    static compaction_type_options make_purge() {
+        return compaction_type_options(purge{});
+    }
+
     template <typename... Visitor>
     auto visit(Visitor&&... visitor) const {
         return std::visit(std::forward<Visitor>(visitor)..., _options);
@@ -172,6 +179,11 @@ struct compaction_descriptor {
     // Denotes if this compaction task is comprised solely of completely expired SSTables
     sstables::has_only_fully_expired has_only_fully_expired = has_only_fully_expired::no;
 
+    // Number of token sub-ranges the input is split into and compacted concurrently,
+    // each into separate sstables of the output run. Only honored by compactions
+    // whose output doesn't have to be written in token order (see compaction::make_sub_ranges()).
+    unsigned parallelism = 1;
+
     compaction_descriptor() = default;
 
     static constexpr int default_level = 0;
@@ -33,6 +33,7 @@
 #include "utils/UUID_gen.hh"
 #include <cmath>
 #include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/range/adaptor/map.hpp>
 
 static logging::logger cmlog("compaction_manager");
 using namespace std::chrono_literals;
@@ -217,6 +218,23 @@ std::vector<sstables::shared_sstable> compaction_manager::get_candidates(const t
     return candidates;
 }
 
+sstables::compaction_descriptor compaction_manager::get_sstables_for_compaction(table& t, sstables::compaction_strategy& cs) {
+    auto candidates = get_candidates(t);
+    auto repaired = std::stable_partition(candidates.begin(), candidates.end(), [] (const sstables::shared_sstable& sst) {
+        return !sst->is_repaired();
+    });
+    if (repaired == candidates.begin() || repaired == candidates.end()) {
+        return cs.get_sstables_for_compaction(t.as_table_state(), get_strategy_control(), std::move(candidates));
+    }
+    std::vector<sstables::shared_sstable> repaired_candidates(std::make_move_iterator(repaired), std::make_move_iterator(candidates.end()));
+    candidates.erase(repaired, candidates.end());
+    auto descriptor = cs.get_sstables_for_compaction(t.as_table_state(), get_strategy_control(), std::move(candidates));
+    if (!descriptor.sstables.empty()) {
+        return descriptor;
+    }
+    return cs.get_sstables_for_compaction(t.as_table_state(), get_strategy_control(), std::move(repaired_candidates));
+}
+
 void compaction_manager::register_compacting_sstables(const std::vector<sstables::shared_sstable>& sstables) {
     std::unordered_set<sstables::shared_sstable> sstables_to_merge;
     sstables_to_merge.reserve(sstables.size());
@@ -290,6 +308,7 @@ future<> compaction_manager::perform_major_compaction(table* t) {
             descriptor.release_exhausted = [compacting] (const std::vector<sstables::shared_sstable>& exhausted_sstables) {
                 compacting->release_compacting(exhausted_sstables);
             };
+            descriptor.parallelism = t->get_config().compaction_sub_range_parallelism();
             task->setup_new_compaction();
             task->output_run_identifier = descriptor.run_identifier;
 
@@ -319,6 +338,39 @@ future<> compaction_manager::perform_major_compaction(table* t) {
     return task->compaction_done.get_future().then([task] {});
 }
 
+// Leveled compaction levels the repaired and the unrepaired sstables separately (see
+// get_sstables_for_compaction()), so the sstables of a level of one kind may overlap
+// with those of the same level of the other kind. An sstable which becomes repaired
+// must then go back to L0, or the level of the repaired sstables would overlap.
+static bool overlaps_repaired_sstables_of_its_level(const table& t, const sstables::sstable& sst) {
+    const auto level = sst.get_sstable_level();
+    if (level == 0) {
+        return false;
+    }
+    const auto& s = *t.schema();
+    return boost::algorithm::any_of(*t.get_sstables(), [&] (const sstables::shared_sstable& other) {
+        return other->is_repaired() && other->get_sstable_level() == level
+                && sst.get_first_decorated_key().tri_compare(s, other->get_last_decorated_key()) <= 0
+                && other->get_first_decorated_key().tri_compare(s, sst.get_last_decorated_key()) <= 0;
+    });
+}
+
+future<> compaction_manager::mark_sstables_repaired(table* t, std::vector<std::pair<sstables::shared_sstable, uint64_t>> sstables) {
+    std::erase_if(sstables, [this] (const std::pair<sstables::shared_sstable, uint64_t>& e) {
+        return _compacting_sstables.contains(e.first);
+    });
+    // Keep compaction away from the sstables while their Statistics are rewritten.
+    auto compacting = compacting_sstable_registration(this, boost::copy_range<std::vector<sstables::shared_sstable>>(sstables
+            | boost::adaptors::map_keys));
+    for (auto& [sst, repaired_at] : sstables) {
+        if (overlaps_repaired_sstables_of_its_level(*t, *sst)) {
+            co_await t->send_sstable_to_level_0(sst);
+        }
+        co_await sst->mutate_repaired_at(repaired_at);
+    }
+    cmlog.debug("Marked {} sstable(s) of {}.{} as repaired", sstables.size(), t->schema()->ks_name(), t->schema()->cf_name());
+}
+
 future<> compaction_manager::run_custom_job(table* t, sstables::compaction_type type, noncopyable_function<future<>(sstables::compaction_data&)> job) {
     if (_state != state::enabled) {
         return make_ready_future<>();
@@ -676,7 +728,7 @@ void compaction_manager::submit(table* t) {
           return with_scheduling_group(_compaction_controller.sg(), [this, task = std::move(task)] () mutable {
             table& t = *task->compacting_table;
             sstables::compaction_strategy cs = t.get_compaction_strategy();
-            sstables::compaction_descriptor descriptor = cs.get_sstables_for_compaction(t.as_table_state(), get_strategy_control(), get_candidates(t));
+            sstables::compaction_descriptor descriptor = get_sstables_for_compaction(t, cs);
             int weight = calculate_weight(descriptor);
 
             if (descriptor.sstables.empty() || !can_proceed(task) || t.is_auto_compaction_disabled_by_user()) {
@@ -992,6 +1044,14 @@ future<> compaction_manager::perform_sstable_upgrade(database& db, table* t, boo
     return rewrite_sstables(t, sstables::compaction_type_options::make_upgrade(db.get_keyspace_local_ranges(t->schema()->ks_name())), std::move(get_sstables));
 }
 
+future<> compaction_manager::perform_tombstone_purge(table* t) {
+    auto get_sstables = [this, t] {
+        auto cs = t->get_compaction_strategy();
+        return make_ready_future<std::vector<sstables::shared_sstable>>(cs.get_tombstone_purge_candidates(t->as_table_state(), get_candidates(*t)));
+    };
+    return rewrite_sstables(t, sstables::compaction_type_options::make_purge(), std::move(get_sstables));
+}
+
 // Submit a table to be scrubbed and wait for its termination.
 future<> compaction_manager::perform_sstable_scrub(table* t, sstables::compaction_type_options::scrub opts) {
     auto scrub_mode = opts.operation_mode;
@@ -180,6 +180,12 @@ class compaction_manager {
     // Get candidates for compaction strategy, which are all sstables but the ones being compacted.
     std::vector<sstables::shared_sstable> get_candidates(const table& t);
 
+    // Asks the strategy for sstables to compact among the candidates. Unrepaired and
+    // repaired sstables are compacted separately, unrepaired ones first, so that data
+    // which was not repaired yet doesn't make repaired sstables unrepaired. For leveled
+    // compaction, each kind has levels of its own.
+    sstables::compaction_descriptor get_sstables_for_compaction(table& t, sstables::compaction_strategy& cs);
+
     void register_compacting_sstables(const std::vector<sstables::shared_sstable>& sstables);
     void deregister_compacting_sstables(const std::vector<sstables::shared_sstable>& sstables);
 
@@ -266,6 +272,13 @@ class compaction_manager {
     // Submit a table to be scrubbed and wait for its termination.
     future<> perform_sstable_scrub(table* t, sstables::compaction_type_options::scrub opts);
 
+    // Submit a table to have its tombstone-dense sstables rewritten, one at a time,
+    // to purge their tombstones, and wait for its termination.
+    // Unlike regular compaction, which purges tombstones as part of merging sstables,
+    // this recovers the performance of reads slowed by tombstones without rewriting
+    // the rest of the table.
+    future<> perform_tombstone_purge(table* t);
+
     // Submit a table for major compaction.
     future<> perform_major_compaction(table* t);
 
@@ -279,6 +292,11 @@ class compaction_manager {
     // parameter job is a function that will carry the operation
     future<> run_custom_job(table* t, sstables::compaction_type type, noncopyable_function<future<>(sstables::compaction_data&)> job);
 
+    // Marks sstables of a table as repaired at the given time (milliseconds since
+    // the epoch), skipping the ones being compacted, which are about to go away.
+    // Leveled sstables which overlap with repaired ones of their level go back to L0.
+    future<> mark_sstables_repaired(table* t, std::vector<std::pair<sstables::shared_sstable, uint64_t>> sstables);
+
     // Run a function with compaction temporarily disabled for a table T.
     future<> run_with_compaction_disabled(table* t, std::function<future<> ()> func);
 
@@ -54,6 +54,7 @@
 #include "date_tiered_compaction_strategy.hh"
 #include "leveled_compaction_strategy.hh"
 #include "time_window_compaction_strategy.hh"
+#include "incremental_compaction_strategy.hh"
 #include "backlog_controller.hh"
 #include "compaction_backlog_manager.hh"
 #include "size_tiered_backlog_tracker.hh"
@@ -82,6 +83,19 @@ bool compaction_strategy_impl::worth_dropping_tombstones(const shared_sstable& s
     return sst->estimate_droppable_tombstone_ratio(gc_before) >= _tombstone_threshold;
 }
 
+std::vector<shared_sstable>
+compaction_strategy_impl::get_tombstone_purge_candidates(table_state& table_s, std::vector<shared_sstable> candidates) {
+    auto gc_before = gc_clock::now() - table_s.schema()->gc_grace_seconds();
+    auto e = boost::range::remove_if(candidates, [&] (const shared_sstable& sst) {
+        // A fully expired sstable, i.e. one whose data is all expired and whose max timestamp is
+        // below the min timestamp of the overlapping sstables, is dropped by compaction without
+        // being read at all, so it's always worth it regardless of its droppable tombstone ratio.
+        return !worth_dropping_tombstones(sst, gc_before) && table_s.fully_expired_sstables({ sst }).empty();
+    });
+    candidates.erase(e, candidates.end());
+    return candidates;
+}
+
 uint64_t compaction_strategy_impl::adjust_partition_estimate(const mutation_source_metadata& ms_meta, uint64_t partition_estimate) {
     return partition_estimate;
 }
@@ -332,6 +346,82 @@ class leveled_compaction_backlog_tracker final : public compaction_backlog_track
     }
 };
 
+// The backlog for ICS is the STCS backlog (see size_tiered_backlog_tracker.hh) with runs in
+// place of SSTables: a run is compacted as a whole, so how many more times its data is going
+// to be rewritten depends on the size of the run, not on the size of its fragments.
+class incremental_backlog_tracker final : public compaction_backlog_tracker::impl {
+    std::unordered_map<utils::UUID, uint64_t> _run_sizes;
+    int64_t _total_bytes = 0;
+    double _runs_backlog_contribution = 0;
+
+    static double log4(double x) {
+        double inv_log_4 = 1.0f / std::log(4);
+        return log(x) * inv_log_4;
+    }
+
+    static double contribution(uint64_t run_size) {
+        return run_size ? run_size * log4(run_size) : 0;
+    }
+
+    void update_run(const utils::UUID& run_id, int64_t delta) {
+        auto& size = _run_sizes[run_id];
+        _runs_backlog_contribution -= contribution(size);
+        size += delta;
+        _runs_backlog_contribution += contribution(size);
+        _total_bytes += delta;
+        if (!size) {
+            _run_sizes.erase(run_id);
+        }
+    }
+
+    uint64_t run_size(const sstables::shared_sstable& sst) const {
+        auto it = _run_sizes.find(sst->run_identifier());
+        return it != _run_sizes.end() ? it->second : sst->data_size();
+    }
+public:
+    virtual double backlog(const compaction_backlog_tracker::ongoing_writes& ow, const compaction_backlog_tracker::ongoing_compactions& oc) const override {
+        if (_total_bytes == 0) {
+            return 0;
+        }
+        int64_t partial_bytes = 0;
+        double partial_contribution = 0;
+        for (auto const& swp : ow) {
+            auto written = swp.second->written();
+            if (written > 0) {
+                partial_bytes += written;
+                partial_contribution += written * log4(written);
+            }
+        }
+        int64_t compacted_bytes = 0;
+        double compacted_contribution = 0;
+        for (auto const& crp : oc) {
+            auto compacted = crp.second->compacted();
+            compacted_bytes += compacted;
+            compacted_contribution += compacted * log4(run_size(crp.first));
+        }
+
+        auto effective_total_size = _total_bytes + partial_bytes - compacted_bytes;
+        if (effective_total_size <= 0) {
+            return 0;
+        }
+        auto runs_contribution = _runs_backlog_contribution + partial_contribution - compacted_contribution;
+        auto b = (effective_total_size * log4(_total_bytes)) - runs_contribution;
+        return b > 0 ? b : 0;
+    }
+
+    virtual void add_sstable(sstables::shared_sstable sst) override {
+        if (sst->data_size() > 0) {
+            update_run(sst->run_identifier(), sst->data_size());
+        }
+    }
+
+    virtual void remove_sstable(sstables::shared_sstable sst) override {
+        if (sst->data_size() > 0) {
+            update_run(sst->run_identifier(), -int64_t(sst->data_size()));
+        }
+    }
+};
+
 struct unimplemented_backlog_tracker final : public compaction_backlog_tracker::impl {
     virtual double backlog(const compaction_backlog_tracker::ongoing_writes& ow, const compaction_backlog_tracker::ongoing_compactions& oc) const override {
         return compaction_controller::disable_backlog;
@@ -617,6 +707,13 @@ size_tiered_compaction_strategy::size_tiered_compaction_strategy(const size_tier
     , _backlog_tracker(std::make_unique<size_tiered_backlog_tracker>())
 {}
 
+incremental_compaction_strategy::incremental_compaction_strategy(const std::map<sstring, sstring>& options)
+    : compaction_strategy_impl(options)
+    , _options(options)
+    , _stcs_options(options)
+    , _backlog_tracker(std::make_unique<incremental_backlog_tracker>())
+{}
+
 compaction_strategy::compaction_strategy(::shared_ptr<compaction_strategy_impl> impl)
     : _compaction_strategy_impl(std::move(impl)) {}
 compaction_strategy::compaction_strategy() = default;
@@ -637,6 +734,10 @@ compaction_descriptor compaction_strategy::get_major_compaction_job(table_state&
     return _compaction_strategy_impl->get_major_compaction_job(table_s, std::move(candidates));
 }
 
+std::vector<shared_sstable> compaction_strategy::get_tombstone_purge_candidates(table_state& table_s, std::vector<shared_sstable> candidates) {
+    return _compaction_strategy_impl->get_tombstone_purge_candidates(table_s, std::move(candidates));
+}
+
 void compaction_strategy::notify_completion(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added) {
     _compaction_strategy_impl->notify_completion(removed, added);
 }
@@ -693,6 +794,9 @@ compaction_strategy make_compaction_strategy(compaction_strategy_type strategy,
     case compaction_strategy_type::time_window:
         impl = ::make_shared<time_window_compaction_strategy>(options);
         break;
+    case compaction_strategy_type::incremental:
+        impl = ::make_shared<incremental_compaction_strategy>(options);
+        break;
     default:
         throw std::runtime_error("strategy not supported");
     }
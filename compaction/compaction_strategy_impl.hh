@@ -76,6 +76,9 @@ class compaction_strategy_impl {
     // droppable tombstone histogram and gc_before.
     bool worth_dropping_tombstones(const shared_sstable& sst, gc_clock::time_point gc_before);
 
+    // Return the candidates worth rewriting on their own to purge their tombstones.
+    std::vector<shared_sstable> get_tombstone_purge_candidates(table_state& table_s, std::vector<shared_sstable> candidates);
+
     virtual compaction_backlog_tracker& get_backlog_tracker() = 0;
 
     virtual uint64_t adjust_partition_estimate(const mutation_source_metadata& ms_meta, uint64_t partition_estimate);
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "incremental_compaction_strategy.hh"
+#include "table_state.hh"
+#include "service/priority_manager.hh"
+
+#include <cmath>
+#include <boost/algorithm/cxx11/all_of.hpp>
+#include <boost/range/adaptors.hpp>
+#include <boost/range/algorithm.hpp>
+
+namespace sstables {
+
+incremental_compaction_strategy_options::incremental_compaction_strategy_options(const std::map<sstring, sstring>& options) {
+    using namespace cql3::statements;
+
+    auto tmp_value = compaction_strategy_impl::get_value(options, FRAGMENT_SIZE_KEY);
+    auto fragment_size_in_mb = property_definitions::to_long(FRAGMENT_SIZE_KEY, tmp_value, DEFAULT_FRAGMENT_SIZE_IN_MB);
+    if (fragment_size_in_mb <= 0) {
+        throw exceptions::configuration_exception(format("{} must be greater than 0, but was {}", FRAGMENT_SIZE_KEY, fragment_size_in_mb));
+    }
+    fragment_size = uint64_t(fragment_size_in_mb) * 1024 * 1024;
+}
+
+std::vector<sstable_run>
+incremental_compaction_strategy::get_candidate_runs(table_state& table_s, const std::vector<shared_sstable>& candidates) {
+    std::unordered_set<shared_sstable> candidate_set(candidates.begin(), candidates.end());
+    auto runs = table_s.get_sstable_set().select_sstable_runs(candidates);
+    // A run with fragments which are not candidates is being compacted already.
+    auto e = boost::range::remove_if(runs, [&] (const sstable_run& run) {
+        return !boost::algorithm::all_of(run.all(), [&] (const shared_sstable& sst) { return candidate_set.contains(sst); });
+    });
+    runs.erase(e, runs.end());
+    return runs;
+}
+
+std::vector<std::vector<sstable_run>>
+incremental_compaction_strategy::get_buckets(std::vector<sstable_run> runs, const size_tiered_compaction_strategy_options& options) {
+    // Same grouping as size_tiered_compaction_strategy::get_buckets(), with runs in place of sstables.
+    std::sort(runs.begin(), runs.end(), [] (const sstable_run& a, const sstable_run& b) {
+        return a.data_size() < b.data_size();
+    });
+
+    std::vector<std::vector<sstable_run>> bucket_list;
+    std::vector<double> bucket_average_size_list;
+
+    for (auto& run : runs) {
+        const uint64_t size = run.data_size();
+
+        if (!bucket_list.empty()) {
+            auto& bucket_average_size = bucket_average_size_list.back();
+
+            if ((size > (bucket_average_size * options.bucket_low) && size < (bucket_average_size * options.bucket_high)) ||
+                    (size < options.min_sstable_size && bucket_average_size < options.min_sstable_size)) {
+                auto& bucket = bucket_list.back();
+                auto total_size = bucket.size() * bucket_average_size;
+                auto new_average_size = (total_size + size) / (bucket.size() + 1);
+                auto smallest_run_in_bucket = bucket[0].data_size();
+
+                if (size < options.min_sstable_size || smallest_run_in_bucket > new_average_size * options.bucket_low) {
+                    bucket.push_back(std::move(run));
+                    bucket_average_size = new_average_size;
+                    continue;
+                }
+            }
+        }
+
+        bucket_list.push_back({std::move(run)});
+        bucket_average_size_list.push_back(size);
+    }
+
+    return bucket_list;
+}
+
+std::vector<sstable_run>
+incremental_compaction_strategy::most_interesting_bucket(std::vector<std::vector<sstable_run>> buckets, size_t min_threshold, size_t max_threshold) {
+    std::vector<sstable_run> ret;
+    for (auto& bucket : buckets) {
+        bucket.resize(std::min(bucket.size(), max_threshold));
+        // Pick the bucket with more runs, as efficiency of same-tier compactions increases with their number.
+        if (bucket.size() >= min_threshold && bucket.size() > ret.size()) {
+            ret = std::move(bucket);
+        }
+    }
+    return ret;
+}
+
+compaction_descriptor
+incremental_compaction_strategy::make_descriptor(table_state& table_s, std::vector<shared_sstable> sstables,
+        utils::UUID run_identifier) const {
+    return compaction_descriptor(std::move(sstables), table_s.get_sstable_set(), service::get_local_compaction_priority(),
+            compaction_descriptor::default_level, _options.fragment_size, run_identifier);
+}
+
+static std::vector<shared_sstable> all_fragments(const std::vector<sstable_run>& runs) {
+    std::vector<shared_sstable> ret;
+    for (auto& run : runs) {
+        ret.insert(ret.end(), run.all().begin(), run.all().end());
+    }
+    return ret;
+}
+
+compaction_descriptor
+incremental_compaction_strategy::get_sstables_for_compaction(table_state& table_s, strategy_control& control, std::vector<sstables::shared_sstable> candidates) {
+    size_t min_threshold = table_s.min_compaction_threshold();
+    size_t max_threshold = table_s.schema()->max_compaction_threshold();
+    auto gc_before = gc_clock::now() - table_s.schema()->gc_grace_seconds();
+
+    auto buckets = get_buckets(get_candidate_runs(table_s, candidates), _stcs_options);
+
+    auto most_interesting = most_interesting_bucket(buckets, min_threshold, max_threshold);
+    // If we are not enforcing min_threshold explicitly, try any pair of runs in the same tier.
+    if (most_interesting.empty() && !table_s.compaction_enforce_min_threshold()) {
+        most_interesting = most_interesting_bucket(buckets, 2, max_threshold);
+    }
+    if (!most_interesting.empty()) {
+        return make_descriptor(table_s, all_fragments(most_interesting));
+    }
+
+    // If there is no run to compact in the standard way, try compacting the single fragment
+    // whose droppable tombstone ratio is the highest above the threshold, starting from the
+    // largest tiers, whose data is less likely to be shadowed by older data. A fragment is
+    // rewritten on its own rather than with its whole run to keep such compactions cheap.
+    // Its replacement covers a subset of its token range, and joins its run, so that the
+    // run stays in its tier instead of leaving behind a small run and a shrunk one.
+    for (auto& bucket : buckets | boost::adaptors::reversed) {
+        std::vector<shared_sstable> fragments;
+        for (auto& run : bucket) {
+            boost::copy(run.all() | boost::adaptors::filtered([this, &gc_before] (const shared_sstable& sst) {
+                return worth_dropping_tombstones(sst, gc_before);
+            }), std::back_inserter(fragments));
+        }
+        if (fragments.empty()) {
+            continue;
+        }
+        auto it = boost::range::max_element(fragments, [&gc_before] (const shared_sstable& a, const shared_sstable& b) {
+            return a->estimate_droppable_tombstone_ratio(gc_before) < b->estimate_droppable_tombstone_ratio(gc_before);
+        });
+        return make_descriptor(table_s, { *it }, (*it)->run_identifier());
+    }
+    return compaction_descriptor();
+}
+
+compaction_descriptor
+incremental_compaction_strategy::get_major_compaction_job(table_state& table_s, std::vector<sstables::shared_sstable> candidates) {
+    // Major compaction would otherwise write a single sstable, holding on to the whole input until it is done.
+    return make_descriptor(table_s, std::move(candidates));
+}
+
+int64_t incremental_compaction_strategy::estimated_pending_compactions(table_state& table_s) const {
+    size_t min_threshold = table_s.min_compaction_threshold();
+    size_t max_threshold = table_s.schema()->max_compaction_threshold();
+    std::unordered_map<utils::UUID, sstable_run> runs;
+    table_s.get_sstable_set().for_each_sstable([&] (const shared_sstable& sst) {
+        runs[sst->run_identifier()].insert(sst);
+    });
+
+    int64_t n = 0;
+    for (auto& bucket : get_buckets(boost::copy_range<std::vector<sstable_run>>(runs | boost::adaptors::map_values), _stcs_options)) {
+        if (bucket.size() >= min_threshold) {
+            n += std::ceil(double(bucket.size()) / max_threshold);
+        }
+    }
+    return n;
+}
+
+}
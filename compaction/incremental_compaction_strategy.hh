@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "compaction_strategy_impl.hh"
+#include "compaction.hh"
+#include "size_tiered_compaction_strategy.hh"
+#include "sstables/sstable_set.hh"
+#include "sstables/sstables.hh"
+
+namespace sstables {
+
+class incremental_compaction_strategy_options {
+    static constexpr uint64_t DEFAULT_FRAGMENT_SIZE_IN_MB = 1000;
+    const sstring FRAGMENT_SIZE_KEY = "sstable_size_in_mb";
+
+    uint64_t fragment_size = DEFAULT_FRAGMENT_SIZE_IN_MB * 1024 * 1024;
+public:
+    incremental_compaction_strategy_options(const std::map<sstring, sstring>& options);
+
+    incremental_compaction_strategy_options() = default;
+
+    friend class incremental_compaction_strategy;
+};
+
+// Size-tiered compaction over sstable runs.
+//
+// Every compaction writes its output as a run of fragments (sstables) of at most
+// sstable_size_in_mb each, and runs, rather than sstables, are grouped into tiers
+// of similar size using the size-tiered options (min_sstable_size, bucket_low and
+// bucket_high). Since the input of a compaction then always contains runs of more
+// than one fragment, the compaction releases each input fragment as soon as the
+// output fragment covering its last key is sealed (see
+// compaction::maybe_replace_exhausted_sstables_by_sst()). The temporary space used
+// by a compaction is therefore bounded by about one fragment per input run, instead
+// of the size of its whole input as with size-tiered compaction.
+class incremental_compaction_strategy : public compaction_strategy_impl {
+    incremental_compaction_strategy_options _options;
+    size_tiered_compaction_strategy_options _stcs_options;
+    compaction_backlog_tracker _backlog_tracker;
+
+    // Return the runs all of whose fragments are candidates.
+    static std::vector<sstable_run> get_candidate_runs(table_state& table_s, const std::vector<shared_sstable>& candidates);
+
+    // Group runs of similar size into buckets.
+    static std::vector<std::vector<sstable_run>> get_buckets(std::vector<sstable_run> runs, const size_tiered_compaction_strategy_options& options);
+
+    // Maybe return the bucket of runs to compact.
+    static std::vector<sstable_run> most_interesting_bucket(std::vector<std::vector<sstable_run>> buckets, size_t min_threshold, size_t max_threshold);
+
+    // Output fragments are written to the run identified by run_identifier, a new one by default.
+    compaction_descriptor make_descriptor(table_state& table_s, std::vector<shared_sstable> sstables,
+            utils::UUID run_identifier = utils::make_random_uuid()) const;
+public:
+    incremental_compaction_strategy(const std::map<sstring, sstring>& options);
+
+    virtual compaction_descriptor get_sstables_for_compaction(table_state& table_s, strategy_control& control, std::vector<sstables::shared_sstable> candidates) override;
+
+    virtual compaction_descriptor get_major_compaction_job(table_state& table_s, std::vector<sstables::shared_sstable> candidates) override;
+
+    virtual int64_t estimated_pending_compactions(table_state& table_s) const override;
+
+    virtual compaction_strategy_type type() const override {
+        return compaction_strategy_type::incremental;
+    }
+
+    virtual std::unique_ptr<sstable_set_impl> make_sstable_set(schema_ptr schema) const override;
+
+    virtual compaction_backlog_tracker& get_backlog_tracker() override {
+        return _backlog_tracker;
+    }
+
+    uint64_t fragment_size() const {
+        return _options.fragment_size;
+    }
+};
+
+}
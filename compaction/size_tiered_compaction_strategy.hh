@@ -89,6 +89,7 @@ class size_tiered_compaction_strategy_options {
     }
 #endif
     friend class size_tiered_compaction_strategy;
+    friend class incremental_compaction_strategy;
 };
 
 class size_tiered_compaction_strategy : public compaction_strategy_impl {
@@ -73,6 +73,14 @@ std::map<sstring, sstring> compressor::options() const {
     return {};
 }
 
+bytes compressor::train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes) const {
+    return bytes();
+}
+
+shared_ptr<compressor> compressor::with_dictionary(bytes_view dictionary, dictionary_usage usage) const {
+    throw std::runtime_error(format("{} does not support compression dictionaries", name()));
+}
+
 compressor::ptr_type compressor::create(const sstring& name, const opt_getter& opts) {
     if (name.empty()) {
         return {};
@@ -23,12 +23,14 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 #include <seastar/core/future.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/sstring.hh>
 
 #include "exceptions/exceptions.hh"
+#include "bytes.hh"
 
 
 class compressor {
@@ -64,6 +66,32 @@ class compressor {
      */
     virtual std::map<sstring, sstring> options() const;
 
+    /**
+     * Returns the maximum size of a dictionary this compressor wants trained
+     * for each sstable, or 0 if it does not use dictionaries.
+     */
+    virtual size_t dictionary_max_size() const {
+        return 0;
+    }
+    /**
+     * Trains a dictionary from samples laid out back to back in "samples",
+     * the size of each given by "sample_sizes". Returns an empty dictionary
+     * if training was not possible, e.g. because there were too few samples.
+     * Training is done in one go, so the caller must keep the samples small
+     * enough not to stall the reactor.
+     */
+    virtual bytes train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes) const;
+    enum class dictionary_usage {
+        compress,
+        uncompress,
+    };
+    /**
+     * Returns a new compressor with the same options as this one, which
+     * either compresses or uncompresses every chunk, depending on "usage",
+     * using "dictionary". Only the state needed for "usage" is built.
+     */
+    virtual shared_ptr<compressor> with_dictionary(bytes_view dictionary, dictionary_usage usage) const;
+
     /**
      * Compressor class name.
      */
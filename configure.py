@@ -379,6 +379,7 @@ scylla_tests = set([
     'test/boost/auth_test',
     'test/boost/batchlog_manager_test',
     'test/boost/big_decimal_test',
+    'test/boost/bloom_filter_test',
     'test/boost/broken_sstable_test',
     'test/boost/bytes_ostream_test',
     'test/boost/cache_flat_mutation_reader_test',
@@ -461,6 +462,7 @@ scylla_tests = set([
     'test/boost/query_processor_test',
     'test/boost/range_test',
     'test/boost/range_tombstone_list_test',
+    'test/boost/repair_hash_tree_test',
     'test/boost/reusable_buffer_test',
     'test/boost/restrictions_test',
     'test/boost/role_manager_test',
@@ -483,6 +485,7 @@ scylla_tests = set([
     'test/boost/sstable_compaction_test',
     'test/boost/sstable_resharding_test',
     'test/boost/sstable_directory_test',
+    'test/boost/sstable_file_streaming_test',
     'test/boost/sstable_test',
     'test/boost/sstable_move_test',
     'test/boost/statement_restrictions_test',
@@ -524,6 +527,7 @@ scylla_tests = set([
     'test/perf/memory_footprint_test',
     'test/perf/perf_cache_eviction',
     'test/perf/perf_cql_parser',
+    'test/perf/perf_cql_pipelining',
     'test/perf/perf_fast_forward',
     'test/perf/perf_hash',
     'test/perf/perf_mutation',
@@ -685,6 +689,7 @@ scylla_core = (['database.cc',
                 'row_cache.cc',
                 'canonical_mutation.cc',
                 'frozen_mutation.cc',
+                'columnar_rows.cc',
                 'memtable.cc',
                 'schema_mutations.cc',
                 'generic_server.cc',
@@ -725,6 +730,7 @@ scylla_core = (['database.cc',
                 'compaction/size_tiered_compaction_strategy.cc',
                 'compaction/leveled_compaction_strategy.cc',
                 'compaction/time_window_compaction_strategy.cc',
+                'compaction/incremental_compaction_strategy.cc',
                 'compaction/compaction_manager.cc',
                 'sstables/integrity_checked_file_impl.cc',
                 'sstables/prepended_input_stream.cc',
@@ -737,6 +743,7 @@ scylla_core = (['database.cc',
                 'transport/event.cc',
                 'transport/event_notifier.cc',
                 'transport/server.cc',
+                'transport/segment.cc',
                 'transport/controller.cc',
                 'transport/messages/result_message.cc',
                 'cdc/cdc_partitioner.cc',
@@ -757,6 +764,7 @@ scylla_core = (['database.cc',
                 'cql3/maps.cc',
                 'cql3/values.cc',
                 'cql3/expr/expression.cc',
+                'cql3/expr/columnar_filter.cc',
                 'cql3/expr/prepare_expr.cc',
                 'cql3/functions/user_function.cc',
                 'cql3/functions/functions.cc',
@@ -960,6 +968,7 @@ scylla_core = (['database.cc',
                 'partition_slice_builder.cc',
                 'init.cc',
                 'lister.cc',
+                'repair/hash_tree.cc',
                 'repair/repair.cc',
                 'repair/row_level.cc',
                 'exceptions/exceptions.cc',
@@ -1096,6 +1105,7 @@ idls = ['idl/gossip_digest.idl.hh',
         'idl/range.idl.hh',
         'idl/keys.idl.hh',
         'idl/read_command.idl.hh',
+        'idl/forward_request.idl.hh',
         'idl/token.idl.hh',
         'idl/ring_position.idl.hh',
         'idl/result.idl.hh',
@@ -1195,6 +1205,7 @@ tests_not_using_seastar_test_framework = set([
     'test/perf/memory_footprint_test',
     'test/perf/perf_cache_eviction',
     'test/perf/perf_cql_parser',
+    'test/perf/perf_cql_pipelining',
     'test/perf/perf_hash',
     'test/perf/perf_mutation',
     'test/perf/perf_collection',
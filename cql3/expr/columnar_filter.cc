@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "columnar_filter.hh"
+
+#include <algorithm>
+#include <boost/range/algorithm/find_if.hpp>
+#include <fmt/ostream.h>
+
+#include "schema.hh"
+#include "types.hh"
+
+namespace cql3 {
+namespace expr {
+
+std::optional<columnar_filter::value_kind> columnar_filter::kind_of(const column_definition& column) {
+    switch (column.type->get_kind()) {
+    case abstract_type::kind::int32:
+        return value_kind::int32;
+    case abstract_type::kind::long_kind:
+    case abstract_type::kind::timestamp:
+        return value_kind::int64;
+    case abstract_type::kind::uuid:
+        return value_kind::uuid;
+    default:
+        return std::nullopt;
+    }
+}
+
+// The version of a uuid is stored in the high nibble of its 7th byte.
+static uint64_t uuid_version(int64_t msb) {
+    return (uint64_t(msb) >> 12) & 0xf;
+}
+
+std::optional<columnar_filter::kernel>
+columnar_filter::compile(size_t block, const expression& e, const query_options& options) const {
+    auto binop = as_if<binary_operator>(&e);
+    if (!binop || binop->order != comparison_order::cql) {
+        return std::nullopt;
+    }
+    switch (binop->op) {
+    case oper_t::EQ:
+    case oper_t::NEQ:
+    case oper_t::LT:
+    case oper_t::LTE:
+    case oper_t::GT:
+    case oper_t::GTE:
+        break;
+    default:
+        return std::nullopt;
+    }
+    auto& b = _blocks[block];
+    auto col = as_if<column_value>(&binop->lhs);
+    if (!col || col->sub || col->col != b.column || contains_nonpure_function(binop->rhs)) {
+        return std::nullopt;
+    }
+    // Null and empty right-hand sides are rare enough to be left to is_satisfied_by().
+    auto value = expr::evaluate(binop->rhs, options);
+    if (value.is_null_or_unset() || value.view().size_bytes() != b.width) {
+        return std::nullopt;
+    }
+    kernel k{block, binop->op, 0, 0};
+    value.view().with_value([&] (const FragmentedView auto& v) {
+        auto view = v;
+        if (b.kind == value_kind::int32) {
+            k.msb = read_simple<int32_t>(view);
+        } else {
+            k.msb = read_simple<int64_t>(view);
+        }
+        if (b.kind == value_kind::uuid) {
+            k.lsb = read_simple<uint64_t>(view);
+        }
+    });
+    // Time-based uuids are ordered by their timestamp, which has no cheap columnar form.
+    if (b.kind == value_kind::uuid && is_slice(k.op) && uuid_version(k.msb) == 1) {
+        return std::nullopt;
+    }
+    return k;
+}
+
+bool columnar_filter::add(const column_definition& column, const expression& restriction, const query_options& options) {
+    auto kind = kind_of(column);
+    if (!kind) {
+        return false;
+    }
+    auto it = boost::find_if(_blocks, [&] (const column_block& b) { return b.column == &column; });
+    auto block = size_t(it - _blocks.begin());
+    const bool new_block = it == _blocks.end();
+    if (new_block) {
+        _blocks.push_back(column_block{&column, *kind, *kind == value_kind::int32 ? 4u : *kind == value_kind::int64 ? 8u : 16u});
+    }
+    std::vector<kernel> kernels;
+    auto compile_one = [&] (const expression& e) {
+        if (auto k = compile(block, e, options)) {
+            kernels.push_back(*k);
+            return true;
+        }
+        return false;
+    };
+    bool compiled;
+    if (auto conj = as_if<conjunction>(&restriction)) {
+        compiled = std::all_of(conj->children.begin(), conj->children.end(), compile_one);
+    } else {
+        compiled = compile_one(restriction);
+    }
+    if (!compiled || kernels.empty()) {
+        if (new_block) {
+            _blocks.pop_back();
+        }
+        return false;
+    }
+    _kernels.insert(_kernels.end(), kernels.begin(), kernels.end());
+    return true;
+}
+
+std::vector<const column_definition*> columnar_filter::columns() const {
+    std::vector<const column_definition*> ret;
+    ret.reserve(_blocks.size());
+    for (auto& b : _blocks) {
+        ret.push_back(b.column);
+    }
+    return ret;
+}
+
+columnar_filter::mask_type columnar_filter::evaluate(const kernel& k) const {
+    auto& b = _blocks[k.block];
+    // Compute which rows are less than and equal to the kernel's value. The loops
+    // run over the whole block, regardless of how many rows were loaded, so that
+    // they have a fixed trip count and no branches.
+    mask_type lt = 0;
+    mask_type eq = 0;
+    if (b.kind != value_kind::uuid) {
+        for (size_t i = 0; i < block_size; ++i) {
+            lt |= mask_type(b.msb[i] < k.msb) << i;
+            eq |= mask_type(b.msb[i] == k.msb) << i;
+        }
+    } else {
+        // Mirrors the uuid comparator: versions are compared first, then the bytes
+        // as unsigned. Kernels on time-based uuids are only compiled for = and !=.
+        const auto version = uuid_version(k.msb);
+        for (size_t i = 0; i < block_size; ++i) {
+            const auto row_version = uuid_version(b.msb[i]);
+            const auto msb = uint64_t(b.msb[i]);
+            const bool msb_eq = msb == uint64_t(k.msb);
+            const bool bytes_lt = msb < uint64_t(k.msb) || (msb_eq && b.lsb[i] < k.lsb);
+            lt |= mask_type(row_version < version || (row_version == version && bytes_lt)) << i;
+            eq |= mask_type(msb_eq && b.lsb[i] == k.lsb) << i;
+        }
+    }
+
+    // Empty values compare less than any other value, and comparisons with null
+    // are false, except for != which is the negation of =.
+    const auto present = b.present;
+    const auto empty = b.empty;
+    const auto null = ~(present | empty);
+    switch (k.op) {
+    case oper_t::EQ:
+        return present & eq;
+    case oper_t::NEQ:
+        return (present & ~eq) | empty | null;
+    case oper_t::LT:
+        return (present & lt) | empty;
+    case oper_t::LTE:
+        return (present & (lt | eq)) | empty;
+    case oper_t::GT:
+        return present & ~(lt | eq);
+    case oper_t::GTE:
+        return present & ~lt;
+    default:
+        throw std::logic_error(format("columnar_filter: unexpected operator {}", k.op));
+    }
+}
+
+columnar_filter::mask_type columnar_filter::evaluate(size_t rows) const {
+    mask_type ret = rows == block_size ? ~mask_type(0) : (mask_type(1) << rows) - 1;
+    for (auto& k : _kernels) {
+        ret &= evaluate(k);
+    }
+    return ret;
+}
+
+} // namespace expr
+} // namespace cql3
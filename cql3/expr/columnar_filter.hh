@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <optional>
+#include <vector>
+
+#include "cql3/expr/expression.hh"
+#include "utils/fragment_range.hh"
+
+class column_definition;
+
+namespace cql3 {
+
+class query_options;
+
+namespace expr {
+
+/// Evaluates simple restrictions over blocks of rows instead of one row at a time.
+///
+/// Comparisons (=, !=, <, <=, >, >=) between an int, bigint, timestamp or uuid column
+/// and a value known when the query starts are compiled into kernels once per query.
+/// The values of the restricted columns for a block of rows are decoded into
+/// column-major arrays with load(), and evaluate() then runs each kernel over the
+/// whole block with branch-free loops. Restrictions which cannot be compiled are
+/// left to is_satisfied_by(), which also defines the semantics the kernels follow,
+/// including the handling of null and empty values.
+class columnar_filter {
+public:
+    static constexpr size_t block_size = 64;
+    /// Bit i describes row i of a block.
+    using mask_type = uint64_t;
+    static_assert(sizeof(mask_type) * 8 == block_size);
+private:
+    enum class value_kind : uint8_t { int32, int64, uuid };
+
+    struct column_block {
+        const column_definition* column;
+        value_kind kind;
+        size_t width;
+        // Values of the rows in the block. Integers are stored in msb, uuids are split
+        // into their most and least significant halves.
+        std::array<int64_t, block_size> msb{};
+        std::array<uint64_t, block_size> lsb{};
+        mask_type present = 0; // rows with a value of the column's full width
+        mask_type empty = 0;   // rows with an empty value; rows in neither mask are null
+    };
+
+    struct kernel {
+        size_t block;
+        oper_t op;
+        int64_t msb;
+        uint64_t lsb;
+    };
+
+    std::vector<column_block> _blocks;
+    std::vector<kernel> _kernels;
+private:
+    static std::optional<value_kind> kind_of(const column_definition& column);
+    std::optional<kernel> compile(size_t block, const expression& e, const query_options& options) const;
+    mask_type evaluate(const kernel& k) const;
+public:
+    /// Compiles restriction, an expression restricting only column, into kernels.
+    ///
+    /// Returns false and leaves the filter unchanged if any part of restriction
+    /// has no kernel, in which case the whole restriction must be evaluated with
+    /// is_satisfied_by().
+    bool add(const column_definition& column, const expression& restriction, const query_options& options);
+
+    bool empty() const {
+        return _kernels.empty();
+    }
+
+    /// Columns whose values have to be loaded for each block, in the order expected by load().
+    std::vector<const column_definition*> columns() const;
+
+    /// Forgets the values loaded for the previous block.
+    void start_block() {
+        for (auto& b : _blocks) {
+            b.present = 0;
+            b.empty = 0;
+        }
+    }
+
+    /// Loads the value of the column at index column of columns() in the given row of
+    /// the current block. Rows for which no value is loaded are treated as null.
+    template <FragmentedView View>
+    void load(size_t column, size_t row, View value) {
+        auto& b = _blocks[column];
+        const auto bit = mask_type(1) << row;
+        // Values are validated on write, so a value shorter than the column's width
+        // can only be empty (or, for uuids, compare as if it was).
+        if (value.size_bytes() < b.width) {
+            b.empty |= bit;
+            return;
+        }
+        switch (b.kind) {
+        case value_kind::int32:
+            b.msb[row] = read_simple<int32_t>(value);
+            break;
+        case value_kind::int64:
+            b.msb[row] = read_simple<int64_t>(value);
+            break;
+        case value_kind::uuid:
+            b.msb[row] = read_simple<int64_t>(value);
+            b.lsb[row] = read_simple<uint64_t>(value);
+            break;
+        }
+        b.present |= bit;
+    }
+
+    /// Returns the mask of the first rows rows of the current block which satisfy all kernels.
+    mask_type evaluate(size_t rows) const;
+};
+
+} // namespace expr
+
+} // namespace cql3
@@ -46,6 +46,7 @@
 #include "functions.hh"
 #include "native_aggregate_function.hh"
 #include "exceptions/exceptions.hh"
+#include <seastar/core/byteorder.hh>
 
 using namespace cql3;
 using namespace functions;
@@ -68,6 +69,14 @@ class impl_count_function : public aggregate_function::aggregate {
     virtual void add_input(cql_serialization_format sf, const std::vector<opt_bytes>& values) override {
         ++_count;
     }
+    virtual opt_bytes get_state() const override {
+        return long_type->decompose(_count);
+    }
+    virtual void merge_state(const opt_bytes& state) override {
+        if (state) {
+            _count += value_cast<int64_t>(long_type->deserialize(*state));
+        }
+    }
 };
 
 class count_rows_function final : public native_aggregate_function {
@@ -76,6 +85,9 @@ class count_rows_function final : public native_aggregate_function {
     virtual std::unique_ptr<aggregate> new_aggregate() override {
         return std::make_unique<impl_count_function>();
     }
+    virtual bool is_reducible() const override {
+        return true;
+    }
     virtual sstring column_name(const std::vector<sstring>& column_names) const override {
         return "count";
     }
@@ -97,6 +109,25 @@ struct int128_accumulator_for {
         }
         return ret;
     }
+
+    // Partial sums are exchanged before narrowing, so that they can't overflow.
+    static bytes serialize(type acc) {
+        bytes ret(bytes::initialized_later(), 2 * sizeof(uint64_t));
+        auto out = reinterpret_cast<char*>(ret.data());
+        write_be<uint64_t>(out, static_cast<uint64_t>(static_cast<unsigned __int128>(acc) >> 64));
+        write_be<uint64_t>(out + sizeof(uint64_t), static_cast<uint64_t>(acc));
+        return ret;
+    }
+
+    static type deserialize(bytes_view v) {
+        if (v.size() != 2 * sizeof(uint64_t)) {
+            throw exceptions::invalid_request_exception(format("Invalid partial sum of size {}", v.size()));
+        }
+        auto in = reinterpret_cast<const char*>(v.data());
+        auto high = read_be<uint64_t>(in);
+        auto low = read_be<uint64_t>(in + sizeof(uint64_t));
+        return static_cast<type>((static_cast<unsigned __int128>(high) << 64) | low);
+    }
 };
 
 template <typename T>
@@ -106,6 +137,14 @@ struct same_type_accumulator_for {
     static T narrow(type acc) {
         return acc;
     }
+
+    static bytes serialize(const type& acc) {
+        return data_type_for<T>()->decompose(acc);
+    }
+
+    static type deserialize(bytes_view v) {
+        return value_cast<T>(data_type_for<T>()->deserialize(v));
+    }
 };
 
 template <typename T>
@@ -156,6 +195,14 @@ class impl_sum_function_for final : public aggregate_function::aggregate {
         }
         _sum += value_cast<Type>(data_type_for<Type>()->deserialize(*values[0]));
     }
+    virtual opt_bytes get_state() const override {
+        return accumulator_for<Type>::serialize(_sum);
+    }
+    virtual void merge_state(const opt_bytes& state) override {
+        if (state) {
+            _sum += accumulator_for<Type>::deserialize(*state);
+        }
+    }
 };
 
 template <typename Type>
@@ -165,6 +212,9 @@ class sum_function_for final : public native_aggregate_function {
     virtual std::unique_ptr<aggregate> new_aggregate() override {
         return std::make_unique<impl_sum_function_for<Type>>();
     }
+    virtual bool is_reducible() const override {
+        return true;
+    }
 };
 
 
@@ -214,6 +264,24 @@ class impl_avg_function_for final : public aggregate_function::aggregate {
         ++_count;
         _sum += value_cast<Type>(data_type_for<Type>()->deserialize(*values[0]));
     }
+    // The state is the count of values, followed by their sum.
+    virtual opt_bytes get_state() const override {
+        auto sum = accumulator_for<Type>::serialize(_sum);
+        bytes ret(bytes::initialized_later(), sizeof(int64_t) + sum.size());
+        write_be<int64_t>(reinterpret_cast<char*>(ret.data()), _count);
+        std::copy(sum.begin(), sum.end(), ret.begin() + sizeof(int64_t));
+        return ret;
+    }
+    virtual void merge_state(const opt_bytes& state) override {
+        if (!state) {
+            return;
+        }
+        if (state->size() < sizeof(int64_t)) {
+            throw exceptions::invalid_request_exception(format("Invalid partial average of size {}", state->size()));
+        }
+        _count += read_be<int64_t>(reinterpret_cast<const char*>(state->data()));
+        _sum += accumulator_for<Type>::deserialize(bytes_view(*state).substr(sizeof(int64_t)));
+    }
 };
 
 template <typename Type>
@@ -223,6 +291,9 @@ class avg_function_for final : public native_aggregate_function {
     virtual std::unique_ptr<aggregate> new_aggregate() override {
         return std::make_unique<impl_avg_function_for<Type>>();
     }
+    virtual bool is_reducible() const override {
+        return true;
+    }
 };
 
 template <typename Type>
@@ -300,6 +371,15 @@ class impl_max_function_for final : public aggregate_function::aggregate {
             _max = max_wrapper(*_max, val);
         }
     }
+    virtual opt_bytes get_state() const override {
+        if (!_max) {
+            return {};
+        }
+        return data_type_for<Type>()->decompose(data_value(Type{*_max}));
+    }
+    virtual void merge_state(const opt_bytes& state) override {
+        add_input(cql_serialization_format::internal(), {state});
+    }
 };
 
 /// The same as `impl_max_function_for' but without compile-time dependency on `Type'.
@@ -332,6 +412,9 @@ class max_function_for final : public native_aggregate_function {
     virtual std::unique_ptr<aggregate> new_aggregate() override {
         return std::make_unique<impl_max_function_for<Type>>();
     }
+    virtual bool is_reducible() const override {
+        return true;
+    }
 };
 
 class max_dynamic_function final : public native_aggregate_function {
@@ -401,6 +484,15 @@ class impl_min_function_for final : public aggregate_function::aggregate {
             _min = min_wrapper(*_min, val);
         }
     }
+    virtual opt_bytes get_state() const override {
+        if (!_min) {
+            return {};
+        }
+        return data_type_for<Type>()->decompose(data_value(Type{*_min}));
+    }
+    virtual void merge_state(const opt_bytes& state) override {
+        add_input(cql_serialization_format::internal(), {state});
+    }
 };
 
 /// The same as `impl_min_function_for' but without compile-time dependency on `Type'.
@@ -433,6 +525,9 @@ class min_function_for final : public native_aggregate_function {
     virtual std::unique_ptr<aggregate> new_aggregate() override {
         return std::make_unique<impl_min_function_for<Type>>();
     }
+    virtual bool is_reducible() const override {
+        return true;
+    }
 };
 
 class min_dynamic_function final : public native_aggregate_function {
@@ -475,6 +570,14 @@ class impl_count_function_for final : public aggregate_function::aggregate {
         }
         ++_count;
     }
+    virtual opt_bytes get_state() const override {
+        return long_type->decompose(_count);
+    }
+    virtual void merge_state(const opt_bytes& state) override {
+        if (state) {
+            _count += value_cast<int64_t>(long_type->deserialize(*state));
+        }
+    }
 };
 
 template <typename Type>
@@ -484,6 +587,9 @@ class count_function_for final : public native_aggregate_function {
     virtual std::unique_ptr<aggregate> new_aggregate() override {
         return std::make_unique<impl_count_function_for<Type>>();
     }
+    virtual bool is_reducible() const override {
+        return true;
+    }
 };
 
 /**
@@ -43,6 +43,7 @@
 
 #include "function.hh"
 #include <optional>
+#include <stdexcept>
 
 namespace cql3 {
 namespace functions {
@@ -62,6 +63,14 @@ class aggregate_function : public virtual function {
      */
     virtual std::unique_ptr<aggregate> new_aggregate() = 0;
 
+    /**
+     * Whether the aggregates of this function can be computed in parts, on
+     * disjoint sets of input values, and then merged with merge_state().
+     */
+    virtual bool is_reducible() const {
+        return false;
+    }
+
     /**
      * An aggregation operation.
      */
@@ -91,6 +100,23 @@ class aggregate_function : public virtual function {
          * Reset this aggregate.
          */
         virtual void reset() = 0;
+
+        /**
+         * Returns the partial state of this aggregate, which can be merged into
+         * another aggregate of the same function with merge_state().
+         *
+         * Only supported by aggregates of reducible functions.
+         */
+        virtual opt_bytes get_state() const {
+            throw std::logic_error("aggregate does not support partial states");
+        }
+
+        /**
+         * Merges a partial state obtained with get_state() into this aggregate.
+         */
+        virtual void merge_state(const opt_bytes& state) {
+            throw std::logic_error("aggregate does not support partial states");
+        }
     };
 };
 
@@ -412,6 +412,7 @@ class query_processor {
                                    std::numeric_limits<uint16_t>::max()));
                 }
                 assert(bound_terms == prepared->bound_names.size());
+                prepared->result_metadata_id = prepared->statement->get_result_metadata()->calculate_metadata_id();
                 return make_ready_future<std::unique_ptr<statements::prepared_statement>>(std::move(prepared));
             }).then([&key, &id_getter, &client_state] (auto prep_ptr) {
                 const auto& warnings = prep_ptr->warnings;
@@ -40,6 +40,8 @@
  */
 
 #include "cql3/result_set.hh"
+#include "cql3/column_specification.hh"
+#include "hashers.hh"
 
 namespace cql3 {
 
@@ -89,6 +91,23 @@ void metadata::maybe_set_paging_state(lw_shared_ptr<const service::pager::paging
     }
 }
 
+bytes metadata::calculate_metadata_id() const {
+    md5_hasher h;
+    auto update = [&h] (std::string_view s) {
+        h.update(s.data(), s.size());
+        h.update("", 1);
+    };
+    auto names_i = get_names().begin();
+    for (uint32_t i = 0; i < column_count(); ++i, ++names_i) {
+        auto& name = **names_i;
+        update(name.ks_name);
+        update(name.cf_name);
+        update(name.name->text());
+        update(name.type->name());
+    }
+    return h.finalize();
+}
+
 void metadata::set_skip_metadata() {
     _flags.set<flag::NO_METADATA>();
 }
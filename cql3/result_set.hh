@@ -59,12 +59,14 @@ class metadata {
         GLOBAL_TABLES_SPEC = 0,
         HAS_MORE_PAGES = 1,
         NO_METADATA = 2,
+        METADATA_CHANGED = 3,
     };
 
     using flag_enum = super_enum<flag,
         flag::GLOBAL_TABLES_SPEC,
         flag::HAS_MORE_PAGES,
-        flag::NO_METADATA>;
+        flag::NO_METADATA,
+        flag::METADATA_CHANGED>;
 
     using flag_enum_set = enum_set<flag_enum>;
 
@@ -122,6 +124,12 @@ class metadata {
     const std::vector<lw_shared_ptr<column_specification>>& get_names() const {
         return _column_info->_names;
     }
+
+    // Identifies the columns of the result in CQL v5, so that a client which skips
+    // the metadata of a prepared statement learns when they changed. It hashes the
+    // names and types of all the columns, so it is meant to be computed once per
+    // prepared statement and not per request.
+    bytes calculate_metadata_id() const;
 };
 
 ::shared_ptr<const cql3::metadata> make_empty_metadata();
@@ -78,6 +78,14 @@ class abstract_function_selector : public selector {
         return _fun->return_type();
     }
 
+    const shared_ptr<functions::function>& function() const {
+        return _fun;
+    }
+
+    const std::vector<shared_ptr<selector>>& arg_selectors() const {
+        return _arg_selectors;
+    }
+
 #if 0
     @Override
     public String toString()
@@ -47,7 +47,10 @@
 #include "cql3/selection/selection.hh"
 #include "cql3/selection/raw_selector.hh"
 #include "cql3/selection/selector_factories.hh"
+#include "cql3/selection/aggregate_function_selector.hh"
+#include "cql3/selection/simple_selector.hh"
 #include "cql3/result_set.hh"
+#include "cql3/expr/columnar_filter.hh"
 #include "cql3/query_options.hh"
 #include "cql3/restrictions/multi_column_restriction.hh"
 #include "cql3/restrictions/statement_restrictions.hh"
@@ -208,6 +211,38 @@ class selection_with_processing : public selection {
     virtual bool is_aggregate() const override {
         return _factories->does_aggregation();
     }
+
+    virtual std::optional<std::vector<reducible_aggregate>> get_reducible_aggregates() const override {
+        if (!_factories->does_aggregation()) {
+            return std::nullopt;
+        }
+        std::vector<reducible_aggregate> ret;
+        for (auto&& s : _factories->new_instances()) {
+            auto agg = dynamic_pointer_cast<aggregate_function_selector>(s);
+            if (!agg) {
+                return std::nullopt;
+            }
+            auto fun = dynamic_pointer_cast<functions::aggregate_function>(agg->function());
+            if (!fun || !fun->is_reducible()) {
+                return std::nullopt;
+            }
+            std::vector<const column_definition*> arguments;
+            for (size_t i = 0; i < agg->arg_selectors().size(); ++i) {
+                auto arg = dynamic_pointer_cast<simple_selector>(agg->arg_selectors()[i]);
+                if (!arg) {
+                    return std::nullopt;
+                }
+                auto column = get_columns()[arg->index()];
+                // Replicas find the function by the types of the columns it aggregates.
+                if (column->type->without_reversed() != *fun->arg_types()[i]) {
+                    return std::nullopt;
+                }
+                arguments.push_back(column);
+            }
+            ret.push_back(reducible_aggregate{std::move(fun), std::move(arguments)});
+        }
+        return ret;
+    }
 protected:
     class selectors_with_processing : public selectors {
     private:
@@ -436,7 +471,75 @@ result_set_builder::restrictions_filter::restrictions_filter(::shared_ptr<restri
     , _per_partition_remaining(_per_partition_limit)
     , _rows_fetched_for_last_partition(rows_fetched_for_last_partition)
     , _last_pkey(std::move(last_pkey))
-{ }
+{
+    const auto& non_pk_restrictions = _restrictions->get_non_pk_restriction();
+    if (std::none_of(non_pk_restrictions.begin(), non_pk_restrictions.end(), [] (auto&& e) {
+            return e.first->kind == column_kind::regular_column;
+        })) {
+        return;
+    }
+    expr::columnar_filter filter;
+    for (auto&& [cdef, restriction] : non_pk_restrictions) {
+        if (cdef->kind == column_kind::regular_column) {
+            filter.add(*cdef, restriction->expression, options);
+        }
+    }
+    if (!filter.empty()) {
+        _columnar_columns = filter.columns();
+        _columnar_filter = std::move(filter);
+    }
+}
+
+bool result_set_builder::restrictions_filter::start_block_evaluation(const selection& selection) {
+    if (!_columnar_filter) {
+        return false;
+    }
+    std::vector<bool> loaded(_columnar_columns.size());
+    size_t loaded_count = 0;
+    for (auto&& cdef : selection.get_columns()) {
+        if (loaded_count == _columnar_columns.size()) {
+            break;
+        }
+        if (cdef->kind != column_kind::regular_column) {
+            continue;
+        }
+        auto it = std::find(_columnar_columns.begin(), _columnar_columns.end(), cdef);
+        auto idx = it - _columnar_columns.begin();
+        if (it == _columnar_columns.end() || loaded[idx]) {
+            _columnar_load_order.emplace_back(cdef, -1);
+        } else {
+            _columnar_load_order.emplace_back(cdef, idx);
+            loaded[idx] = true;
+            ++loaded_count;
+        }
+    }
+    if (loaded_count != _columnar_columns.size()) {
+        // Not all restricted columns are fetched, leave them to do_filter().
+        _columnar_filter.reset();
+        _columnar_columns.clear();
+        _columnar_load_order.clear();
+        return false;
+    }
+    return true;
+}
+
+void result_set_builder::restrictions_filter::evaluate_block(const selection& selection, std::span<const query::result_row_view> rows) const {
+    static_assert(expr::columnar_filter::block_size == visitor<restrictions_filter>::block_size);
+    auto& filter = *_columnar_filter;
+    filter.start_block();
+    for (size_t i = 0; i < rows.size(); ++i) {
+        auto row_iterator = rows[i].iterator();
+        for (auto&& [cdef, idx] : _columnar_load_order) {
+            if (idx < 0) {
+                row_iterator.skip(*cdef);
+            } else if (auto cell = row_iterator.next_atomic_cell()) {
+                filter.load(idx, i, cell->value());
+            }
+        }
+    }
+    _block_matches = filter.evaluate(rows.size());
+    _block_row = 0;
+}
 
 bool result_set_builder::restrictions_filter::do_filter(const selection& selection,
                                                          const std::vector<bytes>& partition_key,
@@ -468,6 +571,13 @@ bool result_set_builder::restrictions_filter::do_filter(const selection& selecti
             if (cdef->kind == column_kind::regular_column && !row_iterator) {
                 continue;
             }
+            if (cdef->kind == column_kind::regular_column && !_columnar_load_order.empty()
+                    && std::find(_columnar_columns.begin(), _columnar_columns.end(), cdef) != _columnar_columns.end()) {
+                if (!_block_row_matches) {
+                    return false;
+                }
+                continue;
+            }
             auto restr_it = non_pk_restrictions_map.find(cdef);
             if (restr_it == non_pk_restrictions_map.end()) {
                 continue;
@@ -529,6 +639,9 @@ bool result_set_builder::restrictions_filter::operator()(const selection& select
                                                          const std::vector<bytes>& clustering_key,
                                                          const query::result_row_view& static_row,
                                                          const query::result_row_view* row) const {
+    if (row && !_columnar_load_order.empty()) {
+        _block_row_matches = _block_matches & (uint64_t(1) << _block_row++);
+    }
     const bool accepted = do_filter(selection, partition_key, clustering_key, static_row, row);
     if (!accepted) {
         ++_rows_dropped;
@@ -46,9 +46,11 @@
 #include "query-result-reader.hh"
 #include "cql3/column_specification.hh"
 #include "cql3/selection/selector.hh"
+#include "cql3/expr/columnar_filter.hh"
 #include "exceptions/exceptions.hh"
 #include "unimplemented.hh"
 #include <seastar/core/thread.hh>
+#include <span>
 
 namespace cql3 {
 
@@ -61,6 +63,10 @@ namespace restrictions {
 class statement_restrictions;
 }
 
+namespace functions {
+class aggregate_function;
+}
+
 namespace selection {
 
 class raw_selector;
@@ -201,6 +207,23 @@ class selection {
      */
     bool is_trivial() const { return _is_trivial; }
 
+    /**
+     * An aggregate of columns whose results over disjoint sets of rows can be
+     * computed separately and merged, see aggregate_function::is_reducible().
+     */
+    struct reducible_aggregate {
+        ::shared_ptr<functions::aggregate_function> function;
+        std::vector<const column_definition*> arguments;
+    };
+
+    /**
+     * Returns the aggregates this selection consists of, if it selects only
+     * reducible aggregates whose arguments are columns of the selection.
+     */
+    virtual std::optional<std::vector<reducible_aggregate>> get_reducible_aggregates() const {
+        return std::nullopt;
+    }
+
     friend class result_set_builder;
 };
 
@@ -238,6 +261,11 @@ class result_set_builder {
         uint64_t get_rows_dropped() const {
             return 0;
         }
+        bool start_block_evaluation(const selection&) {
+            return false;
+        }
+        void evaluate_block(const selection&, std::span<const query::result_row_view>) const {
+        }
     };
     class restrictions_filter {
         ::shared_ptr<restrictions::statement_restrictions> _restrictions;
@@ -254,6 +282,19 @@ class result_set_builder {
         mutable uint64_t _rows_fetched_for_last_partition;
         mutable std::optional<partition_key> _last_pkey;
         mutable bool _is_first_partition_on_page = true;
+        // Restrictions on regular columns which were compiled into columnar kernels.
+        // Rows are then passed to evaluate_block() in blocks, and do_filter() only
+        // looks up the result computed for the row in _block_matches. Held by value,
+        // so that copies of the filter don't share the loaded blocks.
+        mutable std::optional<expr::columnar_filter> _columnar_filter;
+        std::vector<const column_definition*> _columnar_columns;
+        // For each regular column of the selection, up to the last one with kernels,
+        // the index of the column in _columnar_columns, or -1. Empty unless blocks
+        // are being evaluated.
+        std::vector<std::pair<const column_definition*, int>> _columnar_load_order;
+        mutable uint64_t _block_matches = 0;
+        mutable size_t _block_row = 0;
+        mutable bool _block_row_matches = true;
     public:
         explicit restrictions_filter(::shared_ptr<restrictions::statement_restrictions> restrictions,
                 const query_options& options,
@@ -267,6 +308,11 @@ class result_set_builder {
         uint64_t get_rows_dropped() const {
             return _rows_dropped;
         }
+        // Returns true iff rows should be passed to evaluate_block() before being filtered.
+        bool start_block_evaluation(const selection& selection);
+        // Evaluates the compiled restrictions for the rows which will be passed, in the
+        // same order, to the following operator() calls.
+        void evaluate_block(const selection& selection, std::span<const query::result_row_view> rows) const;
     private:
         bool do_filter(const selection& selection, const std::vector<bytes>& pk, const std::vector<bytes>& ck, const query::result_row_view& static_row, const query::result_row_view* row) const;
     };
@@ -293,14 +339,22 @@ class result_set_builder {
         std::vector<bytes> _partition_key;
         std::vector<bytes> _clustering_key;
         Filter _filter;
+        // Rows of the current partition waiting to be filtered as a block, see Filter::evaluate_block()
+        bool _evaluate_blocks;
+        std::vector<query::result_row_view> _pending_rows;
+        std::vector<std::optional<std::vector<bytes>>> _pending_clustering_keys;
+        std::optional<query::result_row_view> _pending_static_row;
     public:
+        static constexpr size_t block_size = 64;
+
         visitor(cql3::selection::result_set_builder& builder, const schema& s,
                 const selection& selection, Filter filter = Filter())
             : _builder(builder)
             , _schema(s)
             , _selection(selection)
             , _row_count(0)
-            , _filter(filter)
+            , _filter(std::move(filter))
+            , _evaluate_blocks(_filter.start_block_evaluation(selection))
         {}
         visitor(visitor&&) = default;
 
@@ -334,11 +388,69 @@ class result_set_builder {
         }
 
         void accept_new_row(const clustering_key& key, const query::result_row_view& static_row, const query::result_row_view& row) {
+            if (_evaluate_blocks) {
+                add_pending_row(key.explode(_schema), static_row, row);
+                return;
+            }
             _clustering_key = key.explode(_schema);
-            accept_new_row(static_row, row);
+            process_row(static_row, row);
         }
 
         void accept_new_row(const query::result_row_view& static_row, const query::result_row_view& row) {
+            if (_evaluate_blocks) {
+                add_pending_row(std::nullopt, static_row, row);
+                return;
+            }
+            process_row(static_row, row);
+        }
+
+        uint64_t accept_partition_end(const query::result_row_view& static_row) {
+            flush_pending_rows();
+            if (_row_count == 0) {
+                if (!_filter(_selection, _partition_key, _clustering_key, static_row, nullptr)) {
+                    return _filter.get_rows_dropped();
+                }
+                _builder.new_row();
+                auto static_row_iterator = static_row.iterator();
+                for (auto&& def : _selection.get_columns()) {
+                    if (def->is_partition_key()) {
+                        _builder.add(_partition_key[def->component_index()]);
+                    } else if (def->is_static()) {
+                        add_value(*def, static_row_iterator);
+                    } else {
+                        _builder.add_empty();
+                    }
+                }
+            }
+            return _filter.get_rows_dropped();
+        }
+    private:
+        void add_pending_row(std::optional<std::vector<bytes>> clustering_key,
+                const query::result_row_view& static_row, const query::result_row_view& row) {
+            _pending_rows.push_back(row);
+            _pending_clustering_keys.push_back(std::move(clustering_key));
+            _pending_static_row = static_row;
+            if (_pending_rows.size() == block_size) {
+                flush_pending_rows();
+            }
+        }
+
+        void flush_pending_rows() {
+            if (_pending_rows.empty()) {
+                return;
+            }
+            _filter.evaluate_block(_selection, _pending_rows);
+            for (size_t i = 0; i < _pending_rows.size(); ++i) {
+                if (_pending_clustering_keys[i]) {
+                    _clustering_key = std::move(*_pending_clustering_keys[i]);
+                }
+                process_row(*_pending_static_row, _pending_rows[i]);
+            }
+            _pending_rows.clear();
+            _pending_clustering_keys.clear();
+        }
+
+        void process_row(const query::result_row_view& static_row, const query::result_row_view& row) {
             auto static_row_iterator = static_row.iterator();
             auto row_iterator = row.iterator();
             if (!_filter(_selection, _partition_key, _clustering_key, static_row, &row)) {
@@ -368,26 +480,6 @@ class result_set_builder {
                 }
             }
         }
-
-        uint64_t accept_partition_end(const query::result_row_view& static_row) {
-            if (_row_count == 0) {
-                if (!_filter(_selection, _partition_key, _clustering_key, static_row, nullptr)) {
-                    return _filter.get_rows_dropped();
-                }
-                _builder.new_row();
-                auto static_row_iterator = static_row.iterator();
-                for (auto&& def : _selection.get_columns()) {
-                    if (def->is_partition_key()) {
-                        _builder.add(_partition_key[def->component_index()]);
-                    } else if (def->is_static()) {
-                        add_value(*def, static_row_iterator);
-                    } else {
-                        _builder.add_empty();
-                    }
-                }
-            }
-            return _filter.get_rows_dropped();
-        }
     };
 
 private:
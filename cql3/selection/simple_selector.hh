@@ -118,6 +118,11 @@ class simple_selector : public selector {
         return _column_name;
     }
 
+    /// The index of the selected column in the selection.
+    uint32_t index() const {
+        return _idx;
+    }
+
 #if 0
     @Override
     public String toString()
@@ -48,6 +48,7 @@
 #include <vector>
 
 #include "exceptions/exceptions.hh"
+#include "bytes.hh"
 
 namespace cql3 {
 
@@ -72,6 +73,8 @@ class prepared_statement : public seastar::weakly_referencable<prepared_statemen
     const std::vector<seastar::lw_shared_ptr<column_specification>> bound_names;
     std::vector<uint16_t> partition_key_bind_indices;
     std::vector<sstring> warnings;
+    // Set when the statement is added to the prepared statements cache.
+    bytes result_metadata_id;
 
     prepared_statement(seastar::shared_ptr<cql_statement> statement_, std::vector<seastar::lw_shared_ptr<column_specification>> bound_names_,
                        std::vector<uint16_t> partition_key_bind_indices, std::vector<sstring> warnings = {});
@@ -45,6 +45,7 @@
 #include "transport/messages/result_message.hh"
 #include "cql3/functions/as_json_function.hh"
 #include "cql3/selection/selection.hh"
+#include "cql3/functions/aggregate_function.hh"
 #include "cql3/util.hh"
 #include "cql3/restrictions/single_column_primary_key_restrictions.hh"
 #include "cql3/restrictions/statement_restrictions.hh"
@@ -376,6 +377,17 @@ select_statement::do_execute(query_processor& qp,
         return execute(qp, command, std::move(key_ranges), state, options, now);
     }
 
+    // Full scans computing only aggregates can leave the aggregation to the replicas,
+    // which then send their partial results instead of their rows. Internal keyspaces
+    // are left out: some of their tables are local or virtual, and can't be read
+    // on the replicas of a vnode.
+    if (_range_scan && _ks_sel == ks_selector::NONSYSTEM && _selection->is_aggregate() && !has_group_by() && !_restrictions_need_filtering
+            && qp.proxy().features().cluster_supports_parallelized_aggregation()) {
+        if (auto aggregates = _selection->get_reducible_aggregates()) {
+            return execute_with_partial_aggregation(qp, command, std::move(key_ranges), state, options, std::move(*aggregates));
+        }
+    }
+
     command->slice.options.set<query::partition_slice::option::allow_short_read>();
     auto timeout_duration = get_timeout(state.get_client_state(), options);
     auto timeout = db::timeout_clock::now() + timeout_duration;
@@ -447,6 +459,47 @@ select_statement::do_execute(query_processor& qp,
             });
 }
 
+future<shared_ptr<cql_transport::messages::result_message>>
+select_statement::execute_with_partial_aggregation(query_processor& qp,
+                          lw_shared_ptr<query::read_command> cmd,
+                          dht::partition_range_vector&& partition_ranges,
+                          service::query_state& state,
+                          const query_options& options,
+                          std::vector<selection::selection::reducible_aggregate> aggregates) const
+{
+    std::vector<query::forward_request::aggregation_info> aggregations;
+    aggregations.reserve(aggregates.size());
+    for (auto& agg : aggregates) {
+        auto& info = aggregations.emplace_back(query::forward_request::aggregation_info{agg.function->name().keyspace, agg.function->name().name, {}});
+        for (auto column : agg.arguments) {
+            info.column_names.push_back(column->name());
+        }
+    }
+    std::vector<bytes> column_names;
+    column_names.reserve(_selection->get_column_count());
+    for (auto column : _selection->get_columns()) {
+        column_names.push_back(column->name());
+    }
+    query::forward_request req{std::move(aggregations), std::move(column_names), *cmd, std::move(partition_ranges), options.get_consistency()};
+
+    auto timeout = get_timeout(state.get_client_state(), options);
+    return qp.proxy().query_partial_aggregates(std::move(req), timeout, state.get_trace_state()).then(
+            [this, aggregates = std::move(aggregates), sf = options.get_cql_serialization_format()] (query::forward_result partial) {
+        std::vector<bytes_opt> row;
+        row.reserve(aggregates.size());
+        for (size_t i = 0; i < aggregates.size(); ++i) {
+            auto agg = aggregates[i].function->new_aggregate();
+            agg->merge_state(partial.query_results[i]);
+            row.push_back(agg->compute(sf));
+        }
+        auto rs = std::make_unique<result_set>(::make_shared<metadata>(*_selection->get_result_metadata()));
+        rs->add_row(std::move(row));
+        update_stats_rows_read(rs->size());
+        auto msg = ::make_shared<cql_transport::messages::result_message::rows>(result(std::move(rs)));
+        return shared_ptr<cql_transport::messages::result_message>(std::move(msg));
+    });
+}
+
 template<typename KeyType>
 requires (std::is_same_v<KeyType, partition_key> || std::is_same_v<KeyType, clustering_key_prefix>)
 static KeyType
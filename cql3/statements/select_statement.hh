@@ -138,6 +138,11 @@ protected :
         lw_shared_ptr<query::read_command> cmd, dht::partition_range_vector&& partition_ranges, service::query_state& state,
          const query_options& options, gc_clock::time_point now) const;
 
+    // Computes the aggregates of the selection with partial aggregates computed by the replicas.
+    future<::shared_ptr<cql_transport::messages::result_message>> execute_with_partial_aggregation(query_processor& qp,
+        lw_shared_ptr<query::read_command> cmd, dht::partition_range_vector&& partition_ranges, service::query_state& state,
+        const query_options& options, std::vector<selection::selection::reducible_aggregate> aggregates) const;
+
     struct primary_key {
         dht::decorated_key partition;
         clustering_key_prefix clustering;
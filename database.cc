@@ -31,6 +31,9 @@
 #include "cql3/functions/functions.hh"
 #include <seastar/core/seastar.hh>
 #include <seastar/core/coroutine.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/coroutine/maybe_yield.hh>
 #include <seastar/core/reactor.hh>
 #include <seastar/core/metrics.hh>
 #include <boost/algorithm/string/split.hpp>
@@ -45,6 +48,7 @@
 #include <boost/range/algorithm/sort.hpp>
 #include <boost/range/algorithm/min_element.hpp>
 #include <boost/container/static_vector.hpp>
+#include <sstream>
 #include "frozen_mutation.hh"
 #include <seastar/core/do_with.hh>
 #include "service/migration_listener.hh"
@@ -218,7 +222,10 @@ void database::setup_scylla_memory_diagnostics_producer() {
         writeln("  used:      {}\n", utils::to_hr_size(lsa_occupancy_stats.used_space()));
         writeln("  free:      {}\n\n", utils::to_hr_size(lsa_occupancy_stats.free_space()));
 
-        const auto row_cache_occupancy_stats = _row_cache_tracker.region().occupancy();
+        logalloc::occupancy_stats row_cache_occupancy_stats;
+        for_each_row_cache_tracker([&] (cache_tracker& tracker) {
+            row_cache_occupancy_stats += tracker.region().occupancy();
+        });
         writeln("Cache:\n");
         writeln("  total: {}\n", utils::to_hr_size(row_cache_occupancy_stats.total_space()));
         writeln("  used:  {}\n", utils::to_hr_size(row_cache_occupancy_stats.used_space()));
@@ -354,8 +361,10 @@ database::database(const db::config& cfg, database_config dbcfg, service::migrat
               _cfg.compaction_large_cell_warning_threshold_mb()*1024*1024,
               _cfg.compaction_rows_count_warning_threshold()))
     , _nop_large_data_handler(std::make_unique<db::nop_large_data_handler>())
-    , _user_sstables_manager(std::make_unique<sstables::sstables_manager>(*_large_data_handler, _cfg, feat, _row_cache_tracker))
-    , _system_sstables_manager(std::make_unique<sstables::sstables_manager>(*_nop_large_data_handler, _cfg, feat, _row_cache_tracker))
+    , _user_sstables_manager(std::make_unique<sstables::sstables_manager>(*_large_data_handler, _cfg, feat, _row_cache_tracker,
+            dbcfg.compaction_scheduling_group))
+    , _system_sstables_manager(std::make_unique<sstables::sstables_manager>(*_nop_large_data_handler, _cfg, feat, _row_cache_tracker,
+            dbcfg.compaction_scheduling_group))
     , _result_memory_limiter(dbcfg.available_memory / 10)
     , _data_listeners(std::make_unique<db::data_listeners>())
     , _mnotifier(mn)
@@ -371,6 +380,10 @@ database::database(const db::config& cfg, database_config dbcfg, service::migrat
     setup_metrics();
 
     _row_cache_tracker.set_compaction_scheduling_group(dbcfg.memory_compaction_scheduling_group);
+    _row_cache_tracker.set_eviction_policy(_cfg.row_cache_eviction_policy() == "second_chance"
+            ? eviction_policy::second_chance : eviction_policy::lru);
+    _row_cache_tracker.set_admission_filter(_cfg.row_cache_admission_filter_size());
+    _row_cache_tracker.set_cold_partition_compression(_cfg.row_cache_compress_cold_partitions());
 
     setup_scylla_memory_diagnostics_producer();
     if (_dbcfg.sstables_format) {
@@ -864,15 +877,46 @@ void database::drop_keyspace(const sstring& name) {
     _keyspaces.erase(name);
 }
 
+cache_tracker& database::row_cache_tracker_for(const schema& s) {
+    const auto& quotas = _cfg.row_cache_quotas();
+    auto i = quotas.find(format("{}.{}", s.ks_name(), s.cf_name()));
+    if (i == quotas.end()) {
+        i = quotas.find(s.ks_name());
+        if (i == quotas.end()) {
+            return _row_cache_tracker;
+        }
+    }
+    auto& tracker = _quota_cache_trackers[i->first];
+    if (!tracker) {
+        size_t quota_mb;
+        try {
+            quota_mb = std::stoull(i->second);
+        } catch (...) {
+            dblog.warn("Ignoring invalid row cache quota for {}: {}", i->first, i->second);
+            _quota_cache_trackers.erase(i->first);
+            return _row_cache_tracker;
+        }
+        tracker = std::make_unique<cache_tracker>();
+        tracker->set_compaction_scheduling_group(_dbcfg.memory_compaction_scheduling_group);
+        tracker->set_eviction_policy(_row_cache_tracker.get_lru().policy());
+        tracker->set_admission_filter(_cfg.row_cache_admission_filter_size());
+        tracker->set_cold_partition_compression(_cfg.row_cache_compress_cold_partitions());
+        tracker->set_memory_quota(quota_mb * 1024 * 1024 / smp::count);
+        dblog.info("Using a row cache of {} MB per node for {}", quota_mb, i->first);
+    }
+    return *tracker;
+}
+
 void database::add_column_family(keyspace& ks, schema_ptr schema, column_family::config cfg) {
     schema = local_schema_registry().learn(schema);
     schema->registry_entry()->mark_synced();
 
+    auto& row_cache_tracker = row_cache_tracker_for(*schema);
     lw_shared_ptr<column_family> cf;
     if (cfg.enable_commitlog && _commitlog) {
-       cf = make_lw_shared<column_family>(schema, std::move(cfg), *_commitlog, *_compaction_manager, *_cl_stats, _row_cache_tracker);
+       cf = make_lw_shared<column_family>(schema, std::move(cfg), *_commitlog, *_compaction_manager, *_cl_stats, row_cache_tracker);
     } else {
-       cf = make_lw_shared<column_family>(schema, std::move(cfg), column_family::no_commitlog(), *_compaction_manager, *_cl_stats, _row_cache_tracker);
+       cf = make_lw_shared<column_family>(schema, std::move(cfg), column_family::no_commitlog(), *_compaction_manager, *_cl_stats, row_cache_tracker);
     }
     cf->set_durable_writes(ks.metadata()->durable_writes());
 
@@ -1113,8 +1157,14 @@ keyspace::make_column_family_config(const schema& s, const database& db) const {
     cfg.enable_disk_writes = _config.enable_disk_writes;
     cfg.enable_commitlog = _config.enable_commitlog;
     cfg.enable_cache = _config.enable_cache;
+    if (db_config.row_cache_save_period() && !is_system_table(s)) {
+        cfg.hot_partitions_to_track = db_config.row_cache_keys_to_save();
+    }
     cfg.enable_dangerous_direct_import_of_cassandra_counters = _config.enable_dangerous_direct_import_of_cassandra_counters;
     cfg.compaction_enforce_min_threshold = _config.compaction_enforce_min_threshold;
+    cfg.compaction_sub_range_parallelism = _config.compaction_sub_range_parallelism;
+    cfg.memtable_flush_sub_range_parallelism = _config.memtable_flush_sub_range_parallelism;
+    cfg.enable_columnar_memtable_rows = _config.enable_columnar_memtable_rows;
     cfg.dirty_memory_manager = _config.dirty_memory_manager;
     cfg.streaming_read_concurrency_semaphore = _config.streaming_read_concurrency_semaphore;
     cfg.compaction_concurrency_semaphore = _config.compaction_concurrency_semaphore;
@@ -1645,7 +1695,7 @@ future<> memtable_list::flush() {
 }
 
 lw_shared_ptr<memtable> memtable_list::new_memtable() {
-    return make_lw_shared<memtable>(_current_schema(), *_dirty_memory_manager, _table_stats, this, _compaction_scheduling_group);
+    return make_lw_shared<memtable>(_current_schema(), *_dirty_memory_manager, _table_stats, this, _compaction_scheduling_group, _columnar_rows());
 }
 
 future<flush_permit> flush_permit::reacquire_sstable_write_permit() && {
@@ -1722,13 +1772,23 @@ future<> database::apply_in_memory(const frozen_mutation& m, schema_ptr m_schema
     data_listeners().on_write(m_schema, m);
 
     return with_gate(cf.async_gate(), [this, &m, m_schema = std::move(m_schema), h = std::move(h), &cf, timeout] () mutable -> future<> {
-        return cf.apply(m, std::move(m_schema), std::move(h), timeout);
+        if (data_listeners().empty()) {
+            return cf.apply(m, std::move(m_schema), std::move(h), timeout);
+        }
+        return cf.apply(m, m_schema, std::move(h), timeout).then([this, &m, m_schema] {
+            data_listeners().on_change(m_schema, dht::partition_range::make_singular(m.decorated_key(*m_schema)));
+        });
     });
 }
 
 future<> database::apply_in_memory(const mutation& m, column_family& cf, db::rp_handle&& h, db::timeout_clock::time_point timeout) {
     return with_gate(cf.async_gate(), [this, &m, h = std::move(h), &cf, timeout]() mutable -> future<> {
-        return cf.apply(m, std::move(h), timeout);
+        if (data_listeners().empty()) {
+            return cf.apply(m, std::move(h), timeout);
+        }
+        return cf.apply(m, std::move(h), timeout).then([this, &m] {
+            data_listeners().on_change(m.schema(), dht::partition_range::make_singular(m.decorated_key()));
+        });
     });
 }
 
@@ -1881,6 +1941,9 @@ database::make_keyspace_config(const keyspace_metadata& ksm) {
     }
     cfg.enable_dangerous_direct_import_of_cassandra_counters = _cfg.enable_dangerous_direct_import_of_cassandra_counters();
     cfg.compaction_enforce_min_threshold = _cfg.compaction_enforce_min_threshold;
+    cfg.compaction_sub_range_parallelism = _cfg.compaction_sub_range_parallelism;
+    cfg.memtable_flush_sub_range_parallelism = _cfg.memtable_flush_sub_range_parallelism;
+    cfg.enable_columnar_memtable_rows = _cfg.enable_columnar_memtable_rows;
     cfg.dirty_memory_manager = &_dirty_memory_manager;
     cfg.streaming_read_concurrency_semaphore = &_streaming_concurrency_sem;
     cfg.compaction_concurrency_semaphore = &_compaction_concurrency_sem;
@@ -1993,9 +2056,194 @@ future<> database::start() {
     co_await init_commitlog();
 }
 
+// Saved caches are replaced atomically, so that a crash while saving leaves the previous copy intact.
+static future<> write_saved_cache(sstring path, sstring contents) {
+    auto tmp_path = path + ".tmp";
+    auto f = co_await open_file_dma(tmp_path, open_flags::wo | open_flags::create | open_flags::truncate);
+    auto out = co_await make_file_output_stream(std::move(f));
+    std::exception_ptr ex;
+    try {
+        co_await out.write(contents.data(), contents.size());
+        co_await out.flush();
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    co_await out.close();
+    if (ex) {
+        std::rethrow_exception(std::move(ex));
+    }
+    co_await rename_file(tmp_path, path);
+}
+
+static future<std::optional<sstring>> read_saved_cache(sstring path) {
+    if (!co_await file_exists(path)) {
+        co_return std::nullopt;
+    }
+    auto f = co_await open_file_dma(path, open_flags::ro);
+    auto in = make_file_input_stream(std::move(f));
+    sstring contents;
+    std::exception_ptr ex;
+    try {
+        while (auto buf = co_await in.read()) {
+            contents.append(buf.get(), buf.size());
+        }
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    co_await in.close();
+    if (ex) {
+        std::rethrow_exception(std::move(ex));
+    }
+    co_return contents;
+}
+
+sstring database::saved_cache_path(std::string_view name) const {
+    return format("{}/{}-{}.txt", _cfg.saved_caches_directory(), name, this_shard_id());
+}
+
+future<> database::save_index_cache() {
+    auto path = saved_cache_path("index_cache");
+    try {
+        co_await write_saved_cache(path, co_await _user_sstables_manager->describe_index_cache());
+    } catch (...) {
+        dblog.warn("Failed to save index cache to {}: {}", path, std::current_exception());
+    }
+}
+
+future<> database::run_index_cache_persistence() {
+    auto path = saved_cache_path("index_cache");
+    try {
+        if (auto saved = co_await read_saved_cache(path)) {
+            auto bandwidth = uint64_t(_cfg.index_cache_preload_bandwidth_mb_per_sec()) << 20;
+            co_await _user_sstables_manager->preload_index_cache(std::move(*saved), bandwidth, _cache_persistence_as);
+        }
+    } catch (const sleep_aborted&) {
+        co_return;
+    } catch (...) {
+        dblog.warn("Failed to preload index cache from {}: {}", path, std::current_exception());
+    }
+    // With a zero period the cache is saved on shutdown only.
+    while (_cfg.key_cache_save_period() && !_cache_persistence_as.abort_requested()) {
+        try {
+            co_await sleep_abortable<lowres_clock>(std::chrono::seconds(_cfg.key_cache_save_period()), _cache_persistence_as);
+        } catch (const sleep_aborted&) {
+            co_return;
+        }
+        co_await save_index_cache();
+    }
+}
+
+// The saved row cache keys have one line per partition:
+//
+//   <table id> <partition key in hex>
+//
+// Tables are listed in no particular order, and the keys of each table hottest first.
+future<> database::save_row_cache_keys() {
+    auto path = saved_cache_path("row_cache_keys");
+    try {
+        std::ostringstream out;
+        auto tables = boost::copy_range<std::vector<lw_shared_ptr<column_family>>>(_column_families | boost::adaptors::map_values);
+        for (auto& t : tables) {
+            for (auto& dk : t->get_row_cache().hot_partitions(_cfg.row_cache_keys_to_save())) {
+                out << t->schema()->id() << ' ' << to_hex(to_bytes(dk.key().representation())) << '\n';
+            }
+            co_await coroutine::maybe_yield();
+        }
+        co_await write_saved_cache(path, sstring(out.str()));
+    } catch (...) {
+        dblog.warn("Failed to save row cache keys to {}: {}", path, std::current_exception());
+    }
+}
+
+// Reads the saved partitions through the regular read path, which populates the cache.
+// Partitions of tables which no longer exist, or which now belong to another shard, are skipped.
+future<> database::warm_up_row_cache(sstring saved) {
+    std::istringstream in(std::string(saved.begin(), saved.end()));
+    std::string id, key;
+    size_t partitions = 0;
+    while (in >> id >> key && !_cache_persistence_as.abort_requested()) {
+        try {
+            auto uuid = utils::UUID(sstring_view(id));
+            auto it = _column_families.find(uuid);
+            if (it == _column_families.end() || !it->second->cache_enabled()) {
+                continue;
+            }
+            auto t = it->second;
+            auto s = t->schema();
+            auto dk = dht::decorate_key(*s, partition_key::from_bytes(from_hex(key)));
+            if (dht::shard_of(*s, dk.token()) != this_shard_id()) {
+                continue;
+            }
+            auto permit = co_await _streaming_concurrency_sem.obtain_permit(s.get(), "row-cache-warm-up", t->estimate_read_memory_cost(), db::no_timeout);
+            auto range = dht::partition_range::make_singular(dk);
+            auto slice = s->full_slice();
+            slice.options.set<query::partition_slice::option::cache_warm_up>();
+            auto rd = t->make_reader(s, std::move(permit), range, slice, service::get_local_streaming_priority(),
+                    nullptr, streamed_mutation::forwarding::no, mutation_reader::forwarding::no);
+            std::exception_ptr ex;
+            try {
+                co_await rd.consume_pausable([] (mutation_fragment) { return stop_iteration::no; });
+            } catch (...) {
+                ex = std::current_exception();
+            }
+            co_await rd.close();
+            if (ex) {
+                std::rethrow_exception(std::move(ex));
+            }
+            ++partitions;
+        } catch (...) {
+            dblog.debug("Failed to warm up row cache with partition {} of table {}: {}", key, id, std::current_exception());
+        }
+    }
+    dblog.info("Warmed up row cache with {} saved partitions", partitions);
+}
+
+future<> database::run_row_cache_persistence() {
+    auto path = saved_cache_path("row_cache_keys");
+    try {
+        if (auto saved = co_await read_saved_cache(path)) {
+            co_await warm_up_row_cache(std::move(*saved));
+        }
+    } catch (...) {
+        dblog.warn("Failed to warm up row cache from {}: {}", path, std::current_exception());
+    }
+    while (!_cache_persistence_as.abort_requested()) {
+        try {
+            co_await sleep_abortable<lowres_clock>(std::chrono::seconds(_cfg.row_cache_save_period()), _cache_persistence_as);
+        } catch (const sleep_aborted&) {
+            co_return;
+        }
+        co_await save_row_cache_keys();
+    }
+}
+
+void database::start_cache_persistence() {
+    if (_cfg.enable_index_cache_persistence()) {
+        _index_cache_persistence_done = run_index_cache_persistence();
+    }
+    if (_cfg.row_cache_save_period()) {
+        _row_cache_persistence_done = with_scheduling_group(_dbcfg.streaming_scheduling_group, [this] {
+            return run_row_cache_persistence();
+        });
+    }
+}
+
+future<> database::stop_cache_persistence() {
+    _cache_persistence_as.request_abort();
+    co_await std::exchange(_index_cache_persistence_done, make_ready_future<>());
+    co_await std::exchange(_row_cache_persistence_done, make_ready_future<>());
+    if (_cfg.enable_index_cache_persistence()) {
+        co_await save_index_cache();
+    }
+    if (_cfg.row_cache_save_period()) {
+        co_await save_row_cache_keys();
+    }
+}
+
 future<> database::shutdown() {
     _shutdown = true;
     co_await _compaction_manager->stop();
+    co_await stop_cache_persistence();
     co_await _stop_barrier.arrive_and_wait();
     // Closing a table can cause us to find a large partition. Since we want to record that, we have to close
     // system.large_partitions after the regular tables.
@@ -2351,7 +2599,7 @@ template <typename T>
 using foreign_unique_ptr = foreign_ptr<std::unique_ptr<T>>;
 
 flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db, schema_ptr schema, reader_permit permit,
-        std::function<std::optional<dht::partition_range>()> range_generator) {
+        std::function<std::optional<dht::partition_range>()> range_generator, table::unrepaired_only only_unrepaired) {
     class streaming_reader_lifecycle_policy
             : public reader_lifecycle_policy
             , public enable_shared_from_this<streaming_reader_lifecycle_policy> {
@@ -2362,9 +2610,11 @@ flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db,
         };
         distributed<database>& _db;
         utils::UUID _table_id;
+        table::unrepaired_only _only_unrepaired;
         std::vector<reader_context> _contexts;
     public:
-        streaming_reader_lifecycle_policy(distributed<database>& db, utils::UUID table_id) : _db(db), _table_id(table_id), _contexts(smp::count) {
+        streaming_reader_lifecycle_policy(distributed<database>& db, utils::UUID table_id, table::unrepaired_only only_unrepaired)
+                : _db(db), _table_id(table_id), _only_unrepaired(only_unrepaired), _contexts(smp::count) {
         }
         virtual flat_mutation_reader create_reader(
                 schema_ptr schema,
@@ -2381,7 +2631,7 @@ flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db,
             _contexts[shard].read_operation = make_foreign(std::make_unique<utils::phased_barrier::operation>(cf.read_in_progress()));
             _contexts[shard].semaphore = &cf.streaming_read_concurrency_semaphore();
 
-            return cf.make_streaming_reader(std::move(schema), std::move(permit), *_contexts[shard].range, slice, fwd_mr);
+            return cf.make_streaming_reader(std::move(schema), std::move(permit), *_contexts[shard].range, slice, fwd_mr, _only_unrepaired);
         }
         virtual void update_read_range(lw_shared_ptr<const dht::partition_range> range) override {
             const auto shard = this_shard_id();
@@ -2408,7 +2658,7 @@ flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db,
             return semaphore().obtain_permit(schema.get(), description, cf.estimate_read_memory_cost(), timeout);
         }
     };
-    auto ms = mutation_source([&db] (schema_ptr s,
+    auto ms = mutation_source([&db, only_unrepaired] (schema_ptr s,
             reader_permit permit,
             const dht::partition_range& pr,
             const query::partition_slice& ps,
@@ -2417,7 +2667,7 @@ flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db,
             streamed_mutation::forwarding,
             mutation_reader::forwarding fwd_mr) {
         auto table_id = s->id();
-        return make_multishard_combining_reader(make_shared<streaming_reader_lifecycle_policy>(db, table_id), std::move(s), std::move(permit), pr, ps, pc,
+        return make_multishard_combining_reader(make_shared<streaming_reader_lifecycle_policy>(db, table_id, only_unrepaired), std::move(s), std::move(permit), pr, ps, pc,
                 std::move(trace_state), fwd_mr);
     });
     auto&& full_slice = schema->full_slice();
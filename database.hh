@@ -173,6 +173,7 @@ class memtable_list {
     std::optional<shared_future<>> _flush_coalescing;
     seastar::scheduling_group _compaction_scheduling_group;
     table_stats& _table_stats;
+    utils::updateable_value<bool> _columnar_rows;
 public:
     using iterator = decltype(_memtables)::iterator;
     using const_iterator = decltype(_memtables)::const_iterator;
@@ -182,13 +183,15 @@ class memtable_list {
             std::function<schema_ptr()> cs,
             dirty_memory_manager* dirty_memory_manager,
             table_stats& table_stats,
-            seastar::scheduling_group compaction_scheduling_group = seastar::current_scheduling_group())
+            seastar::scheduling_group compaction_scheduling_group = seastar::current_scheduling_group(),
+            utils::updateable_value<bool> columnar_rows = utils::updateable_value<bool>(false))
         : _memtables({})
         , _seal_immediate_fn(seal_immediate_fn)
         , _current_schema(cs)
         , _dirty_memory_manager(dirty_memory_manager)
         , _compaction_scheduling_group(compaction_scheduling_group)
-        , _table_stats(table_stats) {
+        , _table_stats(table_stats)
+        , _columnar_rows(std::move(columnar_rows)) {
         add_memtable();
     }
 
@@ -368,9 +371,14 @@ class table : public enable_lw_shared_from_this<table> {
         bool enable_disk_writes = true;
         bool enable_disk_reads = true;
         bool enable_cache = true;
+        // Number of the most frequently read partitions the cache keeps track of, for warm-up after restart.
+        size_t hot_partitions_to_track = 0;
         bool enable_commitlog = true;
         bool enable_incremental_backups = false;
         utils::updateable_value<bool> compaction_enforce_min_threshold{false};
+        utils::updateable_value<uint32_t> compaction_sub_range_parallelism{1};
+        utils::updateable_value<uint32_t> memtable_flush_sub_range_parallelism{1};
+        utils::updateable_value<bool> enable_columnar_memtable_rows{false};
         bool enable_dangerous_direct_import_of_cassandra_counters = false;
         ::dirty_memory_manager* dirty_memory_manager = &default_dirty_memory_manager;
         reader_concurrency_semaphore* streaming_read_concurrency_semaphore;
@@ -432,6 +440,9 @@ class table : public enable_lw_shared_from_this<table> {
     // sstables that should not be compacted (e.g. because they need to be used
     // to generate view updates later)
     std::unordered_map<uint64_t, sstables::shared_sstable> _sstables_staging;
+    // Token ranges of this shard repaired by incremental repair, keyed by their end, with
+    // the time the repair of each started. Used to find sstables to mark as repaired.
+    std::map<dht::token, std::pair<dht::token_range, db_clock::time_point>> _repaired_ranges;
     // Control background fibers waiting for sstables to be deleted
     seastar::gate _sstable_deletion_gate;
     // This semaphore ensures that an operation like snapshot won't have its selected
@@ -472,6 +483,10 @@ class table : public enable_lw_shared_from_this<table> {
     // in dynamically
     std::unordered_map<gms::inet_address, cache_hit_rate> _cluster_cache_hit_rates;
 
+    // average number of rows per vnode range returned to range scans coordinated
+    // by this shard, used to size the concurrency of the next scans
+    std::optional<float> _range_scan_rows_per_range;
+
     // Operations like truncate, flush, query, etc, may depend on a column family being alive to
     // complete.  Some of them have their own gate already (like flush), used in specialized wait
     // logic. That is particularly useful if there is a particular
@@ -697,10 +712,18 @@ class table : public enable_lw_shared_from_this<table> {
     flat_mutation_reader make_streaming_reader(schema_ptr schema, reader_permit permit,
             const dht::partition_range_vector& ranges) const;
 
+    // Like the above, but reads the given sstables instead of the table's current ones.
+    flat_mutation_reader make_streaming_reader(schema_ptr schema, reader_permit permit,
+            const dht::partition_range_vector& ranges, lw_shared_ptr<sstables::sstable_set> sstables) const;
+
+    using unrepaired_only = bool_class<class unrepaired_only_tag>;
+
     // Single range overload.
+    // With unrepaired_only, sstables marked as repaired are not read, for incremental repair.
     flat_mutation_reader make_streaming_reader(schema_ptr schema, reader_permit permit, const dht::partition_range& range,
             const query::partition_slice& slice,
-            mutation_reader::forwarding fwd_mr = mutation_reader::forwarding::no) const;
+            mutation_reader::forwarding fwd_mr = mutation_reader::forwarding::no,
+            unrepaired_only only_unrepaired = unrepaired_only::no) const;
 
     flat_mutation_reader make_streaming_reader(schema_ptr schema, reader_permit permit, const dht::partition_range& range) {
         return make_streaming_reader(std::move(schema), std::move(permit), range, schema->full_slice());
@@ -874,6 +897,20 @@ class table : public enable_lw_shared_from_this<table> {
     std::vector<sstables::shared_sstable> select_sstables(const dht::partition_range& range) const;
     // Return all sstables but those that are off-strategy like the ones in maintenance set and staging dir.
     std::vector<sstables::shared_sstable> in_strategy_sstables() const;
+    // Returns a set of the sstables which are not marked as repaired.
+    lw_shared_ptr<sstables::sstable_set> make_unrepaired_sstable_set() const;
+    // Records that the data of this shard in the range was repaired by an incremental
+    // repair started at repair_start, and marks the sstables whose data is all covered
+    // by repairs started after they were written as repaired.
+    future<> mark_repaired(const dht::token_range& range, db_clock::time_point repair_start);
+    // Moves the sstable to level 0 and rewrites its Statistics. The sstable has to be
+    // registered as compacting, so that it's not removed from the sstable set meanwhile.
+    future<> send_sstable_to_level_0(sstables::shared_sstable sst);
+private:
+    // Returns the start time of the oldest of the repairs which cover all data of the
+    // sstable, if they all started after it was written.
+    std::optional<db_clock::time_point> repaired_at(const sstables::sstable& sst) const;
+public:
     size_t sstables_count() const;
     std::vector<uint64_t> sstable_count_per_level() const;
     int64_t get_unleveled_sstables() const;
@@ -932,6 +969,15 @@ class table : public enable_lw_shared_from_this<table> {
     cache_hit_rate get_hit_rate(gms::inet_address addr);
     void drop_hit_rate(gms::inet_address addr);
 
+    std::optional<float> get_range_scan_rows_per_range() const {
+        return _range_scan_rows_per_range;
+    }
+    // Accounts a round of a range scan which read `rows` rows from `ranges` vnode ranges.
+    void update_range_scan_rows_per_range(size_t ranges, uint64_t rows) {
+        const float rows_per_range = float(rows) / std::max(ranges, size_t(1));
+        _range_scan_rows_per_range = _range_scan_rows_per_range ? (*_range_scan_rows_per_range + rows_per_range) / 2 : rows_per_range;
+    }
+
     void enable_auto_compaction();
     future<> disable_auto_compaction();
     bool is_auto_compaction_disabled_by_user() const {
@@ -1090,6 +1136,9 @@ class keyspace {
         bool enable_cache = true;
         bool enable_incremental_backups = false;
         utils::updateable_value<bool> compaction_enforce_min_threshold{false};
+        utils::updateable_value<uint32_t> compaction_sub_range_parallelism{1};
+        utils::updateable_value<uint32_t> memtable_flush_sub_range_parallelism{1};
+        utils::updateable_value<bool> enable_columnar_memtable_rows{false};
         bool enable_dangerous_direct_import_of_cassandra_counters = false;
         ::dirty_memory_manager* dirty_memory_manager = &default_dirty_memory_manager;
         reader_concurrency_semaphore* streaming_read_concurrency_semaphore;
@@ -1272,6 +1321,9 @@ class database {
     db::timeout_semaphore _view_update_concurrency_sem{max_memory_pending_view_updates()};
 
     cache_tracker _row_cache_tracker;
+    // Trackers of the caches of keyspaces and tables with a quota, by their key
+    // in row_cache_quotas.
+    std::unordered_map<sstring, std::unique_ptr<cache_tracker>> _quota_cache_trackers;
 
     inheriting_concrete_execution_stage<
             future<>,
@@ -1318,8 +1370,22 @@ class database {
     std::unique_ptr<wasm::engine> _wasm_engine;
     utils::cross_shard_barrier _stop_barrier;
 
+    // Saving and reloading of cache contents across restarts,
+    // see enable_index_cache_persistence and row_cache_save_period.
+    abort_source _cache_persistence_as;
+    future<> _index_cache_persistence_done = make_ready_future<>();
+    future<> _row_cache_persistence_done = make_ready_future<>();
+
     class data_dictionary_impl;
     friend class data_dictionary_impl;
+
+    sstring saved_cache_path(std::string_view name) const;
+    future<> save_index_cache();
+    future<> run_index_cache_persistence();
+    future<> save_row_cache_keys();
+    future<> warm_up_row_cache(sstring saved);
+    future<> run_row_cache_persistence();
+    future<> stop_cache_persistence();
 public:
     data_dictionary::database as_data_dictionary() const;
     future<> init_commitlog();
@@ -1394,6 +1460,18 @@ class database {
     ~database();
 
     cache_tracker& row_cache_tracker() { return _row_cache_tracker; }
+    // Returns the tracker for the cache of the given table, which is separate
+    // from row_cache_tracker() if the table or its keyspace has a cache quota.
+    cache_tracker& row_cache_tracker_for(const schema&);
+    // Calls func for the tracker of the shared cache and the trackers of caches
+    // with a quota.
+    template <typename Func>
+    void for_each_row_cache_tracker(Func&& func) {
+        func(_row_cache_tracker);
+        for (auto& [key, tracker] : _quota_cache_trackers) {
+            func(*tracker);
+        }
+    }
     future<> drop_caches() const;
 
     void update_version(const utils::UUID& version);
@@ -1465,6 +1543,10 @@ class database {
     /// the normal concurrency.
     void revert_initial_system_read_concurrency_boost();
     future<> start();
+    // Reloads the index pages and row cache partitions saved by the previous run in the background,
+    // and starts saving them periodically. Does nothing unless enable_index_cache_persistence
+    // or row_cache_save_period are set. Must be called after the tables are populated.
+    void start_cache_persistence();
     future<> shutdown();
     future<> stop();
     future<> close_tables(table_kind kind_to_close);
@@ -1615,6 +1697,7 @@ future<> start_large_data_handler(sharded<database>& db);
 // Shard readers are created via `table::make_streaming_reader()`.
 // Range generator must generate disjoint, monotonically increasing ranges.
 flat_mutation_reader make_multishard_streaming_reader(distributed<database>& db, schema_ptr schema, reader_permit permit,
-        std::function<std::optional<dht::partition_range>()> range_generator);
+        std::function<std::optional<dht::partition_range>()> range_generator,
+        table::unrepaired_only only_unrepaired = table::unrepaired_only::no);
 
 bool is_internal_keyspace(std::string_view name);
@@ -25,10 +25,14 @@
 #include "utils/logalloc.hh"
 #include "partition_version.hh"
 #include "mutation_cleaner.hh"
+#include "utils/UUID.hh"
+#include "utils/frequency_sketch.hh"
 
 #include <seastar/core/metrics_registration.hh>
+#include <seastar/core/timer.hh>
 
 #include <stdint.h>
+#include <unordered_map>
 
 class cache_entry;
 
@@ -79,11 +83,22 @@ class cache_tracker final {
         uint64_t pinned_dirty_memory_overload;
         uint64_t range_tombstone_reads;
         uint64_t row_tombstone_reads;
+        uint64_t admission_rejections;
+        uint64_t partition_compressions;
+        uint64_t partition_decompressions;
+        uint64_t compressed_partitions;
+        uint64_t compressed_bytes;
 
         uint64_t active_reads() const {
             return reads - reads_done;
         }
     };
+    // Statistics of the cache of a single table.
+    struct table_stats {
+        uint64_t partition_evictions = 0;
+        // Number of row_cache instances of the table using this tracker.
+        unsigned caches = 0;
+    };
 private:
     stats _stats{};
     seastar::metrics::metric_groups _metrics;
@@ -91,8 +106,25 @@ class cache_tracker final {
     lru _lru;
     mutation_cleaner _garbage;
     mutation_cleaner _memtable_cleaner;
+    // Maximum memory used by cached data, 0 if unlimited.
+    size_t _memory_quota = 0;
+    // Armed when the quota is exceeded, evicts down to the quota.
+    timer<> _quota_timer;
+    std::unordered_map<utils::UUID, table_stats> _table_stats;
+    // Recent reads of partitions, engaged when the admission filter is enabled.
+    std::unique_ptr<utils::frequency_sketch> _admission_sketch;
+    bool _compress_cold_partitions = false;
+    // Armed on eviction, compresses the least recently used partitions.
+    timer<> _compression_timer;
+    logalloc::allocating_section _compression_section;
 private:
     void setup_metrics();
+    void enforce_memory_quota() noexcept;
+    void maybe_enforce_memory_quota() noexcept;
+    void maybe_compress_cold_partitions() noexcept;
+    void compress_cold_partitions() noexcept;
+    bool compress_coldest_partition();
+    bool compress(cache_entry&);
 public:
     using register_metrics = bool_class<class register_metrics_tag>;
     cache_tracker(mutation_application_stats&, register_metrics);
@@ -110,7 +142,7 @@ class cache_tracker final {
     void on_partition_merge() noexcept;
     void on_partition_hit() noexcept;
     void on_partition_miss() noexcept;
-    void on_partition_eviction() noexcept;
+    void on_partition_eviction(const schema&) noexcept;
     void on_row_eviction() noexcept;
     void on_row_hit() noexcept;
     void on_dummy_row_hit() noexcept;
@@ -132,6 +164,35 @@ class cache_tracker final {
     const stats& get_stats() const noexcept { return _stats; }
     void set_compaction_scheduling_group(seastar::scheduling_group);
     lru& get_lru() { return _lru; }
+    void set_eviction_policy(eviction_policy policy) noexcept { _lru.set_policy(policy); }
+    // Limits the memory used by cached data. When the limit is exceeded, entries
+    // are evicted in the background, in eviction policy order, until it is met.
+    // Used by caches of tables which must not evict the data of other tables.
+    // 0 means no limit, in which case entries are evicted only when LSA needs memory.
+    void set_memory_quota(size_t bytes) noexcept;
+    size_t memory_quota() const noexcept { return _memory_quota; }
+    // Tables are registered by their row_cache instances.
+    void register_table(const utils::UUID& id);
+    void unregister_table(const utils::UUID& id) noexcept;
+    // Returns statistics of a table whose cache uses this tracker, or nullptr.
+    const table_stats* get_table_stats(const utils::UUID& id) const noexcept;
+    // When enabled, range queries add to cache only partitions which were read
+    // at least twice within a window of recent reads, so that scans don't evict
+    // the working set. Single-partition reads always populate cache.
+    // sketch_size is the number of partitions tracked with little error, 0 disables the filter.
+    void set_admission_filter(size_t sketch_size);
+    // Records a single-partition read of the partition.
+    void on_single_partition_read(const schema&, const dht::decorated_key&) noexcept;
+    // Records a range query read of the partition and returns true if its data
+    // can be added to cache.
+    bool admit(const schema&, const dht::decorated_key&) noexcept;
+    // When enabled, partitions which reach the end of the LRU are serialized and
+    // compressed, instead of being evicted, if that makes them smaller. Compressed
+    // partitions are given another pass through the LRU and are decompressed when
+    // read. Only small partitions which are fully cached are compressed.
+    void set_cold_partition_compression(bool enabled) noexcept { _compress_cold_partitions = enabled; }
+    void on_partition_decompression() noexcept { ++_stats.partition_decompressions; }
+    void on_compressed_partition_removal(size_t compressed_size) noexcept;
 };
 
 inline
@@ -145,6 +206,9 @@ void cache_tracker::insert(rows_entry& entry) noexcept {
     ++_stats.row_insertions;
     ++_stats.rows;
     _lru.add(entry);
+    if (_memory_quota) {
+        maybe_enforce_memory_quota();
+    }
 }
 
 inline
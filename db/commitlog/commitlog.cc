@@ -49,6 +49,7 @@
 #include <unordered_set>
 #include <exception>
 #include <filesystem>
+#include <lz4.h>
 
 #include <seastar/core/align.hh>
 #include <seastar/core/seastar.hh>
@@ -64,6 +65,7 @@
 #include <seastar/core/queue.hh>
 #include <seastar/core/sleep.hh>
 #include <seastar/core/coroutine.hh>
+#include <seastar/core/byteorder.hh>
 #include <seastar/net/byteorder.hh>
 #include <seastar/util/defer.hh>
 
@@ -119,6 +121,86 @@ class crc32_nbo {
     }
 };
 
+/*
+ * Payload of a compressed entry (see segment::compressed_entry_flag):
+ *      size     : uint32_t - size of the uncompressed entry
+ *      blocks[] : the uncompressed entry, split into blocks of block_size
+ *                 bytes, each compressed on its own with LZ4:
+ *          length : uint32_t - compressed size of the block
+ *          data   : length bytes
+ *
+ * Independent blocks keep both sides working on buffers of bounded size,
+ * regardless of how large the entry is.
+ */
+class entry_compression {
+public:
+    static constexpr size_t block_size = fragmented_temporary_buffer::default_fragment_size;
+    // Smaller entries seldom shrink enough to pay for the CPU spent on them.
+    static constexpr size_t min_entry_size = 256;
+
+    // data must have been allocated with fragmented_temporary_buffer::allocate_to_fit(),
+    // so that its fragments are the blocks.
+    // Returns the compressed payload, or nothing if it would not be smaller than data.
+    static std::optional<fragmented_temporary_buffer> compress(const fragmented_temporary_buffer& data) {
+        std::vector<temporary_buffer<char>> fragments;
+        fragments.reserve(1 + data.size_bytes() / block_size + 1);
+        temporary_buffer<char> header(sizeof(uint32_t));
+        write_be<uint32_t>(header.get_write(), data.size_bytes());
+        fragments.emplace_back(std::move(header));
+        size_t total = sizeof(uint32_t);
+
+        for (bytes_view block : fragmented_temporary_buffer::view(data)) {
+            const auto input = reinterpret_cast<const char*>(block.data());
+            temporary_buffer<char> buf(sizeof(uint32_t) + LZ4_compressBound(block.size()));
+            const auto output = buf.get_write() + sizeof(uint32_t);
+#ifdef HAVE_LZ4_COMPRESS_DEFAULT
+            auto len = LZ4_compress_default(input, output, block.size(), buf.size() - sizeof(uint32_t));
+#else
+            auto len = LZ4_compress(input, output, block.size());
+#endif
+            if (len <= 0) {
+                return std::nullopt;
+            }
+            write_be<uint32_t>(buf.get_write(), len);
+            buf.trim(sizeof(uint32_t) + len);
+            total += buf.size();
+            if (total >= data.size_bytes()) {
+                return std::nullopt;
+            }
+            fragments.emplace_back(std::move(buf));
+        }
+        return fragmented_temporary_buffer(std::move(fragments), total);
+    }
+
+    // Returns the uncompressed entry, or nothing if the payload is malformed.
+    static std::optional<fragmented_temporary_buffer> decompress(const fragmented_temporary_buffer& payload) {
+        auto in = payload.get_istream();
+        bytes_ostream linearization_buffer;
+        try {
+            auto size = net::ntoh(in.read<uint32_t>());
+            std::vector<temporary_buffer<char>> fragments;
+            fragments.reserve(size / block_size + 1);
+            for (size_t left = size; left; ) {
+                auto len = net::ntoh(in.read<uint32_t>());
+                auto block = in.read_bytes_view(len, linearization_buffer);
+                temporary_buffer<char> buf(std::min(left, block_size));
+                auto ret = LZ4_decompress_safe(reinterpret_cast<const char*>(block.data()), buf.get_write(), len, buf.size());
+                if (ret < 0 || size_t(ret) != buf.size()) {
+                    return std::nullopt;
+                }
+                left -= buf.size();
+                fragments.emplace_back(std::move(buf));
+            }
+            if (in.bytes_left()) {
+                return std::nullopt;
+            }
+            return fragmented_temporary_buffer(std::move(fragments), size);
+        } catch (std::out_of_range&) {
+            return std::nullopt;
+        }
+    }
+};
+
 class db::cf_holder {
 public:
     virtual ~cf_holder() {};
@@ -138,6 +220,7 @@ db::commitlog::config db::commitlog::config::from_db_config(const db::config& cf
     c.reuse_segments = cfg.commitlog_reuse_segments();
     c.use_o_dsync = cfg.commitlog_use_o_dsync();
     c.allow_going_over_size_limit = !cfg.commitlog_use_hard_size_limit();
+    c.use_compression = cfg.commitlog_use_compression();
 
     return c;
 }
@@ -323,6 +406,13 @@ class db::commitlog::segment_manager : public ::enable_shared_from_this<segment_
         // size allocated on disk - i.e. files created (new, reserve, recycled)
         uint64_t total_size_on_disk = 0;
         uint64_t requests_blocked_memory = 0;
+        // entries larger than entry_compression::min_entry_size written to
+        // compressing segments: their size before and after compression (the
+        // latter being the same for the ones which did not compress), and the
+        // time spent compressing them.
+        uint64_t compression_input_bytes = 0;
+        uint64_t compression_output_bytes = 0;
+        uint64_t compression_time_ns = 0;
     };
 
     stats totals;
@@ -574,6 +664,8 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
     static constexpr size_t descriptor_header_size = 5 * sizeof(uint32_t);
     static constexpr uint32_t segment_magic = ('S'<<24) |('C'<< 16) | ('L' << 8) | 'C';
     static constexpr uint32_t multi_entry_size_magic = 0xffffffff;
+    // Set in the size of an entry whose data is compressed (segment_version_3 and up).
+    static constexpr uint32_t compressed_entry_flag = 0x80000000;
 
     // The commit log (chained) sync marker/header size in bytes (int: length + int: checksum [segmentId, position])
     static constexpr size_t sync_marker_size = 2 * sizeof(uint32_t);
@@ -958,6 +1050,45 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
         });
     }
 
+    bool is_compressing() const {
+        return _desc.ver >= descriptor::segment_version_3;
+    }
+
+    // The data of an entry of a compressing segment, serialized (and, if it
+    // helped, compressed) before writing its header.
+    struct prepared_entry {
+        fragmented_temporary_buffer data;
+        bool compressed;
+    };
+
+    std::vector<prepared_entry> prepare_entries(entry_writer& writer, size_t size) {
+        std::vector<prepared_entry> ret;
+        ret.reserve(writer.num_entries);
+        for (size_t entry = 0; entry < writer.num_entries; ++entry) {
+            auto entry_size = writer.num_entries == 1 ? size : writer.size(*this, entry);
+            auto data = fragmented_temporary_buffer::allocate_to_fit(entry_size);
+            auto out = data.get_ostream();
+            writer.write(*this, out, entry);
+            if (entry_size < entry_compression::min_entry_size) {
+                ret.push_back(prepared_entry{std::move(data), false});
+                continue;
+            }
+            auto& totals = _segment_manager->totals;
+            auto start = std::chrono::steady_clock::now();
+            auto compressed = entry_compression::compress(data);
+            totals.compression_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            totals.compression_input_bytes += entry_size;
+            if (compressed) {
+                totals.compression_output_bytes += compressed->size_bytes();
+                ret.push_back(prepared_entry{std::move(*compressed), true});
+            } else {
+                totals.compression_output_bytes += entry_size;
+                ret.push_back(prepared_entry{std::move(data), false});
+            }
+        }
+        return ret;
+    }
+
     enum class write_result {
         ok,
         must_sync,
@@ -1008,6 +1139,21 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
 
         auto& out = _buffer_ostream;
 
+        // Compressing segments serialize the entries first, so that the headers
+        // can carry the sizes actually written. s stays an upper bound of it.
+        std::vector<prepared_entry> prepared;
+        auto written_size = s;
+        if (is_compressing()) {
+            prepared = prepare_entries(writer, size);
+            written_size = writer.num_entries * entry_overhead_size + (writer.num_entries > 1 ? multi_entry_overhead_size : 0u);
+            for (auto& e : prepared) {
+                written_size += e.data.size_bytes();
+            }
+            // The request controller is signalled with the size of the buffer
+            // once it is written, so give back what compression saved now.
+            _segment_manager->notify_memory_written(s - written_size);
+        }
+
         std::optional<crc32_nbo> mecrc;
 
         // if this is multi-entry write, we need to add an extra header + crc
@@ -1022,17 +1168,21 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
         if (writer.num_entries > 1) {
             mecrc.emplace();
             write<uint32_t>(out, multi_entry_size_magic);
-            write<uint32_t>(out, s);
+            write<uint32_t>(out, written_size);
             mecrc->process(multi_entry_size_magic);
-            mecrc->process(uint32_t(s));
+            mecrc->process(uint32_t(written_size));
             write<uint32_t>(out, mecrc->checksum());
         }
 
         for (size_t entry = 0; entry < writer.num_entries; ++entry) {
             replay_position rp(_desc.id, position());
             auto id = writer.id(entry);
-            auto entry_size = writer.num_entries == 1 ? size : writer.size(*this, entry);
-            auto es = entry_size + entry_overhead_size;
+            auto entry_size = !prepared.empty() ? prepared[entry].data.size_bytes()
+                    : writer.num_entries == 1 ? size : writer.size(*this, entry);
+            auto es = uint32_t(entry_size + entry_overhead_size);
+            if (!prepared.empty() && prepared[entry].compressed) {
+                es |= compressed_entry_flag;
+            }
 
             _cf_dirty[id]++; // increase use count for cf.
 
@@ -1041,13 +1191,19 @@ class db::commitlog::segment : public enable_shared_from_this<segment>, public c
             crc32_nbo crc;
 
             write<uint32_t>(out, es);
-            crc.process(uint32_t(es));
+            crc.process(es);
             write<uint32_t>(out, crc.checksum());
 
             // actual data
             auto entry_out = out.write_substream(entry_size);
             auto entry_data = entry_out.to_input_stream();
-            writer.write(*this, entry_out, entry);
+            if (!prepared.empty()) {
+                for (bytes_view frag : fragmented_temporary_buffer::view(prepared[entry].data)) {
+                    entry_out.write(reinterpret_cast<const char*>(frag.data()), frag.size());
+                }
+            } else {
+                writer.write(*this, entry_out, entry);
+            }
             entry_data.with_stream([&] (auto data_str) {
                 crc.process_fragmented(ser::buffer_view<typename std::vector<temporary_buffer<char>>::iterator>(data_str));
             });
@@ -1232,6 +1388,7 @@ db::commitlog::segment_manager::segment_manager(config c)
 {
     assert(max_size > 0);
     assert(max_mutation_size < segment::multi_entry_size_magic);
+    assert(max_mutation_size < segment::compressed_entry_flag);
 
     clogger.trace("Commitlog {} maximum disk size: {} MB / cpu ({} cpus)",
             cfg.commit_log_location, max_disk_size / (1024 * 1024),
@@ -1395,6 +1552,20 @@ void db::commitlog::segment_manager::create_counters(const sstring& metrics_cate
 
         sm::make_gauge("memory_buffer_bytes", totals.buffer_list_bytes,
                        sm::description("Holds the total number of bytes in internal memory buffers.")),
+
+        sm::make_derive("compression_input_bytes", totals.compression_input_bytes,
+                       sm::description("Counts a number of bytes of entries passed to compression.")),
+
+        sm::make_derive("compression_output_bytes", totals.compression_output_bytes,
+                       sm::description("Counts a number of bytes written for the entries passed to compression. "
+                                       "Entries which did not shrink are written, and counted here, uncompressed.")),
+
+        sm::make_gauge("compression_ratio", [this] { return totals.compression_input_bytes ? double(totals.compression_output_bytes) / totals.compression_input_bytes : 1.0; },
+                       sm::description("Holds the ratio between the bytes written and the bytes passed to compression so far. "
+                                       "Values close to 1 indicate that the written data does not compress and compression only costs CPU.")),
+
+        sm::make_derive("compression_time_ns", totals.compression_time_ns,
+                       sm::description("Counts the time, in nanoseconds, spent compressing entries.")),
     });
 }
 
@@ -1574,7 +1745,7 @@ future<> db::commitlog::segment_manager::rename_file(sstring from, sstring to) c
 
 future<db::commitlog::segment_manager::sseg_ptr> db::commitlog::segment_manager::allocate_segment() {
     for (;;) {
-        descriptor d(next_id(), cfg.fname_prefix);
+        descriptor d(next_id(), cfg.fname_prefix, cfg.use_compression ? descriptor::segment_version_3 : descriptor::segment_version_2);
         auto dst = filename(d);
         auto flags = open_flags::wo;
         if (cfg.use_o_dsync) {
@@ -2564,6 +2735,8 @@ db::commitlog::read_log_file(sstring filename, sstring pfx, seastar::io_priority
             crc32_nbo crc;
             crc.process(size);
 
+            bool compressed = false;
+
             // check for multi-entry
             if (d.ver >= descriptor::segment_version_2 && size == segment::multi_entry_size_magic) {
                 auto actual_size = checksum;
@@ -2622,6 +2795,11 @@ db::commitlog::read_log_file(sstring filename, sstring pfx, seastar::io_priority
                 co_return;
             }
 
+            if (d.ver >= descriptor::segment_version_3 && (size & segment::compressed_entry_flag)) {
+                size &= ~segment::compressed_entry_flag;
+                compressed = true;
+            }
+
             if (size < 3 * sizeof(uint32_t) || checksum != crc.checksum()) {
                 auto slack = next - pos;
                 if (size != 0) {
@@ -2654,6 +2832,16 @@ db::commitlog::read_log_file(sstring filename, sstring pfx, seastar::io_priority
                 co_return;
             }
 
+            if (compressed) {
+                auto data = entry_compression::decompress(buf);
+                if (!data) {
+                    clogger.debug("Segment entry at {} failed to decompress. Skipping {} bytes", rp, size);
+                    corrupt_size += size;
+                    co_return;
+                }
+                buf = std::move(*data);
+            }
+
             co_await pf({std::move(buf), rp}, checksum);
         }
 
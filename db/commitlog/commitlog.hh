@@ -141,6 +141,9 @@ class commitlog {
         bool use_o_dsync = false;
         bool warn_about_segments_left_on_disk_after_shutdown = true;
         bool allow_going_over_size_limit = true;
+        // Compress large enough entries with LZ4. Segments written with
+        // compression use segment_version_3 and cannot be read by older versions.
+        bool use_compression = false;
 
         // The base segment ID to use.
         // The segment IDs of newly allocated segments will be issued sequentially
@@ -165,6 +168,8 @@ class commitlog {
 
         static inline constexpr uint32_t segment_version_1 = 1u;
         static inline constexpr uint32_t segment_version_2 = 2u;
+        // Entries may be compressed, see segment::compressed_entry_flag.
+        static inline constexpr uint32_t segment_version_3 = 3u;
 
         descriptor(descriptor&&) noexcept = default;
         descriptor(const descriptor&) = default;
@@ -275,6 +275,12 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "If set to higher than 0, ignore the controller's output and set the compaction shares statically. Do not set this unless you know what you are doing and suspect a problem in the controller. This option will be retired when the controller reaches more maturity")
     , compaction_enforce_min_threshold(this, "compaction_enforce_min_threshold", liveness::LiveUpdate, value_status::Used, false,
         "If set to true, enforce the min_threshold option for compactions strictly. If false (default), Scylla may decide to compact even if below min_threshold")
+    , compaction_sub_range_parallelism(this, "compaction_sub_range_parallelism", liveness::LiveUpdate, value_status::Used, 1,
+        "Number of token sub-ranges a major compaction or reshape splits its input into and compacts concurrently, each into separate sstables of the output run. 1 (default) compacts the whole input as a single stream")
+    , memtable_flush_sub_range_parallelism(this, "memtable_flush_sub_range_parallelism", liveness::LiveUpdate, value_status::Used, 1,
+        "Maximum number of token sub-ranges a large memtable is split into when flushed, each written concurrently into a separate sstable. A memtable is split into sub-ranges of at least 32MB each. 1 (default) flushes a memtable as a single stream")
+    , enable_columnar_memtable_rows(this, "enable_columnar_memtable_rows", liveness::LiveUpdate, value_status::Used, false,
+        "Store rows inserted into a partition in clustering order, such as those of time-series tables, column by column in memtables. This takes several times less memory than the regular layout, so that more data fits in a memtable before it is flushed. Applies to memtables created after the option is changed")
     /* Initialization properties */
     /* The minimal properties needed for configuring a cluster. */
     , cluster_name(this, "cluster_name", value_status::Used, "",
@@ -301,7 +307,7 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "The directory where hints files are stored if hinted handoff is enabled.")
     , view_hints_directory(this, "view_hints_directory", value_status::Used, "",
         "The directory where materialized-view updates are stored while a view replica is unreachable.")
-    , saved_caches_directory(this, "saved_caches_directory", value_status::Unused, "",
+    , saved_caches_directory(this, "saved_caches_directory", value_status::Used, "",
         "The directory location where table key and row caches are stored.")
     /* Commonly used properties */
     /* Properties most frequently used when configuring Scylla. */
@@ -423,6 +429,8 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "Whether or not to use O_DSYNC mode for commitlog segments IO. Can improve commitlog latency on some file systems.\n")
     , commitlog_use_hard_size_limit(this, "commitlog_use_hard_size_limit", value_status::Used, false,
         "Whether or not to use a hard size limit for commitlog disk usage. Default is false. Enabling this can cause latency spikes, whereas the default can lead to occasional disk usage peaks.\n")
+    , commitlog_use_compression(this, "commitlog_use_compression", value_status::Used, false,
+        "Whether or not to compress commitlog entries with LZ4. Trades CPU on the write path for commitlog disk bandwidth, which pays off with large, compressible (e.g. text) writes. Commitlog segments written with compression cannot be replayed by versions which do not support it.\n")
     /* Compaction settings */
     /* Related information: Configuring compaction */
     , compaction_preheat_key_cache(this, "compaction_preheat_key_cache", value_status::Unused, true,
@@ -513,17 +521,18 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     /* Related information: Configuring caches */
     , key_cache_keys_to_save(this, "key_cache_keys_to_save", value_status::Unused, 0,
         "Number of keys from the key cache to save. (0: all)")
-    , key_cache_save_period(this, "key_cache_save_period", value_status::Unused, 14400,
+    , key_cache_save_period(this, "key_cache_save_period", value_status::Used, 14400,
         "Duration in seconds that keys are saved in cache. Caches are saved to saved_caches_directory. Saved caches greatly improve cold-start speeds and has relatively little effect on I/O.")
     , key_cache_size_in_mb(this, "key_cache_size_in_mb", value_status::Unused, 100,
         "A global cache setting for tables. It is the maximum size of the key cache in memory. To disable set to 0.\n"
         "Related information: nodetool setcachecapacity.")
-    , row_cache_keys_to_save(this, "row_cache_keys_to_save", value_status::Unused, 0,
-        "Number of keys from the row cache to save.")
+    , row_cache_keys_to_save(this, "row_cache_keys_to_save", value_status::Used, 1000,
+        "Number of the most frequently read partition keys of each table to save, when row_cache_save_period is set.")
     , row_cache_size_in_mb(this, "row_cache_size_in_mb", value_status::Unused, 0,
         "Maximum size of the row cache in memory. Row cache can save more time than key_cache_size_in_mb, but is space-intensive because it contains the entire row. Use the row cache only for hot rows or static rows. If you reduce the size, you may not get you hottest keys loaded on start up.")
-    , row_cache_save_period(this, "row_cache_save_period", value_status::Unused, 0,
-        "Duration in seconds that rows are saved in cache. Caches are saved to saved_caches_directory.")
+    , row_cache_save_period(this, "row_cache_save_period", value_status::Used, 0,
+        "Duration in seconds between saves of the most frequently read partition keys to saved_caches_directory."
+        " On startup, the saved partitions are read into the row cache in the background. 0 disables.")
     , memory_allocator(this, "memory_allocator", value_status::Invalid, "NativeAllocator",
         "The off-heap memory allocator. In addition to caches, this property affects storage engine meta data. Supported values:\n"
         "\tNativeAllocator\n"
@@ -759,6 +768,24 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         "The SSL port for encrypted communication. Unused unless enabled in encryption_options.")
     , enable_in_memory_data_store(this, "enable_in_memory_data_store", value_status::Used, false, "Enable in memory mode (system tables are always persisted)")
     , enable_cache(this, "enable_cache", value_status::Used, true, "Enable cache")
+    , row_cache_eviction_policy(this, "row_cache_eviction_policy", value_status::Used, "lru",
+        "The order in which rows are evicted from the row cache:\n"
+        "\tlru\tEvict the least recently used rows.\n"
+        "\tsecond_chance\tLike lru, but rows which were read again since they were cached are kept for one more round, so that rows read once, as by scans, are evicted first."
+        , {"lru", "second_chance"})
+    , row_cache_quotas(this, "row_cache_quotas", value_status::Used, {},
+        "Memory limits of the row cache, in megabytes per node, keyed by keyspace name or by keyspace and table name separated by a dot. "
+        "The tables of a keyspace with a limit share a cache of their own, and so does a table with a limit. Data of such tables is evicted when "
+        "the limit is exceeded, and doesn't compete for the shared cache with data of other tables.")
+    , row_cache_admission_filter_size(this, "row_cache_admission_filter_size", value_status::Used, 0,
+        "Number of recently read partitions per shard tracked by the row cache admission filter. Range queries add a partition to "
+        "the cache only if it was read at least twice recently, or if it was read by a single-partition query, so that scans don't "
+        "evict data which is read often. A few tens of thousands is a reasonable size. Zero, the default, disables the filter and "
+        "lets all reads populate the cache.")
+    , row_cache_compress_cold_partitions(this, "row_cache_compress_cold_partitions", value_status::Used, false,
+        "Compress small partitions which reach the end of the row cache LRU, instead of evicting them, so that more data fits in the "
+        "cache. Compressed partitions are decompressed when read, which costs CPU time. Useful for read-mostly workloads whose "
+        "working set is slightly larger than the cache.")
     , enable_commitlog(this, "enable_commitlog", value_status::Used, true, "Enable commitlog")
     , volatile_system_keyspace_for_testing(this, "volatile_system_keyspace_for_testing", value_status::Used, false, "Don't persist system keyspace - testing only!")
     , api_port(this, "api_port", value_status::Used, 10000, "Http Rest API port")
@@ -775,6 +802,12 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     , override_decommission(this, "override_decommission", value_status::Used, false, "Set true to force a decommissioned node to join the cluster")
     , enable_repair_based_node_ops(this, "enable_repair_based_node_ops", liveness::LiveUpdate, value_status::Used, true, "Set true to use enable repair based node operations instead of streaming based")
     , allowed_repair_based_node_ops(this, "allowed_repair_based_node_ops", liveness::LiveUpdate, value_status::Used, "replace", "A comma separated list of node operations which are allowed to enable repair based node operations. The operations can be bootstrap, replace, removenode, decommission and rebuild")
+    , enable_sstable_file_streaming(this, "enable_sstable_file_streaming", liveness::LiveUpdate, value_status::Used, true, "Set true to send sstables whose token range is entirely streamed as whole files, instead of as mutation fragments, in streaming based bootstrap, replace, removenode and decommission")
+    , repair_hash_tree_leaves(this, "repair_hash_tree_leaves", value_status::Used, 0, "Number of token sub-ranges per repaired range for which the hashes of the data are kept between repairs. "
+        "When set on all nodes, row level repair first compares these hashes and only repairs the sub-ranges whose hashes differ, so that ranges which did not change since the last repair are not read again. "
+        "The hashes are kept in memory only, so the first repair after a restart reads all ranges. Each shard keeps them within 1% of its memory, "
+        "about 40 bytes per sub-range, and drops the least recently repaired ranges when they don't fit. "
+        "Set 0 to disable.")
     , ring_delay_ms(this, "ring_delay_ms", value_status::Used, 30 * 1000, "Time a node waits to hear from other nodes before joining the ring in milliseconds. Same as -Dcassandra.ring_delay_ms in cassandra.")
     , shadow_round_ms(this, "shadow_round_ms", value_status::Used, 300 * 1000, "The maximum gossip shadow round time. Can be used to reduce the gossip feature check time during node boot up.")
     , fd_max_interval_ms(this, "fd_max_interval_ms", value_status::Used, 2 * 1000, "The maximum failure_detector interval time in milliseconds. Interval larger than the maximum will be ignored. Larger cluster may need to increase the default.")
@@ -786,6 +819,7 @@ db::config::config(std::shared_ptr<db::extensions> exts)
     , experimental(this, "experimental", value_status::Used, false, "[Deprecated] Set to true to unlock all experimental features (except 'raft' feature, which should be enabled explicitly via 'experimental-features' option). Please use 'experimental-features', instead.")
     , experimental_features(this, "experimental_features", value_status::Used, {}, experimental_features_help_string())
     , lsa_reclamation_step(this, "lsa_reclamation_step", value_status::Used, 1, "Minimum number of segments to reclaim in a single step")
+    , lsa_free_segments_target(this, "lsa_free_segments_target", value_status::Used, 16, "Number of free LSA segments per shard which are kept ready by compacting memory in the background, so that allocations don't have to compact synchronously. Set to zero to disable")
     , prometheus_port(this, "prometheus_port", value_status::Used, 9180, "Prometheus port, set to zero to disable")
     , prometheus_address(this, "prometheus_address", value_status::Used, {/* listen_address */}, "Prometheus listening address, defaulting to listen_address if not explicitly set")
     , prometheus_prefix(this, "prometheus_prefix", value_status::Used, "scylla", "Set the prefix of the exported Prometheus metrics. Changing this will break Scylla's dashboard compatibility, do not change unless you know what you are doing.")
@@ -801,6 +835,11 @@ db::config::config(std::shared_ptr<db::extensions> exts)
         " Performance is affected to some extent as a result. Useful to help debugging problems that may arise at another layers.")
     , enable_sstable_key_validation(this, "enable_sstable_key_validation", value_status::Used, ENABLE_SSTABLE_KEY_VALIDATION, "Enable validation of partition and clustering keys monotonicity"
         " Performance is affected to some extent as a result. Useful to help debugging problems that may arise at another layers.")
+    , enable_blocked_bloom_filters(this, "enable_blocked_bloom_filters", value_status::Used, false, "Write sstable bloom filters in a cache-blocked layout, where all bits of a key are in the same 64-byte block."
+        " Lookups are faster, but versions that do not know the layout treat such filters as always present.")
+    , enable_index_cache_persistence(this, "enable_index_cache_persistence", value_status::Used, false, "Save the identities of cached sstable index pages to saved_caches_directory every key_cache_save_period seconds and on shutdown,"
+        " and preload them in the background on startup. Shortens the period of elevated read latency after a restart.")
+    , index_cache_preload_bandwidth_mb_per_sec(this, "index_cache_preload_bandwidth_mb_per_sec", value_status::Used, 64, "Maximum rate at which saved index pages are read on startup when enable_index_cache_persistence is set. 0 means unlimited.")
     , cpu_scheduler(this, "cpu_scheduler", value_status::Used, true, "Enable cpu scheduling")
     , view_building(this, "view_building", value_status::Used, true, "Enable view building; should only be set to false when the node is experience issues due to view building")
     , enable_sstables_mc_format(this, "enable_sstables_mc_format", value_status::Unused, true, "Enable SSTables 'mc' format to be used as the default file format")
@@ -1019,7 +1058,8 @@ std::unordered_map<sstring, db::experimental_features_t::feature> db::experiment
         {"cdc", UNUSED},
         {"alternator-streams", ALTERNATOR_STREAMS},
         {"alternator-ttl", ALTERNATOR_TTL},
-        {"raft", RAFT}
+        {"raft", RAFT},
+        {"cql-protocol-v5", CQL_PROTOCOL_V5}
     };
 }
 
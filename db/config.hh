@@ -94,7 +94,7 @@ namespace db {
 struct experimental_features_t {
     // NOTE: RAFT feature is not enabled via `experimental` umbrella flag.
     // This option should be enabled explicitly.
-    enum feature { UNUSED, UDF, ALTERNATOR_STREAMS, ALTERNATOR_TTL, RAFT };
+    enum feature { UNUSED, UDF, ALTERNATOR_STREAMS, ALTERNATOR_TTL, RAFT, CQL_PROTOCOL_V5 };
     static std::unordered_map<sstring, feature> map(); // See enum_option.
     static std::vector<enum_option<experimental_features_t>> all();
 };
@@ -149,6 +149,9 @@ class config : public utils::config_file {
     named_value<float> memtable_flush_static_shares;
     named_value<float> compaction_static_shares;
     named_value<bool> compaction_enforce_min_threshold;
+    named_value<uint32_t> compaction_sub_range_parallelism;
+    named_value<uint32_t> memtable_flush_sub_range_parallelism;
+    named_value<bool> enable_columnar_memtable_rows;
     named_value<sstring> cluster_name;
     named_value<sstring> listen_address;
     named_value<sstring> listen_interface;
@@ -187,6 +190,7 @@ class config : public utils::config_file {
     named_value<bool> commitlog_reuse_segments;
     named_value<bool> commitlog_use_o_dsync;
     named_value<bool> commitlog_use_hard_size_limit;
+    named_value<bool> commitlog_use_compression;
     named_value<bool> compaction_preheat_key_cache;
     named_value<uint32_t> concurrent_compactors;
     named_value<uint32_t> in_memory_compaction_limit_in_mb;
@@ -288,6 +292,10 @@ class config : public utils::config_file {
     named_value<uint32_t> ssl_storage_port;
     named_value<bool> enable_in_memory_data_store;
     named_value<bool> enable_cache;
+    named_value<sstring> row_cache_eviction_policy;
+    named_value<string_map> row_cache_quotas;
+    named_value<uint32_t> row_cache_admission_filter_size;
+    named_value<bool> row_cache_compress_cold_partitions;
     named_value<bool> enable_commitlog;
     named_value<bool> volatile_system_keyspace_for_testing;
     named_value<uint16_t> api_port;
@@ -304,6 +312,8 @@ class config : public utils::config_file {
     named_value<bool> override_decommission;
     named_value<bool> enable_repair_based_node_ops;
     named_value<sstring> allowed_repair_based_node_ops;
+    named_value<bool> enable_sstable_file_streaming;
+    named_value<uint32_t> repair_hash_tree_leaves;
     named_value<uint32_t> ring_delay_ms;
     named_value<uint32_t> shadow_round_ms;
     named_value<uint32_t> fd_max_interval_ms;
@@ -315,6 +325,7 @@ class config : public utils::config_file {
     named_value<bool> experimental;
     named_value<std::vector<enum_option<experimental_features_t>>> experimental_features;
     named_value<size_t> lsa_reclamation_step;
+    named_value<size_t> lsa_free_segments_target;
     named_value<uint16_t> prometheus_port;
     named_value<sstring> prometheus_address;
     named_value<sstring> prometheus_prefix;
@@ -327,6 +338,9 @@ class config : public utils::config_file {
     named_value<bool> enable_keyspace_column_family_metrics;
     named_value<bool> enable_sstable_data_integrity_check;
     named_value<bool> enable_sstable_key_validation;
+    named_value<bool> enable_blocked_bloom_filters;
+    named_value<bool> enable_index_cache_persistence;
+    named_value<uint32_t> index_cache_preload_bandwidth_mb_per_sec;
     named_value<bool> cpu_scheduler;
     named_value<bool> view_building;
     named_value<bool> enable_sstables_mc_format;
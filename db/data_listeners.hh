@@ -58,6 +58,12 @@ class data_listener {
             const query::partition_slice& slice, flat_mutation_reader&& rd) {
         return std::move(rd);
     }
+
+    // Invoked after the data of a table in the given range has changed: after a write was
+    // applied to the memtable, or after sstables were added to or removed from the table
+    // outside of compaction (e.g. by streaming, loading or truncation).
+    // Unlike on_write(), this is invoked only once the change is visible to new readers.
+    virtual void on_change(const schema_ptr& s, const dht::partition_range& range) { }
 };
 
 class data_listeners {
@@ -70,6 +76,7 @@ class data_listeners {
     flat_mutation_reader on_read(const schema_ptr& s, const dht::partition_range& range,
             const query::partition_slice& slice, flat_mutation_reader&& rd);
     void on_write(const schema_ptr& s, const frozen_mutation& m);
+    void on_change(const schema_ptr& s, const dht::partition_range& range);
 
     bool exists(data_listener* listener) const;
     bool empty() const { return _listeners.empty(); }
@@ -871,68 +871,162 @@ future<> manager::end_point_hints_manager::sender::send_one_mutation(frozen_muta
     return do_send_one_mutation(std::move(m), natural_endpoints);
 }
 
+bool manager::end_point_hints_manager::sender::hint_batch::can_add(const frozen_mutation_and_schema& m) const {
+    auto& first = mutations.front();
+    return first.s == m.s && first.fm.key().equal(*m.s, m.fm.key()) && size_bytes < max_hint_batch_size;
+}
+
+void manager::end_point_hints_manager::sender::hint_batch::add(frozen_mutation_and_schema m, db::replay_position rp, size_t size) {
+    mutations.emplace_back(std::move(m));
+    rps.push_back(rp);
+    size_bytes += size;
+}
+
+frozen_mutation_and_schema manager::end_point_hints_manager::sender::hint_batch::merge() && {
+    if (mutations.size() == 1) {
+        return std::move(mutations.front());
+    }
+    auto s = mutations.front().s;
+    auto m = mutations.front().fm.unfreeze(s);
+    for (auto it = std::next(mutations.begin()); it != mutations.end(); ++it) {
+        m.apply(it->fm.unfreeze(s));
+    }
+    return {freeze(m), std::move(s)};
+}
+
 future<> manager::end_point_hints_manager::sender::send_one_hint(lw_shared_ptr<send_one_file_ctx> ctx_ptr, fragmented_temporary_buffer buf, db::replay_position rp, gc_clock::duration secs_since_file_mod, const sstring& fname) {
-    return _resource_manager.get_send_units_for(buf.size_bytes()).then([this, secs_since_file_mod, &fname, buf = std::move(buf), rp, ctx_ptr] (auto units) mutable {
-        ctx_ptr->mark_hint_as_in_progress(rp);
+    ctx_ptr->mark_hint_as_in_progress(rp);
+    std::optional<frozen_mutation_and_schema> m;
+    try {
+        m = this->get_mutation(ctx_ptr, buf);
+        gc_clock::duration gc_grace_sec = m->s->gc_grace_seconds();
+
+        // The hint is too old - drop it.
+        //
+        // Files are aggregated for at most manager::hints_timer_period therefore the oldest hint there is
+        // (last_modification - manager::hints_timer_period) old.
+        if (gc_clock::now().time_since_epoch() - secs_since_file_mod > gc_grace_sec - manager::hints_flush_period) {
+            on_hints_sent(*ctx_ptr, {rp}, true);
+            co_return;
+        }
 
-        // Future is waited on indirectly in `send_one_file()` (via `ctx_ptr->file_send_gate`).
-        (void)with_gate(ctx_ptr->file_send_gate, [this, secs_since_file_mod, &fname, buf = std::move(buf), rp, ctx_ptr] () mutable {
-            try {
-                auto m = this->get_mutation(ctx_ptr, buf);
-                gc_clock::duration gc_grace_sec = m.s->gc_grace_seconds();
-
-                // The hint is too old - drop it.
-                //
-                // Files are aggregated for at most manager::hints_timer_period therefore the oldest hint there is
-                // (last_modification - manager::hints_timer_period) old.
-                if (gc_clock::now().time_since_epoch() - secs_since_file_mod > gc_grace_sec - manager::hints_flush_period) {
-                    return make_ready_future<>();
-                }
+    // ignore these errors and move on - probably this hint is too old and the KS/CF has been deleted...
+    } catch (no_such_column_family& e) {
+        manager_logger.debug("send_hints(): no_such_column_family: {}", e.what());
+        ++this->shard_stats().discarded;
+    } catch (no_such_keyspace& e) {
+        manager_logger.debug("send_hints(): no_such_keyspace: {}", e.what());
+        ++this->shard_stats().discarded;
+    } catch (no_column_mapping& e) {
+        manager_logger.debug("send_hints(): {} at {}: {}", fname, rp, e.what());
+        ++this->shard_stats().discarded;
+    } catch (...) {
+        manager_logger.debug("send_hints(): unexpected error in file {} at {}: {}", fname, rp, std::current_exception());
+        on_hints_sent(*ctx_ptr, {rp}, false);
+        co_return;
+    }
+    if (!m) {
+        on_hints_sent(*ctx_ptr, {rp}, true);
+        co_return;
+    }
 
-                return this->send_one_mutation(std::move(m)).then([this, rp, ctx_ptr] {
-                    ++this->shard_stats().sent;
-                }).handle_exception([this, ctx_ptr, rp] (auto eptr) {
-                    manager_logger.trace("send_one_hint(): failed to send to {}: {}", end_point_key(), eptr);
-                    return make_exception_future<>(std::move(eptr));
-                });
+    if (ctx_ptr->batch && !ctx_ptr->batch->can_add(*m)) {
+        co_await send_hint_batch(ctx_ptr);
+    }
+    if (!ctx_ptr->batch) {
+        ctx_ptr->batch.emplace();
+    }
+    ctx_ptr->batch->add(std::move(*m), rp, buf.size_bytes());
+}
 
-            // ignore these errors and move on - probably this hint is too old and the KS/CF has been deleted...
-            } catch (no_such_column_family& e) {
-                manager_logger.debug("send_hints(): no_such_column_family: {}", e.what());
-                ++this->shard_stats().discarded;
-            } catch (no_such_keyspace& e) {
-                manager_logger.debug("send_hints(): no_such_keyspace: {}", e.what());
-                ++this->shard_stats().discarded;
-            } catch (no_column_mapping& e) {
-                manager_logger.debug("send_hints(): {} at {}: {}", fname, rp, e.what());
-                ++this->shard_stats().discarded;
-            } catch (...) {
-                auto eptr = std::current_exception();
-                manager_logger.debug("send_hints(): unexpected error in file {} at {}: {}", fname, rp, eptr);
-                return make_exception_future<>(std::move(eptr));
-            }
-            return make_ready_future<>();
-        }).then_wrapped([this, units = std::move(units), rp, ctx_ptr] (future<>&& f) {
-            // Information about the error was already printed somewhere higher.
-            // We just need to account in the ctx that sending of this hint has failed.
-            if (!f.failed()) {
-                ctx_ptr->on_hint_send_success(rp);
-                auto new_bound = ctx_ptr->get_replayed_bound();
-                // Segments from other shards are replayed first and are considered to be "before" replay position 0.
-                // Update the sent upper bound only if it is a local segment.
-                if (new_bound.shard_id() == this_shard_id() && _sent_upper_bound_rp < new_bound) {
-                    _sent_upper_bound_rp = new_bound;
-                    notify_replay_waiters();
+future<> manager::end_point_hints_manager::sender::send_hint_batch(lw_shared_ptr<send_one_file_ctx> ctx_ptr) {
+    if (!ctx_ptr->batch) {
+        co_return;
+    }
+    auto batch = std::move(*ctx_ptr->batch);
+    ctx_ptr->batch.reset();
+    // Kept out of the lambda below, which is gone if with_gate() throws, so that the
+    // hints can still be accounted as failed.
+    auto rps = std::move(batch.rps);
+
+    try {
+        auto window_units = co_await get_units(_send_window_sem, 1);
+        auto units = co_await _resource_manager.get_send_units_for(batch.size_bytes);
+
+        // Future is waited on indirectly in `send_one_file()` (via `ctx_ptr->file_send_gate`).
+        (void)with_gate(ctx_ptr->file_send_gate, [this, ctx_ptr, batch = std::move(batch), rps, window_units = std::move(window_units), units = std::move(units)] () mutable {
+            auto start = clock::now();
+            return futurize_invoke([this, batch = std::move(batch)] () mutable {
+                return this->send_one_mutation(std::move(batch).merge());
+            }).then_wrapped([this, ctx_ptr, rps = std::move(rps), start, window_units = std::move(window_units), units = std::move(units)] (future<>&& f) {
+                // Information about the error was already printed somewhere higher.
+                // We just need to account in the ctx that sending of these hints has failed.
+                const bool succeeded = !f.failed();
+                if (succeeded) {
+                    this->shard_stats().sent += rps.size();
+                } else {
+                    manager_logger.trace("send_hint_batch(): failed to send to {}: {}", end_point_key(), f.get_exception());
                 }
-            } else {
-                ctx_ptr->on_hint_send_failure(rp);
-            }
-            f.ignore_ready_future();
+                adjust_send_window(succeeded, clock::now() - start);
+                on_hints_sent(*ctx_ptr, rps, succeeded);
+            });
         });
-    }).handle_exception([this, ctx_ptr, rp] (auto eptr) {
-        manager_logger.trace("send_one_file(): Hmmm. Something bad had happend: {}", eptr);
-        ctx_ptr->on_hint_send_failure(rp);
-    });
+    } catch (...) {
+        manager_logger.trace("send_one_file(): Hmmm. Something bad had happend: {}", std::current_exception());
+        on_hints_sent(*ctx_ptr, rps, false);
+    }
+}
+
+void manager::end_point_hints_manager::sender::on_hints_sent(send_one_file_ctx& ctx, const std::vector<db::replay_position>& rps, bool succeeded) noexcept {
+    if (!succeeded) {
+        ctx.on_hints_send_failure(rps);
+        return;
+    }
+    for (auto& rp : rps) {
+        ctx.on_hint_send_success(rp);
+    }
+    auto new_bound = ctx.get_replayed_bound();
+    // Segments from other shards are replayed first and are considered to be "before" replay position 0.
+    // Update the sent upper bound only if it is a local segment.
+    if (new_bound.shard_id() == this_shard_id() && _sent_upper_bound_rp < new_bound) {
+        _sent_upper_bound_rp = new_bound;
+        notify_replay_waiters();
+    }
+}
+
+ssize_t manager::end_point_hints_manager::sender::send_window::on_send(bool succeeded, seastar::lowres_clock::duration latency, float view_backlog, seastar::lowres_clock::time_point now) noexcept {
+    if (!succeeded || latency > slow_send_threshold || view_backlog > max_view_update_backlog) {
+        // Halve the window at most once per slow send period, as all the sends
+        // in flight when the destination got overloaded are likely to be slow.
+        if (_size > 1 && now - _last_shrink > slow_send_threshold) {
+            const auto old_size = _size;
+            _size /= 2;
+            _credit = 0;
+            _last_shrink = now;
+            return -ssize_t(old_size - _size);
+        }
+        return 0;
+    }
+    // Grow the window by one per window's worth of timely sends.
+    if (_size < max_size && ++_credit >= _size) {
+        ++_size;
+        _credit = 0;
+        return 1;
+    }
+    return 0;
+}
+
+void manager::end_point_hints_manager::sender::adjust_send_window(bool succeeded, clock::duration latency) noexcept {
+    const auto backlog = _proxy.get_backlog_of(end_point_key()).relative_size();
+    const auto delta = _send_window.on_send(succeeded, latency, backlog, clock::now());
+    if (delta < 0) {
+        // Units held by sends in flight above the new window are returned when they complete.
+        _send_window_sem.consume(-delta);
+        manager_logger.trace("[{}] send window shrunk to {}: succeeded={}, latency={}ms, view backlog={}", end_point_key(), _send_window.size(),
+                succeeded, std::chrono::duration_cast<std::chrono::milliseconds>(latency).count(), backlog);
+    } else if (delta > 0) {
+        _send_window_sem.signal(delta);
+    }
 }
 
 void manager::end_point_hints_manager::sender::notify_replay_waiters() noexcept {
@@ -1012,6 +1106,12 @@ void manager::end_point_hints_manager::sender::send_one_file_ctx::on_hint_send_f
     }
 }
 
+void manager::end_point_hints_manager::sender::send_one_file_ctx::on_hints_send_failure(const std::vector<db::replay_position>& rps) noexcept {
+    for (auto& rp : rps) {
+        on_hint_send_failure(rp);
+    }
+}
+
 db::replay_position manager::end_point_hints_manager::sender::send_one_file_ctx::get_replayed_bound() const noexcept {
     // We are sure that all hints were sent _below_ the position which is the minimum of the following:
     // - Position of the first hint that failed to be sent in this replay (first_failed_rp),
@@ -1093,6 +1193,16 @@ bool manager::end_point_hints_manager::sender::send_one_file(const sstring& fnam
         ctx_ptr->segment_replay_failed = true;
     }
 
+    // Send the hints of the last partition read, unless sending the file was given up on.
+    if (ctx_ptr->batch) {
+        if ((draining() || !ctx_ptr->segment_replay_failed) && can_send()) {
+            send_hint_batch(ctx_ptr).get();
+        } else {
+            on_hints_sent(*ctx_ptr, ctx_ptr->batch->rps, false);
+            ctx_ptr->batch.reset();
+        }
+    }
+
     // wait till all background hints sending is complete
     ctx_ptr->file_send_gate.close().get();
 
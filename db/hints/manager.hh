@@ -122,6 +122,20 @@ class manager {
                 state::ep_state_left_the_ring,
                 state::draining>>;
 
+        public:
+            /// Consecutive hints of a file which belong to the same partition. They are merged
+            /// into a single mutation, so they are sent in a single RPC.
+            struct hint_batch {
+                std::vector<frozen_mutation_and_schema> mutations;
+                std::vector<db::replay_position> rps;
+                size_t size_bytes = 0;
+
+                bool can_add(const frozen_mutation_and_schema& m) const;
+                void add(frozen_mutation_and_schema m, db::replay_position rp, size_t size);
+                /// Returns the hints of the batch merged into a single mutation.
+                frozen_mutation_and_schema merge() &&;
+            };
+
             struct send_one_file_ctx {
                 send_one_file_ctx(std::unordered_map<table_schema_version, column_mapping>& last_schema_ver_to_column_mapping)
                     : schema_ver_to_column_mapping(last_schema_ver_to_column_mapping)
@@ -131,16 +145,40 @@ class manager {
                 std::optional<db::replay_position> first_failed_rp;
                 std::optional<db::replay_position> last_succeeded_rp;
                 std::set<db::replay_position> in_progress_rps;
+                std::optional<hint_batch> batch;
                 bool segment_replay_failed = false;
 
                 void mark_hint_as_in_progress(db::replay_position rp);
                 void on_hint_send_success(db::replay_position rp) noexcept;
                 void on_hint_send_failure(db::replay_position rp) noexcept;
+                void on_hints_send_failure(const std::vector<db::replay_position>& rps) noexcept;
 
                 // Returns a position below which hints were successfully replayed.
                 db::replay_position get_replayed_bound() const noexcept;
             };
 
+            /// The number of hint batches sent to the destination concurrently. It grows by one per
+            /// window's worth of timely sends and is halved when the destination reports a large view
+            /// update backlog, or when sends become slow or fail, so that a node which just came back
+            /// is not flooded with hints while it catches up.
+            class send_window {
+            public:
+                static constexpr size_t initial_size = 8;
+                static constexpr size_t max_size = 64;
+                // Sends which take longer than this are taken as a sign of an overloaded destination.
+                static constexpr std::chrono::milliseconds slow_send_threshold{500};
+                // The relative view update backlog of the destination above which replay backs off.
+                static constexpr float max_view_update_backlog = 0.5;
+            private:
+                size_t _size = initial_size;
+                size_t _credit = 0;
+                seastar::lowres_clock::time_point _last_shrink;
+            public:
+                size_t size() const noexcept { return _size; }
+                /// Accounts a completed send and returns by how much the window size changed.
+                ssize_t on_send(bool succeeded, seastar::lowres_clock::duration latency, float view_backlog, seastar::lowres_clock::time_point now) noexcept;
+            };
+
         private:
             std::list<sstring> _segments_to_replay;
             // Segments to replay which were not created on this shard but were moved during rebalancing
@@ -165,6 +203,11 @@ class manager {
 
             std::multimap<db::replay_position, lw_shared_ptr<std::optional<promise<>>>> _replay_waiters;
 
+            send_window _send_window;
+            semaphore _send_window_sem{send_window::initial_size};
+
+            static constexpr size_t max_hint_batch_size = 256 * 1024;
+
         public:
             sender(end_point_hints_manager& parent, service::storage_proxy& local_storage_proxy, database& local_db, gms::gossiper& local_gossiper) noexcept;
             ~sender();
@@ -245,8 +288,8 @@ class manager {
             }
 
             /// \brief Try to send one hint read from the file.
-            ///  - Limit the maximum memory size of hints "in the air" and the maximum total number of hints "in the air".
             ///  - Discard the hints that are older than the grace seconds value of the corresponding table.
+            ///  - Add the hint to the batch of the current partition, sending the batch first if the hint is for another partition.
             ///
             /// If sending fails we are going to set the state::segment_replay_failed in the _state and _first_failed_rp will be updated to min(_first_failed_rp, \ref rp).
             ///
@@ -258,6 +301,20 @@ class manager {
             /// \return future that resolves when next hint may be sent
             future<> send_one_hint(lw_shared_ptr<send_one_file_ctx> ctx_ptr, fragmented_temporary_buffer buf, db::replay_position rp, gc_clock::duration secs_since_file_mod, const sstring& fname);
 
+            /// \brief Send the pending batch of hints of the file, if any.
+            ///  - Limit the number of batches "in the air" to the destination to the send window.
+            ///  - Limit the maximum memory size of hints "in the air" and the maximum total number of hints "in the air".
+            ///
+            /// \param ctx_ptr shared pointer to the file sending context
+            /// \return future that resolves when the next batch may be sent
+            future<> send_hint_batch(lw_shared_ptr<send_one_file_ctx> ctx_ptr);
+
+            /// \brief Account for the result of sending the hints at the given replay positions.
+            void on_hints_sent(send_one_file_ctx& ctx, const std::vector<db::replay_position>& rps, bool succeeded) noexcept;
+
+            /// \brief Adapt the send window to the destination's view update backlog and to the latency of the last send.
+            void adjust_send_window(bool succeeded, clock::duration latency) noexcept;
+
             /// \brief Send all hint from a single file and delete it after it has been successfully sent.
             /// Send all hints from the given file. If we failed to send the current segment we will pick up in the next
             /// iteration from where we left in this one.
@@ -2324,10 +2324,12 @@ class runtime_info_table : public memtable_filling_virtual_table {
             };
             return _db.map_reduce0([] (database& db) {
                 stats res{};
-                auto occupancy = db.row_cache_tracker().region().occupancy();
-                res.total = occupancy.total_space();
-                res.free = occupancy.free_space();
-                res.entries = db.row_cache_tracker().partitions();
+                db.for_each_row_cache_tracker([&] (cache_tracker& tracker) {
+                    auto occupancy = tracker.region().occupancy();
+                    res.total += occupancy.total_space();
+                    res.free += occupancy.free_space();
+                    res.entries += tracker.partitions();
+                });
                 for (const auto& [_, t] : db.get_column_families()) {
                     auto& cache_stats = t->get_row_cache().stats();
                     res.hits += cache_stats.hits.count();
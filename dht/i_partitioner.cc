@@ -278,6 +278,26 @@ split_range_to_single_shard(const schema& s, const partition_range& pr, shard_id
     });
 }
 
+partition_range_vector
+split_range_to_equal_token_spans(const token& first, const token& last, unsigned n) {
+    const auto first_value = token::to_int64(first);
+    const uint64_t span = uint64_t(token::to_int64(last)) - uint64_t(first_value);
+    const uint64_t count = std::min(uint64_t(n), span);
+    if (count <= 1 || token::to_int64(last) < first_value) {
+        return { partition_range::make_open_ended_both_sides() };
+    }
+    partition_range_vector ranges;
+    ranges.reserve(count);
+    std::optional<partition_range::bound> start;
+    for (uint64_t i = 1; i < count; ++i) {
+        auto t = token::from_int64(int64_t(uint64_t(first_value) + span / count * i));
+        ranges.emplace_back(std::move(start), partition_range::bound(ring_position::starting_at(t), false));
+        start = partition_range::bound(ring_position::starting_at(t), true);
+    }
+    ranges.emplace_back(std::move(start), std::nullopt);
+    return ranges;
+}
+
 std::strong_ordering ring_position::tri_compare(const schema& s, const ring_position& o) const {
     return ring_position_comparator(s)(*this, o);
 }
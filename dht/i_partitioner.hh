@@ -671,6 +671,11 @@ split_range_to_shards(dht::partition_range pr, const schema& s);
 // Intersect a partition_range with a shard and return the the resulting sub-ranges, in sorted order
 future<utils::chunked_vector<partition_range>> split_range_to_single_shard(const schema& s, const dht::partition_range& pr, shard_id shard);
 
+// Splits the ring into at most n disjoint partition ranges, in sorted order, whose boundaries
+// divide the tokens from first to last into spans of equal width. The first and last ranges
+// are unbounded, so together the ranges cover the whole ring.
+dht::partition_range_vector split_range_to_equal_token_spans(const token& first, const token& last, unsigned n);
+
 std::unique_ptr<dht::i_partitioner> make_partitioner(sstring name);
 
 } // dht
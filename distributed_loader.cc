@@ -321,15 +321,22 @@ distributed_loader::make_sstables_available(sstables::sstable_directory& dir, sh
 future<>
 distributed_loader::process_upload_dir(distributed<database>& db, distributed<db::system_distributed_keyspace>& sys_dist_ks,
         distributed<db::view::view_update_generator>& view_update_generator, sstring ks, sstring cf) {
+    auto upload = fs::path(db.local().find_column_family(ks, cf).dir()) / sstables::upload_dir;
+    return process_sstables_dir(db, sys_dist_ks, view_update_generator, std::move(ks), std::move(cf), std::move(upload), streaming::stream_reason::repair);
+}
+
+future<>
+distributed_loader::process_sstables_dir(distributed<database>& db, distributed<db::system_distributed_keyspace>& sys_dist_ks,
+        distributed<db::view::view_update_generator>& view_update_generator, sstring ks, sstring cf,
+        fs::path sstables_dir, streaming::stream_reason reason) {
     seastar::thread_attributes attr;
     attr.sched_group = db.local().get_streaming_scheduling_group();
 
-    return seastar::async(std::move(attr), [&db, &view_update_generator, &sys_dist_ks, ks = std::move(ks), cf = std::move(cf)] {
+    return seastar::async(std::move(attr), [&db, &view_update_generator, &sys_dist_ks, ks = std::move(ks), cf = std::move(cf), sstables_dir = std::move(sstables_dir), reason] {
         global_column_family_ptr global_table(db, ks, cf);
 
         sharded<sstables::sstable_directory> directory;
-        auto upload = fs::path(global_table->dir()) / sstables::upload_dir;
-        directory.start(upload, db.local().get_config().initial_sstable_loading_concurrency(), std::ref(db.local().get_sharded_sst_dir_semaphore()),
+        directory.start(sstables_dir, db.local().get_config().initial_sstable_loading_concurrency(), std::ref(db.local().get_sharded_sst_dir_semaphore()),
             sstables::sstable_directory::need_mutate_level::yes,
             sstables::sstable_directory::lack_of_toc_fatal::no,
             sstables::sstable_directory::enable_dangerous_direct_import_of_cassandra_counters(db.local().get_config().enable_dangerous_direct_import_of_cassandra_counters()),
@@ -354,26 +361,26 @@ distributed_loader::process_upload_dir(distributed<database>& db, distributed<db
             shard_gen[s].store(shard_generation_base * smp::count + s, std::memory_order_relaxed);
         }
 
-        reshard(directory, db, ks, cf, [&global_table, upload, &shard_gen] (shard_id shard) mutable {
+        reshard(directory, db, ks, cf, [&global_table, sstables_dir, &shard_gen] (shard_id shard) mutable {
             // we need generation calculated by instance of cf at requested shard
             auto gen = shard_gen[shard].fetch_add(smp::count, std::memory_order_relaxed);
 
-            return global_table->make_sstable(upload.native(), gen,
+            return global_table->make_sstable(sstables_dir.native(), gen,
                     global_table->get_sstables_manager().get_highest_supported_format(),
                     sstables::sstable::format_types::big, &error_handler_gen_for_upload_dir);
         }).get();
 
-        reshape(directory, db, sstables::reshape_mode::strict, ks, cf, [global_table, upload, &shard_gen] (shard_id shard) {
+        reshape(directory, db, sstables::reshape_mode::strict, ks, cf, [global_table, sstables_dir, &shard_gen] (shard_id shard) {
             auto gen = shard_gen[shard].fetch_add(smp::count, std::memory_order_relaxed);
-            return global_table->make_sstable(upload.native(), gen,
+            return global_table->make_sstable(sstables_dir.native(), gen,
                   global_table->get_sstables_manager().get_highest_supported_format(),
                   sstables::sstable::format_types::big,
                   &error_handler_gen_for_upload_dir);
         }).get();
 
-        const bool use_view_update_path = db::view::check_needs_view_update_path(sys_dist_ks.local(), *global_table, streaming::stream_reason::repair).get0();
+        const bool use_view_update_path = db::view::check_needs_view_update_path(sys_dist_ks.local(), *global_table, reason).get0();
 
-        auto datadir = upload.parent_path();
+        auto datadir = fs::path(global_table->dir());
         if (use_view_update_path) {
             // Move to staging directory to avoid clashes with future uploads. Unique generation number ensures no collisions.
            datadir /= sstables::staging_dir;
@@ -556,7 +563,13 @@ future<> distributed_loader::populate_keyspace(distributed<database>& db, sstrin
                 sstring cfname = cf->schema()->cf_name();
                 auto sstdir = ks.column_family_directory(ksdir, cfname, uuid);
                 dblog.info("Keyspace {}: Reading CF {} id={} version={}", ks_name, cfname, uuid, s->version());
-                return ks.make_directory_for_column_family(cfname, uuid).then([&db, sstdir, uuid, ks_name, cfname] {
+                return ks.make_directory_for_column_family(cfname, uuid).then([sstdir] {
+                    // Sstables received as files by streams which did not complete are never loaded.
+                    auto streaming = fs::path(sstdir) / sstables::streaming_dir;
+                    return file_exists(streaming.native()).then([streaming] (bool exists) {
+                        return exists ? lister::rmdir(streaming) : make_ready_future<>();
+                    });
+                }).then([&db, sstdir, uuid, ks_name, cfname] {
                     return distributed_loader::populate_column_family(db, sstdir + "/" + sstables::staging_dir, ks_name, cfname);
                 }).then([&db, sstdir, ks_name, cfname] {
                     return distributed_loader::populate_column_family(db, sstdir + "/" + sstables::quarantine_dir, ks_name, cfname, false /* must_exist */);
@@ -31,6 +31,7 @@
 #include <filesystem>
 #include "seastarx.hh"
 #include "compaction/compaction_descriptor.hh"
+#include "streaming/stream_reason.hh"
 
 class database;
 class table;
@@ -91,4 +92,9 @@ class distributed_loader {
             get_sstables_from_upload_dir(distributed<database>& db, sstring ks, sstring cf);
     static future<> process_upload_dir(distributed<database>& db, distributed<db::system_distributed_keyspace>& sys_dist_ks,
             distributed<db::view::view_update_generator>& view_update_generator, sstring ks_name, sstring cf_name);
+    // Loads the sstables of dir into the table, the same way as process_upload_dir() does
+    // with the upload directory. reason decides whether they go through the view update path.
+    static future<> process_sstables_dir(distributed<database>& db, distributed<db::system_distributed_keyspace>& sys_dist_ks,
+            distributed<db::view::view_update_generator>& view_update_generator, sstring ks_name, sstring cf_name,
+            std::filesystem::path dir, streaming::stream_reason reason);
 };
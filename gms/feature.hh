@@ -151,6 +151,9 @@ extern const std::string_view UDA;
 extern const std::string_view SEPARATE_PAGE_SIZE_AND_SAFETY_LIMIT;
 extern const std::string_view SUPPORTS_RAFT_CLUSTER_MANAGEMENT;
 extern const std::string_view USES_RAFT_CLUSTER_MANAGEMENT;
+extern const std::string_view PARALLELIZED_AGGREGATION;
+extern const std::string_view STREAM_SSTABLE_FILES;
+extern const std::string_view ZSTD_DICTIONARY_COMPRESSION;
 
 }
 
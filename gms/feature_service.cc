@@ -76,6 +76,9 @@ constexpr std::string_view features::UDA = "UDA";
 constexpr std::string_view features::SEPARATE_PAGE_SIZE_AND_SAFETY_LIMIT = "SEPARATE_PAGE_SIZE_AND_SAFETY_LIMIT";
 constexpr std::string_view features::SUPPORTS_RAFT_CLUSTER_MANAGEMENT = "SUPPORTS_RAFT_CLUSTER_MANAGEMENT";
 constexpr std::string_view features::USES_RAFT_CLUSTER_MANAGEMENT = "USES_RAFT_CLUSTER_MANAGEMENT";
+constexpr std::string_view features::PARALLELIZED_AGGREGATION = "PARALLELIZED_AGGREGATION";
+constexpr std::string_view features::STREAM_SSTABLE_FILES = "STREAM_SSTABLE_FILES";
+constexpr std::string_view features::ZSTD_DICTIONARY_COMPRESSION = "ZSTD_DICTIONARY_COMPRESSION";
 
 static logging::logger logger("features");
 
@@ -104,6 +107,9 @@ feature_service::feature_service(feature_config cfg) : _config(cfg)
         , _separate_page_size_and_safety_limit(*this, features::SEPARATE_PAGE_SIZE_AND_SAFETY_LIMIT)
         , _supports_raft_cluster_mgmt(*this, features::SUPPORTS_RAFT_CLUSTER_MANAGEMENT)
         , _uses_raft_cluster_mgmt(*this, features::USES_RAFT_CLUSTER_MANAGEMENT)
+        , _parallelized_aggregation(*this, features::PARALLELIZED_AGGREGATION)
+        , _stream_sstable_files(*this, features::STREAM_SSTABLE_FILES)
+        , _zstd_dictionary_compression(*this, features::ZSTD_DICTIONARY_COMPRESSION)
         , _raft_support_listener(_supports_raft_cluster_mgmt.when_enabled([this] {
             // When the cluster fully supports raft-based cluster management,
             // we can re-enable support for the second gossip feature to trigger
@@ -227,6 +233,9 @@ std::set<std::string_view> feature_service::known_feature_set() {
         gms::features::SEPARATE_PAGE_SIZE_AND_SAFETY_LIMIT,
         gms::features::SUPPORTS_RAFT_CLUSTER_MANAGEMENT,
         gms::features::USES_RAFT_CLUSTER_MANAGEMENT,
+        gms::features::PARALLELIZED_AGGREGATION,
+        gms::features::STREAM_SSTABLE_FILES,
+        gms::features::ZSTD_DICTIONARY_COMPRESSION,
     };
 
     for (const sstring& s : _config._disabled_features) {
@@ -335,6 +344,9 @@ void feature_service::enable(const std::set<std::string_view>& list) {
         std::ref(_separate_page_size_and_safety_limit),
         std::ref(_supports_raft_cluster_mgmt),
         std::ref(_uses_raft_cluster_mgmt),
+        std::ref(_parallelized_aggregation),
+        std::ref(_stream_sstable_files),
+        std::ref(_zstd_dictionary_compression),
     })
     {
         if (list.contains(f.name())) {
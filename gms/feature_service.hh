@@ -103,6 +103,9 @@ class feature_service final {
     gms::feature _separate_page_size_and_safety_limit;
     gms::feature _supports_raft_cluster_mgmt;
     gms::feature _uses_raft_cluster_mgmt;
+    gms::feature _parallelized_aggregation;
+    gms::feature _stream_sstable_files;
+    gms::feature _zstd_dictionary_compression;
 
     gms::feature::listener_registration _raft_support_listener;
 
@@ -199,6 +202,22 @@ class feature_service final {
         return bool(_separate_page_size_and_safety_limit);
     }
 
+    // Whether all nodes can compute partial aggregates of a query (FORWARD_REQUEST).
+    bool cluster_supports_parallelized_aggregation() const {
+        return bool(_parallelized_aggregation);
+    }
+
+    // Whether all nodes can receive whole sstables as files (STREAM_SSTABLE_FILES).
+    bool cluster_supports_stream_sstable_files() const {
+        return bool(_stream_sstable_files);
+    }
+
+    // Whether all nodes can read sstables compressed with a trained zstd dictionary
+    // (the CompressionDictionary component).
+    bool cluster_supports_zstd_dictionary_compression() const {
+        return bool(_zstd_dictionary_compression);
+    }
+
     static std::set<sstring> to_feature_set(sstring features_string);
     // Persist enabled feature in the `system.scylla_local` table under the "enabled_features" key.
     // The key itself is maintained as an `unordered_set<string>` and serialized via `to_string`
@@ -612,6 +612,7 @@ For more information about individual apps, run: scylla {app_name} --help
                 st_cfg.defragment_on_idle = cfg->defragment_memory_on_idle();
                 st_cfg.abort_on_lsa_bad_alloc = cfg->abort_on_lsa_bad_alloc();
                 st_cfg.lsa_reclamation_step = cfg->lsa_reclamation_step();
+                st_cfg.free_segments_target = cfg->lsa_free_segments_target();
                 st_cfg.background_reclaim_sched_group = background_reclaim_scheduling_group;
                 st_cfg.sanitizer_report_backtrace = cfg->sanitizer_report_backtrace();
                 logalloc::shard_tracker().configure(st_cfg);
@@ -873,6 +874,9 @@ For more information about individual apps, run: scylla {app_name} --help
             utils::directories::set dir_set;
             dir_set.add(cfg->data_file_directories());
             dir_set.add(cfg->commitlog_directory());
+            if (cfg->enable_index_cache_persistence() || cfg->row_cache_save_period()) {
+                dir_set.add(cfg->saved_caches_directory());
+            }
             dirs.emplace(cfg->developer_mode());
             dirs->create_and_verify(std::move(dir_set)).get();
 
@@ -1037,6 +1041,7 @@ For more information about individual apps, run: scylla {app_name} --help
                     cf.trigger_compaction();
                 }
             }).get();
+            db.invoke_on_all(&database::start_cache_persistence).get();
             api::set_server_gossip(ctx, gossiper).get();
             api::set_server_snitch(ctx).get();
             api::set_server_storage_proxy(ctx, ss).get();
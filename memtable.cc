@@ -124,14 +124,15 @@ void memtable::memtable_encoding_stats_collector::update(const ::schema& s, cons
 }
 
 memtable::memtable(schema_ptr schema, dirty_memory_manager& dmm, table_stats& table_stats,
-    memtable_list* memtable_list, seastar::scheduling_group compaction_scheduling_group)
+    memtable_list* memtable_list, seastar::scheduling_group compaction_scheduling_group, bool enable_columnar_rows)
         : logalloc::region(dmm.region_group())
         , _dirty_mgr(dmm)
         , _cleaner(*this, no_cache_tracker, table_stats.memtable_app_stats, compaction_scheduling_group)
         , _memtable_list(memtable_list)
         , _schema(std::move(schema))
         , partitions(dht::raw_token_less_comparator{})
-        , _table_stats(table_stats) {
+        , _table_stats(table_stats)
+        , _columnar_rows(enable_columnar_rows) {
 }
 
 static thread_local dirty_memory_manager mgr_for_tests;
@@ -203,7 +204,7 @@ future<> memtable::clear_gently() noexcept {
     });
 }
 
-partition_entry&
+memtable_entry&
 memtable::find_or_create_partition_slow(partition_key_view key) {
     assert(!reclaiming_enabled());
 
@@ -213,15 +214,15 @@ memtable::find_or_create_partition_slow(partition_key_view key) {
     // partitions doesn't support heterogeneous lookup.
     // We could switch to boost::intrusive_map<> similar to what we have for row keys.
     auto& outer = current_allocator();
-    return with_allocator(standard_allocator(), [&, this] () -> partition_entry& {
+    return with_allocator(standard_allocator(), [&, this] () -> memtable_entry& {
         auto dk = dht::decorate_key(*_schema, key);
-        return with_allocator(outer, [&dk, this] () -> partition_entry& {
+        return with_allocator(outer, [&dk, this] () -> memtable_entry& {
             return find_or_create_partition(dk);
         });
     });
 }
 
-partition_entry&
+memtable_entry&
 memtable::find_or_create_partition(const dht::decorated_key& key) {
     assert(!reclaiming_enabled());
 
@@ -237,12 +238,12 @@ memtable::find_or_create_partition(const dht::decorated_key& key) {
         if (!hint.emplace_keeps_iterators()) {
             current_allocator().invalidate_references();
         }
-        return entry->partition();
+        return *entry;
     } else {
         ++_table_stats.memtable_partition_hits;
         upgrade_entry(*i);
     }
-    return i->partition();
+    return *i;
 }
 
 boost::iterator_range<memtable::partitions_type::const_iterator>
@@ -403,6 +404,101 @@ class partition_snapshot_read_accounter {
     void operator()(const partition_end& eop) {}
 };
 
+// Merges the rows of a memtable entry stored in the columnar layout, copied when the
+// snapshot of the entry was taken, into the stream read from that snapshot.
+class columnar_rows_merging_reader final : public flat_mutation_reader::impl {
+    flat_mutation_reader _reader;
+    columnar_rows_cursor _cursor;
+    // The encoded rows are owned by the reader, so they are accounted to its permit.
+    reader_permit::resource_units _units;
+    // Decoded rows of the current chunk, in the order of the stream.
+    std::deque<clustering_row> _rows;
+private:
+    bool has_rows() {
+        while (_rows.empty() && !_cursor.empty()) {
+            _rows = _cursor.next_chunk();
+        }
+        return !_rows.empty();
+    }
+    void push_rows_before(position_in_partition_view pos) {
+        position_in_partition::less_compare less(*_schema);
+        while (has_rows() && less(_rows.front().position(), pos)) {
+            push_mutation_fragment(*_schema, _permit, std::move(_rows.front()));
+            _rows.pop_front();
+        }
+    }
+    void push_all_rows() {
+        while (has_rows()) {
+            push_mutation_fragment(*_schema, _permit, std::move(_rows.front()));
+            _rows.pop_front();
+        }
+    }
+public:
+    columnar_rows_merging_reader(flat_mutation_reader reader, columnar_rows_cursor cursor)
+        : impl(reader.schema(), reader.permit())
+        , _reader(std::move(reader))
+        , _cursor(std::move(cursor))
+        , _units(_permit.consume_memory(_cursor.memory_usage()))
+    { }
+
+    virtual future<> fill_buffer() override {
+        return do_until([this] { return is_end_of_stream() || is_buffer_full(); }, [this] {
+            return _reader().then([this] (mutation_fragment_opt mf) {
+                if (!mf) {
+                    _end_of_stream = true;
+                    return;
+                }
+                if (mf->is_end_of_partition()) {
+                    push_all_rows();
+                } else if (!mf->is_partition_start() && !mf->is_static_row()) {
+                    push_rows_before(mf->position());
+                    // The same row may have been written to both layouts.
+                    if (mf->is_clustering_row() && has_rows() && _rows.front().key().equal(*_schema, mf->as_clustering_row().key())) {
+                        mf->mutate_as_clustering_row(*_schema, [this] (clustering_row& cr) {
+                            cr.apply(*_schema, std::move(_rows.front()));
+                        });
+                        _rows.pop_front();
+                    }
+                }
+                push_mutation_fragment(std::move(*mf));
+            });
+        });
+    }
+    virtual future<> next_partition() override {
+        clear_buffer_to_next_partition();
+        if (is_buffer_empty()) {
+            _rows.clear();
+            _cursor = {};
+            return _reader.next_partition();
+        }
+        return make_ready_future<>();
+    }
+    virtual future<> fast_forward_to(const dht::partition_range&) override {
+        return make_exception_future<>(make_backtraced_exception_ptr<std::bad_function_call>());
+    }
+    virtual future<> fast_forward_to(position_range) override {
+        return make_exception_future<>(make_backtraced_exception_ptr<std::bad_function_call>());
+    }
+    virtual future<> close() noexcept override {
+        return _reader.close();
+    }
+};
+
+// The cursor has to be in the order of rd, whose schema is reversed for reversed
+// reads, and rd has to be a reader of a single partition without streamed_mutation::forwarding.
+static flat_mutation_reader merge_columnar_rows(flat_mutation_reader rd, columnar_rows_cursor rows) {
+    if (rows.empty()) {
+        return rd;
+    }
+    return make_flat_mutation_reader<columnar_rows_merging_reader>(std::move(rd), std::move(rows));
+}
+
+struct memtable_partition_read {
+    dht::decorated_key key;
+    partition_snapshot_ptr snp;
+    columnar_rows_cursor rows;
+};
+
 class scanning_reader final : public flat_mutation_reader::impl, private iterator_reader {
     std::optional<dht::partition_range> _delegate_range;
     flat_mutation_reader_opt _delegate;
@@ -458,7 +554,7 @@ class scanning_reader final : public flat_mutation_reader::impl, private iterato
                 if (_delegate_range) {
                     _delegate = delegate_reader(_permit, *_delegate_range, _slice, _pc, streamed_mutation::forwarding::no, _fwd_mr);
                 } else {
-                    auto key_and_snp = read_section()(region(), [&] () -> std::optional<std::pair<dht::decorated_key, partition_snapshot_ptr>> {
+                    auto read = read_section()(region(), [&] () -> std::optional<memtable_partition_read> {
                         memtable_entry *e = fetch_entry();
                         if (!e) {
                             return { };
@@ -468,21 +564,23 @@ class scanning_reader final : public flat_mutation_reader::impl, private iterato
                             // virtual calls, intermediate buffers and futures.
                             auto key = e->key();
                             auto snp = e->snapshot(*mtbl());
+                            auto rows = e->read_columnar_rows(_slice.row_ranges(*schema(), key.key()), _slice.is_reversed());
                             advance_iterator();
-                            return std::pair(std::move(key), std::move(snp));
+                            return memtable_partition_read{std::move(key), std::move(snp), std::move(rows)};
                         }
                     });
-                    if (key_and_snp) {
-                        update_last(key_and_snp->first);
+                    if (read) {
+                        update_last(read->key);
 
-                        const query::clustering_row_ranges& ranges = _slice.row_ranges(*schema(), key_and_snp->first.key());
+                        const query::clustering_row_ranges& ranges = _slice.row_ranges(*schema(), read->key.key());
                         // TODO: when the slice passed from query finally changes format from half-reversed into native reversed, this line needs to change.
                         auto cr = query::clustering_key_filter_ranges(ranges);
 
-                        auto snp_schema = key_and_snp->second->schema();
+                        auto snp_schema = read->snp->schema();
                         bool digest_requested = _slice.options.contains<query::partition_slice::option::with_digest>();
                         bool is_reversed = _slice.is_reversed();
-                        auto mpsr = make_partition_snapshot_flat_reader_from_snp_schema(is_reversed, _permit, std::move(key_and_snp->first), std::move(cr), std::move(key_and_snp->second), digest_requested, region(), read_section(), mtbl(), streamed_mutation::forwarding::no, *mtbl());
+                        auto mpsr = make_partition_snapshot_flat_reader_from_snp_schema(is_reversed, _permit, std::move(read->key), std::move(cr), std::move(read->snp), digest_requested, region(), read_section(), mtbl(), streamed_mutation::forwarding::no, *mtbl());
+                        mpsr = merge_columnar_rows(std::move(mpsr), std::move(read->rows));
                         mpsr.upgrade_schema(schema());
                         _delegate = std::move(mpsr);
                     } else {
@@ -558,7 +656,8 @@ class flush_memory_accounter {
     }
     uint64_t compute_size(memtable_entry& e, partition_snapshot& snp) {
         return e.size_in_allocator_without_rows(_mt.allocator())
-            + _mt.allocator().object_memory_size_in_allocator(&*snp.version());
+            + _mt.allocator().object_memory_size_in_allocator(&*snp.version())
+            + e.columnar_rows_memory_usage();
     }
 };
 
@@ -626,9 +725,9 @@ class flush_reader final : public flat_mutation_reader::impl, private iterator_r
     flat_mutation_reader_opt _partition_reader;
     flush_memory_accounter _flushed_memory;
 public:
-    flush_reader(schema_ptr s, reader_permit permit, lw_shared_ptr<memtable> m)
+    flush_reader(schema_ptr s, reader_permit permit, lw_shared_ptr<memtable> m, const dht::partition_range& range)
         : impl(s, std::move(permit))
-        , iterator_reader(std::move(s), m, query::full_partition_range)
+        , iterator_reader(std::move(s), m, range)
         , _flushed_memory(*m)
     {}
     flush_reader(const flush_reader&) = delete;
@@ -638,24 +737,26 @@ class flush_reader final : public flat_mutation_reader::impl, private iterator_r
 private:
     void get_next_partition() {
         uint64_t component_size = 0;
-        auto key_and_snp = read_section()(region(), [&] () -> std::optional<std::pair<dht::decorated_key, partition_snapshot_ptr>> {
+        auto read = read_section()(region(), [&] () -> std::optional<memtable_partition_read> {
             memtable_entry* e = fetch_entry();
             if (e) {
                 auto dk = e->key();
                 auto snp = e->snapshot(*mtbl());
+                auto rows = e->read_columnar_rows(query::clustering_row_ranges{query::full_clustering_range}, false);
                 component_size = _flushed_memory.compute_size(*e, *snp);
                 advance_iterator();
-                return std::pair(std::move(dk), std::move(snp));
+                return memtable_partition_read{std::move(dk), std::move(snp), std::move(rows)};
             }
             return { };
         });
-        if (key_and_snp) {
+        if (read) {
             _flushed_memory.update_bytes_read(component_size);
-            update_last(key_and_snp->first);
-            auto cr = query::clustering_key_filter_ranges::get_ranges(*schema(), schema()->full_slice(), key_and_snp->first.key());
-            auto snp_schema = key_and_snp->second->schema();
-            auto mpsr = make_partition_snapshot_flat_reader<false, partition_snapshot_flush_accounter>(snp_schema, _permit, std::move(key_and_snp->first), std::move(cr),
-                            std::move(key_and_snp->second), false, region(), read_section(), mtbl(), streamed_mutation::forwarding::no, *snp_schema, _flushed_memory);
+            update_last(read->key);
+            auto cr = query::clustering_key_filter_ranges::get_ranges(*schema(), schema()->full_slice(), read->key.key());
+            auto snp_schema = read->snp->schema();
+            auto mpsr = make_partition_snapshot_flat_reader<false, partition_snapshot_flush_accounter>(snp_schema, _permit, std::move(read->key), std::move(cr),
+                            std::move(read->snp), false, region(), read_section(), mtbl(), streamed_mutation::forwarding::no, *snp_schema, _flushed_memory);
+            mpsr = merge_columnar_rows(std::move(mpsr), std::move(read->rows));
             mpsr.upgrade_schema(schema());
             _partition_reader = std::move(mpsr);
         }
@@ -718,10 +819,14 @@ memtable::make_flat_reader(schema_ptr s,
     bool is_reversed = slice.is_reversed();
     if (query::is_single_partition(range) && !fwd_mr) {
         const query::ring_position& pos = range.start()->value();
+        auto dk = pos.as_decorated_key();
+        const query::clustering_row_ranges& ranges = slice.row_ranges(*s, dk.key());
+        columnar_rows_cursor rows;
         auto snp = _read_section(*this, [&] () -> partition_snapshot_ptr {
             auto i = partitions.find(pos, dht::ring_position_comparator(*_schema));
             if (i != partitions.end()) {
                 upgrade_entry(*i);
+                rows = i->read_columnar_rows(ranges, is_reversed);
                 return i->snapshot(*this);
             } else {
                 return { };
@@ -730,13 +835,18 @@ memtable::make_flat_reader(schema_ptr s,
         if (!snp) {
             return make_empty_flat_reader(std::move(s), std::move(permit));
         }
-        auto dk = pos.as_decorated_key();
 
-        const query::clustering_row_ranges& ranges = slice.row_ranges(*s, dk.key());
         // TODO: when the slice passed from query finally changes format from half-reversed into native reversed, this line needs to change.
         auto cr = query::clustering_key_filter_ranges(ranges);
 
         bool digest_requested = slice.options.contains<query::partition_slice::option::with_digest>();
+        if (!rows.empty()) {
+            // Rows in the columnar layout are merged into a stream without forwarding.
+            auto rd = make_partition_snapshot_flat_reader_from_snp_schema(is_reversed, std::move(permit), std::move(dk), std::move(cr), std::move(snp), digest_requested, *this, _read_section, shared_from_this(), streamed_mutation::forwarding::no, *this);
+            rd = merge_columnar_rows(std::move(rd), std::move(rows));
+            rd.upgrade_schema(s);
+            return fwd ? make_forwardable(std::move(rd)) : std::move(rd);
+        }
         auto rd = make_partition_snapshot_flat_reader_from_snp_schema(is_reversed, std::move(permit), std::move(dk), std::move(cr), std::move(snp), digest_requested, *this, _read_section, shared_from_this(), fwd, *this);
         rd.upgrade_schema(s);
         return rd;
@@ -752,13 +862,26 @@ memtable::make_flat_reader(schema_ptr s,
 
 flat_mutation_reader
 memtable::make_flush_reader(schema_ptr s, reader_permit permit, const io_priority_class& pc) {
+    return make_flush_reader(std::move(s), std::move(permit), pc, query::full_partition_range);
+}
+
+flat_mutation_reader
+memtable::make_flush_reader(schema_ptr s, reader_permit permit, const io_priority_class& pc, const dht::partition_range& range) {
     if (group()) {
-        return make_flat_mutation_reader<flush_reader>(std::move(s), std::move(permit), shared_from_this());
+        return make_flat_mutation_reader<flush_reader>(std::move(s), std::move(permit), shared_from_this(), range);
     } else {
         auto& full_slice = s->full_slice();
         return make_flat_mutation_reader<scanning_reader>(std::move(s), shared_from_this(), std::move(permit),
-            query::full_partition_range, full_slice, pc, mutation_reader::forwarding::no);
+            range, full_slice, pc, mutation_reader::forwarding::no);
+    }
+}
+
+dht::partition_range_vector
+memtable::split_for_flush(unsigned n) const {
+    if (partitions.empty()) {
+        return { query::full_partition_range };
     }
+    return dht::split_range_to_equal_token_spans(partitions.begin()->key().token(), std::prev(partitions.end())->key().token(), n);
 }
 
 void
@@ -784,9 +907,9 @@ void
 memtable::apply(const mutation& m, db::rp_handle&& h) {
     with_allocator(allocator(), [this, &m] {
         _allocating_section(*this, [&, this] {
-            auto& p = find_or_create_partition(m.decorated_key());
+            auto& e = find_or_create_partition(m.decorated_key());
             _stats_collector.update(*m.schema(), m.partition());
-            p.apply(*_schema, m.partition(), *m.schema(), _table_stats.memtable_app_stats);
+            apply_to_entry(e, m.partition(), *m.schema());
         });
     });
     update(std::move(h));
@@ -796,17 +919,58 @@ void
 memtable::apply(const frozen_mutation& m, const schema_ptr& m_schema, db::rp_handle&& h) {
     with_allocator(allocator(), [this, &m, &m_schema] {
         _allocating_section(*this, [&, this] {
-            auto& p = find_or_create_partition_slow(m.key());
+            auto& e = find_or_create_partition_slow(m.key());
             mutation_partition mp(m_schema);
             partition_builder pb(*m_schema, mp);
             m.partition().accept(*m_schema, pb);
             _stats_collector.update(*m_schema, mp);
-            p.apply(*_schema, std::move(mp), *m_schema, _table_stats.memtable_app_stats);
+            if (!try_append_columnar_rows(e, mp, *m_schema)) {
+                e.partition().apply(*_schema, std::move(mp), *m_schema, _table_stats.memtable_app_stats);
+            }
         });
     });
     update(std::move(h));
 }
 
+void memtable::apply_to_entry(memtable_entry& e, const mutation_partition& mp, const schema& mp_schema) {
+    if (!try_append_columnar_rows(e, mp, mp_schema)) {
+        e.partition().apply(*_schema, mp, mp_schema, _table_stats.memtable_app_stats);
+    }
+}
+
+bool memtable::try_append_columnar_rows(memtable_entry& e, const mutation_partition& mp, const schema& mp_schema) {
+    if (!_columnar_rows || mp_schema.version() != _schema->version() || e._schema != _schema) {
+        return false;
+    }
+    if (e._columnar) {
+        if (!e._columnar->can_append(*_schema, mp)) {
+            return false;
+        }
+        e._columnar->append(*_schema, mp);
+    } else {
+        columnar_rows rows;
+        if (!rows.can_append(*_schema, mp)) {
+            return false;
+        }
+        rows.append(*_schema, mp);
+        e._columnar = make_managed<columnar_rows>(std::move(rows));
+    }
+    _table_stats.memtable_app_stats.row_writes += mp.row_count();
+    return true;
+}
+
+// Rows in the columnar layout are encoded for the schema of the entry, so they are
+// moved to the partition_entry, which knows how to upgrade them, before the schema changes.
+void memtable::fold_columnar_rows(memtable_entry& e) {
+    if (!e._columnar) {
+        return;
+    }
+    mutation_partition mp(e._schema);
+    e._columnar->apply_to(*e._schema, mp);
+    e.partition().apply(*e._schema, std::move(mp), *e._schema, _table_stats.memtable_app_stats);
+    e._columnar = {};
+}
+
 logalloc::occupancy_stats memtable::occupancy() const {
     return logalloc::region::occupancy();
 }
@@ -828,13 +992,19 @@ memtable_entry::memtable_entry(memtable_entry&& o) noexcept
     : _schema(std::move(o._schema))
     , _key(std::move(o._key))
     , _pe(std::move(o._pe))
+    , _columnar(std::move(o._columnar))
     , _flags(o._flags)
 { }
 
 stop_iteration memtable_entry::clear_gently() noexcept {
+    _columnar = {};
     return _pe.clear_gently(no_cache_tracker);
 }
 
+columnar_rows_cursor memtable_entry::read_columnar_rows(const query::clustering_row_ranges& ranges, bool reversed) const {
+    return _columnar ? _columnar->read(_schema, ranges, reversed) : columnar_rows_cursor();
+}
+
 void memtable::mark_flushed(mutation_source underlying) noexcept {
     _underlying = std::move(underlying);
 }
@@ -858,6 +1028,7 @@ void memtable::upgrade_entry(memtable_entry& e) {
     if (e._schema != _schema) {
         assert(!reclaiming_enabled());
         with_allocator(allocator(), [this, &e] {
+            fold_columnar_rows(e);
             e.upgrade_schema(_schema, cleaner());
         });
     }
@@ -877,5 +1048,9 @@ std::ostream& operator<<(std::ostream& out, memtable& mt) {
 }
 
 std::ostream& operator<<(std::ostream& out, const memtable_entry& mt) {
-    return out << "{" << mt.key() << ": " << partition_entry::printer(*mt.schema(), mt.partition()) << "}";
+    out << "{" << mt.key() << ": " << partition_entry::printer(*mt.schema(), mt.partition());
+    if (mt.has_columnar_rows()) {
+        out << ", columnar rows: " << mt._columnar->size();
+    }
+    return out << "}";
 }
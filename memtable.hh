@@ -35,6 +35,8 @@
 #include "mutation_cleaner.hh"
 #include "sstables/types.hh"
 #include "utils/double-decker.hh"
+#include "utils/managed_ref.hh"
+#include "columnar_rows.hh"
 
 class frozen_mutation;
 class flat_mutation_reader;
@@ -46,6 +48,8 @@ class memtable_entry {
     schema_ptr _schema;
     dht::decorated_key _key;
     partition_entry _pe;
+    // Rows appended in the columnar layout, in addition to those in _pe.
+    managed_ref<columnar_rows> _columnar;
     struct {
         bool _head : 1;
         bool _tail : 1;
@@ -79,6 +83,11 @@ class memtable_entry {
     schema_ptr& schema() { return _schema; }
     partition_snapshot_ptr snapshot(memtable& mtbl);
 
+    bool has_columnar_rows() const noexcept { return bool(_columnar); }
+    // Returns a cursor over the rows stored in the columnar layout within ranges, in
+    // clustering order, or in reverse clustering order if reversed is set.
+    columnar_rows_cursor read_columnar_rows(const query::clustering_row_ranges& ranges, bool reversed) const;
+
     // Makes the entry conform to given schema.
     // Must be called under allocating section of the region which owns the entry.
     void upgrade_schema(const schema_ptr&, mutation_cleaner&);
@@ -87,6 +96,10 @@ class memtable_entry {
         return _key.key().external_memory_usage();
     }
 
+    size_t columnar_rows_memory_usage() const {
+        return _columnar ? sizeof(columnar_rows) + _columnar->external_memory_usage() : 0;
+    }
+
     size_t object_memory_size(allocation_strategy& allocator);
 
     size_t size_in_allocator_without_rows(allocation_strategy& allocator) {
@@ -98,7 +111,7 @@ class memtable_entry {
         for (auto&& v : _pe.versions()) {
             size += v.size_in_allocator(*_schema, allocator);
         }
-        return size;
+        return size + columnar_rows_memory_usage();
     }
 
     friend dht::ring_position_view ring_position_view_to_compare(const memtable_entry& mt) { return mt._key; }
@@ -134,6 +147,8 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
     mutation_source_opt _underlying;
     uint64_t _flushed_memory = 0;
     table_stats& _table_stats;
+    // Whether rows can be appended to partitions in the columnar layout (see columnar_rows).
+    bool _columnar_rows;
 
     class memtable_encoding_stats_collector : public encoding_stats_collector {
     private:
@@ -170,8 +185,11 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
     friend class partition_snapshot_read_accounter;
 private:
     boost::iterator_range<partitions_type::const_iterator> slice(const dht::partition_range& r) const;
-    partition_entry& find_or_create_partition(const dht::decorated_key& key);
-    partition_entry& find_or_create_partition_slow(partition_key_view key);
+    memtable_entry& find_or_create_partition(const dht::decorated_key& key);
+    memtable_entry& find_or_create_partition_slow(partition_key_view key);
+    void apply_to_entry(memtable_entry& e, const mutation_partition& mp, const schema& mp_schema);
+    bool try_append_columnar_rows(memtable_entry& e, const mutation_partition& mp, const schema& mp_schema);
+    void fold_columnar_rows(memtable_entry& e);
     void upgrade_entry(memtable_entry&);
     void add_flushed_memory(uint64_t);
     void remove_flushed_memory(uint64_t);
@@ -179,7 +197,7 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
     uint64_t dirty_size() const;
 public:
     explicit memtable(schema_ptr schema, dirty_memory_manager&, table_stats& table_stats, memtable_list *memtable_list = nullptr,
-            seastar::scheduling_group compaction_scheduling_group = seastar::current_scheduling_group());
+            seastar::scheduling_group compaction_scheduling_group = seastar::current_scheduling_group(), bool enable_columnar_rows = false);
     // Used for testing that want to control the flush process.
     explicit memtable(schema_ptr schema);
     ~memtable();
@@ -263,6 +281,14 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
 
     flat_mutation_reader make_flush_reader(schema_ptr, reader_permit permit, const io_priority_class& pc);
 
+    // Reads only the partitions of the memtable within range, which has to be kept alive
+    // as long as the reader is used. The readers of disjoint ranges can flush a memtable concurrently.
+    flat_mutation_reader make_flush_reader(schema_ptr, reader_permit permit, const io_priority_class& pc, const dht::partition_range& range);
+
+    // Splits the ring into at most n ranges which hold about the same span of the memtable's tokens,
+    // to be flushed concurrently (see make_flush_reader()).
+    dht::partition_range_vector split_for_flush(unsigned n) const;
+
     mutation_source as_data_source();
 
     bool empty() const { return partitions.empty(); }
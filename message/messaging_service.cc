@@ -55,6 +55,7 @@
 #include "idl/token.dist.hh"
 #include "idl/gossip_digest.dist.hh"
 #include "idl/read_command.dist.hh"
+#include "idl/forward_request.dist.hh"
 #include "idl/range.dist.hh"
 #include "idl/partition_checksum.dist.hh"
 #include "idl/query.dist.hh"
@@ -80,6 +81,7 @@
 #include "idl/token.dist.impl.hh"
 #include "idl/gossip_digest.dist.impl.hh"
 #include "idl/read_command.dist.impl.hh"
+#include "idl/forward_request.dist.impl.hh"
 #include "idl/range.dist.impl.hh"
 #include "idl/partition_checksum.dist.impl.hh"
 #include "idl/query.dist.impl.hh"
@@ -456,6 +458,7 @@ static constexpr unsigned do_get_rpc_client_idx(messaging_verb verb) {
     case messaging_verb::REPLICATION_FINISHED:
     case messaging_verb::UNUSED__REPAIR_CHECKSUM_RANGE:
     case messaging_verb::STREAM_MUTATION_FRAGMENTS:
+    case messaging_verb::STREAM_SSTABLE_FILES:
     case messaging_verb::REPAIR_ROW_LEVEL_START:
     case messaging_verb::REPAIR_ROW_LEVEL_STOP:
     case messaging_verb::REPAIR_GET_FULL_ROW_HASHES:
@@ -469,6 +472,7 @@ static constexpr unsigned do_get_rpc_client_idx(messaging_verb verb) {
     case messaging_verb::REPAIR_GET_ROW_DIFF_WITH_RPC_STREAM:
     case messaging_verb::REPAIR_PUT_ROW_DIFF_WITH_RPC_STREAM:
     case messaging_verb::REPAIR_GET_FULL_ROW_HASHES_WITH_RPC_STREAM:
+    case messaging_verb::REPAIR_GET_RANGE_HASHES:
     case messaging_verb::NODE_OPS_CMD:
     case messaging_verb::HINT_MUTATION:
         return 1;
@@ -477,6 +481,7 @@ static constexpr unsigned do_get_rpc_client_idx(messaging_verb verb) {
     case messaging_verb::READ_DATA:
     case messaging_verb::READ_MUTATION_DATA:
     case messaging_verb::READ_DIGEST:
+    case messaging_verb::FORWARD_REQUEST:
     case messaging_verb::DEFINITIONS_UPDATE:
     case messaging_verb::TRUNCATE:
     case messaging_verb::MIGRATION_REQUEST:
@@ -793,6 +798,35 @@ future<> messaging_service::unregister_stream_mutation_fragments() {
     return unregister_handler(messaging_verb::STREAM_MUTATION_FRAGMENTS);
 }
 
+rpc::sink<int32_t> messaging_service::make_sink_for_stream_sstable_files(rpc::source<streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd>& source) {
+    return source.make_sink<netw::serializer, int32_t>();
+}
+
+future<std::tuple<rpc::sink<streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd>, rpc::source<int32_t>>>
+messaging_service::make_sink_and_source_for_stream_sstable_files(utils::UUID schema_id, utils::UUID plan_id, utils::UUID cf_id, streaming::stream_reason reason, msg_addr id) {
+    using value_type = std::tuple<rpc::sink<streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd>, rpc::source<int32_t>>;
+    if (is_shutting_down()) {
+        return make_exception_future<value_type>(rpc::closed_error());
+    }
+    auto rpc_client = get_rpc_client(messaging_verb::STREAM_SSTABLE_FILES, id);
+    return rpc_client->make_stream_sink<netw::serializer, streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd>().then([this, plan_id, schema_id, cf_id, reason, rpc_client] (rpc::sink<streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd> sink) mutable {
+        auto rpc_handler = rpc()->make_client<rpc::source<int32_t> (utils::UUID, utils::UUID, utils::UUID, streaming::stream_reason, rpc::sink<streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd>)>(messaging_verb::STREAM_SSTABLE_FILES);
+        return rpc_handler(*rpc_client , plan_id, schema_id, cf_id, reason, sink).then_wrapped([sink, rpc_client] (future<rpc::source<int32_t>> source) mutable {
+            return (source.failed() ? sink.close() : make_ready_future<>()).then([sink = std::move(sink), source = std::move(source)] () mutable {
+                return make_ready_future<value_type>(value_type(std::move(sink), source.get0()));
+            });
+        });
+    });
+}
+
+void messaging_service::register_stream_sstable_files(std::function<future<rpc::sink<int32_t>> (const rpc::client_info& cinfo, UUID plan_id, UUID schema_id, UUID cf_id, streaming::stream_reason reason, rpc::source<streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd> source)>&& func) {
+    register_handler(this, messaging_verb::STREAM_SSTABLE_FILES, std::move(func));
+}
+
+future<> messaging_service::unregister_stream_sstable_files() {
+    return unregister_handler(messaging_verb::STREAM_SSTABLE_FILES);
+}
+
 template<class SinkType, class SourceType>
 future<std::tuple<rpc::sink<SinkType>, rpc::source<SourceType>>>
 do_make_sink_source(messaging_verb verb, uint32_t repair_meta_id, shared_ptr<messaging_service::rpc_protocol_client_wrapper> rpc_client, std::unique_ptr<messaging_service::rpc_protocol_wrapper>& rpc) {
@@ -1071,6 +1105,16 @@ future<rpc::tuple<query::result, rpc::optional<cache_temperature>>> messaging_se
     return send_message_timeout<future<rpc::tuple<query::result, rpc::optional<cache_temperature>>>>(this, messaging_verb::READ_DATA, std::move(id), timeout, cmd, pr, da);
 }
 
+void messaging_service::register_forward_request(std::function<future<query::forward_result> (const rpc::client_info&, rpc::opt_time_point t, query::forward_request req)>&& func) {
+    register_handler(this, netw::messaging_verb::FORWARD_REQUEST, std::move(func));
+}
+future<> messaging_service::unregister_forward_request() {
+    return unregister_handler(netw::messaging_verb::FORWARD_REQUEST);
+}
+future<query::forward_result> messaging_service::send_forward_request(msg_addr id, clock_type::time_point timeout, const query::forward_request& req) {
+    return send_message_timeout<query::forward_result>(this, messaging_verb::FORWARD_REQUEST, std::move(id), timeout, req);
+}
+
 void messaging_service::register_get_schema_version(std::function<future<frozen_schema>(unsigned, table_schema_version)>&& func) {
     register_handler(this, netw::messaging_verb::GET_SCHEMA_VERSION, std::move(func));
 }
@@ -1191,25 +1235,25 @@ future<> messaging_service::send_repair_put_row_diff(msg_addr id, uint32_t repai
 }
 
 // Wrapper for REPAIR_ROW_LEVEL_START
-void messaging_service::register_repair_row_level_start(std::function<future<repair_row_level_start_response> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, rpc::optional<streaming::stream_reason> reason)>&& func) {
+void messaging_service::register_repair_row_level_start(std::function<future<repair_row_level_start_response> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, rpc::optional<streaming::stream_reason> reason, rpc::optional<bool> incremental)>&& func) {
     register_handler(this, messaging_verb::REPAIR_ROW_LEVEL_START, std::move(func));
 }
 future<> messaging_service::unregister_repair_row_level_start() {
     return unregister_handler(messaging_verb::REPAIR_ROW_LEVEL_START);
 }
-future<rpc::optional<repair_row_level_start_response>> messaging_service::send_repair_row_level_start(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, streaming::stream_reason reason) {
-    return send_message<rpc::optional<repair_row_level_start_response>>(this, messaging_verb::REPAIR_ROW_LEVEL_START, std::move(id), repair_meta_id, std::move(keyspace_name), std::move(cf_name), std::move(range), algo, max_row_buf_size, seed, remote_shard, remote_shard_count, remote_ignore_msb, std::move(remote_partitioner_name), std::move(schema_version), reason);
+future<rpc::optional<repair_row_level_start_response>> messaging_service::send_repair_row_level_start(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, streaming::stream_reason reason, bool incremental) {
+    return send_message<rpc::optional<repair_row_level_start_response>>(this, messaging_verb::REPAIR_ROW_LEVEL_START, std::move(id), repair_meta_id, std::move(keyspace_name), std::move(cf_name), std::move(range), algo, max_row_buf_size, seed, remote_shard, remote_shard_count, remote_ignore_msb, std::move(remote_partitioner_name), std::move(schema_version), reason, incremental);
 }
 
 // Wrapper for REPAIR_ROW_LEVEL_STOP
-void messaging_service::register_repair_row_level_stop(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range)>&& func) {
+void messaging_service::register_repair_row_level_stop(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, rpc::optional<bool> mark_repaired)>&& func) {
     register_handler(this, messaging_verb::REPAIR_ROW_LEVEL_STOP, std::move(func));
 }
 future<> messaging_service::unregister_repair_row_level_stop() {
     return unregister_handler(messaging_verb::REPAIR_ROW_LEVEL_STOP);
 }
-future<> messaging_service::send_repair_row_level_stop(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range) {
-    return send_message<void>(this, messaging_verb::REPAIR_ROW_LEVEL_STOP, std::move(id), repair_meta_id, std::move(keyspace_name), std::move(cf_name), std::move(range));
+future<> messaging_service::send_repair_row_level_stop(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, bool mark_repaired) {
+    return send_message<void>(this, messaging_verb::REPAIR_ROW_LEVEL_STOP, std::move(id), repair_meta_id, std::move(keyspace_name), std::move(cf_name), std::move(range), mark_repaired);
 }
 
 // Wrapper for REPAIR_GET_ESTIMATED_PARTITIONS
@@ -1245,6 +1289,17 @@ future<std::vector<row_level_diff_detect_algorithm>> messaging_service::send_rep
     return send_message<future<std::vector<row_level_diff_detect_algorithm>>>(this, messaging_verb::REPAIR_GET_DIFF_ALGORITHMS, std::move(id));
 }
 
+// Wrapper for REPAIR_GET_RANGE_HASHES
+void messaging_service::register_repair_get_range_hashes(std::function<future<std::vector<repair_hash>> (const rpc::client_info& cinfo, uint32_t repair_meta_id, uint32_t nr_leaves)>&& func) {
+    register_handler(this, messaging_verb::REPAIR_GET_RANGE_HASHES, std::move(func));
+}
+future<> messaging_service::unregister_repair_get_range_hashes() {
+    return unregister_handler(messaging_verb::REPAIR_GET_RANGE_HASHES);
+}
+future<std::vector<repair_hash>> messaging_service::send_repair_get_range_hashes(msg_addr id, uint32_t repair_meta_id, uint32_t nr_leaves) {
+    return send_message<future<std::vector<repair_hash>>>(this, messaging_verb::REPAIR_GET_RANGE_HASHES, std::move(id), repair_meta_id, nr_leaves);
+}
+
 // Wrapper for NODE_OPS_CMD
 void messaging_service::register_node_ops_cmd(std::function<future<node_ops_cmd_response> (const rpc::client_info& cinfo, node_ops_cmd_request)>&& func) {
     register_handler(this, messaging_verb::NODE_OPS_CMD, std::move(func));
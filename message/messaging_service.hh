@@ -38,6 +38,7 @@
 #include "digest_algorithm.hh"
 #include "streaming/stream_reason.hh"
 #include "streaming/stream_mutation_fragments_cmd.hh"
+#include "streaming/stream_sstable_files.hh"
 #include "cache_temperature.hh"
 #include "service/paxos/prepare_response.hh"
 #include "raft/raft.hh"
@@ -86,6 +87,8 @@ namespace query {
     using partition_range = dht::partition_range;
     class read_command;
     class result;
+    struct forward_request;
+    struct forward_result;
 }
 
 namespace compat {
@@ -161,7 +164,10 @@ enum class messaging_verb : int32_t {
     RAFT_MODIFY_CONFIG = 56,
     GROUP0_PEER_EXCHANGE = 57,
     GROUP0_MODIFY_CONFIG = 58,
-    LAST = 59,
+    FORWARD_REQUEST = 59,
+    STREAM_SSTABLE_FILES = 60,
+    REPAIR_GET_RANGE_HASHES = 61,
+    LAST = 62,
 };
 
 } // namespace netw
@@ -331,6 +337,13 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     rpc::sink<int32_t> make_sink_for_stream_mutation_fragments(rpc::source<frozen_mutation_fragment, rpc::optional<streaming::stream_mutation_fragments_cmd>>& source);
     future<std::tuple<rpc::sink<frozen_mutation_fragment, streaming::stream_mutation_fragments_cmd>, rpc::source<int32_t>>> make_sink_and_source_for_stream_mutation_fragments(utils::UUID schema_id, utils::UUID plan_id, utils::UUID cf_id, uint64_t estimated_partitions, streaming::stream_reason reason, msg_addr id);
 
+    // Wrapper for STREAM_SSTABLE_FILES
+    // Like STREAM_MUTATION_FRAGMENTS, the receiver sends a status code to the sender once it has written the files, or failed to.
+    void register_stream_sstable_files(std::function<future<rpc::sink<int32_t>> (const rpc::client_info& cinfo, UUID plan_id, UUID schema_id, UUID cf_id, streaming::stream_reason reason, rpc::source<streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd> source)>&& func);
+    future<> unregister_stream_sstable_files();
+    rpc::sink<int32_t> make_sink_for_stream_sstable_files(rpc::source<streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd>& source);
+    future<std::tuple<rpc::sink<streaming::stream_sstable_file_chunk, streaming::stream_sstable_files_cmd>, rpc::source<int32_t>>> make_sink_and_source_for_stream_sstable_files(utils::UUID schema_id, utils::UUID plan_id, utils::UUID cf_id, streaming::stream_reason reason, msg_addr id);
+
     // Wrapper for REPAIR_GET_ROW_DIFF_WITH_RPC_STREAM
     future<std::tuple<rpc::sink<repair_hash_with_cmd>, rpc::source<repair_row_on_wire_with_cmd>>> make_sink_and_source_for_repair_get_row_diff_with_rpc_stream(uint32_t repair_meta_id, msg_addr id);
     rpc::sink<repair_row_on_wire_with_cmd> make_sink_for_repair_get_row_diff_with_rpc_stream(rpc::source<repair_hash_with_cmd>& source);
@@ -383,14 +396,14 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     future<> send_repair_put_row_diff(msg_addr id, uint32_t repair_meta_id, repair_rows_on_wire row_diff);
 
     // Wrapper for REPAIR_ROW_LEVEL_START
-    void register_repair_row_level_start(std::function<future<repair_row_level_start_response> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, rpc::optional<streaming::stream_reason> reason)>&& func);
+    void register_repair_row_level_start(std::function<future<repair_row_level_start_response> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, rpc::optional<streaming::stream_reason> reason, rpc::optional<bool> incremental)>&& func);
     future<> unregister_repair_row_level_start();
-    future<rpc::optional<repair_row_level_start_response>> send_repair_row_level_start(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, streaming::stream_reason reason);
+    future<rpc::optional<repair_row_level_start_response>> send_repair_row_level_start(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed, unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, streaming::stream_reason reason, bool incremental);
 
     // Wrapper for REPAIR_ROW_LEVEL_STOP
-    void register_repair_row_level_stop(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range)>&& func);
+    void register_repair_row_level_stop(std::function<future<> (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, rpc::optional<bool> mark_repaired)>&& func);
     future<> unregister_repair_row_level_stop();
-    future<> send_repair_row_level_stop(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range);
+    future<> send_repair_row_level_stop(msg_addr id, uint32_t repair_meta_id, sstring keyspace_name, sstring cf_name, dht::token_range range, bool mark_repaired);
 
     // Wrapper for REPAIR_GET_ESTIMATED_PARTITIONS
     void register_repair_get_estimated_partitions(std::function<future<uint64_t> (const rpc::client_info& cinfo, uint32_t repair_meta_id)>&& func);
@@ -407,6 +420,11 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     future<> unregister_repair_get_diff_algorithms();
     future<std::vector<row_level_diff_detect_algorithm>> send_repair_get_diff_algorithms(msg_addr id);
 
+    // Wrapper for REPAIR_GET_RANGE_HASHES
+    void register_repair_get_range_hashes(std::function<future<std::vector<repair_hash>> (const rpc::client_info& cinfo, uint32_t repair_meta_id, uint32_t nr_leaves)>&& func);
+    future<> unregister_repair_get_range_hashes();
+    future<std::vector<repair_hash>> send_repair_get_range_hashes(msg_addr id, uint32_t repair_meta_id, uint32_t nr_leaves);
+
     // Wrapper for NODE_OPS_CMD
     void register_node_ops_cmd(std::function<future<node_ops_cmd_response> (const rpc::client_info& cinfo, node_ops_cmd_request)>&& func);
     future<> unregister_node_ops_cmd();
@@ -505,6 +523,11 @@ class messaging_service : public seastar::async_sharded_service<messaging_servic
     future<> unregister_read_digest();
     future<rpc::tuple<query::result_digest, rpc::optional<api::timestamp_type>, rpc::optional<cache_temperature>>> send_read_digest(msg_addr id, clock_type::time_point timeout, const query::read_command& cmd, const dht::partition_range& pr, query::digest_algorithm da);
 
+    // Wrapper for FORWARD_REQUEST
+    void register_forward_request(std::function<future<query::forward_result> (const rpc::client_info&, rpc::opt_time_point timeout, query::forward_request)>&& func);
+    future<> unregister_forward_request();
+    future<query::forward_result> send_forward_request(msg_addr id, clock_type::time_point timeout, const query::forward_request& req);
+
     // Wrapper for TRUNCATE
     void register_truncate(std::function<future<>(sstring, sstring)>&& func);
     future<> unregister_truncate();
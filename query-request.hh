@@ -31,6 +31,7 @@
 #include "tracing/tracing.hh"
 #include "utils/small_vector.hh"
 #include "query_class_config.hh"
+#include "db/consistency_level_type.hh"
 
 class position_in_partition_view;
 class partition_slice_builder;
@@ -174,6 +175,17 @@ class partition_slice {
         // directly, bypassing the intermediate reconcilable_result format used
         // in pre 4.5 range scans.
         range_scan_data_variant,
+        // Lets sstable readers skip the values of cells of columns which are
+        // not selected, when the liveness of the row can't depend on them.
+        // Such cells are still emitted, with an empty value, so that they keep
+        // shadowing older cells.
+        // Only safe for reads which build query::result directly and don't
+        // populate the cache. Local to the replica, never sent over the wire.
+        skip_unselected_values,
+        // Marks the reads which warm up the cache after a restart. They populate
+        // the cache, but don't count towards the ranking of hot partitions, which
+        // should reflect the real traffic. Local to the replica, never sent over the wire.
+        cache_warm_up,
     };
     using option_set = enum_set<super_enum<option,
         option::send_clustering_key,
@@ -188,7 +200,9 @@ class partition_slice {
         option::with_digest,
         option::bypass_cache,
         option::always_return_static_content,
-        option::range_scan_data_variant>>;
+        option::range_scan_data_variant,
+        option::skip_unselected_values,
+        option::cache_warm_up>>;
     clustering_row_ranges _row_ranges;
 public:
     column_id_vector static_columns; // TODO: consider using bitmap
@@ -372,4 +386,31 @@ class read_command {
     friend std::ostream& operator<<(std::ostream& out, const read_command& r);
 };
 
+// A request to compute partial results of aggregates over the given ranges,
+// sent by a coordinator to the replicas owning them. Replicas reply with
+// a forward_result, which the coordinator merges into the final results.
+struct forward_request {
+    // A reducible aggregate function, see aggregate_function::is_reducible(),
+    // applied to the named columns.
+    struct aggregation_info {
+        sstring function_keyspace;
+        sstring function_name;
+        std::vector<bytes> column_names;
+    };
+
+    std::vector<aggregation_info> aggregations;
+    // Columns of the selection the aggregates were taken from, in its order.
+    std::vector<bytes> column_names;
+    query::read_command cmd;
+    dht::partition_range_vector pr;
+    db::consistency_level cl;
+};
+
+// The partial states of the aggregates of a forward_request, in the same order.
+struct forward_result {
+    std::vector<bytes_opt> query_results;
+};
+
+std::ostream& operator<<(std::ostream& out, const forward_request& r);
+
 }
@@ -73,6 +73,17 @@ std::ostream& operator<<(std::ostream& out, const read_command& r) {
         << "}";
 }
 
+std::ostream& operator<<(std::ostream& out, const forward_request& r) {
+    out << "forward_request{aggregations=[";
+    for (auto& a : r.aggregations) {
+        out << a.function_keyspace << "." << a.function_name << ", ";
+    }
+    return out << "], cmd=" << r.cmd
+        << ", pr=[" << join(", ", r.pr) << "]"
+        << ", cl=" << r.cl
+        << "}";
+}
+
 std::ostream& operator<<(std::ostream& out, const specific_ranges& s) {
     return out << "{" << s._pk << " : " << join(", ", s._ranges) << "}";
 }
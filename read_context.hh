@@ -159,6 +159,9 @@ class read_context final : public enable_lw_shared_from_this<read_context> {
     std::optional<dht::decorated_key> _key;
     bool _partition_exists;
     row_cache::phase_type _phase;
+    // False when data of the current partition read from the underlying source
+    // must not be added to cache, see cache_tracker::admit().
+    bool _admitted = true;
 public:
     read_context(row_cache& cache,
             schema_ptr schema,
@@ -213,6 +216,8 @@ class read_context final : public enable_lw_shared_from_this<read_context> {
     row_cache::phase_type phase() const { return _phase; }
     const dht::decorated_key& key() const { return *_key; }
     bool partition_exists() const { return _partition_exists; }
+    bool admitted() const { return _admitted; }
+    void set_admitted(bool admitted) { _admitted = admitted; }
     void on_underlying_created() { ++_underlying_created; }
     bool digest_requested() const { return _slice.options.contains<query::partition_slice::option::with_digest>(); }
 public:
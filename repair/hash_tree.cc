@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "repair/hash_tree.hh"
+
+static int64_t range_first(const dht::token_range& range) {
+    if (!range.start() || range.start()->value().is_minimum()) {
+        return std::numeric_limits<int64_t>::min();
+    }
+    return dht::token::to_int64(range.start()->value());
+}
+
+static int64_t range_last(const dht::token_range& range) {
+    if (!range.end() || range.end()->value().is_maximum()) {
+        return std::numeric_limits<int64_t>::max();
+    }
+    return dht::token::to_int64(range.end()->value());
+}
+
+// Both replicas of a range must split it the same way, so the split points
+// depend only on the range and the number of leaves.
+static std::vector<dht::token> make_split_points(const dht::token_range& range, unsigned nr_leaves) {
+    const auto first = range_first(range);
+    const auto last = range_last(range);
+    std::vector<dht::token> points;
+    if (last <= first) {
+        return points;
+    }
+    const uint64_t span = uint64_t(last) - uint64_t(first);
+    const uint64_t count = std::min(uint64_t(std::max(nr_leaves, 1u)), span);
+    points.reserve(count - 1);
+    for (uint64_t i = 1; i < count; ++i) {
+        points.push_back(dht::token::from_int64(int64_t(uint64_t(first) + span / count * i)));
+    }
+    return points;
+}
+
+repair_hash_tree::repair_hash_tree(dht::token_range range, table_schema_version schema_version, unsigned nr_leaves)
+    : _range(std::move(range))
+    , _schema_version(schema_version)
+    , _nr_leaves_requested(nr_leaves)
+    , _split_points(make_split_points(_range, nr_leaves))
+    , _leaves(_split_points.size() + 1)
+{ }
+
+dht::token_range repair_hash_tree::leaf_range(size_t i) const {
+    auto start = i == 0 ? _range.start() : dht::token_range::bound(_split_points[i - 1], false);
+    auto end = i == _split_points.size() ? _range.end() : dht::token_range::bound(_split_points[i], true);
+    return dht::token_range(std::move(start), std::move(end));
+}
+
+void repair_hash_tree::invalidate(const dht::token_range& range) {
+    if (!range.overlaps(_range, dht::token_comparator())) {
+        return;
+    }
+    auto first = range.start()
+            ? std::lower_bound(_split_points.begin(), _split_points.end(), range.start()->value()) - _split_points.begin()
+            : 0;
+    auto last = range.end()
+            ? std::lower_bound(_split_points.begin(), _split_points.end(), range.end()->value()) - _split_points.begin()
+            : _split_points.size();
+    for (auto i = first; i <= last; ++i) {
+        _leaves[i].hash.reset();
+        ++_leaves[i].generation;
+    }
+}
+
+size_t repair_hash_tree::memory_usage() const noexcept {
+    return sizeof(*this) + _split_points.capacity() * sizeof(dht::token) + _leaves.capacity() * sizeof(leaf);
+}
+
+std::optional<dht::token_range_vector> find_unsynced_ranges(const repair_hash_tree& tree, const std::vector<std::vector<repair_hash>>& hashes) {
+    if (!std::all_of(hashes.begin(), hashes.end(), [&] (const std::vector<repair_hash>& h) { return h.size() == tree.size(); })) {
+        return std::nullopt;
+    }
+    dht::token_range_vector ranges;
+    std::optional<size_t> first_unsynced;
+    for (size_t i = 0; i <= tree.size(); ++i) {
+        bool synced = i == tree.size() || std::all_of(hashes.begin(), hashes.end(), [&] (const std::vector<repair_hash>& h) {
+            return h[i] == hashes.front()[i];
+        });
+        if (!synced && !first_unsynced) {
+            first_unsynced = i;
+        } else if (synced && first_unsynced) {
+            ranges.emplace_back(tree.leaf_range(*first_unsynced).start(), tree.leaf_range(i - 1).end());
+            first_unsynced.reset();
+        }
+    }
+    return ranges;
+}
+
+repair_hash_trees::repair_hash_trees(size_t max_memory)
+    : _max_memory(max_memory)
+{ }
+
+void repair_hash_trees::erase(table_trees& trees, table_trees::iterator it) {
+    _memory_usage -= it->second->memory_usage();
+    --_nr_trees;
+    trees.erase(it);
+}
+
+void repair_hash_trees::evict_least_recently_used() {
+    table_trees* victim_trees = nullptr;
+    table_trees::iterator victim;
+    for (auto& [id, trees] : _tables) {
+        for (auto it = trees.begin(); it != trees.end(); ++it) {
+            if (!victim_trees || it->second->last_used() < victim->second->last_used()) {
+                victim_trees = &trees;
+                victim = it;
+            }
+        }
+    }
+    if (victim_trees) {
+        erase(*victim_trees, victim);
+    }
+}
+
+lw_shared_ptr<repair_hash_tree> repair_hash_trees::get(const schema& s, const dht::token_range& range, unsigned nr_leaves) {
+    auto& trees = _tables[s.id()];
+    auto key = range.end() ? range.end()->value() : dht::maximum_token();
+    auto cmp = dht::token_comparator();
+
+    auto it = trees.find(key);
+    if (it != trees.end()) {
+        auto& tree = *it->second;
+        if (tree.range().equal(range, cmp) && tree.nr_leaves_requested() == nr_leaves && tree.schema_version() == s.version()) {
+            tree.touch(++_uses);
+            return it->second;
+        }
+    }
+
+    it = range.start() ? trees.lower_bound(range.start()->value()) : trees.begin();
+    while (it != trees.end()) {
+        auto& other = it->second->range();
+        if (other.start() && range.after(other.start()->value(), cmp)) {
+            break;
+        }
+        if (other.overlaps(range, cmp)) {
+            erase(trees, it++);
+        } else {
+            ++it;
+        }
+    }
+
+    auto tree = make_lw_shared<repair_hash_tree>(range, s.version(), nr_leaves);
+    while (_nr_trees && _memory_usage + tree->memory_usage() > _max_memory) {
+        evict_least_recently_used();
+    }
+    tree->touch(++_uses);
+    trees.emplace(key, tree);
+    _memory_usage += tree->memory_usage();
+    ++_nr_trees;
+    return tree;
+}
+
+void repair_hash_trees::invalidate(const schema& s, const dht::partition_range& range) {
+    auto table = _tables.find(s.id());
+    if (table == _tables.end()) {
+        return;
+    }
+    auto& trees = table->second;
+    // Widen the partition range to whole tokens.
+    auto start = range.start() ? std::optional(dht::token_range::bound(range.start()->value().token(), true)) : std::nullopt;
+    auto end = range.end() ? std::optional(dht::token_range::bound(range.end()->value().token(), true)) : std::nullopt;
+    auto tr = dht::token_range(std::move(start), std::move(end));
+    auto cmp = dht::token_comparator();
+
+    for (auto it = tr.start() ? trees.lower_bound(tr.start()->value()) : trees.begin(); it != trees.end(); ++it) {
+        auto& tree = *it->second;
+        if (tree.range().start() && tr.after(tree.range().start()->value(), cmp)) {
+            break;
+        }
+        tree.invalidate(tr);
+    }
+}
+
+void repair_hash_trees::on_change(const schema_ptr& s, const dht::partition_range& range) {
+    invalidate(*s, range);
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <seastar/core/shared_ptr.hh>
+
+#include "db/data_listeners.hh"
+#include "dht/i_partitioner.hh"
+#include "repair/repair.hh"
+#include "schema.hh"
+
+// The hashes of the data a shard holds in one repair range of a table.
+//
+// The range is split into leaves, sub-ranges of equal token width, each of
+// which has the combined hash of all the mutation fragments in it. Replicas
+// which split the same range into the same number of leaves can compare
+// their leaves and repair only the sub-ranges whose hashes differ.
+//
+// A leaf loses its hash when the data in its sub-range changes and gets it
+// back when a repair hashes the sub-range again, so a repair of a range
+// which barely changed since the last one only reads a few leaves.
+//
+// Trees are kept in memory only. After a restart, the first repair of each
+// range hashes all of its leaves again.
+class repair_hash_tree {
+public:
+    struct leaf {
+        std::optional<repair_hash> hash;
+        // Bumped on every invalidation, so that a hash computed while
+        // the data of the leaf changed is not kept.
+        uint64_t generation = 0;
+    };
+private:
+    dht::token_range _range;
+    table_schema_version _schema_version;
+    unsigned _nr_leaves_requested;
+    // Leaf i ends at _split_points[i] (inclusive) and the next leaf starts
+    // right after it. The first and last leaves extend to the range bounds.
+    std::vector<dht::token> _split_points;
+    std::vector<leaf> _leaves;
+    uint64_t _last_used = 0;
+public:
+    repair_hash_tree(dht::token_range range, table_schema_version schema_version, unsigned nr_leaves);
+
+    const dht::token_range& range() const noexcept { return _range; }
+    const table_schema_version& schema_version() const noexcept { return _schema_version; }
+    unsigned nr_leaves_requested() const noexcept { return _nr_leaves_requested; }
+
+    // May be less than requested for ranges narrower than the number of leaves.
+    size_t size() const noexcept { return _leaves.size(); }
+    leaf& at(size_t i) noexcept { return _leaves[i]; }
+    const leaf& at(size_t i) const noexcept { return _leaves[i]; }
+    dht::token_range leaf_range(size_t i) const;
+
+    // Invalidates the leaves which overlap with the given range.
+    void invalidate(const dht::token_range& range);
+
+    uint64_t last_used() const noexcept { return _last_used; }
+    void touch(uint64_t now) noexcept { _last_used = now; }
+
+    size_t memory_usage() const noexcept;
+};
+
+// Given the leaf hashes of the tree's range on each replica, returns the
+// sub-ranges made of runs of adjacent leaves whose hashes differ between the
+// replicas, in token order. Returns std::nullopt if a replica has a different
+// number of leaves than the tree.
+std::optional<dht::token_range_vector> find_unsynced_ranges(const repair_hash_tree& tree, const std::vector<std::vector<repair_hash>>& hashes);
+
+// The repair hash trees of all tables on a shard.
+//
+// The trees take at most max_memory bytes. A tree of n leaves takes about
+// 40 * n bytes, so with 1024 leaves and a budget of 10MB, about 250 ranges
+// keep their hashes, across all tables. When a new tree doesn't fit, the
+// least recently used trees are dropped, and their ranges are read in full
+// by their next repair.
+//
+// Keeps the trees up to date by listening to the changes of the data of the
+// tables. Changes made by compaction are not reported and don't need to be:
+// the trees hash what readers see, which compaction does not change, except
+// for dropping data that is already purgeable on every replica.
+class repair_hash_trees : public db::data_listener {
+    // The trees of a table are disjoint and keyed by the end of their range.
+    using table_trees = std::map<dht::token, lw_shared_ptr<repair_hash_tree>>;
+    std::unordered_map<utils::UUID, table_trees> _tables;
+    size_t _nr_trees = 0;
+    size_t _memory_usage = 0;
+    size_t _max_memory;
+    uint64_t _uses = 0;
+private:
+    void evict_least_recently_used();
+    void erase(table_trees& trees, table_trees::iterator it);
+public:
+    explicit repair_hash_trees(size_t max_memory);
+
+    // Returns the tree of the given range of the table, creating it if it
+    // doesn't exist yet. A new tree replaces the trees whose ranges overlap
+    // with its range, and has no leaf hashes.
+    lw_shared_ptr<repair_hash_tree> get(const schema& s, const dht::token_range& range, unsigned nr_leaves);
+
+    void invalidate(const schema& s, const dht::partition_range& range);
+
+    size_t size() const noexcept { return _nr_trees; }
+    size_t memory_usage() const noexcept { return _memory_usage; }
+
+    virtual void on_change(const schema_ptr& s, const dht::partition_range& range) override;
+};
@@ -599,6 +599,7 @@ repair_info::repair_info(repair_service& repair,
     , mm(repair.get_migration_manager())
     , gossiper(repair.get_gossiper())
     , sharder(get_sharder_for_tables(db, keyspace_, table_ids_))
+    , hash_trees(repair.hash_trees())
     , keyspace(keyspace_)
     , ranges(ranges_)
     , cfs(get_table_names(db.local(), table_ids_))
@@ -644,6 +645,13 @@ repair_neighbors repair_info::get_repair_neighbors(const dht::token_range& range
         neighbors[range];
 }
 
+bool repair_info::covers_all_replicas(const dht::token_range& range, const std::vector<gms::inet_address>& peers) {
+    if (!data_centers.empty() || !hosts.empty() || !ignore_nodes.empty() || !neighbors.empty()) {
+        return false;
+    }
+    return get_neighbors(db.local(), keyspace, range, {}, {}, {}).size() == peers.size();
+}
+
 // Repair a single local range, multiple column families.
 // Comparable to RepairSession in Origin
 future<> repair_info::repair_range(const dht::token_range& range) {
@@ -827,6 +835,9 @@ struct repair_options {
     // The node starting the repair must be in the data center; Issuing a
     // repair to a data center other than the named one returns an error.
     std::vector<sstring> data_centers;
+    // incremental repair reads only the sstables not yet marked as repaired,
+    // and marks the sstables whose data it repaired on all replicas.
+    bool incremental = false;
 
     repair_options(std::unordered_map<sstring, sstring> options) {
         bool_opt(primary_range, options, PRIMARY_RANGE_KEY);
@@ -835,14 +846,8 @@ struct repair_options {
         list_opt(hosts, options, HOSTS_KEY);
         list_opt(ignore_nodes, options, IGNORE_NODES_KEY);
         list_opt(data_centers, options, DATACENTERS_KEY);
-        // We currently do not support incremental repair. We could probably
-        // ignore this option as it is just an optimization, but for now,
-        // let's make it an error.
-        bool incremental = false;
+        // Incremental repair skips the sstables which were already repaired.
         bool_opt(incremental, options, INCREMENTAL_KEY);
-        if (incremental) {
-            throw std::runtime_error("unsupported incremental repair");
-        }
         // We do not currently support the distinction between "parallel" and
         // "sequential" repair, and operate the same for both.
         // We don't currently support "dc parallel" parallelism.
@@ -1157,11 +1162,12 @@ int repair_service::do_repair_start(sstring keyspace, std::unordered_map<sstring
 
         for (auto shard : boost::irange(unsigned(0), smp::count)) {
             auto f = container().invoke_on(shard, [keyspace, table_ids, id, ranges,
-                    data_centers = options.data_centers, hosts = options.hosts, ignore_nodes] (repair_service& local_repair) mutable {
+                    data_centers = options.data_centers, hosts = options.hosts, ignore_nodes, incremental = options.incremental] (repair_service& local_repair) mutable {
                 _node_ops_metrics.repair_total_ranges_sum += ranges.size();
                 auto ri = make_lw_shared<repair_info>(local_repair,
                         std::move(keyspace), std::move(ranges), std::move(table_ids),
                         id, std::move(data_centers), std::move(hosts), std::move(ignore_nodes), streaming::stream_reason::repair, id.uuid);
+                ri->incremental = incremental;
                 return repair_ranges(ri);
             });
             repair_results.push_back(std::move(f));
@@ -166,6 +166,8 @@ class repair_neighbors {
     }
 };
 
+class repair_hash_trees;
+
 class repair_info {
 public:
     seastar::sharded<database>& db;
@@ -175,6 +177,7 @@ class repair_info {
     service::migration_manager& mm;
     gms::gossiper& gossiper;
     const dht::sharder& sharder;
+    repair_hash_trees* hash_trees;
     sstring keyspace;
     dht::token_range_vector ranges;
     std::vector<sstring> cfs;
@@ -194,6 +197,8 @@ class repair_info {
     repair_stats _stats;
     std::unordered_set<sstring> dropped_tables;
     std::optional<utils::UUID> _ops_uuid;
+    // Read only unrepaired sstables and mark the repaired ones.
+    bool incremental = false;
 public:
     repair_info(repair_service& repair,
             const sstring& keyspace_,
@@ -209,6 +214,9 @@ class repair_info {
     void abort();
     void check_in_abort();
     repair_neighbors get_repair_neighbors(const dht::token_range& range);
+    // Whether the peers are all the other replicas of the range, so that
+    // syncing with them leaves no replica of the range unrepaired.
+    bool covers_all_replicas(const dht::token_range& range, const std::vector<gms::inet_address>& peers);
     void update_statistics(const repair_stats& stats) {
         _stats.add(stats);
     }
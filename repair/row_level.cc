@@ -47,6 +47,7 @@
 #include "gms/i_endpoint_state_change_subscriber.hh"
 #include "gms/gossiper.hh"
 #include "repair/row_level.hh"
+#include "repair/hash_tree.hh"
 #include "mutation_source_metadata.hh"
 #include "utils/stall_free.hh"
 #include "service/migration_manager.hh"
@@ -63,6 +64,10 @@ struct shard_config {
 
 static bool inject_rpc_stream_error = false;
 
+// Seed of the hashes kept in repair hash trees, which must be the same on all
+// nodes and across repairs.
+static constexpr uint64_t repair_hash_tree_seed = 0;
+
 enum class repair_state : uint16_t {
     unknown,
     row_level_start_started,
@@ -71,6 +76,8 @@ enum class repair_state : uint16_t {
     get_estimated_partitions_finished,
     set_estimated_partitions_started,
     set_estimated_partitions_finished,
+    get_range_hashes_started,
+    get_range_hashes_finished,
     get_sync_boundary_started,
     get_sync_boundary_finished,
     get_combined_row_hash_started,
@@ -377,7 +384,8 @@ using is_local_reader = bool_class<class is_local_reader_tag>;
             const dht::sharder& remote_sharder,
             unsigned remote_shard,
             uint64_t seed,
-            is_local_reader local_reader)
+            is_local_reader local_reader,
+            table::unrepaired_only only_unrepaired = table::unrepaired_only::no)
             : _schema(s)
             , _permit(std::move(permit))
             , _range(dht::to_partition_range(range))
@@ -386,7 +394,7 @@ using is_local_reader = bool_class<class is_local_reader_tag>;
             , _local_read_op(local_reader ? std::optional(cf.read_in_progress()) : std::nullopt)
             , _reader(nullptr) {
         if (local_reader) {
-            auto ms = mutation_source([&cf] (
+            auto ms = mutation_source([&cf, only_unrepaired] (
                         schema_ptr s,
                         reader_permit permit,
                         const dht::partition_range& pr,
@@ -395,7 +403,7 @@ using is_local_reader = bool_class<class is_local_reader_tag>;
                         tracing::trace_state_ptr,
                         streamed_mutation::forwarding,
                         mutation_reader::forwarding fwd_mr) {
-                return cf.make_streaming_reader(std::move(s), std::move(permit), pr, ps, fwd_mr);
+                return cf.make_streaming_reader(std::move(s), std::move(permit), pr, ps, fwd_mr, only_unrepaired);
             });
             std::tie(_reader, _reader_handle) = make_manually_paused_evictable_reader(
                     std::move(ms),
@@ -413,7 +421,7 @@ using is_local_reader = bool_class<class is_local_reader_tag>;
                     return std::optional<dht::partition_range>(dht::to_partition_range(*shard_range));
                 }
                 return std::optional<dht::partition_range>();
-            });
+            }, only_unrepaired);
         }
     }
 
@@ -660,6 +668,10 @@ class repair_meta {
     // sharding info of repair master
     dht::sharder _remote_sharder;
     bool _same_sharding_config = false;
+    // Incremental repair reads only unrepaired sstables and marks the
+    // sstables written before it started as repaired when it succeeds.
+    bool _incremental = false;
+    db_clock::time_point _started_at = db_clock::now();
     uint64_t _estimated_partitions = 0;
     // For repair master nr peers is the number of repair followers, for repair
     // follower nr peers is always one because repair master is the only peer.
@@ -745,7 +757,8 @@ class repair_meta {
             shard_config master_node_shard_config,
             std::vector<gms::inet_address> all_live_peer_nodes,
             size_t nr_peer_nodes = 1,
-            row_level_repair* row_level_repair_ptr = nullptr)
+            row_level_repair* row_level_repair_ptr = nullptr,
+            bool incremental = false)
             : _db(db)
             , _messaging(ms)
             , _sys_dist_ks(sys_dist_ks)
@@ -765,6 +778,7 @@ class repair_meta {
             , _master_node_shard_config(std::move(master_node_shard_config))
             , _remote_sharder(make_remote_sharder())
             , _same_sharding_config(is_same_sharding_config())
+            , _incremental(incremental)
             , _nr_peer_nodes(nr_peer_nodes)
             , _repair_reader(
                     _db,
@@ -775,7 +789,8 @@ class repair_meta {
                     _remote_sharder,
                     _master_node_shard_config.shard,
                     _seed,
-                    repair_reader::is_local_reader(_repair_master || _same_sharding_config)
+                    repair_reader::is_local_reader(_repair_master || _same_sharding_config),
+                    table::unrepaired_only(_incremental)
               )
             , _repair_writer(make_lw_shared<repair_writer>(_schema, _permit, _estimated_partitions, _reason))
             , _sink_source_for_get_full_row_hashes(_repair_meta_id, _nr_peer_nodes,
@@ -865,7 +880,8 @@ class repair_meta {
             uint64_t seed,
             shard_config master_node_shard_config,
             table_schema_version schema_version,
-            streaming::stream_reason reason) {
+            streaming::stream_reason reason,
+            bool incremental) {
         return repair.get_migration_manager().get_schema_for_write(schema_version, {from, src_cpu_id}, repair.get_messaging()).then([&repair,
                 from,
                 repair_meta_id,
@@ -875,7 +891,8 @@ class repair_meta {
                 seed,
                 master_node_shard_config,
                 schema_version,
-                reason] (schema_ptr s) {
+                reason,
+                incremental] (schema_ptr s) {
             auto& db = repair.get_db();
             auto& cf = db.local().find_column_family(s->id());
           return db.local().obtain_reader_permit(cf, "repair-meta", db::no_timeout).then([s = std::move(s),
@@ -890,7 +907,8 @@ class repair_meta {
                     seed,
                     master_node_shard_config,
                     schema_version,
-                    reason] (reader_permit permit) mutable {
+                    reason,
+                    incremental] (reader_permit permit) mutable {
             node_repair_meta_id id{from, repair_meta_id};
             auto rm = make_lw_shared<repair_meta>(db,
                     repair.get_messaging().container(),
@@ -907,7 +925,10 @@ class repair_meta {
                     repair_meta_id,
                     reason,
                     std::move(master_node_shard_config),
-                    std::vector<gms::inet_address>{from});
+                    std::vector<gms::inet_address>{from},
+                    1,
+                    nullptr,
+                    incremental);
             rm->set_repair_state_for_local_node(repair_state::row_level_start_started);
             bool insertion = repair_meta_map().emplace(id, rm).second;
             if (!insertion) {
@@ -1097,6 +1118,82 @@ class repair_meta {
         });
     }
 
+    // Called after an incremental repair of the range succeeded on all replicas.
+    // A shard which read the range through the multishard reader shares the
+    // sstables of the range with other shards, so it doesn't mark anything.
+    future<> mark_repaired() {
+        if (!_incremental || !(_repair_master || _same_sharding_config)) {
+            return make_ready_future<>();
+        }
+        return _cf.mark_repaired(_range, _started_at);
+    }
+
+    // Combines the hashes of the rows in the given part of the repair range.
+    // Unlike the hashes of the rows synced between the peers, these use a
+    // fixed seed, so they can be kept and compared across repairs.
+    future<repair_hash> hash_range(dht::token_range range) {
+        repair_reader reader(_db, _cf, _schema, _permit, std::move(range), _remote_sharder, _master_node_shard_config.shard,
+                repair_hash_tree_seed, repair_reader::is_local_reader(_repair_master || _same_sharding_config));
+        repair_hash combined;
+        std::exception_ptr ex;
+        try {
+            while (auto mf = co_await reader.read_mutation_fragment()) {
+                if (mf->is_partition_start()) {
+                    auto& start = mf->as_partition_start();
+                    reader.set_current_dk(start.key());
+                    if (!start.partition_tombstone()) {
+                        continue;
+                    }
+                } else if (mf->is_end_of_partition()) {
+                    reader.clear_current_dk();
+                    continue;
+                }
+                xx_hasher h(repair_hash_tree_seed);
+                feed_hash(h, *mf, *_schema);
+                feed_hash(h, reader.get_current_dk()->hash.hash);
+                combined.add(repair_hash(h.finalize_uint64()));
+            }
+        } catch (...) {
+            ex = std::current_exception();
+        }
+        co_await reader.close();
+        if (ex) {
+            std::rethrow_exception(std::move(ex));
+        }
+        co_return combined;
+    }
+
+    // Returns the hashes of the leaves of the hash tree of the repair range,
+    // hashing the leaves which changed since they were last hashed. Returns
+    // nothing if this node keeps no hash trees.
+    future<std::vector<repair_hash>> get_range_hashes(repair_hash_trees* trees, uint32_t nr_leaves) {
+        auto holder = _gate.hold();
+        std::vector<repair_hash> hashes;
+        if (!trees || !nr_leaves) {
+            co_return hashes;
+        }
+        // The kept trees cover the data of this shard, which is what the
+        // master has to compare only if it shards the data the same way.
+        // Otherwise hash the master's share of the range from scratch.
+        auto tree = _repair_master || _same_sharding_config
+                ? trees->get(*_schema, _range, nr_leaves)
+                : make_lw_shared<repair_hash_tree>(_range, _schema->version(), nr_leaves);
+        hashes.reserve(tree->size());
+        for (size_t i = 0; i < tree->size(); ++i) {
+            if (tree->at(i).hash) {
+                hashes.push_back(*tree->at(i).hash);
+                continue;
+            }
+            auto generation = tree->at(i).generation;
+            auto hash = co_await hash_range(tree->leaf_range(i));
+            if (tree->at(i).generation == generation) {
+                tree->at(i).hash = hash;
+            }
+            hashes.push_back(hash);
+        }
+        co_return hashes;
+    }
+
     dht::sharder make_remote_sharder() {
         return dht::sharder(_master_node_shard_config.shard_count, _master_node_shard_config.ignore_msb);
     }
@@ -1642,7 +1739,7 @@ class repair_meta {
 
     // RPC API
     future<>
-    repair_row_level_start(gms::inet_address remote_node, sstring ks_name, sstring cf_name, dht::token_range range, table_schema_version schema_version, streaming::stream_reason reason) {
+    repair_row_level_start(gms::inet_address remote_node, sstring ks_name, sstring cf_name, dht::token_range range, table_schema_version schema_version, streaming::stream_reason reason, bool incremental) {
         if (remote_node == _myip) {
             return make_ready_future<>();
         }
@@ -1656,7 +1753,7 @@ class repair_meta {
         return _messaging.local().send_repair_row_level_start(msg_addr(remote_node),
                 _repair_meta_id, ks_name, cf_name, std::move(range), _algo, _max_row_buf_size, _seed,
                 _master_node_shard_config.shard, _master_node_shard_config.shard_count, _master_node_shard_config.ignore_msb,
-                remote_partitioner_name, std::move(schema_version), reason).then([ks_name, cf_name] (rpc::optional<repair_row_level_start_response> resp) {
+                remote_partitioner_name, std::move(schema_version), reason, incremental).then([ks_name, cf_name] (rpc::optional<repair_row_level_start_response> resp) {
             if (resp && resp->status == repair_row_level_start_status::no_such_column_family) {
                 return make_exception_future<>(no_such_column_family(ks_name, cf_name));
             } else {
@@ -1669,10 +1766,10 @@ class repair_meta {
     static future<repair_row_level_start_response>
     repair_row_level_start_handler(repair_service& repair, gms::inet_address from, uint32_t src_cpu_id, uint32_t repair_meta_id, sstring ks_name, sstring cf_name,
             dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size,
-            uint64_t seed, shard_config master_node_shard_config, table_schema_version schema_version, streaming::stream_reason reason) {
-        rlogger.debug(">>> Started Row Level Repair (Follower): local={}, peers={}, repair_meta_id={}, keyspace={}, cf={}, schema_version={}, range={}, seed={}, max_row_buf_siz={}",
-            utils::fb_utilities::get_broadcast_address(), from, repair_meta_id, ks_name, cf_name, schema_version, range, seed, max_row_buf_size);
-        return insert_repair_meta(repair, from, src_cpu_id, repair_meta_id, std::move(range), algo, max_row_buf_size, seed, std::move(master_node_shard_config), std::move(schema_version), reason).then([] {
+            uint64_t seed, shard_config master_node_shard_config, table_schema_version schema_version, streaming::stream_reason reason, bool incremental) {
+        rlogger.debug(">>> Started Row Level Repair (Follower): local={}, peers={}, repair_meta_id={}, keyspace={}, cf={}, schema_version={}, range={}, seed={}, max_row_buf_siz={}, incremental={}",
+            utils::fb_utilities::get_broadcast_address(), from, repair_meta_id, ks_name, cf_name, schema_version, range, seed, max_row_buf_size, incremental);
+        return insert_repair_meta(repair, from, src_cpu_id, repair_meta_id, std::move(range), algo, max_row_buf_size, seed, std::move(master_node_shard_config), std::move(schema_version), reason, incremental).then([] {
             return repair_row_level_start_response{repair_row_level_start_status::ok};
         }).handle_exception_type([] (no_such_column_family&) {
             return repair_row_level_start_response{repair_row_level_start_status::no_such_column_family};
@@ -1680,24 +1777,27 @@ class repair_meta {
     }
 
     // RPC API
-    future<> repair_row_level_stop(gms::inet_address remote_node, sstring ks_name, sstring cf_name, dht::token_range range) {
+    future<> repair_row_level_stop(gms::inet_address remote_node, sstring ks_name, sstring cf_name, dht::token_range range, bool repaired) {
         if (remote_node == _myip) {
-            return stop();
+            return stop().then([this, repaired] {
+                return repaired ? mark_repaired() : make_ready_future<>();
+            });
         }
         stats().rpc_call_nr++;
         return _messaging.local().send_repair_row_level_stop(msg_addr(remote_node),
-                _repair_meta_id, std::move(ks_name), std::move(cf_name), std::move(range));
+                _repair_meta_id, std::move(ks_name), std::move(cf_name), std::move(range), repaired);
     }
 
     // RPC handler
     static future<>
-    repair_row_level_stop_handler(gms::inet_address from, uint32_t repair_meta_id, sstring ks_name, sstring cf_name, dht::token_range range) {
-        rlogger.debug("<<< Finished Row Level Repair (Follower): local={}, peers={}, repair_meta_id={}, keyspace={}, cf={}, range={}",
-            utils::fb_utilities::get_broadcast_address(), from, repair_meta_id, ks_name, cf_name, range);
+    repair_row_level_stop_handler(gms::inet_address from, uint32_t repair_meta_id, sstring ks_name, sstring cf_name, dht::token_range range, bool repaired) {
+        rlogger.debug("<<< Finished Row Level Repair (Follower): local={}, peers={}, repair_meta_id={}, keyspace={}, cf={}, range={}, repaired={}",
+            utils::fb_utilities::get_broadcast_address(), from, repair_meta_id, ks_name, cf_name, range, repaired);
         auto rm = get_repair_meta(from, repair_meta_id);
         rm->set_repair_state_for_local_node(repair_state::row_level_stop_started);
-        return remove_repair_meta(from, repair_meta_id, std::move(ks_name), std::move(cf_name), std::move(range)).then([rm] {
+        return remove_repair_meta(from, repair_meta_id, std::move(ks_name), std::move(cf_name), std::move(range)).then([rm, repaired] {
             rm->set_repair_state_for_local_node(repair_state::row_level_stop_finished);
+            return repaired ? rm->mark_repaired() : make_ready_future<>();
         });
     }
 
@@ -1721,6 +1821,26 @@ class repair_meta {
         });
     }
 
+    // RPC API
+    future<std::vector<repair_hash>> repair_get_range_hashes(gms::inet_address remote_node, repair_hash_trees* trees, uint32_t nr_leaves) {
+        if (remote_node == _myip) {
+            return get_range_hashes(trees, nr_leaves);
+        }
+        stats().rpc_call_nr++;
+        return _messaging.local().send_repair_get_range_hashes(msg_addr(remote_node), _repair_meta_id, nr_leaves);
+    }
+
+
+    // RPC handler
+    static future<std::vector<repair_hash>> repair_get_range_hashes_handler(repair_hash_trees* trees, gms::inet_address from, uint32_t repair_meta_id, uint32_t nr_leaves) {
+        auto rm = get_repair_meta(from, repair_meta_id);
+        rm->set_repair_state_for_local_node(repair_state::get_range_hashes_started);
+        return rm->get_range_hashes(trees, nr_leaves).then([rm] (std::vector<repair_hash> hashes) {
+            rm->set_repair_state_for_local_node(repair_state::get_range_hashes_finished);
+            return hashes;
+        });
+    }
+
     // RPC API
     future<> repair_set_estimated_partitions(gms::inet_address remote_node, uint64_t estimated_partitions) {
         if (remote_node == _myip) {
@@ -2387,11 +2507,11 @@ future<> repair_service::init_ms_handlers() {
     });
     ms.register_repair_row_level_start([this] (const rpc::client_info& cinfo, uint32_t repair_meta_id, sstring ks_name,
             sstring cf_name, dht::token_range range, row_level_diff_detect_algorithm algo, uint64_t max_row_buf_size, uint64_t seed,
-            unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, rpc::optional<streaming::stream_reason> reason) {
+            unsigned remote_shard, unsigned remote_shard_count, unsigned remote_ignore_msb, sstring remote_partitioner_name, table_schema_version schema_version, rpc::optional<streaming::stream_reason> reason, rpc::optional<bool> incremental) {
         auto src_cpu_id = cinfo.retrieve_auxiliary<uint32_t>("src_cpu_id");
         auto from = cinfo.retrieve_auxiliary<gms::inet_address>("baddr");
         return container().invoke_on(src_cpu_id % smp::count, [from, src_cpu_id, repair_meta_id, ks_name, cf_name,
-                range, algo, max_row_buf_size, seed, remote_shard, remote_shard_count, remote_ignore_msb, schema_version, reason] (repair_service& local_repair) mutable {
+                range, algo, max_row_buf_size, seed, remote_shard, remote_shard_count, remote_ignore_msb, schema_version, reason, incremental] (repair_service& local_repair) mutable {
             if (!local_repair._sys_dist_ks.local_is_initialized() || !local_repair._view_update_generator.local_is_initialized()) {
                 return make_exception_future<repair_row_level_start_response>(std::runtime_error(format("Node {} is not fully initialized for repair, try again later",
                         utils::fb_utilities::get_broadcast_address())));
@@ -2400,16 +2520,16 @@ future<> repair_service::init_ms_handlers() {
             return repair_meta::repair_row_level_start_handler(local_repair, from, src_cpu_id, repair_meta_id, std::move(ks_name),
                     std::move(cf_name), std::move(range), algo, max_row_buf_size, seed,
                     shard_config{remote_shard, remote_shard_count, remote_ignore_msb},
-                    schema_version, r);
+                    schema_version, r, incremental.value_or(false));
         });
     });
     ms.register_repair_row_level_stop([] (const rpc::client_info& cinfo, uint32_t repair_meta_id,
-            sstring ks_name, sstring cf_name, dht::token_range range) {
+            sstring ks_name, sstring cf_name, dht::token_range range, rpc::optional<bool> mark_repaired) {
         auto src_cpu_id = cinfo.retrieve_auxiliary<uint32_t>("src_cpu_id");
         auto from = cinfo.retrieve_auxiliary<gms::inet_address>("baddr");
-        return smp::submit_to(src_cpu_id % smp::count, [from, repair_meta_id, ks_name, cf_name, range] () mutable {
+        return smp::submit_to(src_cpu_id % smp::count, [from, repair_meta_id, ks_name, cf_name, range, mark_repaired] () mutable {
             return repair_meta::repair_row_level_stop_handler(from, repair_meta_id,
-                    std::move(ks_name), std::move(cf_name), std::move(range));
+                    std::move(ks_name), std::move(cf_name), std::move(range), mark_repaired.value_or(false));
         });
     });
     ms.register_repair_get_estimated_partitions([] (const rpc::client_info& cinfo, uint32_t repair_meta_id) {
@@ -2427,6 +2547,13 @@ future<> repair_service::init_ms_handlers() {
             return repair_meta::repair_set_estimated_partitions_handler(from, repair_meta_id, estimated_partitions);
         });
     });
+    ms.register_repair_get_range_hashes([this] (const rpc::client_info& cinfo, uint32_t repair_meta_id, uint32_t nr_leaves) {
+        auto src_cpu_id = cinfo.retrieve_auxiliary<uint32_t>("src_cpu_id");
+        auto from = cinfo.retrieve_auxiliary<gms::inet_address>("baddr");
+        return container().invoke_on(src_cpu_id % smp::count, [from, repair_meta_id, nr_leaves] (repair_service& local_repair) {
+            return repair_meta::repair_get_range_hashes_handler(local_repair.hash_trees(), from, repair_meta_id, nr_leaves);
+        });
+    });
     ms.register_repair_get_diff_algorithms([] (const rpc::client_info& cinfo) {
         return make_ready_future<std::vector<row_level_diff_detect_algorithm>>(suportted_diff_detect_algorithms());
     });
@@ -2450,6 +2577,7 @@ future<> repair_service::uninit_ms_handlers() {
         ms.unregister_repair_row_level_stop(),
         ms.unregister_repair_get_estimated_partitions(),
         ms.unregister_repair_set_estimated_partitions(),
+        ms.unregister_repair_get_range_hashes(),
         ms.unregister_repair_get_diff_algorithms()).discard_result();
 }
 
@@ -2522,19 +2650,29 @@ class row_level_repair {
     // the next repair.
     uint64_t _seed;
 
+    // Number of hash tree leaves the peers compare before syncing rows, or 0
+    // to sync the whole range right away.
+    uint32_t _hash_tree_leaves;
+
+    // The sub-ranges of the range whose hash tree leaves differ between the
+    // peers. When set, only these are synced, each in a repair of its own.
+    std::optional<dht::token_range_vector> _unsynced_ranges;
+
 public:
     row_level_repair(repair_info& ri,
             sstring cf_name,
             utils::UUID table_id,
             dht::token_range range,
-            std::vector<gms::inet_address> all_live_peer_nodes)
+            std::vector<gms::inet_address> all_live_peer_nodes,
+            uint32_t hash_tree_leaves = 0)
         : _ri(ri)
         , _cf_name(std::move(cf_name))
         , _table_id(std::move(table_id))
         , _range(std::move(range))
         , _all_live_peer_nodes(std::move(all_live_peer_nodes))
         , _cf(_ri.db.local().find_column_family(_table_id))
-        , _seed(get_random_seed()) {
+        , _seed(get_random_seed())
+        , _hash_tree_leaves(hash_tree_leaves) {
     }
 
 private:
@@ -2549,6 +2687,38 @@ class row_level_repair {
         return is_rpc_stream_supported(algo) ?  tracker::max_repair_memory_per_range() : 256 * 1024;
     }
 
+    // Step 0: Compare the hash tree leaves of the range on all peers.
+    // Returns the sub-ranges whose leaves differ, or std::nullopt if the
+    // leaves can't be compared and the whole range has to be synced, e.g.
+    // because one of the peers keeps no hash trees or doesn't know the verb.
+    std::optional<dht::token_range_vector> find_unsynced_ranges(repair_meta& master) {
+        check_in_shutdown();
+        _ri.check_in_abort();
+        auto& nodes = master.all_nodes();
+        std::vector<std::vector<repair_hash>> hashes(nodes.size());
+        try {
+            parallel_for_each(boost::irange(size_t(0), nodes.size()), [&, this] (size_t idx) {
+                auto& ns = nodes[idx];
+                ns.state = repair_state::get_range_hashes_started;
+                return master.repair_get_range_hashes(ns.node, _ri.hash_trees, _hash_tree_leaves).then([&hashes, &ns, idx] (std::vector<repair_hash> h) {
+                    ns.state = repair_state::get_range_hashes_finished;
+                    hashes[idx] = std::move(h);
+                });
+            }).get();
+        } catch (...) {
+            rlogger.debug("Failed to get hash tree leaves for keyspace={}, cf={}, range={}, repairing the whole range: {}",
+                    _ri.keyspace, _cf_name, _range, std::current_exception());
+            return std::nullopt;
+        }
+        auto ranges = ::find_unsynced_ranges(repair_hash_tree(_range, _cf.schema()->version(), _hash_tree_leaves), hashes);
+        if (!ranges) {
+            return std::nullopt;
+        }
+        rlogger.debug("Hash tree leaves of keyspace={}, cf={}, range={} differ in {} sub-ranges: {}",
+                _ri.keyspace, _cf_name, _range, ranges->size(), *ranges);
+        return ranges;
+    }
+
     // Step A: Negotiate sync boundary to use
     op_status negotiate_sync_boundary(repair_meta& master) {
         check_in_shutdown();
@@ -2771,6 +2941,16 @@ class row_level_repair {
         master.stats().round_nr_slow_path++;
     }
 
+    future<> repair_unsynced_ranges() {
+        if (!_unsynced_ranges) {
+            co_return;
+        }
+        for (auto& range : *_unsynced_ranges) {
+            auto repair = row_level_repair(_ri, _cf_name, _table_id, range, _all_live_peer_nodes);
+            co_await repair.run();
+        }
+    }
+
 public:
     future<> run() {
         return seastar::async([this] {
@@ -2807,7 +2987,8 @@ class row_level_repair {
                     std::move(master_node_shard_config),
                     _all_live_peer_nodes,
                     _all_live_peer_nodes.size(),
-                    this);
+                    this,
+                    _ri.incremental);
             auto auto_stop_master = defer([&master] {
                 master.stop().handle_exception([] (std::exception_ptr ep) {
                     rlogger.warn("Failed auto-stopping Row Level Repair (Master): {}. Ignored.", ep);
@@ -2824,7 +3005,7 @@ class row_level_repair {
                 parallel_for_each(master.all_nodes(), [&, this] (repair_node_state& ns) {
                     const auto& node = ns.node;
                     ns.state = repair_state::row_level_start_started;
-                    return master.repair_row_level_start(node, _ri.keyspace, _cf_name, _range, schema_version, _ri.reason).then([&] () {
+                    return master.repair_row_level_start(node, _ri.keyspace, _cf_name, _range, schema_version, _ri.reason, _ri.incremental).then([&] () {
                         ns.state = repair_state::row_level_start_finished;
                         nodes_to_stop.push_back(node);
                         ns.state = repair_state::get_estimated_partitions_started;
@@ -2845,7 +3026,11 @@ class row_level_repair {
                     });
                 }).get();
 
-                while (true) {
+                if (_hash_tree_leaves) {
+                    _unsynced_ranges = find_unsynced_ranges(master);
+                }
+
+                while (!_unsynced_ranges) {
                     auto status = negotiate_sync_boundary(master);
                     if (status == op_status::next_round) {
                         continue;
@@ -2870,9 +3055,11 @@ class row_level_repair {
                 _failed = true;
             }
 
+            // The data read by the peers is repaired only if the range was synced on all its replicas.
+            bool mark_repaired = _ri.incremental && !_failed && nodes_to_stop.size() == master.all_nodes().size() && _ri.covers_all_replicas(_range, _all_live_peer_nodes);
             parallel_for_each(nodes_to_stop, [&] (const gms::inet_address& node) {
                 master.set_repair_state(repair_state::row_level_stop_started, node);
-                return master.repair_row_level_stop(node, _ri.keyspace, _cf_name, _range).then([node, &master] {
+                return master.repair_row_level_stop(node, _ri.keyspace, _cf_name, _range, mark_repaired).then([node, &master] {
                     master.set_repair_state(repair_state::row_level_stop_finished, node);
                 });
             }).get();
@@ -2887,6 +3074,10 @@ class row_level_repair {
             }
             rlogger.debug("<<< Finished Row Level Repair (Master): local={}, peers={}, repair_meta_id={}, keyspace={}, cf={}, range={}, tx_hashes_nr={}, rx_hashes_nr={}, tx_row_nr={}, rx_row_nr={}, row_from_disk_bytes={}, row_from_disk_nr={}",
                     master.myip(), _all_live_peer_nodes, master.repair_meta_id(), _ri.keyspace, _cf_name, _range, master.stats().tx_hashes_nr, master.stats().rx_hashes_nr, master.stats().tx_row_nr, master.stats().rx_row_nr, master.stats().row_from_disk_bytes, master.stats().row_from_disk_nr);
+        }).then([this] {
+            // Each sub-range gets a master of its own, which needs a reader permit, so they are
+            // synced only after the master of the whole range was stopped and released its permit.
+            return repair_unsynced_ranges();
         });
     }
 };
@@ -2895,7 +3086,12 @@ future<> repair_cf_range_row_level(repair_info& ri,
         sstring cf_name, utils::UUID table_id, dht::token_range range,
         const std::vector<gms::inet_address>& all_peer_nodes) {
     return seastar::futurize_invoke([&ri, cf_name = std::move(cf_name), table_id = std::move(table_id), range = std::move(range), &all_peer_nodes] () mutable {
-        auto repair = row_level_repair(ri, std::move(cf_name), std::move(table_id), std::move(range), all_peer_nodes);
+        // Node operations sync ranges which mostly differ, so comparing hash trees first would only add a read.
+        // Incremental repair marks the whole range as repaired when it's done, which must wait until
+        // the sub-ranges whose hash tree leaves differ were synced, so it doesn't use hash trees.
+        auto use_hash_trees = ri.hash_trees && ri.reason == streaming::stream_reason::repair && !ri.incremental;
+        auto hash_tree_leaves = use_hash_trees ? ri.db.local().get_config().repair_hash_tree_leaves() : 0;
+        auto repair = row_level_repair(ri, std::move(cf_name), std::move(table_id), std::move(range), all_peer_nodes, hash_tree_leaves);
         return do_with(std::move(repair), [] (row_level_repair& repair) {
             return repair.run();
         });
@@ -2973,14 +3169,23 @@ repair_service::repair_service(distributed<gms::gossiper>& gossiper,
         _tracker = std::make_unique<tracker>(smp::count, max_repair_memory);
         _gossiper.local().register_(_gossip_helper);
     }
+    if (_db.local().get_config().repair_hash_tree_leaves()) {
+        _hash_trees = std::make_unique<repair_hash_trees>(max_repair_memory / 10);
+    }
 }
 
 future<> repair_service::start() {
     co_await init_metrics();
     co_await init_ms_handlers();
+    if (_hash_trees) {
+        _db.local().data_listeners().install(_hash_trees.get());
+    }
 }
 
 future<> repair_service::stop() {
+    if (_hash_trees) {
+        _db.local().data_listeners().uninstall(_hash_trees.get());
+    }
     co_await uninit_ms_handlers();
     if (this_shard_id() == 0) {
         co_await _gossiper.local().unregister_(_gossip_helper);
@@ -27,6 +27,7 @@
 #include <seastar/core/distributed.hh>
 
 class row_level_repair_gossip_helper;
+class repair_hash_trees;
 
 namespace service {
 class migration_manager;
@@ -52,6 +53,8 @@ class repair_service : public seastar::peering_sharded_service<repair_service> {
 
     shared_ptr<row_level_repair_gossip_helper> _gossip_helper;
     std::unique_ptr<tracker> _tracker;
+    // Set if row level repair compares hash trees before syncing rows.
+    std::unique_ptr<repair_hash_trees> _hash_trees;
     bool _stopped = false;
 
     future<> init_ms_handlers();
@@ -108,6 +111,7 @@ class repair_service : public seastar::peering_sharded_service<repair_service> {
     sharded<db::system_distributed_keyspace>& get_sys_dist_ks() noexcept { return _sys_dist_ks; }
     sharded<db::view::view_update_generator>& get_view_update_generator() noexcept { return _view_update_generator; }
     gms::gossiper& get_gossiper() noexcept { return _gossiper.local(); }
+    repair_hash_trees* hash_trees() noexcept { return _hash_trees.get(); }
 };
 
 class repair_info;
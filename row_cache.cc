@@ -33,6 +33,10 @@
 #include "dirty_memory_manager.hh"
 #include "cache_flat_mutation_reader.hh"
 #include "real_dirty_memory_accounter.hh"
+#include "mutation_partition_serializer.hh"
+#include "mutation_partition_view.hh"
+#include "serializer_impl.hh"
+#include "compress.hh"
 
 namespace cache {
 
@@ -69,6 +73,8 @@ static thread_local cache_tracker* current_tracker;
 cache_tracker::cache_tracker(mutation_application_stats& app_stats, register_metrics with_metrics)
     : _garbage(_region, this, app_stats)
     , _memtable_cleaner(_region, nullptr, app_stats)
+    , _quota_timer([this] { enforce_memory_quota(); })
+    , _compression_timer([this] { compress_cold_partitions(); })
 {
     if (with_metrics) {
         setup_metrics();
@@ -148,6 +154,16 @@ cache_tracker::setup_metrics() {
             sm::description("total amount of range tombstones processed during read")),
         sm::make_derive("row_tombstone_reads", _stats.row_tombstone_reads,
             sm::description("total amount of row tombstones processed during read")),
+        sm::make_derive("admission_rejections", _stats.admission_rejections,
+            sm::description("total number of partitions read by range queries whose data was not added to cache, because they were not read recently")),
+        sm::make_derive("partition_compressions", _stats.partition_compressions,
+            sm::description("total number of cold partitions which were compressed instead of being evicted")),
+        sm::make_derive("partition_decompressions", _stats.partition_decompressions,
+            sm::description("total number of compressed partitions which were decompressed to be read or updated")),
+        sm::make_gauge("compressed_partitions", _stats.compressed_partitions,
+            sm::description("current number of compressed partitions in cache")),
+        sm::make_gauge("compressed_bytes", _stats.compressed_bytes,
+            sm::description("current amount of memory used by compressed partitions in cache")),
     });
 }
 
@@ -169,9 +185,164 @@ void cache_tracker::clear() {
 
 void cache_tracker::touch(rows_entry& e) {
     // last dummy may not be linked if evicted, but
-    // the unlink_from_lru() handles it
-    e.unlink_from_lru();
-    _lru.add(e);
+    // lru::access() handles it
+    _lru.access(e);
+}
+
+void cache_tracker::set_memory_quota(size_t bytes) noexcept {
+    _memory_quota = bytes;
+    if (_memory_quota) {
+        maybe_enforce_memory_quota();
+    }
+}
+
+void cache_tracker::maybe_enforce_memory_quota() noexcept {
+    if (!_quota_timer.armed() && _region.occupancy().used_space() > _memory_quota) {
+        // Eviction is deferred to a task, because entries can't be evicted
+        // while they are being inserted or read.
+        _quota_timer.arm(timer<>::clock::now());
+    }
+}
+
+void cache_tracker::enforce_memory_quota() noexcept {
+    while (_memory_quota && _region.occupancy().used_space() > _memory_quota) {
+        if (_region.evict_some() == memory::reclaiming_result::reclaimed_nothing) {
+            break;
+        }
+        if (need_preempt()) {
+            _quota_timer.arm(timer<>::clock::now());
+            break;
+        }
+    }
+}
+
+void cache_tracker::register_table(const utils::UUID& id) {
+    ++_table_stats[id].caches;
+}
+
+void cache_tracker::unregister_table(const utils::UUID& id) noexcept {
+    auto i = _table_stats.find(id);
+    if (i != _table_stats.end() && !--i->second.caches) {
+        _table_stats.erase(i);
+    }
+}
+
+const cache_tracker::table_stats* cache_tracker::get_table_stats(const utils::UUID& id) const noexcept {
+    auto i = _table_stats.find(id);
+    return i != _table_stats.end() ? &i->second : nullptr;
+}
+
+void cache_tracker::set_admission_filter(size_t sketch_size) {
+    _admission_sketch = sketch_size ? std::make_unique<utils::frequency_sketch>(sketch_size) : nullptr;
+}
+
+static uint64_t admission_key(const schema& s, const dht::decorated_key& dk) noexcept {
+    return uint64_t(dk.token().raw()) ^ s.id().get_most_significant_bits() ^ (s.id().get_least_significant_bits() << 1);
+}
+
+void cache_tracker::on_single_partition_read(const schema& s, const dht::decorated_key& dk) noexcept {
+    if (_admission_sketch) {
+        _admission_sketch->record(admission_key(s, dk));
+    }
+}
+
+bool cache_tracker::admit(const schema& s, const dht::decorated_key& dk) noexcept {
+    if (!_admission_sketch || _admission_sketch->record(admission_key(s, dk)) >= 2) {
+        return true;
+    }
+    ++_stats.admission_rejections;
+    return false;
+}
+
+// Compressing larger partitions would make single row reads too expensive.
+static constexpr unsigned max_compressed_partition_rows = 256;
+static constexpr size_t max_compressed_partition_size = 64 * 1024;
+// Bounds the work of looking for a partition to compress.
+static constexpr unsigned max_compression_candidates = 64;
+
+// Returns the cache entry whose latest version holds the row, or nullptr if there is no such
+// entry or if it's too large to be compressed.
+static cache_entry* owning_cache_entry(rows_entry& row) noexcept {
+    mutation_partition::rows_type::iterator it(&row);
+    for (unsigned n = 0; !it->is_last_dummy(); ++n) {
+        if (n == max_compressed_partition_rows) {
+            return nullptr;
+        }
+        ++it;
+    }
+    mutation_partition::rows_type* rows = (++it).tree_if_end();
+    partition_version& pv = partition_version::container_of(mutation_partition::container_of(*rows));
+    if (!pv.is_referenced_from_entry()) {
+        return nullptr;
+    }
+    return &cache_entry::container_of(partition_entry::container_of(pv));
+}
+
+void cache_tracker::maybe_compress_cold_partitions() noexcept {
+    if (_compress_cold_partitions && !_compression_timer.armed()) {
+        // Deferred to a task, because entries can't be compressed during eviction.
+        _compression_timer.arm(timer<>::clock::now());
+    }
+}
+
+void cache_tracker::compress_cold_partitions() noexcept {
+    try {
+        while (_compression_section(_region, [this] { return compress_coldest_partition(); })) {
+            if (need_preempt()) {
+                _compression_timer.arm(timer<>::clock::now());
+                break;
+            }
+        }
+    } catch (...) {
+        clogger.warn("Failed to compress cold partitions: {}", std::current_exception());
+    }
+}
+
+bool cache_tracker::compress_coldest_partition() {
+    cache_entry* ce = nullptr;
+    auto found = _lru.find_coldest(max_compression_candidates, [&] (evictable& e) {
+        // The LRU is shared with other caches, e.g. of sstable index pages.
+        auto* row = dynamic_cast<rows_entry*>(&e);
+        ce = row ? owning_cache_entry(*row) : nullptr;
+        return ce && ce->can_compress();
+    });
+    return found && compress(*ce);
+}
+
+bool cache_tracker::compress(cache_entry& e) {
+    const schema& s = *e.schema();
+    bytes_ostream out;
+    mutation_partition_serializer(s, e.partition().version()->partition()).write(out);
+    if (out.size() > max_compressed_partition_size) {
+        return false;
+    }
+    auto in = out.linearize();
+    auto& lz4 = *compressor::lz4;
+    auto buf_size = lz4.compress_max_size(in.size());
+    auto buf = std::make_unique<char[]>(buf_size);
+    auto len = lz4.compress(reinterpret_cast<const char*>(in.data()), in.size(), buf.get(), buf_size);
+    if (len >= in.size()) {
+        return false;
+    }
+    with_allocator(_region.allocator(), [&] {
+        auto cp = make_managed<compressed_partition>(compressed_partition{_region.alloc_buf(len), uint32_t(in.size())});
+        std::copy_n(buf.get(), len, cp->data.get());
+        // The last dummy of the empty partition keeps the entry in the LRU.
+        auto pe = partition_entry::make_evictable(s, mutation_partition::make_incomplete(s));
+        e.evict(*this);
+        e.partition() = std::move(pe);
+        e._compressed = std::move(cp);
+        insert(e.partition());
+    });
+    ++_stats.partition_compressions;
+    ++_stats.compressed_partitions;
+    _stats.compressed_bytes += len;
+    return true;
+}
+
+void cache_tracker::on_compressed_partition_removal(size_t compressed_size) noexcept {
+    --_stats.compressed_partitions;
+    _stats.compressed_bytes -= compressed_size;
 }
 
 void cache_tracker::insert(cache_entry& entry) {
@@ -200,14 +371,19 @@ void cache_tracker::on_partition_miss() noexcept {
     ++_stats.partition_misses;
 }
 
-void cache_tracker::on_partition_eviction() noexcept {
+void cache_tracker::on_partition_eviction(const schema& s) noexcept {
     --_stats.partitions;
     ++_stats.partition_evictions;
+    auto i = _table_stats.find(s.id());
+    if (i != _table_stats.end()) {
+        ++i->second.partition_evictions;
+    }
 }
 
 void cache_tracker::on_row_eviction() noexcept {
     --_stats.rows;
     ++_stats.row_evictions;
+    maybe_compress_cold_partitions();
 }
 
 void cache_tracker::on_row_hit() noexcept {
@@ -373,6 +549,7 @@ class single_partition_populating_reader final : public flat_mutation_reader::im
     future<> create_reader() {
         auto src_and_phase = _cache.snapshot_of(_read_context->range().start()->value());
         auto phase = src_and_phase.phase;
+        _cache._tracker.on_single_partition_read(*_cache._schema, _read_context->range().start()->value().as_decorated_key());
         _read_context->enter_partition(_read_context->range().start()->value().as_decorated_key(), src_and_phase.snapshot, phase);
         return _read_context->create_underlying().then([this, phase] {
           return _read_context->underlying().underlying()().then([this, phase] (auto&& mfopt) {
@@ -532,6 +709,14 @@ class range_populating_reader {
                 _cache.on_partition_miss();
                 const partition_start& ps = mfopt->as_partition_start();
                 const dht::decorated_key& key = ps.key();
+                if (!_cache._tracker.admit(*_cache._schema, key)) {
+                    // Not read recently, probably by a scan, which would evict data
+                    // read more often. Continuity can't be set across it.
+                    _last_key = {};
+                    return make_ready_future<read_result>(
+                            read_result(read_directly_from_underlying(_read_context), std::move(mfopt)));
+                }
+                _read_context.set_admitted(true);
                 if (_reader.creation_phase() == _cache.phase_of(key)) {
                     return _cache._read_section(_cache._tracker.region(), [&] {
                         cache_entry& e = _cache.find_or_create_incomplete(ps, _reader.creation_phase(),
@@ -583,6 +768,8 @@ class scanning_and_populating_reader final : public flat_mutation_reader::impl {
     flat_mutation_reader read_from_entry(cache_entry& ce) {
         _cache.upgrade_entry(ce);
         _cache.on_partition_hit();
+        // Rows missing in a cached partition are populated only if it's read often.
+        _read_context->set_admitted(_cache._tracker.admit(*_cache._schema, ce.key()));
         return ce.read(_cache, *_read_context);
     }
 
@@ -732,6 +919,34 @@ row_cache::make_scanning_reader(const dht::partition_range& range, std::unique_p
     return make_flat_mutation_reader<scanning_and_populating_reader>(*this, range, std::move(context));
 }
 
+void row_cache::record_read(const dht::ring_position& pos) {
+    if (!_hot_partitions || ++_hot_partition_reads % hot_partition_sample_period) {
+        return;
+    }
+    try {
+        _hot_partitions->append(pos.as_decorated_key());
+    } catch (...) {
+        // The ranking is only a hint, stop maintaining it rather than fail the read.
+        clogger.warn("Failed to record hot partition, disabling tracking: {}", std::current_exception());
+        _hot_partitions.reset();
+    }
+}
+
+void row_cache::track_hot_partitions(size_t capacity) {
+    _hot_partitions = capacity ? std::make_unique<hot_partitions_type>(capacity) : nullptr;
+}
+
+std::vector<dht::decorated_key> row_cache::hot_partitions(size_t k) const {
+    std::vector<dht::decorated_key> ret;
+    if (!_hot_partitions) {
+        return ret;
+    }
+    for (auto& r : _hot_partitions->top(k)) {
+        ret.push_back(r.item);
+    }
+    return ret;
+}
+
 flat_mutation_reader
 row_cache::make_reader(schema_ptr s,
                        reader_permit permit,
@@ -749,6 +964,9 @@ row_cache::make_reader(schema_ptr s,
     if (query::is_single_partition(range) && !fwd_mr) {
         tracing::trace(trace_state, "Querying cache for range {} and slice {}",
                 range, seastar::value_of([&slice] { return slice.get_all_ranges(); }));
+        if (!slice.options.contains(query::partition_slice::option::cache_warm_up)) {
+            record_read(range.start()->value());
+        }
         auto mr = _read_section(_tracker.region(), [&] {
             dht::ring_position_comparator cmp(*_schema);
             auto&& pos = range.start()->value();
@@ -786,6 +1004,7 @@ row_cache::make_reader(schema_ptr s,
 }
 
 row_cache::~row_cache() {
+    _tracker.unregister_table(_schema->id());
     with_allocator(_tracker.allocator(), [this] {
         _partitions.clear_and_dispose([this] (cache_entry* p) mutable noexcept {
             if (!p->is_dummy_entry()) {
@@ -851,8 +1070,8 @@ cache_entry& row_cache::find_or_create_incomplete(const partition_start& ps, row
     }, [&] (auto i) { // visit
         _tracker.on_miss_already_populated();
         cache_entry& e = *i;
-        e.partition().open_version(*e.schema(), &_tracker, phase).partition().apply(ps.partition_tombstone());
         upgrade_entry(e);
+        e.partition().open_version(*e.schema(), &_tracker, phase).partition().apply(ps.partition_tombstone());
     });
 }
 
@@ -1025,7 +1244,7 @@ future<> row_cache::do_update(external_updater eu, memtable& m, Updater updater)
 }
 
 future<> row_cache::update(external_updater eu, memtable& m) {
-    return do_update(std::move(eu), m, [this] (logalloc::allocating_section& alloc,
+    return do_update(std::move(eu), m, [this, &m] (logalloc::allocating_section& alloc,
             row_cache::partitions_type::iterator cache_i, memtable_entry& mem_e, partition_presence_checker& is_present,
             real_dirty_memory_accounter& acc, const partitions_type::bound_hint& hint) mutable {
         // If cache doesn't contain the entry we cannot insert it because the mutation may be incomplete.
@@ -1036,6 +1255,8 @@ future<> row_cache::update(external_updater eu, memtable& m) {
             upgrade_entry(entry);
             assert(entry._schema == _schema);
             _tracker.on_partition_merge();
+            // Rows in the columnar layout are moved to the partition_entry, to be merged with the rest.
+            m.fold_columnar_rows(mem_e);
             mem_e.upgrade_schema(_schema, _tracker.memtable_cleaner());
             return entry.partition().apply_to_incomplete(*_schema, std::move(mem_e.partition()), _tracker.memtable_cleaner(),
                 alloc, _tracker.region(), _tracker, _underlying_phase, acc);
@@ -1048,6 +1269,7 @@ future<> row_cache::update(external_updater eu, memtable& m) {
                 partition_entry::make_evictable(*_schema, mutation_partition(_schema)));
             entry->set_continuous(cache_i->continuous());
             _tracker.insert(*entry);
+            m.fold_columnar_rows(mem_e);
             mem_e.upgrade_schema(_schema, _tracker.memtable_cleaner());
             return entry->partition().apply_to_incomplete(*_schema, std::move(mem_e.partition()), _tracker.memtable_cleaner(),
                 alloc, _tracker.region(), _tracker, _underlying_phase, acc);
@@ -1197,6 +1419,7 @@ row_cache::row_cache(schema_ptr s, snapshot_source src, cache_tracker& tracker,
         entry.set_continuous(bool(cont));
         _partitions.insert(entry.position().token().raw(), std::move(entry), dht::ring_position_comparator{*_schema});
     });
+    _tracker.register_table(_schema->id());
 }
 
 cache_entry::cache_entry(cache_entry&& o) noexcept
@@ -1204,6 +1427,7 @@ cache_entry::cache_entry(cache_entry&& o) noexcept
     , _key(std::move(o._key))
     , _pe(std::move(o._pe))
     , _flags(o._flags)
+    , _compressed(std::move(o._compressed))
 {
 }
 
@@ -1211,9 +1435,30 @@ cache_entry::~cache_entry() {
 }
 
 void cache_entry::evict(cache_tracker& tracker) noexcept {
+    if (_compressed) {
+        tracker.on_compressed_partition_removal(_compressed->data.size());
+        _compressed = {};
+    }
     _pe.evict(tracker.cleaner());
 }
 
+bool cache_entry::can_compress() noexcept {
+    if (is_dummy_entry() || is_compressed() || _pe._snapshot || !_pe._version->is_single()) {
+        return false;
+    }
+    const mutation_partition& p = _pe._version->partition();
+    if (!p.static_row_continuous()) {
+        return false;
+    }
+    unsigned n = 0;
+    for (const rows_entry& row : p.clustered_rows()) {
+        if (!row.continuous() || ++n > max_compressed_partition_rows) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void row_cache::set_schema(schema_ptr new_schema) noexcept {
     _schema = std::move(new_schema);
 }
@@ -1222,7 +1467,7 @@ void cache_entry::on_evicted(cache_tracker& tracker) noexcept {
     row_cache::partitions_type::iterator it(this);
     std::next(it)->set_continuous(false);
     evict(tracker);
-    tracker.on_partition_eviction();
+    tracker.on_partition_eviction(*_schema);
     it.erase(dht::raw_token_less_comparator{});
 }
 
@@ -1314,7 +1559,29 @@ const schema_ptr& row_cache::schema() const {
     return _schema;
 }
 
+void row_cache::decompress_entry(cache_entry& e) {
+    auto& r = _tracker.region();
+    assert(!r.reclaiming_enabled());
+    const schema& s = *e.schema();
+    const compressed_partition& cp = *e._compressed;
+    bytes data(bytes::initialized_later(), cp.size);
+    compressor::lz4->uncompress(cp.data.get(), cp.data.size(), reinterpret_cast<char*>(data.data()), data.size());
+    with_allocator(r.allocator(), [&] {
+        mutation_partition p(e.schema());
+        mutation_application_stats app_stats;
+        p.apply(s, mutation_partition_view::from_stream(ser::as_input_stream(bytes_view(data))), s, app_stats);
+        auto pe = partition_entry::make_evictable(s, std::move(p));
+        e.evict(_tracker);
+        e.partition() = std::move(pe);
+        _tracker.insert(e.partition());
+    });
+    _tracker.on_partition_decompression();
+}
+
 void row_cache::upgrade_entry(cache_entry& e) {
+    if (e.is_compressed()) {
+        decompress_entry(e);
+    }
     if (e._schema != _schema && !e.partition().is_locked()) {
         auto& r = _tracker.region();
         assert(!r.reclaiming_enabled());
@@ -38,6 +38,8 @@
 #include "mutation_cleaner.hh"
 #include "utils/double-decker.hh"
 #include "db/cache_tracker.hh"
+#include "utils/top_k.hh"
+#include "utils/managed_ref.hh"
 
 namespace bi = boost::intrusive;
 
@@ -55,6 +57,14 @@ class lsa_manager;
 
 }
 
+// Contents of a cold cache entry, serialized with mutation_partition_serializer
+// and compressed with LZ4.
+struct compressed_partition {
+    logalloc::lsa_buffer data;
+    // Size of the serialized partition.
+    uint32_t size;
+};
+
 // Intrusive set entry which holds partition data.
 //
 // TODO: Make memtables use this format too.
@@ -70,6 +80,10 @@ class cache_entry {
         bool _tail : 1;
         bool _train : 1;
     } _flags{};
+    // Engaged when the partition is compressed. Then _pe holds an empty and
+    // discontinuous partition, and the entry must be decompressed with
+    // row_cache::decompress_entry() before it's read or updated.
+    managed_ref<compressed_partition> _compressed;
     friend class size_calculator;
 
     flat_mutation_reader do_read(row_cache&, cache::read_context& ctx);
@@ -149,6 +163,9 @@ class cache_entry {
     void set_continuous(bool value) noexcept { _flags._continuous = value; }
 
     bool is_dummy_entry() const noexcept { return _flags._dummy_entry; }
+    bool is_compressed() const noexcept { return bool(_compressed); }
+    // Tells whether the partition is small, fully cached and not being read or updated.
+    bool can_compress() noexcept;
 
     friend std::ostream& operator<<(std::ostream&, cache_entry&);
 };
@@ -251,6 +268,28 @@ class row_cache final {
     // have the same phases and that it's the same phase as that of the start
     // of the range at the time when reading began.
 
+    // Approximate ranking of the most frequently read partitions, used to warm up
+    // the cache after restart. Keys are compared by their serialized form, which is
+    // canonical, so the schema is not needed.
+    struct hot_partition_hash {
+        size_t operator()(const dht::decorated_key& dk) const {
+            return std::hash<dht::token>()(dk.token());
+        }
+    };
+    struct hot_partition_equal {
+        bool operator()(const dht::decorated_key& a, const dht::decorated_key& b) const {
+            return a.token() == b.token() && a.key().representation() == b.key().representation();
+        }
+    };
+    using hot_partitions_type = utils::space_saving_top_k<dht::decorated_key, hot_partition_hash, hot_partition_equal>;
+    // Only every hot_partition_sample_period-th single-partition read is recorded,
+    // to keep the cost off the read path.
+    static constexpr unsigned hot_partition_sample_period = 4;
+    std::unique_ptr<hot_partitions_type> _hot_partitions;
+    unsigned _hot_partition_reads = 0;
+
+    void record_read(const dht::ring_position& pos);
+
     mutation_source _underlying;
     phase_type _underlying_phase = partition_snapshot::min_phase;
     mutation_source_opt _prev_snapshot;
@@ -274,7 +313,10 @@ class row_cache final {
     void on_row_miss();
     void on_static_row_insert();
     void on_mispopulate();
+    // Must be called before the entry is read or updated.
+    // Decompresses the entry and upgrades it to the current schema.
     void upgrade_entry(cache_entry&);
+    void decompress_entry(cache_entry&);
     void invalidate_locked(const dht::decorated_key&);
     void clear_now() noexcept;
 
@@ -386,6 +428,21 @@ class row_cache final {
     }
 
     const stats& stats() const { return _stats; }
+
+    // Number of partitions of this table evicted from the cache.
+    uint64_t partition_evictions() const noexcept {
+        auto* ts = _tracker.get_table_stats(_schema->id());
+        return ts ? ts->partition_evictions : 0;
+    }
+
+    // Starts tracking up to capacity of the most frequently read partitions.
+    // Only single-partition reads are taken into account, except those which
+    // warm up the cache (partition_slice::option::cache_warm_up).
+    void track_hot_partitions(size_t capacity);
+
+    // Returns at most k of the most frequently read partitions, hottest first.
+    // Returns an empty vector if tracking is not enabled.
+    std::vector<dht::decorated_key> hot_partitions(size_t k) const;
 public:
     // Populate cache from given mutation, which must be fully continuous.
     // Intended to be used only in tests.
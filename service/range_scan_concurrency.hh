@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <unordered_map>
+
+#include "gms/inet_address.hh"
+
+namespace service {
+
+// Sizes the rounds of a range scan, i.e. how many vnode ranges it reads concurrently.
+//
+// A round is bounded by two budgets:
+//  - the number of vnode ranges expected to return the rest of the page, derived
+//    from the rows per range seen by previous rounds and pages of the table's scans;
+//  - the concurrency limit, which grows while the replicas answer as fast as usual
+//    and backs off when they slow down. Ranges read by this node only are cheaper
+//    (no network, no remote replica) and count as half a range toward it.
+struct range_scan_concurrency {
+    // query_ranges_to_vnodes_generator never returns more ranges at once.
+    static constexpr size_t max_ranges = 1024;
+    // Reads are issued for 10% more ranges than estimated, to avoid a second round
+    // for the last few rows of a page.
+    static constexpr float rows_margin = 1.1f;
+    // A round whose slowest read took this many times the usual latency of its replica
+    // doesn't grow the concurrency limit...
+    static constexpr float hold_slowdown = 2.0f;
+    // ...and one this slow halves it.
+    static constexpr float backoff_slowdown = 4.0f;
+
+    // The number of vnode ranges expected to contain remaining_rows rows, if the
+    // number of rows per range is known.
+    static std::optional<size_t> ranges_for_rows(uint64_t remaining_rows, std::optional<float> rows_per_range) {
+        if (!rows_per_range) {
+            return std::nullopt;
+        }
+        // A small positive floor keeps the division finite for tables with mostly empty ranges.
+        auto ranges = std::ceil(remaining_rows * rows_margin / std::max(*rows_per_range, 1.0f / max_ranges));
+        return size_t(std::clamp(ranges, 1.0f, float(max_ranges)));
+    }
+
+    // The concurrency limit of the next round, given the one of the last round and
+    // the largest slowdown of its reads (see replica_latency_tracker::update()).
+    static size_t next_limit(size_t limit, float slowdown) {
+        if (slowdown >= backoff_slowdown) {
+            return std::max(limit / 2, size_t(1));
+        }
+        if (slowdown >= hold_slowdown) {
+            return limit;
+        }
+        return std::min(limit * 2, max_ranges);
+    }
+};
+
+// Tracks the usual latency of range reads sent to each replica, as an exponentially
+// weighted moving average.
+class replica_latency_tracker {
+    static constexpr float alpha = 0.25f;
+    std::unordered_map<gms::inet_address, float> _latency_us;
+public:
+    // Records the latency of a read from ep and returns how many times slower it was
+    // than the average latency of ep before it, or 1 if ep has no history yet.
+    float update(gms::inet_address ep, std::chrono::microseconds latency) {
+        const float us = std::max(float(latency.count()), 1.0f);
+        auto [it, inserted] = _latency_us.try_emplace(ep, us);
+        if (inserted) {
+            return 1.0f;
+        }
+        const float slowdown = us / it->second;
+        it->second += alpha * (us - it->second);
+        return slowdown;
+    }
+
+    std::optional<float> get(gms::inet_address ep) const {
+        auto it = _latency_us.find(ep);
+        return it == _latency_us.end() ? std::nullopt : std::optional<float>(it->second);
+    }
+
+    void remove(gms::inet_address ep) {
+        _latency_us.erase(ep);
+    }
+};
+
+} // namespace service
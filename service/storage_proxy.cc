@@ -115,6 +115,13 @@
 #include "idl/uuid.dist.impl.hh"
 #include "idl/frozen_schema.dist.hh"
 #include "idl/frozen_schema.dist.impl.hh"
+#include "cql3/functions/functions.hh"
+#include "cql3/functions/aggregate_function.hh"
+#include "cql3/selection/selection.hh"
+#include "cql3/result_set.hh"
+#include "cql3/query_options.hh"
+#include "service/query_state.hh"
+#include "service/pager/query_pagers.hh"
 
 namespace bi = boost::intrusive;
 
@@ -4168,32 +4175,55 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
     };
     const auto to_token_range = [] (const dht::partition_range& r) { return r.transform(std::mem_fn(&dht::ring_position::token)); };
 
-    dht::partition_range_vector ranges = ranges_to_vnodes(concurrency_factor);
-    dht::partition_range_vector::iterator i = ranges.begin();
+    // Collect the vnodes of this round, with their replicas. The round ends when it
+    // is expected to return enough rows to fill the page, or when it reaches the
+    // concurrency limit, to which ranges read only by this node count half.
+    struct vnode {
+        dht::partition_range range;
+        inet_address_vector_replica_set live_endpoints;
+        inet_address_vector_replica_set preferred_replicas;
+        inet_address_vector_replica_set filtered_endpoints;
+    };
+    const auto my_address = utils::fb_utilities::get_broadcast_address();
+    const size_t rows_budget = range_scan_concurrency::ranges_for_rows(remaining_row_count, cf.get_range_scan_rows_per_range())
+            .value_or(range_scan_concurrency::max_ranges);
+    std::vector<vnode> vnodes;
+    size_t cost = 0;
+    while (!ranges_to_vnodes.empty() && vnodes.size() < rows_budget && cost < 2 * size_t(concurrency_factor)) {
+        for (auto&& r : ranges_to_vnodes(1)) {
+            auto live_endpoints = get_live_sorted_endpoints(ks, end_token(r));
+            auto preferred = preferred_replicas_for_range(r);
+            auto filtered_endpoints = filter_for_query(cl, ks, live_endpoints, preferred, pcf);
+            const bool local = filtered_endpoints.size() == 1 && filtered_endpoints.front() == my_address;
+            cost += local ? 1 : 2;
+            vnodes.push_back(vnode{std::move(r), std::move(live_endpoints), std::move(preferred), std::move(filtered_endpoints)});
+        }
+    }
+    const size_t vnode_count = vnodes.size();
+    auto i = vnodes.begin();
 
-    // query_ranges_to_vnodes_generator can return less results than requested. If the number of results
-    // is small enough or there are a lot of results - concurrentcy_factor which is increased by shifting left can
-    // eventualy zero out resulting in an infinite recursion. This line makes sure that concurrency factor is never
-    // get stuck on 0 and never increased too much if the number of results remains small.
-    concurrency_factor = std::max(size_t(1), ranges.size());
+    // query_ranges_to_vnodes_generator can return less results than requested. Make sure the
+    // concurrency factor never gets stuck on 0 and is not increased too much if the number of
+    // results remains small.
+    concurrency_factor = std::max(size_t(1), std::min(size_t(concurrency_factor), vnode_count));
 
-    while (i != ranges.end()) {
-        dht::partition_range& range = *i;
-        inet_address_vector_replica_set live_endpoints = get_live_sorted_endpoints(ks, end_token(range));
-        inet_address_vector_replica_set merged_preferred_replicas = preferred_replicas_for_range(*i);
-        inet_address_vector_replica_set filtered_endpoints = filter_for_query(cl, ks, live_endpoints, merged_preferred_replicas, pcf);
+    while (i != vnodes.end()) {
+        dht::partition_range range = std::move(i->range);
+        inet_address_vector_replica_set live_endpoints = std::move(i->live_endpoints);
+        inet_address_vector_replica_set merged_preferred_replicas = std::move(i->preferred_replicas);
+        inet_address_vector_replica_set filtered_endpoints = std::move(i->filtered_endpoints);
         std::vector<dht::token_range> merged_ranges{to_token_range(range)};
         ++i;
 
         // getRestrictedRange has broken the queried range into per-[vnode] token ranges, but this doesn't take
         // the replication factor into account. If the intersection of live endpoints for 2 consecutive ranges
         // still meets the CL requirements, then we can merge both ranges into the same RangeSliceCommand.
-        while (i != ranges.end())
+        while (i != vnodes.end())
         {
-            const auto current_range_preferred_replicas = preferred_replicas_for_range(*i);
-            dht::partition_range& next_range = *i;
-            inet_address_vector_replica_set next_endpoints = get_live_sorted_endpoints(ks, end_token(next_range));
-            inet_address_vector_replica_set next_filtered_endpoints = filter_for_query(cl, ks, next_endpoints, current_range_preferred_replicas, pcf);
+            const auto& current_range_preferred_replicas = i->preferred_replicas;
+            dht::partition_range& next_range = i->range;
+            const inet_address_vector_replica_set& next_endpoints = i->live_endpoints;
+            const inet_address_vector_replica_set& next_filtered_endpoints = i->filtered_endpoints;
 
             // Origin has this to say here:
             // *  If the current range right is the min token, we should stop merging because CFS.getRangeSlice
@@ -4288,8 +4318,17 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
     query::result_merger merger(cmd->get_row_limit(), cmd->partition_limit);
     merger.reserve(exec.size());
 
-    auto f = ::map_reduce(exec.begin(), exec.end(), [timeout] (::shared_ptr<abstract_read_executor>& rex) {
-        return rex->execute(timeout);
+    // The largest slowdown of the reads of this round, relative to the usual latency of their replicas.
+    auto slowdown = make_lw_shared<float>(1.0f);
+    auto f = ::map_reduce(exec.begin(), exec.end(), [p, timeout, slowdown] (::shared_ptr<abstract_read_executor>& rex) {
+        auto start = utils::latency_counter::now();
+        return rex->execute(timeout).then([p, rex, start, slowdown] (foreign_ptr<lw_shared_ptr<query::result>> result) {
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(utils::latency_counter::now() - start);
+            for (auto& ep : rex->used_targets()) {
+                *slowdown = std::max(*slowdown, p->_range_read_latencies.update(ep, latency));
+            }
+            return result;
+        });
     }, std::move(merger));
 
     return f.then([p,
@@ -4300,6 +4339,9 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
             cl,
             cmd,
             concurrency_factor,
+            vnode_count,
+            slowdown,
+            table = cf.shared_from_this(),
             timeout,
             remaining_row_count,
             remaining_partition_count,
@@ -4308,6 +4350,11 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
             ranges_per_exec = std::move(ranges_per_exec),
             permit = std::move(permit)] (foreign_ptr<lw_shared_ptr<query::result>>&& result) mutable {
         result->ensure_counts();
+        // A short read stops at a memory limit rather than at the end of its ranges,
+        // so it says nothing about the number of rows per range.
+        if (!result->is_short_read() && vnode_count) {
+            table->update_range_scan_rows_per_range(vnode_count, result->row_count().value());
+        }
         remaining_row_count -= result->row_count().value();
         remaining_partition_count -= result->partition_count().value();
         results.emplace_back(std::move(result));
@@ -4328,8 +4375,10 @@ storage_proxy::query_partition_key_range_concurrent(storage_proxy::clock_type::t
         } else {
             cmd->set_row_limit(remaining_row_count);
             cmd->partition_limit = remaining_partition_count;
+            auto next_concurrency_factor = range_scan_concurrency::next_limit(concurrency_factor, *slowdown);
+            slogger.trace("range scan read {} vnodes in a round with slowdown {}, next concurrency factor: {}", vnode_count, *slowdown, next_concurrency_factor);
             return p->query_partition_key_range_concurrent(timeout, std::move(results), cmd, cl, std::move(ranges_to_vnodes),
-                    concurrency_factor * 2, std::move(trace_state), remaining_row_count, remaining_partition_count, std::move(preferred_replicas), std::move(permit));
+                    next_concurrency_factor, std::move(trace_state), remaining_row_count, remaining_partition_count, std::move(preferred_replicas), std::move(permit));
         }
     }).handle_exception([p] (std::exception_ptr eptr) {
         p->handle_read_error(eptr, true);
@@ -4349,13 +4398,16 @@ storage_proxy::query_partition_key_range(lw_shared_ptr<query::read_command> cmd,
     // expensive in clusters with vnodes)
     query_ranges_to_vnodes_generator ranges_to_vnodes(get_token_metadata_ptr(), schema, std::move(partition_ranges), ks.get_replication_strategy().get_type() == locator::replication_strategy_type::local);
 
-    int result_rows_per_range = 0;
-    int concurrency_factor = 1;
+    // Start with as many ranges as previous scans of the table suggest are needed to
+    // fill the page, instead of ramping up from a single range on every page.
+    auto& cf = _db.local().find_column_family(schema);
+    auto result_rows_per_range = cf.get_range_scan_rows_per_range();
+    int concurrency_factor = range_scan_concurrency::ranges_for_rows(cmd->get_row_limit(), result_rows_per_range).value_or(1);
 
     std::vector<foreign_ptr<lw_shared_ptr<query::result>>> results;
 
     slogger.debug("Estimated result rows per range: {}; requested rows: {}, concurrent range requests: {}",
-            result_rows_per_range, cmd->get_row_limit(), concurrency_factor);
+            result_rows_per_range.value_or(0), cmd->get_row_limit(), concurrency_factor);
 
     // The call to `query_partition_key_range_concurrent()` below
     // updates `cmd` directly when processing the results. Under
@@ -4396,6 +4448,150 @@ storage_proxy::query_partition_key_range(lw_shared_ptr<query::read_command> cmd,
     });
 }
 
+// Creates aggregates for the functions of a partial aggregation request. The
+// functions are found by the types of the columns they aggregate.
+static std::vector<std::unique_ptr<cql3::functions::aggregate_function::aggregate>>
+make_partial_aggregates(const schema& s, const query::forward_request& req) {
+    std::vector<std::unique_ptr<cql3::functions::aggregate_function::aggregate>> ret;
+    ret.reserve(req.aggregations.size());
+    for (auto& info : req.aggregations) {
+        std::vector<data_type> arg_types;
+        arg_types.reserve(info.column_names.size());
+        for (auto& name : info.column_names) {
+            auto column = s.get_column_definition(name);
+            if (!column) {
+                throw std::runtime_error(format("Unknown column {} in partial aggregation of {}.{}", name, s.ks_name(), s.cf_name()));
+            }
+            arg_types.push_back(column->type->without_reversed().shared_from_this());
+        }
+        auto name = cql3::functions::function_name(info.function_keyspace, info.function_name);
+        auto fun = dynamic_pointer_cast<cql3::functions::aggregate_function>(cql3::functions::functions::find(name, arg_types));
+        if (!fun || !fun->is_reducible()) {
+            throw std::runtime_error(format("Function {} can't be used in partial aggregation", name));
+        }
+        ret.push_back(fun->new_aggregate());
+    }
+    return ret;
+}
+
+future<query::forward_result>
+storage_proxy::query_partial_aggregates_locally(schema_ptr s, query::forward_request req,
+        storage_proxy::clock_type::time_point timeout, tracing::trace_state_ptr trace_state) {
+    // Rows are read in pages of the same size as the ones of aggregate queries.
+    static constexpr uint32_t page_size = 10000;
+
+    auto aggregates = make_partial_aggregates(*s, req);
+    std::vector<const column_definition*> columns;
+    columns.reserve(req.column_names.size());
+    for (auto& name : req.column_names) {
+        auto column = s->get_column_definition(name);
+        if (!column) {
+            throw std::runtime_error(format("Unknown column {} in partial aggregation of {}.{}", name, s->ks_name(), s->cf_name()));
+        }
+        columns.push_back(column);
+    }
+    // The positions of the arguments of each aggregate in the rows of the selection.
+    std::vector<std::vector<size_t>> arguments;
+    arguments.reserve(req.aggregations.size());
+    for (auto& info : req.aggregations) {
+        auto& positions = arguments.emplace_back();
+        for (auto& name : info.column_names) {
+            auto it = boost::find_if(columns, [&] (const column_definition* c) { return c->name() == name; });
+            if (it == columns.end()) {
+                throw std::runtime_error(format("Column {} of partial aggregation is not selected", name));
+            }
+            positions.push_back(it - columns.begin());
+        }
+    }
+
+    tracing::trace(trace_state, "Computing partial aggregates over {} ranges", req.pr.size());
+    auto selection = cql3::selection::selection::for_columns(s, std::move(columns));
+    service::query_state query_state(service::client_state::for_internal_calls(), trace_state, empty_service_permit());
+    cql3::query_options query_options(req.cl, std::vector<cql3::raw_value>{});
+    auto now = req.cmd.timestamp;
+    auto cmd = make_lw_shared<query::read_command>(std::move(req.cmd));
+    cmd->slice.options.set<query::partition_slice::option::allow_short_read>();
+    auto pager = service::pager::query_pagers::pager(s, selection, query_state, query_options, cmd, std::move(req.pr), nullptr);
+
+    const auto sf = cql_serialization_format::internal();
+    std::vector<bytes_opt> args;
+    while (!pager->is_exhausted()) {
+        auto rs = co_await pager->fetch_page(page_size, now, timeout);
+        for (auto& row : rs->rows()) {
+            for (size_t i = 0; i < aggregates.size(); ++i) {
+                args.clear();
+                for (auto pos : arguments[i]) {
+                    args.push_back(row[pos]);
+                }
+                aggregates[i]->add_input(sf, args);
+            }
+        }
+    }
+
+    query::forward_result ret;
+    ret.query_results.reserve(aggregates.size());
+    for (auto& agg : aggregates) {
+        ret.query_results.push_back(agg->get_state());
+    }
+    co_return ret;
+}
+
+future<query::forward_result>
+storage_proxy::query_partial_aggregates(query::forward_request req,
+        storage_proxy::clock_type::duration timeout,
+        tracing::trace_state_ptr trace_state) {
+    schema_ptr schema = local_schema_registry().get(req.cmd.schema_version);
+    keyspace& ks = _db.local().find_keyspace(schema->ks_name());
+    const auto my_address = utils::fb_utilities::get_broadcast_address();
+
+    // Every vnode is read by exactly one replica, so that each row is aggregated once.
+    // Vnodes without live replicas are left to this node, whose read will fail with
+    // the appropriate error.
+    std::unordered_map<gms::inet_address, dht::partition_range_vector> ranges_per_endpoint;
+    query_ranges_to_vnodes_generator ranges_to_vnodes(get_token_metadata_ptr(), schema, std::move(req.pr),
+            ks.get_replication_strategy().get_type() == locator::replication_strategy_type::local);
+    while (!ranges_to_vnodes.empty()) {
+        for (auto&& range : ranges_to_vnodes(1024)) {
+            auto endpoints = get_live_sorted_endpoints(ks, end_token(range));
+            auto endpoint = endpoints.empty() ? my_address : endpoints.front();
+            ranges_per_endpoint[endpoint].push_back(std::move(range));
+        }
+    }
+
+    auto aggregates = make_partial_aggregates(*schema, req);
+    co_await parallel_for_each(ranges_per_endpoint, [&] (auto& endpoint_ranges) -> future<> {
+        auto& [endpoint, ranges] = endpoint_ranges;
+        for (auto it = ranges.begin(); it != ranges.end();) {
+            auto batch_end = it + std::min<size_t>(vnodes_per_partial_aggregation, ranges.end() - it);
+            query::forward_request sub_req{req.aggregations, req.column_names, req.cmd,
+                    dht::partition_range_vector(std::make_move_iterator(it), std::make_move_iterator(batch_end)), req.cl};
+            it = batch_end;
+            auto sub_timeout = clock_type::now() + timeout;
+            query::forward_result result;
+            if (endpoint == my_address) {
+                result = co_await query_partial_aggregates_locally(schema, std::move(sub_req), sub_timeout, trace_state);
+            } else {
+                tracing::trace(trace_state, "Sending partial aggregation of {} ranges to /{}", sub_req.pr.size(), endpoint);
+                result = co_await _messaging.send_forward_request(netw::msg_addr{endpoint, 0}, sub_timeout, sub_req);
+                tracing::trace(trace_state, "Got partial aggregates from /{}", endpoint);
+            }
+            if (result.query_results.size() != aggregates.size()) {
+                throw std::runtime_error(format("Got {} partial aggregates from {}, expected {}", result.query_results.size(), endpoint, aggregates.size()));
+            }
+            for (size_t i = 0; i < aggregates.size(); ++i) {
+                aggregates[i]->merge_state(result.query_results[i]);
+            }
+        }
+    });
+
+    query::forward_result ret;
+    ret.query_results.reserve(aggregates.size());
+    for (auto& agg : aggregates) {
+        ret.query_results.push_back(agg->get_state());
+    }
+    co_return ret;
+}
+
 future<storage_proxy::coordinator_query_result>
 storage_proxy::query(schema_ptr s,
     lw_shared_ptr<query::read_command> cmd,
@@ -5131,6 +5327,21 @@ void storage_proxy::init_messaging_service(shared_ptr<migration_manager> mm) {
             });
         });
     });
+    ms.register_forward_request([this, mm] (const rpc::client_info& cinfo, rpc::opt_time_point t, query::forward_request req) -> future<query::forward_result> {
+        tracing::trace_state_ptr trace_state_ptr;
+        auto src_addr = netw::messaging_service::get_source(cinfo);
+        if (req.cmd.trace_info) {
+            trace_state_ptr = tracing::tracing::get_local_tracing_instance().create_session(*req.cmd.trace_info);
+            tracing::begin(trace_state_ptr);
+            tracing::trace(trace_state_ptr, "forward_request: message received from /{}", src_addr.addr);
+        }
+        auto src_ip = src_addr.addr;
+        auto timeout = t ? *t : db::no_timeout;
+        schema_ptr s = co_await mm->get_schema_for_read(req.cmd.schema_version, std::move(src_addr), _messaging);
+        auto result = co_await query_partial_aggregates_locally(std::move(s), std::move(req), timeout, trace_state_ptr);
+        tracing::trace(trace_state_ptr, "forward_request handling is done, sending a response to /{}", src_ip);
+        co_return result;
+    });
     ms.register_read_mutation_data([mm] (const rpc::client_info& cinfo, rpc::opt_time_point t, query::read_command cmd, ::compat::wrapping_partition_range pr) {
         tracing::trace_state_ptr trace_state_ptr;
         auto src_addr = netw::messaging_service::get_source(cinfo);
@@ -5313,6 +5524,7 @@ future<> storage_proxy::uninit_messaging_service() {
         ms.unregister_read_data(),
         ms.unregister_read_mutation_data(),
         ms.unregister_read_digest(),
+        ms.unregister_forward_request(),
         ms.unregister_truncate(),
         ms.unregister_paxos_prepare(),
         ms.unregister_paxos_accept(),
@@ -5513,6 +5725,7 @@ void storage_proxy::on_join_cluster(const gms::inet_address& endpoint) {};
 void storage_proxy::on_leave_cluster(const gms::inet_address& endpoint) {
     _hints_manager.drain_for(endpoint);
     _hints_for_views_manager.drain_for(endpoint);
+    _range_read_latencies.remove(endpoint);
 }
 
 void storage_proxy::on_up(const gms::inet_address& endpoint) {};
@@ -70,6 +70,7 @@
 #include "db/hints/host_filter.hh"
 #include "utils/small_vector.hh"
 #include "service/endpoint_lifecycle_subscriber.hh"
+#include "service/range_scan_concurrency.hh"
 
 class reconcilable_result;
 class frozen_mutation_and_schema;
@@ -294,6 +295,8 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
     // for read repair chance calculation
     std::default_random_engine _urandom;
     std::uniform_real_distribution<> _read_repair_chance = std::uniform_real_distribution<>(0,1);
+    // for sizing the rounds of range scans
+    replica_latency_tracker _range_read_latencies;
     seastar::metrics::metric_groups _metrics;
     uint64_t _background_write_throttle_threahsold;
     inheriting_concrete_execution_stage<
@@ -390,6 +393,8 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
             dht::partition_range_vector partition_ranges,
             db::consistency_level cl,
             coordinator_query_options optional_params);
+    future<query::forward_result> query_partial_aggregates_locally(schema_ptr s, query::forward_request req,
+            clock_type::time_point timeout, tracing::trace_state_ptr trace_state);
     static inet_address_vector_replica_set intersection(const inet_address_vector_replica_set& l1, const inet_address_vector_replica_set& l2);
     future<query_partition_key_range_concurrent_result> query_partition_key_range_concurrent(clock_type::time_point timeout,
             std::vector<foreign_ptr<lw_shared_ptr<query::result>>>&& results,
@@ -454,8 +459,6 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
 
     void maybe_update_view_backlog_of(gms::inet_address, std::optional<db::view::update_backlog>);
 
-    db::view::update_backlog get_backlog_of(gms::inet_address) const;
-
     template<typename Range>
     future<> mutate_counters(Range&& mutations, db::consistency_level cl, tracing::trace_state_ptr tr_state, service_permit permit, clock_type::time_point timeout);
 
@@ -471,6 +474,9 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
     distributed<database>& get_db() {
         return _db;
     }
+
+    // The last view update backlog reported by the node, in write responses or through gossip.
+    db::view::update_backlog get_backlog_of(gms::inet_address) const;
     const database& local_db() const noexcept {
         return _db.local();
     }
@@ -612,6 +618,24 @@ class storage_proxy : public seastar::async_sharded_service<storage_proxy>, publ
         db::consistency_level cl,
         coordinator_query_options optional_params);
 
+    /*
+     * Computes the aggregates of a full-scan query without moving its rows.
+     *
+     * Each vnode of the request's ranges is assigned to a single live replica
+     * (this node when possible), which reads its ranges with the requested
+     * consistency level and replies with the partial states of the aggregates
+     * only. The returned states are the merged states of all replicas, in the
+     * order of req.aggregations.
+     *
+     * The vnodes of a replica are sent in batches of at most
+     * vnodes_per_partial_aggregation, one after the other, and each batch must
+     * be done within timeout, like a page of a regular aggregate query.
+     */
+    static constexpr size_t vnodes_per_partial_aggregation = 16;
+    future<query::forward_result> query_partial_aggregates(query::forward_request req,
+        clock_type::duration timeout,
+        tracing::trace_state_ptr trace_state);
+
     future<rpc::tuple<foreign_ptr<lw_shared_ptr<reconcilable_result>>, cache_temperature>> query_mutations_locally(
         schema_ptr, lw_shared_ptr<query::read_command> cmd, const dht::partition_range&,
         clock_type::time_point timeout,
@@ -26,7 +26,10 @@
 #include <seastar/core/align.hh>
 #include <seastar/core/bitops.hh>
 #include <seastar/core/byteorder.hh>
+#include <seastar/core/coroutine.hh>
 #include <seastar/core/fstream.hh>
+#include <seastar/core/loop.hh>
+#include <seastar/coroutine/maybe_yield.hh>
 
 #include "../compress.hh"
 #include "compress.hh"
@@ -281,7 +284,11 @@ local_compression::local_compression(const compression& c)
             return std::nullopt;
         });
     }())
-{}
+{
+    if (_compressor && !c.dictionary.data.value.empty()) {
+        _compressor = _compressor->with_dictionary(c.dictionary.data.value, compressor::dictionary_usage::uncompress);
+    }
+}
 
 size_t local_compression::uncompress(const char* input,
                 size_t input_len, char* output, size_t output_len) const {
@@ -356,11 +363,11 @@ class compressed_file_data_source_impl : public data_source_impl {
     uint64_t _beg_pos;
     uint64_t _end_pos;
 public:
-    compressed_file_data_source_impl(file f, sstables::compression* cm,
+    compressed_file_data_source_impl(file f, sstables::compression* cm, compressor_ptr c,
                 uint64_t pos, size_t len, file_input_stream_options options)
             : _compression_metadata(cm)
             , _offsets(_compression_metadata->offsets.get_accessor())
-            , _compression(*cm)
+            , _compression(c ? sstables::local_compression(std::move(c)) : sstables::local_compression(*cm))
     {
         _beg_pos = pos;
         if (pos > _compression_metadata->uncompressed_file_length()) {
@@ -456,21 +463,21 @@ template <typename ChecksumType>
 requires ChecksumUtils<ChecksumType>
 class compressed_file_data_source : public data_source {
 public:
-    compressed_file_data_source(file f, sstables::compression* cm,
+    compressed_file_data_source(file f, sstables::compression* cm, compressor_ptr c,
             uint64_t offset, size_t len, file_input_stream_options options)
         : data_source(std::make_unique<compressed_file_data_source_impl<ChecksumType>>(
-                std::move(f), cm, offset, len, std::move(options)))
+                std::move(f), cm, std::move(c), offset, len, std::move(options)))
         {}
 };
 
 template <typename ChecksumType>
 requires ChecksumUtils<ChecksumType>
 inline input_stream<char> make_compressed_file_input_stream(
-        file f, sstables::compression *cm, uint64_t offset, size_t len,
+        file f, sstables::compression *cm, compressor_ptr c, uint64_t offset, size_t len,
         file_input_stream_options options)
 {
     return input_stream<char>(compressed_file_data_source<ChecksumType>(
-            std::move(f), cm, offset, len, std::move(options)));
+            std::move(f), cm, std::move(c), offset, len, std::move(options)));
 }
 
 // For SSTables 2.x (formats 'ka' and 'la'), the full checksum is a combination of checksums of compressed chunks.
@@ -481,9 +488,26 @@ enum class compressed_checksum_mode {
     checksum_all,
 };
 
+// Compressors using a dictionary have it trained on the first chunks written
+// to the sstable. The sample is this many times larger than the dictionary,
+// up to max_dictionary_sample_size, and is cut into pieces of
+// dictionary_sample_piece_size bytes, roughly the size of a few rows.
+//
+// Training runs on the shard, in one go, as zstd can't train incrementally,
+// so the sample is kept small enough for a single pass over it to take about
+// a task quota.
+static constexpr size_t dictionary_sample_ratio = 16;
+static constexpr size_t max_dictionary_sample_size = 1024 * 1024;
+static constexpr size_t dictionary_sample_piece_size = 1024;
+
 // compressed_file_data_sink_impl works as a filter for a file output stream,
 // where the buffer flushed will be compressed and its checksum computed, then
 // the result passed to a regular output stream.
+//
+// If the compressor uses a dictionary, the first chunks are held back until
+// there are enough of them to train one, and only then compressed, with the
+// new dictionary, like all the chunks that follow. Until that happens the
+// compressed file length stays at 0.
 template <typename ChecksumType, compressed_checksum_mode mode>
 requires ChecksumUtils<ChecksumType>
 class compressed_file_data_sink_impl : public data_sink_impl {
@@ -493,17 +517,87 @@ class compressed_file_data_sink_impl : public data_sink_impl {
     sstables::local_compression _compression;
     size_t _pos = 0;
     uint32_t _full_checksum;
+    bool _sampling;
+    std::vector<temporary_buffer<char>> _sample;
+    size_t _sample_size = 0;
+    seastar::scheduling_group _training_sg;
 public:
-    compressed_file_data_sink_impl(output_stream<char> out, sstables::compression* cm, sstables::local_compression lc)
+    compressed_file_data_sink_impl(output_stream<char> out, sstables::compression* cm, sstables::local_compression lc,
+            sstables::dictionary_training_config dtc)
             : _out(std::move(out))
             , _compression_metadata(cm)
             , _offsets(_compression_metadata->offsets.get_writer())
             , _compression(lc)
             , _full_checksum(ChecksumType::init_checksum())
+            , _sampling(dtc.enabled && _compression && _compression.compressor()->dictionary_max_size())
+            , _training_sg(dtc.sg)
     {}
 
     virtual future<> put(net::packet data) override { abort(); }
     virtual future<> put(temporary_buffer<char> buf) override {
+        if (_sampling) {
+            _sample_size += buf.size();
+            _sample.push_back(std::move(buf));
+            auto wanted = std::min(_compression.compressor()->dictionary_max_size() * dictionary_sample_ratio, max_dictionary_sample_size);
+            if (_sample_size < wanted) {
+                return make_ready_future<>();
+            }
+            return flush_sample();
+        }
+        return compress_and_write(std::move(buf));
+    }
+    virtual future<> close() override {
+        auto f = _sampling ? flush_sample() : make_ready_future<>();
+        return f.finally([this] {
+            return _out.close();
+        });
+    }
+
+    virtual size_t buffer_size() const noexcept override {
+        return _compression_metadata->uncompressed_chunk_length();
+    }
+private:
+    future<> train_dictionary() {
+        // Runs in the maintenance group, whatever the writer's own group, so that a burst
+        // of flushes doesn't hold back the other work of the group they run in.
+        return with_scheduling_group(_training_sg, [this] {
+            return do_train_dictionary();
+        });
+    }
+
+    future<> do_train_dictionary() {
+        bytes samples(bytes::initialized_later(), _sample_size);
+        std::vector<size_t> sample_sizes;
+        auto out = samples.begin();
+        for (auto& buf : _sample) {
+            out = std::copy_n(reinterpret_cast<const int8_t*>(buf.get()), buf.size(), out);
+            for (size_t off = 0; off < buf.size(); off += dictionary_sample_piece_size) {
+                sample_sizes.push_back(std::min(dictionary_sample_piece_size, buf.size() - off));
+            }
+            co_await coroutine::maybe_yield();
+        }
+        auto dictionary = _compression.compressor()->train_dictionary(samples, sample_sizes);
+        if (dictionary.empty()) {
+            sstables::sstlog.debug("Not enough data to train a compression dictionary, compressing without one");
+            co_return;
+        }
+        _compression = sstables::local_compression(_compression.compressor()->with_dictionary(dictionary,
+                compressor::dictionary_usage::compress));
+        _compression_metadata->dictionary.data.value = std::move(dictionary);
+    }
+
+    future<> flush_sample() {
+        _sampling = false;
+        return train_dictionary().then([this] {
+            return do_for_each(_sample, [this] (temporary_buffer<char>& buf) {
+                return compress_and_write(std::move(buf));
+            });
+        }).then([this] {
+            _sample.clear();
+        });
+    }
+
+    future<> compress_and_write(temporary_buffer<char> buf) {
         auto output_len = _compression.compress_max_size(buf.size());
 
         // account space for checksum that goes after compressed data.
@@ -543,29 +637,24 @@ class compressed_file_data_sink_impl : public data_sink_impl {
         auto f = _out.write(compressed.get(), compressed.size());
         return f.then([compressed = std::move(compressed)] {});
     }
-    virtual future<> close() override {
-        return _out.close();
-    }
-
-    virtual size_t buffer_size() const noexcept override {
-        return _compression_metadata->uncompressed_chunk_length();
-    }
 };
 
 template <typename ChecksumType, compressed_checksum_mode mode>
 requires ChecksumUtils<ChecksumType>
 class compressed_file_data_sink : public data_sink {
 public:
-    compressed_file_data_sink(output_stream<char> out, sstables::compression* cm, sstables::local_compression lc)
+    compressed_file_data_sink(output_stream<char> out, sstables::compression* cm, sstables::local_compression lc,
+            sstables::dictionary_training_config dtc)
         : data_sink(std::make_unique<compressed_file_data_sink_impl<ChecksumType, mode>>(
-                std::move(out), cm, std::move(lc))) {}
+                std::move(out), cm, std::move(lc), dtc)) {}
 };
 
 template <typename ChecksumType, compressed_checksum_mode mode>
 requires ChecksumUtils<ChecksumType>
 inline output_stream<char> make_compressed_file_output_stream(output_stream<char> out,
          sstables::compression* cm,
-         const compression_parameters& cp) {
+         const compression_parameters& cp,
+         sstables::dictionary_training_config dtc) {
     // buffer of output stream is set to chunk length, because flush must
     // happen every time a chunk was filled up.
 
@@ -577,26 +666,27 @@ inline output_stream<char> make_compressed_file_output_stream(output_stream<char
     // defaults to 1.0.
     cm->options.elements.push_back({"crc_check_chance", "1.0"});
 
-    return output_stream<char>(compressed_file_data_sink<ChecksumType, mode>(std::move(out), cm, p));
+    return output_stream<char>(compressed_file_data_sink<ChecksumType, mode>(std::move(out), cm, p, dtc));
 }
 
 input_stream<char> sstables::make_compressed_file_k_l_format_input_stream(file f,
         sstables::compression* cm, uint64_t offset, size_t len,
-        class file_input_stream_options options)
+        class file_input_stream_options options, compressor_ptr c)
 {
-    return make_compressed_file_input_stream<adler32_utils>(std::move(f), cm, offset, len, std::move(options));
+    return make_compressed_file_input_stream<adler32_utils>(std::move(f), cm, std::move(c), offset, len, std::move(options));
 }
 
 input_stream<char> sstables::make_compressed_file_m_format_input_stream(file f,
         sstables::compression *cm, uint64_t offset, size_t len,
-        class file_input_stream_options options) {
-    return make_compressed_file_input_stream<crc32_utils>(std::move(f), cm, offset, len, std::move(options));
+        class file_input_stream_options options, compressor_ptr c) {
+    return make_compressed_file_input_stream<crc32_utils>(std::move(f), cm, std::move(c), offset, len, std::move(options));
 }
 
 output_stream<char> sstables::make_compressed_file_m_format_output_stream(output_stream<char> out,
         sstables::compression* cm,
-        const compression_parameters& cp) {
+        const compression_parameters& cp,
+        dictionary_training_config dtc) {
     return make_compressed_file_output_stream<crc32_utils, compressed_checksum_mode::checksum_all>(
-            std::move(out), cm, cp);
+            std::move(out), cm, cp, dtc);
 }
 
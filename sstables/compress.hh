@@ -54,6 +54,7 @@
 #include <seastar/core/seastar.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/fstream.hh>
+#include <seastar/core/scheduling.hh>
 
 #include "types.hh"
 #include "sstables/types.hh"
@@ -309,6 +310,9 @@ struct compression {
     uint32_t chunk_len = 0;
     uint64_t data_len = 0;
     segmented_offsets offsets;
+    // Not found in the "Compression Info" file either, but in its own
+    // CompressionDictionary component, if the compressor uses one.
+    compression_dictionary dictionary;
 
 private:
     // Variables *not* found in the "Compression Info" file (added by update()):
@@ -374,7 +378,8 @@ struct compression {
     friend class sstable;
 };
 
-// for API query only. Free function just to distinguish it from an accessor in compression
+// Returns a compressor able to uncompress the sstable's chunks. Free function
+// just to distinguish it from an accessor in compression.
 compressor_ptr get_sstable_compressor(const compression&);
 
 // Note: compression_metadata is passed by reference; The caller is
@@ -382,17 +387,30 @@ compressor_ptr get_sstable_compressor(const compression&);
 // are open streams on it. This should happen naturally on a higher level -
 // as long as we have *sstables* work in progress, we need to keep the whole
 // sstable alive, and the compression metadata is only a part of it.
+//
+// If "c" is given, it is used to uncompress the chunks, instead of a
+// compressor built from "cm" for this stream alone. Sharing one between the
+// streams of an sstable saves loading its dictionary again for each of them.
 input_stream<char> make_compressed_file_k_l_format_input_stream(file f,
                 sstables::compression* cm, uint64_t offset, size_t len,
-                class file_input_stream_options options);
+                class file_input_stream_options options, compressor_ptr c = nullptr);
 
 input_stream<char> make_compressed_file_m_format_input_stream(file f,
                 sstables::compression* cm, uint64_t offset, size_t len,
-                class file_input_stream_options options);
+                class file_input_stream_options options, compressor_ptr c = nullptr);
+
+// Whether, and where, the sink trains a dictionary, for compressors which use one.
+struct dictionary_training_config {
+    // False when the sstable must not have a dictionary, e.g. because not all
+    // nodes of the cluster can read one.
+    bool enabled = false;
+    seastar::scheduling_group sg = seastar::default_scheduling_group();
+};
 
 output_stream<char> make_compressed_file_m_format_output_stream(output_stream<char> out,
                 sstables::compression* cm,
-                const compression_parameters& cp);
+                const compression_parameters& cp,
+                dictionary_training_config dtc = {});
 
 }
 
@@ -243,6 +243,10 @@ class mp_row_consumer_m {
 
     ~mp_row_consumer_m() {}
 
+    const query::partition_slice& slice() const {
+        return _slice;
+    }
+
     // See the RowConsumer concept
     void push_ready_fragments() {
         if (auto rto = std::move(_stored_tombstone)) {
@@ -715,6 +719,9 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
 
         // Represents the subset of _all_columns present in current row
         boost::dynamic_bitset<uint64_t> _columns_selector; // size() == _columns.size()
+
+        // Represents the subset of _all_columns whose cell values are not needed, see setup_skipped_values()
+        boost::dynamic_bitset<uint64_t> _skipped_values; // size() == _all_columns.size()
     };
 
     row_schema _regular_row;
@@ -762,6 +769,22 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
     void setup_columns(row_schema& rs, const std::vector<column_translation::column_info>& columns) {
         rs._all_columns = boost::make_iterator_range(columns);
         rs._columns_selector = boost::dynamic_bitset<uint64_t>(columns.size());
+        rs._skipped_values = boost::dynamic_bitset<uint64_t>(columns.size());
+    }
+    // With partition_slice::option::skip_unselected_values, cells of columns which are not
+    // selected are still parsed, but their values may be skipped in the input instead of being
+    // copied out, and the cells passed to the consumer empty. See can_skip_column_value() for
+    // the cells this is done for.
+    // Counter cells are always read in full, since an empty counter cell is not valid.
+    void setup_skipped_values(row_schema& rs, const query::column_id_vector& selected) {
+        size_t pos = 0;
+        for (const auto& column_info : rs._all_columns) {
+            if (column_info.id && !column_info.is_counter
+                    && std::find(selected.begin(), selected.end(), *column_info.id) == selected.end()) {
+                rs._skipped_values.set(pos);
+            }
+            ++pos;
+        }
     }
     void skip_absent_columns() {
         size_t pos = _row->_columns_selector.find_first();
@@ -778,6 +801,26 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
                                                                                   : next_pos - current_pos;
         _row->_columns.advance_begin(jump_to_next);
     }
+    bool is_column_value_skipped() const {
+        return _row->_skipped_values.test(_row->_all_columns.size() - _row->_columns.size());
+    }
+    // When cells from several sources have the same timestamp, their values decide which
+    // one wins, ahead of their expiry, so emptying a value may let an expiring cell win
+    // over a non-expiring one and change the liveness of the row. The value is only skipped
+    // for cells which row liveness doesn't depend on: those of a row with a live, non-expiring
+    // marker, which are not expiring and not newer than the marker. The row is then live
+    // through its marker, unless a row tombstone shadows both the marker and the cell.
+    // This still assumes no other source has a newer, expiring marker for the row along with
+    // an equal-timestamp cell, which only client-provided timestamps could produce.
+    bool can_skip_column_value() const {
+        return _liveness.timestamp() != api::missing_timestamp
+                && _liveness.ttl() == gc_clock::duration::zero()
+                && _liveness.local_deletion_time() == gc_clock::time_point::max()
+                && !_column_flags.is_deleted()
+                && !_column_flags.is_expiring()
+                && _column_ttl == gc_clock::duration::zero()
+                && _column_timestamp <= _liveness.timestamp();
+    }
     bool is_column_simple() const { return !_row->_columns.front().is_collection; }
     bool is_column_counter() const { return _row->_columns.front().is_counter; }
     const column_translation::column_info& get_column_info() const {
@@ -1092,6 +1135,19 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
             }
             if (!_column_flags.has_value()) {
                 _column_value = fragmented_temporary_buffer();
+            } else if (is_column_value_skipped() && can_skip_column_value()) {
+                _column_value = fragmented_temporary_buffer();
+                uint64_t value_length;
+                if (auto len = get_column_value_length()) {
+                    value_length = *len;
+                } else {
+                    co_yield read_unsigned_vint(*_processing_data);
+                    value_length = _u64;
+                }
+                auto maybe_skip_bytes = skip(*_processing_data, value_length);
+                if (std::holds_alternative<skip_bytes>(maybe_skip_bytes)) {
+                    co_yield maybe_skip_bytes;
+                }
             } else {
                 read_status status = read_status::waiting;
                 if (auto len = get_column_value_length()) {
@@ -1192,6 +1248,12 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
     {
         setup_columns(_regular_row, _column_translation.regular_columns());
         setup_columns(_static_row, _column_translation.static_columns());
+        // Static rows of static compact tables hold regular columns, keep it simple and read them in full.
+        const auto& slice = consumer.slice();
+        if (slice.options.contains(query::partition_slice::option::skip_unselected_values) && !s.is_static_compact_table()) {
+            setup_skipped_values(_regular_row, slice.regular_columns);
+            setup_skipped_values(_static_row, slice.static_columns);
+        }
     }
 
     void verify_end_state() {
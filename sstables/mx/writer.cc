@@ -800,7 +800,8 @@ class writer : public sstable_writer::writer_impl {
         _sst._shards = { shard };
 
         _cfg.monitor->on_write_started(_data_writer->offset_tracker());
-        _sst._components->filter = utils::i_filter::get_filter(estimated_partitions, _schema.bloom_filter_fp_chance(), utils::filter_format::m_format);
+        _sst._components->filter = utils::i_filter::get_filter(estimated_partitions, _schema.bloom_filter_fp_chance(),
+                _cfg.blocked_bloom_filter ? utils::filter_format::blocked_format : utils::filter_format::m_format);
         _pi_write_m.desired_block_size = cfg.promoted_index_block_size;
         _index_sampling_state.summary_byte_cost = _cfg.summary_byte_cost;
         prepare_summary(_sst._components->summary, estimated_partitions, _schema.min_index_interval());
@@ -888,11 +889,13 @@ void writer::init_file_writers() {
         _data_writer = std::make_unique<crc32_checksummed_file_writer>(std::move(out), options.buffer_size, _sst.filename(component_type::Data));
     } else {
         auto out = make_file_output_stream(std::move(_sst._data_file), options).get0();
+        // The TOC, generated before, decides whether the sstable has a dictionary.
+        dictionary_training_config dtc{_sst.has_component(component_type::CompressionDictionary), _sst.manager().maintenance_scheduling_group()};
         _data_writer = std::make_unique<file_writer>(
             make_compressed_file_m_format_output_stream(
                 std::move(out),
                 &_sst._components->compression,
-                _schema.get_compressor_params()), _sst.filename(component_type::Data));
+                _schema.get_compressor_params(), dtc), _sst.filename(component_type::Data));
     }
     auto w = file_writer::make(std::move(_sst._index_file), std::move(options), _sst.filename(component_type::Index));
     _index_writer = std::make_unique<file_writer>(w.get0());
@@ -355,6 +355,7 @@ future<uint64_t> sstable_directory::reshape(compaction_manager& cm, table& table
             }
 
             desc.creator = creator;
+            desc.parallelism = table.get_config().compaction_sub_range_parallelism();
 
             return cm.run_custom_job(&table, compaction_type::Reshape, [this, &table, sstlist = std::move(sstlist), desc = std::move(desc)] (sstables::compaction_data& info) mutable {
                 return sstables::compact_sstables(std::move(desc), info, table.as_table_state()).then([this, sstlist = std::move(sstlist)] (sstables::compaction_result result) mutable {
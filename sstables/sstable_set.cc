@@ -30,6 +30,7 @@
 #include "compaction/compaction_strategy_impl.hh"
 #include "compaction/leveled_compaction_strategy.hh"
 #include "compaction/time_window_compaction_strategy.hh"
+#include "compaction/incremental_compaction_strategy.hh"
 
 #include "sstable_set_impl.hh"
 
@@ -606,6 +607,11 @@ std::unique_ptr<sstable_set_impl> leveled_compaction_strategy::make_sstable_set(
     return std::make_unique<partitioned_sstable_set>(std::move(schema), make_lw_shared<sstable_list>());
 }
 
+std::unique_ptr<sstable_set_impl> incremental_compaction_strategy::make_sstable_set(schema_ptr schema) const {
+    // Fragments of a run are disjoint, so reads only need the few whose token ranges they overlap.
+    return std::make_unique<partitioned_sstable_set>(std::move(schema), make_lw_shared<sstable_list>(), false);
+}
+
 std::unique_ptr<sstable_set_impl> time_window_compaction_strategy::make_sstable_set(schema_ptr schema) const {
     return std::make_unique<time_series_sstable_set>(std::move(schema));
 }
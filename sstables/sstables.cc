@@ -854,6 +854,9 @@ void sstable::generate_toc(compressor_ptr c, double filter_fp_chance) {
         _recognized_components.insert(component_type::CRC);
     } else {
         _recognized_components.insert(component_type::CompressionInfo);
+        if (c->dictionary_max_size() && _manager.dictionary_compression_enabled()) {
+            _recognized_components.insert(component_type::CompressionDictionary);
+        }
     }
     _recognized_components.insert(component_type::Scylla);
 }
@@ -1073,7 +1076,12 @@ future<> sstable::read_compression(const io_priority_class& pc) {
         return make_ready_future<>();
     }
 
-    return read_simple<component_type::CompressionInfo>(_components->compression, pc);
+    return read_simple<component_type::CompressionInfo>(_components->compression, pc).then([this, &pc] {
+        if (!has_component(component_type::CompressionDictionary)) {
+            return make_ready_future<>();
+        }
+        return read_simple<component_type::CompressionDictionary>(_components->compression.dictionary, pc);
+    });
 }
 
 void sstable::write_compression(const io_priority_class& pc) {
@@ -1082,6 +1090,9 @@ void sstable::write_compression(const io_priority_class& pc) {
     }
 
     write_simple<component_type::CompressionInfo>(_components->compression, pc);
+    if (has_component(component_type::CompressionDictionary)) {
+        write_simple<component_type::CompressionDictionary>(_components->compression.dictionary, pc);
+    }
 }
 
 void sstable::validate_partitioner() {
@@ -1343,6 +1354,20 @@ future<> sstable::drop_caches() {
     });
 }
 
+std::vector<std::pair<uint64_t, uint64_t>> sstable::cached_index_page_runs() const {
+    if (!_cached_index_file) {
+        return {};
+    }
+    return _cached_index_file->cached_page_runs();
+}
+
+future<> sstable::preload_index_pages(uint64_t first_page, uint64_t count, const io_priority_class& pc) {
+    if (!_cached_index_file) {
+        return make_ready_future<>();
+    }
+    return _cached_index_file->populate(first_page, count, pc);
+}
+
 future<> sstable::read_filter(const io_priority_class& pc) {
     if (!has_component(component_type::Filter)) {
         _components->filter = std::make_unique<utils::filter::always_present_filter>();
@@ -1357,7 +1382,12 @@ future<> sstable::read_filter(const io_priority_class& pc) {
         utils::filter_format format = (_version >= sstable_version_types::mc)
                                       ? utils::filter_format::m_format
                                       : utils::filter_format::k_l_format;
-        _components->filter = utils::filter::create_filter(filter.hashes, std::move(bs), format);
+        auto hashes = filter.hashes;
+        if (hashes & utils::filter::blocked_filter_marker) {
+            format = utils::filter_format::blocked_format;
+            hashes &= ~utils::filter::blocked_filter_marker;
+        }
+        _components->filter = utils::filter::create_filter(hashes, std::move(bs), format);
     });
 }
 
@@ -1366,10 +1396,14 @@ void sstable::write_filter(const io_priority_class& pc) {
         return;
     }
 
-    auto f = static_cast<utils::filter::murmur3_bloom_filter *>(_components->filter.get());
+    auto f = static_cast<utils::filter::bloom_filter *>(_components->filter.get());
 
     auto&& bs = f->bits();
-    auto filter_ref = sstables::filter_ref(f->num_hashes(), bs.get_storage());
+    uint32_t hashes = f->num_hashes();
+    if (f->format() == utils::filter_format::blocked_format) {
+        hashes |= utils::filter::blocked_filter_marker;
+    }
+    auto filter_ref = sstables::filter_ref(hashes, bs.get_storage());
     write_simple<component_type::Filter>(filter_ref, pc);
 }
 
@@ -2194,8 +2228,8 @@ static entry_descriptor make_entry_descriptor(sstring sstdir, sstring fname, sst
     static std::regex la_mx("(la|m[cd])-(\\d+)-(\\w+)-(.*)");
     static std::regex ka("(\\w+)-(\\w+)-ka-(\\d+)-(.*)");
 
-    static std::regex dir(format(".*/([^/]*)/([^/]+)-[\\da-fA-F]+(?:/({}|{}|{}|{})(?:/[^/]+)?)?/?",
-            sstables::staging_dir, sstables::quarantine_dir, sstables::upload_dir, sstables::snapshots_dir).c_str());
+    static std::regex dir(format(".*/([^/]*)/([^/]+)-[\\da-fA-F]+(?:/({}|{}|{}|{}|{})(?:/[^/]+)?)?/?",
+            sstables::staging_dir, sstables::quarantine_dir, sstables::upload_dir, sstables::snapshots_dir, sstables::streaming_dir).c_str());
 
     std::smatch match;
 
@@ -2292,12 +2326,15 @@ input_stream<char> sstable::data_stream(uint64_t pos, size_t len, const io_prior
 
     input_stream<char> stream;
     if (_components->compression) {
+        if (!_data_compressor) {
+            _data_compressor = get_sstable_compressor(_components->compression);
+        }
         if (_version >= sstable_version_types::mc) {
              return make_compressed_file_m_format_input_stream(f, &_components->compression,
-                pos, len, std::move(options));
+                pos, len, std::move(options), _data_compressor);
         } else {
             return make_compressed_file_k_l_format_input_stream(f, &_components->compression,
-                pos, len, std::move(options));
+                pos, len, std::move(options), _data_compressor);
         }
     }
 
@@ -2413,6 +2450,32 @@ future<> sstable::mutate_sstable_level(uint32_t new_level) {
     });
 }
 
+future<> sstable::mutate_repaired_at(uint64_t repaired_at) {
+    if (!has_component(component_type::Statistics)) {
+        return make_ready_future<>();
+    }
+
+    auto entry = _components->statistics.contents.find(metadata_type::Stats);
+    if (entry == _components->statistics.contents.end()) {
+        return make_ready_future<>();
+    }
+
+    auto& p = entry->second;
+    if (!p) {
+        throw std::runtime_error("Statistics is malformed");
+    }
+    stats_metadata& s = *static_cast<stats_metadata *>(p.get());
+    if (s.repaired_at == repaired_at) {
+        return make_ready_future<>();
+    }
+
+    sstlog.debug("set repaired_at of {} from {} to {}", get_filename(), s.repaired_at, repaired_at);
+    s.repaired_at = repaired_at;
+    return seastar::async([this] {
+        rewrite_statistics(default_priority_class());
+    });
+}
+
 int sstable::compare_by_max_timestamp(const sstable& other) const {
     auto ts1 = get_stats_metadata().max_timestamp;
     auto ts2 = other.get_stats_metadata().max_timestamp;
@@ -3124,6 +3187,7 @@ std::ostream& operator<<(std::ostream& out, const sstables::component_type& comp
     case ct::TemporaryTOC: out << "TemporaryTOC"; break;
     case ct::TemporaryStatistics: out << "TemporaryStatistics"; break;
     case ct::Scylla: out << "Scylla"; break;
+    case ct::CompressionDictionary: out << "CompressionDictionary"; break;
     case ct::Unknown: out << "Unknown"; break;
     }
     return out;
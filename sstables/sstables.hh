@@ -117,10 +117,12 @@ struct sstable_writer_config {
     mutation_fragment_stream_validation_level validation_level;
     std::optional<db::replay_position> replay_position;
     std::optional<int> sstable_level;
+    std::optional<uint64_t> repaired_at;
     write_monitor* monitor = &default_write_monitor();
     utils::UUID run_identifier = utils::make_random_uuid();
     size_t summary_byte_cost;
     sstring origin;
+    bool blocked_bloom_filter = false;
 
 private:
     explicit sstable_writer_config() {}
@@ -131,6 +133,7 @@ constexpr const char* staging_dir = "staging";
 constexpr const char* upload_dir = "upload";
 constexpr const char* snapshots_dir = "snapshots";
 constexpr const char* quarantine_dir = "quarantine";
+constexpr const char* streaming_dir = "streaming";
 
 class sstable : public enable_lw_shared_from_this<sstable> {
     friend ::sstable_assertions;
@@ -508,6 +511,10 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     std::vector<sstring> _unrecognized_components;
 
     foreign_ptr<lw_shared_ptr<shareable_components>> _components = make_foreign(make_lw_shared<shareable_components>());
+    // Uncompresses the data file for all readers of this shard, built on
+    // first use. Compressors can't be shared across shards, so unlike the
+    // compression metadata this is not part of _components.
+    compressor_ptr _data_compressor;
     column_translation _column_translation;
     std::optional<open_flags> _open_mode;
     // _compaction_ancestors track which sstable generations were used to generate this sstable.
@@ -832,6 +839,19 @@ class sstable : public enable_lw_shared_from_this<sstable> {
 
     future<> mutate_sstable_level(uint32_t);
 
+    // Start time of the incremental repair which covered all the data of the
+    // sstable, in milliseconds since the epoch, or 0 if it's not repaired.
+    uint64_t get_repaired_at() const {
+        return get_stats_metadata().repaired_at;
+    }
+
+    bool is_repaired() const {
+        return get_repaired_at() != 0;
+    }
+
+    // Changes the repaired_at marker and rewrites the Statistics component.
+    future<> mutate_repaired_at(uint64_t);
+
     const summary& get_summary() const {
         return _components->summary;
     }
@@ -873,6 +893,12 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // Drops all evictable in-memory caches of on-disk content.
     future<> drop_caches();
 
+    // Returns the cached pages of the index component as (first page, page count) runs.
+    std::vector<std::pair<uint64_t, uint64_t>> cached_index_page_runs() const;
+
+    // Reads index pages [first_page, first_page + count) into the index page cache.
+    future<> preload_index_pages(uint64_t first_page, uint64_t count, const io_priority_class& pc);
+
     // Allow the test cases from sstable_test.cc to test private methods. We use
     // a placeholder to avoid cluttering this class too much. The sstable_test class
     // will then re-export as public every method it needs.
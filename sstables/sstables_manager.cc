@@ -26,14 +26,23 @@
 #include "db/config.hh"
 #include "gms/feature.hh"
 #include "gms/feature_service.hh"
+#include "service/priority_manager.hh"
+#include "utils/cached_file.hh"
+
+#include <seastar/core/coroutine.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/coroutine/maybe_yield.hh>
+
+#include <sstream>
 
 namespace sstables {
 
 logging::logger smlogger("sstables_manager");
 
 sstables_manager::sstables_manager(
-    db::large_data_handler& large_data_handler, const db::config& dbcfg, gms::feature_service& feat, cache_tracker& ct)
-    : _large_data_handler(large_data_handler), _db_config(dbcfg), _features(feat), _cache_tracker(ct) {
+    db::large_data_handler& large_data_handler, const db::config& dbcfg, gms::feature_service& feat, cache_tracker& ct,
+    seastar::scheduling_group maintenance_sg)
+    : _large_data_handler(large_data_handler), _db_config(dbcfg), _features(feat), _cache_tracker(ct), _maintenance_sg(maintenance_sg) {
 }
 
 sstables_manager::~sstables_manager() {
@@ -53,6 +62,10 @@ shared_sstable sstables_manager::make_sstable(schema_ptr schema,
     return make_lw_shared<sstable>(std::move(schema), std::move(dir), generation, v, f, get_large_data_handler(), *this, now, std::move(error_handler_gen), buffer_size);
 }
 
+bool sstables_manager::dictionary_compression_enabled() const {
+    return _features.cluster_supports_zstd_dictionary_compression();
+}
+
 sstable_writer_config sstables_manager::configure_writer(sstring origin) const {
     sstable_writer_config cfg;
 
@@ -61,6 +74,7 @@ sstable_writer_config sstables_manager::configure_writer(sstring origin) const {
             ? mutation_fragment_stream_validation_level::clustering_key
             : mutation_fragment_stream_validation_level::token;
     cfg.summary_byte_cost = summary_byte_cost(_db_config.sstable_summary_ratio());
+    cfg.blocked_bloom_filter = _db_config.enable_blocked_bloom_filters();
 
     cfg.origin = std::move(origin);
 
@@ -96,6 +110,98 @@ void sstables_manager::maybe_done() {
     }
 }
 
+std::vector<shared_sstable> sstables_manager::active_sstables() {
+    std::vector<shared_sstable> ret;
+    for (auto& sst : _active) {
+        ret.push_back(sst.shared_from_this());
+    }
+    return ret;
+}
+
+// The saved index cache has one line per sstable:
+//
+//   <index size> <run count> <first page> <page count>... <index file name>
+//
+// The file name comes last because it runs to the end of the line.
+future<sstring> sstables_manager::describe_index_cache() {
+    std::ostringstream out;
+    size_t pages = 0;
+    for (auto& sst : active_sstables()) {
+        if (sst->marked_for_deletion()) {
+            continue;
+        }
+        auto runs = sst->cached_index_page_runs();
+        if (runs.empty()) {
+            continue;
+        }
+        out << sst->index_size() << ' ' << runs.size();
+        for (auto& [first, count] : runs) {
+            out << ' ' << first << ' ' << count;
+            pages += count;
+        }
+        out << ' ' << sst->filename(component_type::Index) << '\n';
+        co_await coroutine::maybe_yield();
+    }
+    smlogger.debug("Described {} cached index pages", pages);
+    co_return sstring(out.str());
+}
+
+future<> sstables_manager::preload_index_cache(sstring saved, uint64_t bytes_per_second, abort_source& as) {
+    struct saved_entry {
+        uint64_t index_size;
+        std::vector<std::pair<uint64_t, uint64_t>> runs;
+    };
+    std::unordered_map<sstring, saved_entry> entries;
+    std::istringstream in(std::string(saved.begin(), saved.end()));
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        saved_entry e;
+        size_t run_count = 0;
+        fields >> e.index_size >> run_count;
+        e.runs.resize(fields ? run_count : 0);
+        for (auto& [first, count] : e.runs) {
+            fields >> first >> count;
+        }
+        std::string name;
+        fields >> std::ws;
+        std::getline(fields, name);
+        if (fields.fail() || name.empty()) {
+            smlogger.warn("Ignoring malformed saved index cache entry: {}", line);
+            continue;
+        }
+        entries.emplace(sstring(name), std::move(e));
+        co_await coroutine::maybe_yield();
+    }
+
+    // Pages are read in runs, and the budget is enforced by sleeping after each run
+    // until the average rate drops back to bytes_per_second.
+    auto start = lowres_clock::now();
+    uint64_t bytes = 0;
+    for (auto& sst : active_sstables()) {
+        auto i = entries.find(sst->filename(component_type::Index));
+        // The size guards against a different sstable reusing the name.
+        if (i == entries.end() || i->second.index_size != sst->index_size()) {
+            continue;
+        }
+        for (auto& [first, count] : i->second.runs) {
+            if (as.abort_requested() || _closing) {
+                co_return;
+            }
+            co_await sst->preload_index_pages(first, count, service::get_local_compaction_priority());
+            bytes += count * cached_file::page_size;
+            if (bytes_per_second) {
+                auto due = start + std::chrono::duration_cast<lowres_clock::duration>(
+                        std::chrono::duration<double>(double(bytes) / bytes_per_second));
+                if (due > lowres_clock::now()) {
+                    co_await sleep_abortable<lowres_clock>(due - lowres_clock::now(), as);
+                }
+            }
+        }
+    }
+    smlogger.info("Preloaded {} bytes of saved index pages", bytes);
+}
+
 future<> sstables_manager::close() {
     _closing = true;
     maybe_done();
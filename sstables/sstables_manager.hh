@@ -24,6 +24,8 @@
 
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/sharded.hh>
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/scheduling.hh>
 
 #include "utils/disk-error-handler.hh"
 #include "gc_clock.hh"
@@ -78,8 +80,11 @@ class sstables_manager {
     bool _closing = false;
     promise<> _done;
     cache_tracker& _cache_tracker;
+    // Background work of sstable writers, like training compression dictionaries, runs in this group.
+    seastar::scheduling_group _maintenance_sg;
 public:
-    explicit sstables_manager(db::large_data_handler& large_data_handler, const db::config& dbcfg, gms::feature_service& feat, cache_tracker&);
+    explicit sstables_manager(db::large_data_handler& large_data_handler, const db::config& dbcfg, gms::feature_service& feat, cache_tracker&,
+            seastar::scheduling_group maintenance_sg = seastar::default_scheduling_group());
     ~sstables_manager();
 
     // Constructs a shared sstable
@@ -95,10 +100,25 @@ class sstables_manager {
     sstable_writer_config configure_writer(sstring origin) const;
     const db::config& config() const { return _db_config; }
     cache_tracker& get_cache_tracker() { return _cache_tracker; }
+    seastar::scheduling_group maintenance_scheduling_group() const noexcept { return _maintenance_sg; }
+
+    // Whether new sstables may have their data compressed with a trained dictionary,
+    // which nodes not supporting ZSTD_DICTIONARY_COMPRESSION can't read.
+    bool dictionary_compression_enabled() const;
 
     void set_format(sstable_version_types format) noexcept { _format = format; }
     sstables::sstable::version_types get_highest_supported_format() const noexcept { return _format; }
 
+    // Describes the identities of the index pages currently cached for the sstables
+    // of this manager, so that preload_index_cache() can bring them back after a restart.
+    future<sstring> describe_index_cache();
+
+    // Populates the index page cache of the sstables which are still the same on disk
+    // from a description produced by describe_index_cache().
+    // Reads at most bytes_per_second on average (0 means unlimited).
+    // Stops early when the abort source fires or the manager is closing.
+    future<> preload_index_cache(sstring saved, uint64_t bytes_per_second, abort_source& as);
+
     // Wait until all sstables managed by this sstables_manager instance
     // (previously created by make_sstable()) have been disposed of:
     //   - if they were marked for deletion, the files are deleted
@@ -116,6 +136,8 @@ class sstables_manager {
     void deactivate(sstable* sst);
     void remove(sstable* sst);
     void maybe_done();
+    // Returns references to the active sstables, so that they can be iterated across preemption points.
+    std::vector<shared_sstable> active_sstables();
 private:
     db::large_data_handler& get_large_data_handler() const {
         return _large_data_handler;
@@ -115,6 +115,16 @@ struct filter {
     explicit filter(int hashes, utils::chunked_vector<uint64_t> buckets) : hashes(hashes), buckets({std::move(buckets)}) {}
 };
 
+// Contents of the CompressionDictionary component: a dictionary trained on
+// a sample of the sstable's own data and used to compress all of its chunks.
+// Empty if there was too little data to train one.
+struct compression_dictionary {
+    disk_string<uint32_t> data;
+
+    template <typename Describer>
+    auto describe_type(sstable_version_types v, Describer f) { return f(data); }
+};
+
 // Do this so we don't have to copy on write time. We can just keep a reference.
 struct filter_ref {
     uint32_t hashes;
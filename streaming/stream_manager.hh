@@ -38,6 +38,9 @@
 
 #pragma once
 #include "streaming/progress_info.hh"
+#include "streaming/stream_reason.hh"
+#include "streaming/stream_sstable_files.hh"
+#include "schema_fwd.hh"
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/distributed.hh>
 #include "utils/UUID.hh"
@@ -46,9 +49,13 @@
 #include "gms/endpoint_state.hh"
 #include "gms/application_state.hh"
 #include <seastar/core/semaphore.hh>
+#include <seastar/core/gate.hh>
 #include <seastar/core/metrics_registration.hh>
+#include <seastar/rpc/rpc_types.hh>
 #include <map>
 
+class table;
+
 namespace db {
 class system_distributed_keyspace;
 namespace view {
@@ -124,6 +131,8 @@ class stream_manager : public gms::i_endpoint_state_change_subscriber, public en
     uint64_t _total_incoming_bytes{0};
     uint64_t _total_outgoing_bytes{0};
     semaphore _mutation_send_limiter{256};
+    // Held by the sstable files being received in the background, see receive_sstable_files().
+    seastar::gate _sstable_files_gate;
     seastar::metrics::metric_groups _metrics;
 
 public:
@@ -208,6 +217,16 @@ class stream_manager : public gms::i_endpoint_state_change_subscriber, public en
 
     void init_messaging_service_handler();
     future<> uninit_messaging_service_handler();
+
+public:
+    // Writes the sstable files received from a STREAM_SSTABLE_FILES stream into
+    // the directory of the plan, see load_sstable_files(). If the stream fails,
+    // the files written so far are removed.
+    future<> receive_sstable_files(UUID plan_id, gms::inet_address from, table& cf, schema_ptr s,
+            stream_sstable_file_source source);
+    // Loads the sstable files received from the peer for the table, if any,
+    // once all of them were written.
+    future<> load_sstable_files(UUID plan_id, gms::inet_address from, UUID cf_id, stream_reason reason);
 };
 
 } // namespace streaming
@@ -64,7 +64,13 @@
 #include "../db/view/view_update_generator.hh"
 #include "mutation_source_metadata.hh"
 #include "streaming/stream_mutation_fragments_cmd.hh"
+#include "streaming/stream_sstable_files.hh"
 #include "consumer.hh"
+#include "distributed_loader.hh"
+#include "lister.hh"
+#include "sstables/sstables.hh"
+#include <seastar/core/coroutine.hh>
+#include <seastar/core/fstream.hh>
 
 namespace streaming {
 
@@ -78,6 +84,118 @@ static sstables::offstrategy is_offstrategy_supported(streaming::stream_reason r
     return sstables::offstrategy(operations_supported.contains(reason));
 }
 
+// Directory where the sstable files sent by a peer for a plan are written, until
+// they are loaded into the table.
+static fs::path sstable_files_dir(const table& cf, utils::UUID plan_id, gms::inet_address from) {
+    return fs::path(cf.dir()) / sstables::streaming_dir / format("{}-{}", plan_id, from);
+}
+
+future<> stream_manager::receive_sstable_files(UUID plan_id, gms::inet_address from, table& cf, schema_ptr s,
+        stream_sstable_file_source source) {
+    auto dir = sstable_files_dir(cf, plan_id, from).native();
+    co_await recursive_touch_directory(dir);
+    // The sstables are written under new generations of the table, which are also
+    // unique among the ones written by the other shards into the same directory.
+    std::unordered_map<int64_t, int64_t> generations;
+    std::vector<sstring> written;
+    std::optional<output_stream<char>> out;
+    std::pair<int64_t, sstring> current;
+    bool got_end_of_stream = false;
+    std::exception_ptr ex;
+    try {
+        while (auto opt = co_await source()) {
+            auto& [chunk, cmd] = *opt;
+            switch (cmd) {
+            case stream_sstable_files_cmd::file_data:
+                break;
+            case stream_sstable_files_cmd::error:
+                throw std::runtime_error("Sender failed");
+            case stream_sstable_files_cmd::end_of_stream:
+                got_end_of_stream = true;
+                continue;
+            default:
+                throw std::runtime_error("Sender sent wrong cmd");
+            }
+            if (!out || current.first != chunk.generation || current.second != chunk.component) {
+                if (chunk.component.find('/') != sstring::npos) {
+                    throw std::runtime_error(format("Sender sent invalid component name {}", chunk.component));
+                }
+                if (out) {
+                    auto o = std::move(*out);
+                    out.reset();
+                    co_await o.close();
+                }
+                auto [it, inserted] = generations.try_emplace(chunk.generation, 0);
+                if (inserted) {
+                    it->second = cf.calculate_generation_for_new_table();
+                }
+                auto filename = sstables::sstable::filename(dir, s->ks_name(), s->cf_name(), sstables::sstable::version_from_sstring(chunk.version),
+                        it->second, sstables::sstable::format_types::big, chunk.component);
+                auto f = co_await open_file_dma(filename, open_flags::wo | open_flags::create | open_flags::exclusive);
+                written.push_back(std::move(filename));
+                file_output_stream_options options;
+                options.io_priority_class = service::get_local_streaming_priority();
+                out = co_await make_file_output_stream(std::move(f), std::move(options));
+                current = {chunk.generation, chunk.component};
+            }
+            co_await out->write(reinterpret_cast<const char*>(chunk.data.data()), chunk.data.size());
+            update_progress(plan_id, from, progress_info::direction::IN, chunk.data.size());
+        }
+        if (!got_end_of_stream) {
+            throw std::runtime_error("Sender did not send end_of_stream");
+        }
+        if (out) {
+            auto o = std::move(*out);
+            out.reset();
+            co_await o.close();
+        }
+        co_await sync_directory(dir);
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    if (ex) {
+        if (out) {
+            try {
+                co_await out->close();
+            } catch (...) {
+            }
+        }
+        for (auto& filename : written) {
+            try {
+                co_await remove_file(filename);
+            } catch (...) {
+                sslog.warn("[Stream #{}] Failed to remove {}: {}", plan_id, filename, std::current_exception());
+            }
+        }
+        std::rethrow_exception(std::move(ex));
+    }
+}
+
+future<> stream_manager::load_sstable_files(UUID plan_id, gms::inet_address from, UUID cf_id, stream_reason reason) {
+    auto& cf = _db.local().find_column_family(cf_id);
+    auto dir = sstable_files_dir(cf, plan_id, from);
+    if (!co_await file_exists(dir.native())) {
+        co_return;
+    }
+    auto s = cf.schema();
+    sslog.info("[Stream #{}] Loading sstables received as files from {} for ks={}, cf={}", plan_id, from, s->ks_name(), s->cf_name());
+    std::exception_ptr ex;
+    try {
+        co_await distributed_loader::process_sstables_dir(_db, _sys_dist_ks, _view_update_generator, s->ks_name(), s->cf_name(), dir, reason);
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    // The loaded sstables were moved out of the directory, and those which failed to load are of no use.
+    try {
+        co_await lister::rmdir(dir);
+    } catch (...) {
+        sslog.warn("[Stream #{}] Failed to remove {}: {}", plan_id, dir.native(), std::current_exception());
+    }
+    if (ex) {
+        std::rethrow_exception(std::move(ex));
+    }
+}
+
 void stream_manager::init_messaging_service_handler() {
     auto& ms = _ms.local();
 
@@ -185,11 +303,50 @@ void stream_manager::init_messaging_service_handler() {
         });
       });
     });
+    ms.register_stream_sstable_files([this] (const rpc::client_info& cinfo, UUID plan_id, UUID schema_id, UUID cf_id, stream_reason reason, rpc::source<stream_sstable_file_chunk, stream_sstable_files_cmd> source) {
+        auto from = netw::messaging_service::get_source(cinfo);
+        sslog.trace("Got stream_sstable_files from {} reason {}", from, int(reason));
+        table& cf = _db.local().find_column_family(cf_id);
+        if (!_sys_dist_ks.local_is_initialized() || !_view_update_generator.local_is_initialized()) {
+            return make_exception_future<rpc::sink<int>>(std::runtime_error(format("Node {} is not fully initialized for streaming, try again later",
+                    utils::fb_utilities::get_broadcast_address())));
+        }
+
+        // The schema is only needed to be in sync with the sender before loading the sstables.
+        return _mm.local().get_schema_for_write(schema_id, from, _ms.local()).then([this, from, plan_id, &cf, source] (schema_ptr s) mutable {
+            auto holder = _sstable_files_gate.hold();
+            auto sink = _ms.local().make_sink_for_stream_sstable_files(source);
+            // The files are received in the background, and stop() waits for them.
+            (void)receive_sstable_files(plan_id, from.addr, cf, s, [source] () mutable { return source(); }).then_wrapped([s, plan_id, from, sink] (future<> f) mutable {
+                int32_t status = 0;
+                if (f.failed()) {
+                    sslog.error("[Stream #{}] Failed to handle STREAM_SSTABLE_FILES (receive phase) for ks={}, cf={}, peer={}: {}",
+                            plan_id, s->ks_name(), s->cf_name(), from.addr, f.get_exception());
+                    status = -1;
+                }
+                return sink(status).finally([sink] () mutable {
+                    return sink.close();
+                });
+            }).handle_exception([s, plan_id, from, sink] (std::exception_ptr ep) {
+                sslog.error("[Stream #{}] Failed to handle STREAM_SSTABLE_FILES (respond phase) for ks={}, cf={}, peer={}: {}",
+                        plan_id, s->ks_name(), s->cf_name(), from.addr, ep);
+            }).finally([op = cf.stream_in_progress(), holder = std::move(holder)] {});
+            return make_ready_future<rpc::sink<int>>(sink);
+        });
+    });
     ms.register_stream_mutation_done([this] (const rpc::client_info& cinfo, UUID plan_id, dht::token_range_vector ranges, UUID cf_id, unsigned dst_cpu_id) {
         const auto& from = cinfo.retrieve_auxiliary<gms::inet_address>("baddr");
         return container().invoke_on(dst_cpu_id, [ranges = std::move(ranges), plan_id, cf_id, from] (auto& sm) mutable {
             auto session = sm.get_session(plan_id, from, "STREAM_MUTATION_DONE", cf_id);
-            session->receive_task_completed(cf_id);
+            // The sender is done with the table, so all the sstable files it sent were written.
+            // They are loaded before replying, because a sender pushing its data away, as
+            // decommission does, must not finish before its data is available here. The reply
+            // is therefore delayed by resharding and reshaping the files one peer sent for one
+            // table, which run in the streaming scheduling group. The verb has no timeout, so
+            // the sender waits for them rather than failing the transfer.
+            return sm.load_sstable_files(plan_id, from, cf_id, session->get_reason()).then([session, cf_id] {
+                session->receive_task_completed(cf_id);
+            });
         });
     });
     ms.register_complete_message([this] (const rpc::client_info& cinfo, UUID plan_id, unsigned dst_cpu_id, rpc::optional<bool> failed) {
@@ -215,6 +372,7 @@ future<> stream_manager::uninit_messaging_service_handler() {
         ms.unregister_prepare_message(),
         ms.unregister_prepare_done_message(),
         ms.unregister_stream_mutation_fragments(),
+        ms.unregister_stream_sstable_files(),
         ms.unregister_stream_mutation_done(),
         ms.unregister_complete_message()).discard_result();
 }
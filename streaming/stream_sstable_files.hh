@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <seastar/core/future.hh>
+#include <seastar/core/sstring.hh>
+#include <seastar/util/noncopyable_function.hh>
+#include "bytes.hh"
+
+namespace streaming {
+
+enum class stream_sstable_files_cmd : uint8_t {
+    error,
+    file_data,
+    end_of_stream,
+};
+
+// A piece of a component file of an sstable sent by STREAM_SSTABLE_FILES.
+//
+// The files of a stream are sent one after the other, each in one or more
+// chunks, with the TOC of an sstable sent after its other components.
+struct stream_sstable_file_chunk {
+    // Generation of the sstable on the sender, which identifies it within the stream.
+    int64_t generation;
+    seastar::sstring version;
+    // The file name suffix of the component, e.g. Data.db.
+    seastar::sstring component;
+    bytes data;
+};
+
+// Produces the chunks of a STREAM_SSTABLE_FILES stream, like its rpc::source.
+using stream_sstable_file_source = seastar::noncopyable_function<
+        seastar::future<std::optional<std::tuple<stream_sstable_file_chunk, stream_sstable_files_cmd>>>()>;
+
+}
@@ -43,6 +43,7 @@
 #include "streaming/stream_manager.hh"
 #include "streaming/stream_reason.hh"
 #include "streaming/stream_mutation_fragments_cmd.hh"
+#include "streaming/stream_sstable_files.hh"
 #include "mutation_reader.hh"
 #include "flat_mutation_reader.hh"
 #include "mutation_fragment_stream_validator.hh"
@@ -53,11 +54,16 @@
 #include "dht/i_partitioner.hh"
 #include "dht/sharder.hh"
 #include "service/priority_manager.hh"
+#include <seastar/core/coroutine.hh>
+#include <seastar/core/fstream.hh>
+#include <boost/algorithm/cxx11/any_of.hpp>
 #include <boost/range/irange.hpp>
 #include <boost/icl/interval.hpp>
 #include <boost/icl/interval_set.hpp>
 #include "sstables/sstables.hh"
+#include "sstables/sstable_set.hh"
 #include "database.hh"
+#include "db/config.hh"
 #include "gms/feature_service.hh"
 
 namespace streaming {
@@ -85,11 +91,14 @@ struct send_info {
     column_family& cf;
     dht::token_range_vector ranges;
     dht::partition_range_vector prs;
+    // Sstables sent as files, which the reader doesn't read.
+    std::vector<sstables::shared_sstable> files;
     flat_mutation_reader reader;
     noncopyable_function<void(size_t)> update;
     send_info(netw::messaging_service& ms_, utils::UUID plan_id_, table& tbl_, reader_permit permit_,
               dht::token_range_vector ranges_, netw::messaging_service::msg_addr id_,
-              uint32_t dst_cpu_id_, stream_reason reason_, noncopyable_function<void(size_t)> update_fn)
+              uint32_t dst_cpu_id_, stream_reason reason_, noncopyable_function<void(size_t)> update_fn,
+              std::vector<sstables::shared_sstable> files_ = {}, lw_shared_ptr<sstables::sstable_set> remaining_sstables = {})
         : ms(ms_)
         , plan_id(plan_id_)
         , cf_id(tbl_.schema()->id())
@@ -99,7 +108,9 @@ struct send_info {
         , cf(tbl_)
         , ranges(std::move(ranges_))
         , prs(dht::to_partition_ranges(ranges))
-        , reader(cf.make_streaming_reader(cf.schema(), std::move(permit_), prs))
+        , files(std::move(files_))
+        , reader(remaining_sstables ? cf.make_streaming_reader(cf.schema(), std::move(permit_), prs, std::move(remaining_sstables))
+                          : cf.make_streaming_reader(cf.schema(), std::move(permit_), prs))
         , update(std::move(update_fn))
     {
     }
@@ -124,6 +135,9 @@ struct send_info {
     future<size_t> estimate_partitions() {
         return do_with(cf.get_sstables(), size_t(0), [this] (auto& sstables, size_t& partition_count) {
             return do_for_each(*sstables, [this, &partition_count] (auto& sst) {
+                if (boost::algorithm::any_of_equal(files, sst)) {
+                    return make_ready_future<>();
+                }
                 return do_for_each(ranges, [this, &sst, &partition_count] (auto& range) {
                     partition_count += sst->estimated_keys_for_range(range);
                 });
@@ -214,6 +228,125 @@ future<> send_mutation_fragments(lw_shared_ptr<send_info> si) {
  });
 }
 
+static bool is_file_streaming_supported(stream_reason reason) {
+    static const std::unordered_set<stream_reason> operations_supported = {
+        stream_reason::bootstrap,
+        stream_reason::replace,
+        stream_reason::decommission,
+        stream_reason::removenode,
+    };
+    return operations_supported.contains(reason);
+}
+
+std::vector<sstables::shared_sstable> select_sstables_for_file_streaming(const sstable_list& sstables, const dht::token_range_vector& ranges) {
+    std::vector<sstables::shared_sstable> ret;
+    for (auto& sst : sstables) {
+        if (sst->is_shared()) {
+            continue;
+        }
+        auto sst_range = dht::token_range::make(sst->get_first_decorated_key().token(), sst->get_last_decorated_key().token());
+        if (boost::algorithm::any_of(ranges, [&] (const dht::token_range& r) { return r.contains(sst_range, dht::token_comparator()); })) {
+            ret.push_back(sst);
+        }
+    }
+    return ret;
+}
+
+static constexpr size_t file_chunk_size = 128 * 1024;
+
+static future<> send_sstable_file(lw_shared_ptr<send_info> si, rpc::sink<stream_sstable_file_chunk, stream_sstable_files_cmd>& sink,
+        const sstables::shared_sstable& sst, sstring component, const bool& got_error_from_peer) {
+    auto& s = *sst->get_schema();
+    auto filename = sstables::sstable::filename(sst->get_dir(), s.ks_name(), s.cf_name(), sst->get_version(), sst->generation(),
+            sstables::sstable::format_types::big, component);
+    auto f = co_await open_file_dma(filename, open_flags::ro);
+    file_input_stream_options options;
+    options.buffer_size = file_chunk_size;
+    options.read_ahead = 1;
+    options.io_priority_class = service::get_local_streaming_priority();
+    auto in = make_file_input_stream(std::move(f), 0, std::move(options));
+    std::exception_ptr ex;
+    try {
+        bool sent = false;
+        for (;;) {
+            auto buf = co_await in.read();
+            if (got_error_from_peer) {
+                throw std::runtime_error("Got status error code from peer");
+            }
+            // Empty files are sent as a single empty chunk, so that they are created on the receiver.
+            if (buf.empty() && sent) {
+                break;
+            }
+            si->update(buf.size());
+            co_await sink(stream_sstable_file_chunk{sst->generation(), sstables::to_string(sst->get_version()), component,
+                    bytes(reinterpret_cast<const bytes::value_type*>(buf.get()), buf.size())}, stream_sstable_files_cmd::file_data);
+            if (buf.empty()) {
+                break;
+            }
+            sent = true;
+        }
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    co_await in.close();
+    if (ex) {
+        std::rethrow_exception(std::move(ex));
+    }
+}
+
+static future<> send_sstable_files(lw_shared_ptr<send_info> si, rpc::sink<stream_sstable_file_chunk, stream_sstable_files_cmd> sink, const bool& got_error_from_peer) {
+    std::exception_ptr ex;
+    try {
+        for (auto& sst : si->files) {
+            // The TOC is written last, as when an sstable is sealed.
+            auto components = sst->all_components();
+            std::stable_partition(components.begin(), components.end(), [] (auto& c) { return c.first != sstables::component_type::TOC; });
+            for (auto& [type, component] : components) {
+                co_await send_sstable_file(si, sink, sst, component, got_error_from_peer);
+            }
+        }
+        co_await sink(stream_sstable_file_chunk{}, stream_sstable_files_cmd::end_of_stream);
+    } catch (...) {
+        ex = std::current_exception();
+    }
+    if (ex) {
+        // Notify the receiver the sender has failed
+        try {
+            co_await sink(stream_sstable_file_chunk{}, stream_sstable_files_cmd::error);
+        } catch (...) {
+            sslog.debug("[Stream #{}] Failed to notify peer={} of the failure to send sstable files: {}", si->plan_id, si->id.addr, std::current_exception());
+        }
+    }
+    co_await sink.close();
+    if (ex) {
+        std::rethrow_exception(std::move(ex));
+    }
+}
+
+// Sends the sstables selected by select_sstables_for_file_streaming() as raw
+// component files. The receiver loads them once the transfer of the table is done.
+future<> send_sstables_as_files(lw_shared_ptr<send_info> si) {
+    if (si->files.empty()) {
+        co_return;
+    }
+    sslog.info("[Stream #{}] Start sending ks={}, cf={}, sstables={}, as files", si->plan_id, si->cf.schema()->ks_name(), si->cf.schema()->cf_name(), si->files.size());
+    auto [sink, source] = co_await si->ms.make_sink_and_source_for_stream_sstable_files(si->cf.schema()->version(), si->plan_id, si->cf_id, si->reason, si->id);
+    auto got_error_from_peer = make_lw_shared<bool>(false);
+    auto source_op = [] (rpc::source<int32_t> source, lw_shared_ptr<bool> got_error_from_peer, lw_shared_ptr<send_info> si) -> future<> {
+        // Read until EOS, as with send_mutation_fragments()
+        while (auto status_opt = co_await source()) {
+            auto status = std::get<0>(*status_opt);
+            *got_error_from_peer = status == -1;
+            sslog.debug("Got status code from peer={}, plan_id={}, cf_id={}, status={}", si->id.addr, si->plan_id, si->cf_id, status);
+        }
+    }(std::move(source), got_error_from_peer, si);
+    auto sink_op = send_sstable_files(si, std::move(sink), *got_error_from_peer);
+    co_await when_all_succeed(std::move(source_op), std::move(sink_op)).discard_result();
+    if (*got_error_from_peer) {
+        throw std::runtime_error(format("Peer failed to process sstable files peer={}, plan_id={}, cf_id={}", si->id.addr, si->plan_id, si->cf_id));
+    }
+}
+
 future<> stream_transfer_task::execute() {
     auto plan_id = session->plan_id();
     auto cf_id = this->cf_id;
@@ -226,16 +359,33 @@ future<> stream_transfer_task::execute() {
     return sm.container().invoke_on_all([plan_id, cf_id, id, dst_cpu_id, ranges=this->_ranges, reason] (stream_manager& sm) mutable {
         auto& tbl = sm.db().find_column_family(cf_id);
       return sm.db().obtain_reader_permit(tbl, "stream-transfer-task", db::no_timeout).then([&sm, &tbl, plan_id, cf_id, id, dst_cpu_id, ranges=std::move(ranges), reason] (reader_permit permit) mutable {
+        std::vector<sstables::shared_sstable> files;
+        lw_shared_ptr<sstables::sstable_set> remaining_sstables;
+        if (is_file_streaming_supported(reason) && sm.db().get_config().enable_sstable_file_streaming()
+                && sm.db().features().cluster_supports_stream_sstable_files()) {
+            // The remaining sstables are read from the same snapshot of the table's
+            // sstables, so that every sstable is sent exactly once.
+            auto all = tbl.get_sstables();
+            files = select_sstables_for_file_streaming(*all, ranges);
+            if (!files.empty()) {
+                remaining_sstables = make_lw_shared<sstables::sstable_set>(sstables::make_partitioned_sstable_set(tbl.schema(), make_lw_shared<sstable_list>(), false));
+                for (auto& sst : *all) {
+                    if (!boost::algorithm::any_of_equal(files, sst)) {
+                        remaining_sstables->insert(sst);
+                    }
+                }
+            }
+        }
         auto si = make_lw_shared<send_info>(sm.ms(), plan_id, tbl, std::move(permit), std::move(ranges), id, dst_cpu_id, reason, [&sm, plan_id, addr = id.addr] (size_t sz) {
             sm.update_progress(plan_id, addr, streaming::progress_info::direction::OUT, sz);
-        });
+        }, std::move(files), std::move(remaining_sstables));
         return si->has_relevant_range_on_this_shard().then([si, plan_id, cf_id] (bool has_relevant_range_on_this_shard) {
             if (!has_relevant_range_on_this_shard) {
                 sslog.debug("[Stream #{}] stream_transfer_task: cf_id={}: ignore ranges on shard={}",
                         plan_id, cf_id, this_shard_id());
                 return make_ready_future<>();
             }
-            return send_mutation_fragments(std::move(si));
+            return when_all_succeed(send_sstables_as_files(si), send_mutation_fragments(si)).discard_result();
         }).finally([si] {
             return si->reader.close();
         });
@@ -41,6 +41,7 @@
 #include "utils/UUID.hh"
 #include "streaming/stream_task.hh"
 #include "streaming/stream_detail.hh"
+#include "sstables/shared_sstable.hh"
 #include <map>
 #include <seastar/core/semaphore.hh>
 
@@ -49,6 +50,12 @@ namespace streaming {
 class stream_session;
 class send_info;
 
+// Selects the sstables of the table which can be sent as files, i.e. those whose
+// token range is within one of the ranges to stream, so that all of their data
+// is sent. Shared sstables also belong to other shards, which would send them too.
+std::vector<sstables::shared_sstable> select_sstables_for_file_streaming(const sstables::sstable_list& sstables,
+        const dht::token_range_vector& ranges);
+
 /**
  * StreamTransferTask sends sections of SSTable files in certain ColumnFamily.
  */
@@ -53,6 +53,7 @@
 #include "db/commitlog/commitlog.hh"
 
 #include <boost/range/algorithm/remove_if.hpp>
+#include <boost/range/irange.hpp>
 #include <boost/range/algorithm.hpp>
 
 static logging::logger tlogger("table");
@@ -90,6 +91,9 @@ table::make_sstable_reader(schema_ptr s,
     }
 }
 
+// Memtables are not split into sub-ranges smaller than this when flushed (see memtable_flush_sub_range_parallelism).
+static constexpr uint64_t min_memtable_sub_range_flush_size = 32 << 20;
+
 lw_shared_ptr<sstables::sstable_set> table::make_compound_sstable_set() {
     return make_lw_shared(sstables::make_compound_sstable_set(_schema, { _main_sstables, _maintenance_sstables }));
 }
@@ -245,8 +249,28 @@ table::make_streaming_reader(schema_ptr s, reader_permit permit,
     return make_flat_multi_range_reader(s, std::move(permit), std::move(source), ranges, slice, pc, nullptr, mutation_reader::forwarding::no);
 }
 
+flat_mutation_reader
+table::make_streaming_reader(schema_ptr s, reader_permit permit,
+                           const dht::partition_range_vector& ranges, lw_shared_ptr<sstables::sstable_set> sstables) const {
+    auto& slice = s->full_slice();
+    auto& pc = service::get_local_streaming_priority();
+
+    auto source = mutation_source([this, sstables = std::move(sstables)] (schema_ptr s, reader_permit permit, const dht::partition_range& range, const query::partition_slice& slice,
+                                      const io_priority_class& pc, tracing::trace_state_ptr trace_state, streamed_mutation::forwarding fwd, mutation_reader::forwarding fwd_mr) {
+        std::vector<flat_mutation_reader_v2> readers;
+        readers.reserve(_memtables->size() + 1);
+        for (auto&& mt : *_memtables) {
+            readers.emplace_back(upgrade_to_v2(mt->make_flat_reader(s, permit, range, slice, pc, trace_state, fwd, fwd_mr)));
+        }
+        readers.emplace_back(make_sstable_reader(s, permit, sstables, range, slice, pc, std::move(trace_state), fwd, fwd_mr));
+        return downgrade_to_v1(make_combined_reader(s, std::move(permit), std::move(readers), fwd, fwd_mr));
+    });
+
+    return make_flat_multi_range_reader(s, std::move(permit), std::move(source), ranges, slice, pc, nullptr, mutation_reader::forwarding::no);
+}
+
 flat_mutation_reader table::make_streaming_reader(schema_ptr schema, reader_permit permit, const dht::partition_range& range,
-        const query::partition_slice& slice, mutation_reader::forwarding fwd_mr) const {
+        const query::partition_slice& slice, mutation_reader::forwarding fwd_mr, unrepaired_only only_unrepaired) const {
     const auto& pc = service::get_local_streaming_priority();
     auto trace_state = tracing::trace_state_ptr();
     const auto fwd = streamed_mutation::forwarding::no;
@@ -256,7 +280,8 @@ flat_mutation_reader table::make_streaming_reader(schema_ptr schema, reader_perm
     for (auto&& mt : *_memtables) {
         readers.emplace_back(upgrade_to_v2(mt->make_flat_reader(schema, permit, range, slice, pc, trace_state, fwd, fwd_mr)));
     }
-    readers.emplace_back(make_sstable_reader(schema, permit, _sstables, range, slice, pc, std::move(trace_state), fwd, fwd_mr));
+    auto sstables = only_unrepaired ? make_unrepaired_sstable_set() : _sstables;
+    readers.emplace_back(make_sstable_reader(schema, permit, std::move(sstables), range, slice, pc, std::move(trace_state), fwd, fwd_mr));
     return downgrade_to_v1(make_combined_reader(std::move(schema), std::move(permit), std::move(readers), fwd, fwd_mr));
 }
 
@@ -436,7 +461,8 @@ void table::enable_off_strategy_trigger() {
 future<>
 table::add_sstable_and_update_cache(sstables::shared_sstable sst, sstables::offstrategy offstrategy) {
     auto permit = co_await seastar::get_units(_sstable_set_mutation_sem, 1);
-    co_return co_await get_row_cache().invalidate(row_cache::external_updater([this, sst, offstrategy] () noexcept {
+    auto pr = dht::partition_range::make({sst->get_first_decorated_key(), true}, {sst->get_last_decorated_key(), true});
+    co_await get_row_cache().invalidate(row_cache::external_updater([this, sst, offstrategy] () noexcept {
         // FIXME: this is not really noexcept, but we need to provide strong exception guarantees.
         // atomically load all opened sstables into column family.
         if (!offstrategy) {
@@ -445,7 +471,10 @@ table::add_sstable_and_update_cache(sstables::shared_sstable sst, sstables::offs
         } else {
             add_maintenance_sstable(sst);
         }
-    }), dht::partition_range::make({sst->get_first_decorated_key(), true}, {sst->get_last_decorated_key(), true}));
+    }), pr);
+    if (_config.data_listeners && !_config.data_listeners->empty()) {
+        _config.data_listeners->on_change(_schema, pr);
+    }
 }
 
 future<>
@@ -626,43 +655,92 @@ table::try_flush_memtable_to_sstable(lw_shared_ptr<memtable> old, sstable_write_
         auto metadata = mutation_source_metadata{};
         metadata.min_timestamp = old->get_min_timestamp();
         metadata.max_timestamp = old->get_max_timestamp();
-        auto estimated_partitions = _compaction_strategy.adjust_partition_estimate(metadata, old->partition_count());
 
-        auto consumer = _compaction_strategy.make_interposer_consumer(metadata, [this, old, permit, &newtabs, metadata, estimated_partitions] (flat_mutation_reader reader) mutable -> future<> {
-            auto&& priority = service::get_local_memtable_flush_priority();
-            sstables::sstable_writer_config cfg = get_sstables_manager().configure_writer("memtable");
-            cfg.backup = incremental_backups_enabled();
+        // A large memtable is split into token sub-ranges which are written concurrently, each into
+        // its own sstables, so that flushing it is not bound by the throughput of a single writer.
+        const auto sub_ranges = old->split_for_flush(std::min<uint64_t>(old->occupancy().used_space() / min_memtable_sub_range_flush_size,
+                _config.memtable_flush_sub_range_parallelism()));
+        auto estimated_partitions = _compaction_strategy.adjust_partition_estimate(metadata, old->partition_count() / sub_ranges.size());
+
+        // The sstables written for disjoint sub-ranges form a single run, unless the compaction
+        // strategy segregates the flushed data into several sstables of its own.
+        std::optional<utils::UUID> run_identifier;
+        if (!_compaction_strategy.use_interposer_consumer()) {
+            run_identifier = utils::make_random_uuid();
+        }
 
-            auto newtab = make_sstable();
-            newtabs.push_back(newtab);
-            tlogger.debug("Flushing to {}", newtab->get_filename());
+        auto make_consumer = [&] {
+            return _compaction_strategy.make_interposer_consumer(metadata, [this, old, permit, &newtabs, metadata, estimated_partitions, run_identifier] (flat_mutation_reader reader) mutable -> future<> {
+                auto&& priority = service::get_local_memtable_flush_priority();
+                sstables::sstable_writer_config cfg = get_sstables_manager().configure_writer("memtable");
+                cfg.backup = incremental_backups_enabled();
+                if (run_identifier) {
+                    cfg.run_identifier = *run_identifier;
+                }
 
-            auto monitor = database_sstable_write_monitor(permit, newtab, _compaction_strategy,
-                old->get_max_timestamp());
+                auto newtab = make_sstable();
+                newtabs.push_back(newtab);
+                tlogger.debug("Flushing to {}", newtab->get_filename());
 
-            co_return co_await write_memtable_to_sstable(std::move(reader), *old, newtab, estimated_partitions, monitor, cfg, priority);
-        });
+                auto monitor = database_sstable_write_monitor(permit, newtab, _compaction_strategy,
+                    old->get_max_timestamp());
 
-        flat_mutation_reader reader = old->make_flush_reader(
-            old->schema(),
-            compaction_concurrency_semaphore().make_tracking_only_permit(old->schema().get(), "try_flush_memtable_to_sstable()", db::no_timeout),
-            service::get_local_memtable_flush_priority());
+                co_return co_await write_memtable_to_sstable(std::move(reader), *old, newtab, estimated_partitions, monitor, cfg, priority);
+            });
+        };
 
-        if (old->has_any_tombstones()) {
-            reader = make_compacting_reader(
-                std::move(reader),
-                gc_clock::now(),
-                [] (const dht::decorated_key&) { return api::min_timestamp; });
-        }
+        std::vector<flat_mutation_reader> readers;
+        readers.reserve(sub_ranges.size());
+        std::exception_ptr ex;
+        for (auto& range : sub_ranges) {
+            flat_mutation_reader reader = old->make_flush_reader(
+                old->schema(),
+                compaction_concurrency_semaphore().make_tracking_only_permit(old->schema().get(), "try_flush_memtable_to_sstable()", db::no_timeout),
+                service::get_local_memtable_flush_priority(),
+                range);
+
+            if (old->has_any_tombstones()) {
+                reader = make_compacting_reader(
+                    std::move(reader),
+                    gc_clock::now(),
+                    [] (const dht::decorated_key&) { return api::min_timestamp; });
+            }
 
-        mutation_fragment* fragment = co_await reader.peek();
-        if (!fragment) {
-            co_await reader.close();
+            mutation_fragment* fragment = nullptr;
+            try {
+                fragment = co_await reader.peek();
+            } catch (...) {
+                ex = std::current_exception();
+            }
+            if (!fragment) {
+                co_await reader.close();
+                if (ex) {
+                    break;
+                }
+                continue;
+            }
+            readers.push_back(std::move(reader));
+        }
+        if (ex) {
+            for (auto& reader : readers) {
+                co_await reader.close();
+            }
+            std::rethrow_exception(std::move(ex));
+        }
+        if (readers.empty()) {
             _memtables->erase(old);
             co_return stop_iteration::yes;
         }
 
-        auto f = consumer(std::move(reader));
+        // The consumers, and the state of the coroutines they run, have to outlive f.
+        std::vector<reader_consumer> consumers;
+        consumers.reserve(readers.size());
+        for (size_t i = 0; i < readers.size(); ++i) {
+            consumers.push_back(make_consumer());
+        }
+        auto f = parallel_for_each(boost::irange(size_t(0), readers.size()), [&] (size_t i) {
+            return consumers[i](std::move(readers[i]));
+        });
 
         // Switch back to default scheduling group for post-flush actions, to avoid them being staved by the memtable flush
         // controller. Cache update does not affect the input of the memtable cpu controller, so it can be subject to
@@ -1061,6 +1139,7 @@ future<> table::run_offstrategy_compaction(sstables::compaction_data& info) {
             co_await update_sstable_lists_on_off_strategy_completion(old_sstables, reshape_candidates);
             break;
         }
+        desc.parallelism = _config.compaction_sub_range_parallelism();
 
         desc.creator = [this, &new_unused_sstables] (shard_id dummy) {
             auto sst = make_sstable();
@@ -1177,6 +1256,92 @@ std::vector<sstables::shared_sstable> table::in_strategy_sstables() const {
     }));
 }
 
+lw_shared_ptr<sstables::sstable_set> table::make_unrepaired_sstable_set() const {
+    auto set = make_lw_shared<sstables::sstable_set>(_compaction_strategy.make_sstable_set(_schema));
+    for (auto& sst : *_sstables->all()) {
+        if (!sst->is_repaired()) {
+            set->insert(sst);
+        }
+    }
+    return set;
+}
+
+std::optional<db_clock::time_point> table::repaired_at(const sstables::sstable& sst) const {
+    const auto& first = sst.get_first_decorated_key().token();
+    const auto& last = sst.get_last_decorated_key().token();
+    auto cmp = dht::token_comparator();
+    auto it = _repaired_ranges.lower_bound(first);
+    if (it == _repaired_ranges.end() || !it->second.first.contains(first, cmp)) {
+        return std::nullopt;
+    }
+    auto oldest = it->second.second;
+    while (!it->second.first.contains(last, cmp)) {
+        auto prev_end = it->second.first.end();
+        if (!prev_end || ++it == _repaired_ranges.end()) {
+            return std::nullopt;
+        }
+        // The ranges must be adjacent, like (a, b] and (b, c].
+        auto next_start = it->second.first.start();
+        if (!next_start || next_start->value() != prev_end->value() || (!next_start->is_inclusive() && !prev_end->is_inclusive())) {
+            return std::nullopt;
+        }
+        oldest = std::min(oldest, it->second.second);
+    }
+    // Data written after the repair started may not have been repaired.
+    if (oldest <= sst.data_file_write_time()) {
+        return std::nullopt;
+    }
+    return oldest;
+}
+
+future<> table::mark_repaired(const dht::token_range& range, db_clock::time_point repair_start) {
+    // Keep the recorded ranges disjoint by forgetting the ones which overlap with the new one.
+    auto cmp = dht::token_comparator();
+    auto it = range.start() ? _repaired_ranges.lower_bound(range.start()->value()) : _repaired_ranges.begin();
+    while (it != _repaired_ranges.end()) {
+        auto& other = it->second.first;
+        if (other.start() && range.after(other.start()->value(), cmp)) {
+            break;
+        }
+        it = other.overlaps(range, cmp) ? _repaired_ranges.erase(it) : std::next(it);
+    }
+    auto key = range.end() ? range.end()->value() : dht::maximum_token();
+    _repaired_ranges.emplace(key, std::make_pair(range, repair_start));
+
+    std::vector<std::pair<sstables::shared_sstable, uint64_t>> to_mark;
+    for (auto& sst : *_main_sstables->all()) {
+        if (sst->is_repaired() || sst->is_shared()) {
+            continue;
+        }
+        if (auto at = repaired_at(*sst)) {
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(at->time_since_epoch()).count();
+            to_mark.emplace_back(sst, uint64_t(ms));
+        }
+    }
+    if (to_mark.empty()) {
+        co_return;
+    }
+    tlogger.debug("Marking {} sstable(s) of {}.{} as repaired", to_mark.size(), _schema->ks_name(), _schema->cf_name());
+    co_await _compaction_manager.mark_sstables_repaired(this, std::move(to_mark));
+}
+
+future<> table::send_sstable_to_level_0(sstables::shared_sstable sst) {
+    if (sst->get_sstable_level() == 0) {
+        co_return;
+    }
+    // The sstable set and the backlog tracker file the sstable by its level, so it's
+    // taken out of them before its level changes, and put back right after.
+    auto new_sstables = make_lw_shared<sstables::sstable_set>(*_main_sstables);
+    new_sstables->erase(sst);
+    remove_sstable_from_backlog_tracker(_compaction_strategy.get_backlog_tracker(), sst);
+    auto rewrite = sst->mutate_sstable_level(0);
+    new_sstables->insert(sst);
+    add_sstable_to_backlog_tracker(_compaction_strategy.get_backlog_tracker(), sst);
+    _main_sstables = std::move(new_sstables);
+    refresh_compound_sstable_set();
+    co_await std::move(rewrite);
+}
+
 // Gets the list of all sstables in the column family, including ones that are
 // not used for active queries because they have already been compacted, but are
 // waiting for delete_atomically() to return.
@@ -1211,7 +1376,8 @@ table::make_memtable_list() {
         return seal_active_memtable(std::move(permit));
     };
     auto get_schema = [this] { return schema(); };
-    return make_lw_shared<memtable_list>(std::move(seal), std::move(get_schema), _config.dirty_memory_manager, _stats, _config.memory_compaction_scheduling_group);
+    return make_lw_shared<memtable_list>(std::move(seal), std::move(get_schema), _config.dirty_memory_manager, _stats, _config.memory_compaction_scheduling_group,
+            _config.enable_columnar_memtable_rows);
 }
 
 table::table(schema_ptr schema, config config, db::commitlog* cl, compaction_manager& compaction_manager,
@@ -1240,6 +1406,9 @@ table::table(schema_ptr schema, config config, db::commitlog* cl, compaction_man
     if (!_config.enable_disk_writes) {
         tlogger.warn("Writes disabled, column family no durable.");
     }
+    if (_config.enable_cache) {
+        _cache.track_hot_partitions(_config.hot_partitions_to_track);
+    }
     set_metrics();
     _compaction_manager.add(this);
 }
@@ -1586,6 +1755,9 @@ future<db::replay_position> table::discard_sstables(db_clock::time_point truncat
         tlogger.debug("cleaning out row cache");
     })).then([this, p]() mutable {
         rebuild_statistics();
+        if (_config.data_listeners && !_config.data_listeners->empty()) {
+            _config.data_listeners->on_change(_schema, query::full_partition_range);
+        }
 
         return parallel_for_each(p->remove, [this](pruner::removed_sstable& r) {
             if (r.enable_backlog_tracker) {
@@ -2061,6 +2233,15 @@ table::query(schema_ptr s,
 
     query_state qs(s, cmd, opts, partition_ranges, std::move(accounter));
 
+    // The result is built directly from what is read, so when the cache is not
+    // populated either, sstable readers need not copy out the unselected columns.
+    std::optional<query::partition_slice> projecting_slice;
+    if (bypass_cache) {
+        projecting_slice.emplace(qs.cmd.slice);
+        projecting_slice->options.set<query::partition_slice::option::skip_unselected_values>();
+    }
+    const auto& slice = projecting_slice ? *projecting_slice : qs.cmd.slice;
+
     std::optional<query::data_querier> querier_opt;
     if (saved_querier) {
         querier_opt = std::move(*saved_querier);
@@ -2070,7 +2251,7 @@ table::query(schema_ptr s,
         auto&& range = *qs.current_partition_range++;
 
         if (!querier_opt) {
-            querier_opt = query::data_querier(as_mutation_source(), s, permit, range, qs.cmd.slice,
+            querier_opt = query::data_querier(as_mutation_source(), s, permit, range, slice,
                     service::get_local_sstable_query_read_priority(), trace_state);
         }
         auto& q = *querier_opt;
@@ -28,16 +28,25 @@
 #include <boost/multiprecision/cpp_int.hpp>
 
 #include "utils/big_decimal.hh"
+#include "cql3/functions/aggregate_fcts.hh"
+#include "cql3/functions/functions.hh"
 #include "exceptions/exceptions.hh"
 #include <seastar/testing/test_case.hh>
 #include "test/lib/cql_test_env.hh"
 #include "test/lib/cql_assertions.hh"
 
 #include <seastar/core/future-util.hh>
+#include <seastar/util/defer.hh>
 #include "transport/messages/result_message.hh"
 #include "types/set.hh"
 
 #include "db/config.hh"
+#include "gms/feature_service.hh"
+#include "message/messaging_service.hh"
+#include "partition_slice_builder.hh"
+#include "query-request.hh"
+#include "service/migration_manager.hh"
+#include "service/storage_proxy.hh"
 
 namespace {
 
@@ -286,3 +295,154 @@ SEASTAR_TEST_CASE(test_minmax_on_set) {
         }
     });
 }
+
+// Aggregates of full scans are computed from partial states merged by the coordinator.
+SEASTAR_TEST_CASE(test_aggregate_partial_states) {
+    using namespace cql3::functions;
+    const auto sf = cql_serialization_format::internal();
+    auto check = [&] (const sstring& name, std::vector<data_type> arg_types, std::vector<data_value> values) {
+        auto fun = dynamic_pointer_cast<aggregate_function>(functions::find(function_name::native_function(name), arg_types));
+        BOOST_REQUIRE(fun);
+        BOOST_REQUIRE(fun->is_reducible());
+        auto whole = fun->new_aggregate();
+        auto even = fun->new_aggregate();
+        auto odd = fun->new_aggregate();
+        for (size_t i = 0; i < values.size(); ++i) {
+            auto args = arg_types.empty() ? std::vector<bytes_opt>{} : std::vector<bytes_opt>{values[i].serialize()};
+            whole->add_input(sf, args);
+            (i % 2 ? odd : even)->add_input(sf, args);
+        }
+        auto merged = fun->new_aggregate();
+        merged->merge_state(even->get_state());
+        merged->merge_state(odd->get_state());
+        // Merging the state of an aggregate which saw no values is a no-op.
+        merged->merge_state(fun->new_aggregate()->get_state());
+        BOOST_REQUIRE(merged->compute(sf) == whole->compute(sf));
+    };
+    const auto max_int = std::numeric_limits<int32_t>::max();
+
+    check(aggregate_fcts::COUNT_ROWS_FUNCTION_NAME, {}, {int32_t(1), int32_t(2), int32_t(3)});
+    check("count", {int32_type}, {int32_t(1), data_value::make_null(int32_type), int32_t(3)});
+    check("sum", {int32_type}, {int32_t(1), int32_t(2), int32_t(3)});
+    // The partial sum of the even values overflows an int, but the total doesn't.
+    check("sum", {int32_type}, {max_int, -max_int, max_int, int32_t(-1)});
+    check("sum", {double_type}, {1.5, 2.5, -1.0});
+    check("sum", {decimal_type}, {big_decimal("1.5"), big_decimal("2.25"), big_decimal("-0.5")});
+    check("avg", {long_type}, {int64_t(1), int64_t(2), int64_t(6)});
+    check("avg", {varint_type}, {utils::multiprecision_int(10), utils::multiprecision_int(20), utils::multiprecision_int(33)});
+    check("min", {utf8_type}, {sstring("b"), sstring("a"), sstring("c")});
+    check("max", {int32_type}, {int32_t(1), int32_t(7), data_value::make_null(int32_type)});
+    check("min", {int32_type}, {});
+    return make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(test_aggregate_empty_table) {
+    return do_with_cql_env_thread([&] (auto& e) {
+        e.execute_cql("CREATE TABLE test (pk int, ck int, v int, PRIMARY KEY (pk, ck))").get();
+
+        auto msg = e.execute_cql("SELECT count(*), count(v), sum(v), avg(v), min(v), max(v) FROM test").get0();
+        assert_that(msg).is_rows().with_size(1).with_row({{long_type->decompose(int64_t(0))},
+                                                          {long_type->decompose(int64_t(0))},
+                                                          {int32_type->decompose(int32_t(0))},
+                                                          {int32_type->decompose(int32_t(0))},
+                                                          {},
+                                                          {}});
+
+        for (int pk = 0; pk < 10; ++pk) {
+            for (int ck = 0; ck < 10; ++ck) {
+                e.execute_cql(format("INSERT INTO test (pk, ck, v) VALUES ({}, {}, {})", pk, ck, pk * ck)).get();
+            }
+        }
+        e.execute_cql("DELETE FROM test WHERE pk = 9").get();
+        e.execute_cql("UPDATE test SET v = null WHERE pk = 8 AND ck = 8").get();
+
+        // 9 partitions of 10 rows, one of which has no value: v sums to 45 * (0 + ... + 8) - 64.
+        msg = e.execute_cql("SELECT count(*), count(v), sum(v), min(v), max(v) FROM test").get0();
+        assert_that(msg).is_rows().with_size(1).with_row({{long_type->decompose(int64_t(90))},
+                                                          {long_type->decompose(int64_t(89))},
+                                                          {int32_type->decompose(int32_t(45 * 36 - 64))},
+                                                          {int32_type->decompose(int32_t(0))},
+                                                          {int32_type->decompose(int32_t(8 * 9))}});
+    });
+}
+
+// Inserts 10 partitions of 10 rows, where v sums to 45 * 45.
+static void populate_for_partial_aggregation(cql_test_env& e) {
+    e.execute_cql("CREATE TABLE test (pk int, ck int, v int, PRIMARY KEY (pk, ck))").get();
+    for (int pk = 0; pk < 10; ++pk) {
+        for (int ck = 0; ck < 10; ++ck) {
+            e.execute_cql(format("INSERT INTO test (pk, ck, v) VALUES ({}, {}, {})", pk, ck, pk * ck)).get();
+        }
+    }
+}
+
+// Replicas compute their partial aggregates when asked with the FORWARD_REQUEST verb.
+SEASTAR_TEST_CASE(test_aggregate_forward_request) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        populate_for_partial_aggregation(e);
+
+        auto& ms = e.messaging_service();
+        auto& proxy = service::get_storage_proxy();
+        ms.invoke_on_all(&netw::messaging_service::start_listen).get();
+        proxy.invoke_on_all([&e] (service::storage_proxy& p) {
+            p.init_messaging_service(e.migration_manager().local().shared_from_this());
+        }).get();
+        auto uninit = defer([&proxy] {
+            proxy.invoke_on_all(&service::storage_proxy::uninit_messaging_service).get();
+        });
+
+        auto s = e.local_db().find_schema("ks", "test");
+        auto slice = partition_slice_builder(*s).build();
+        query::read_command cmd(s->id(), s->version(), slice, e.local_db().get_unlimited_query_max_result_size());
+        query::forward_request req{
+                {{"system", "count", {to_bytes("v")}}, {"system", "sum", {to_bytes("v")}}},
+                {to_bytes("v")},
+                cmd,
+                {query::full_partition_range},
+                db::consistency_level::ONE};
+
+        auto result = ms.local().send_forward_request(netw::msg_addr{utils::fb_utilities::get_broadcast_address(), 0},
+                db::timeout_clock::now() + std::chrono::seconds(10), req).get0();
+        BOOST_REQUIRE_EQUAL(result.query_results.size(), 2);
+
+        using namespace cql3::functions;
+        const auto sf = cql_serialization_format::internal();
+        auto compute = [&] (const sstring& name, size_t i) {
+            auto agg = functions::find(function_name::native_function(name), {int32_type});
+            auto aggregate = dynamic_pointer_cast<aggregate_function>(agg)->new_aggregate();
+            aggregate->merge_state(result.query_results[i]);
+            return aggregate->compute(sf);
+        };
+        BOOST_REQUIRE(compute("count", 0) == long_type->decompose(int64_t(100)));
+        BOOST_REQUIRE(compute("sum", 1) == int32_type->decompose(int32_t(45 * 45)));
+    });
+}
+
+// Partial aggregation is only used once the whole cluster supports it.
+SEASTAR_TEST_CASE(test_aggregate_without_partial_aggregation) {
+    cql_test_config cfg;
+    cfg.disabled_features.insert(sstring(gms::features::PARALLELIZED_AGGREGATION));
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        BOOST_REQUIRE(!e.local_qp().proxy().features().cluster_supports_parallelized_aggregation());
+        populate_for_partial_aggregation(e);
+
+        auto msg = e.execute_cql("SELECT count(*), sum(v), max(v) FROM test").get0();
+        assert_that(msg).is_rows().with_size(1).with_row({{long_type->decompose(int64_t(100))},
+                                                          {int32_type->decompose(int32_t(45 * 45))},
+                                                          {int32_type->decompose(int32_t(81))}});
+    }, std::move(cfg));
+}
+
+// The coordinator reads its vnodes in several batches, whose partial aggregates are merged.
+SEASTAR_TEST_CASE(test_aggregate_partial_aggregation_batches) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        BOOST_REQUIRE(e.local_qp().proxy().features().cluster_supports_parallelized_aggregation());
+        BOOST_REQUIRE_GT(e.local_db().get_config().num_tokens(), service::storage_proxy::vnodes_per_partial_aggregation);
+        populate_for_partial_aggregation(e);
+
+        auto msg = e.execute_cql("SELECT count(*), sum(v), max(v) FROM test").get0();
+        assert_that(msg).is_rows().with_size(1).with_row({{long_type->decompose(int64_t(100))},
+                                                          {int32_type->decompose(int32_t(45 * 45))},
+                                                          {int32_type->decompose(int32_t(81))}});
+    });
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <seastar/testing/thread_test_case.hh>
+
+#include "utils/bloom_filter.hh"
+#include "utils/i_filter.hh"
+#include "test/lib/random_utils.hh"
+
+static std::vector<bytes> make_keys(size_t n) {
+    std::vector<bytes> keys;
+    keys.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys.push_back(tests::random::get_bytes(16));
+    }
+    return keys;
+}
+
+static double false_positive_rate(utils::i_filter& f, size_t probes) {
+    size_t positives = 0;
+    for (size_t i = 0; i < probes; ++i) {
+        // Longer than the inserted keys, so never one of them.
+        positives += f.is_present(tests::random::get_bytes(17));
+    }
+    return double(positives) / probes;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_blocked_filter_has_no_false_negatives) {
+    auto keys = make_keys(10000);
+    auto f = utils::i_filter::get_filter(keys.size(), 0.01, utils::filter_format::blocked_format);
+    for (auto& k : keys) {
+        f->add(k);
+    }
+    for (auto& k : keys) {
+        BOOST_REQUIRE(f->is_present(k));
+        BOOST_REQUIRE(f->is_present(utils::make_hashed_key(k)));
+    }
+    // Allow some slack over the requested rate for the blocked layout and randomness.
+    BOOST_REQUIRE_LT(false_positive_rate(*f, 100000), 0.02);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_blocked_filter_reload) {
+    auto keys = make_keys(1000);
+    auto f = utils::i_filter::get_filter(keys.size(), 0.1, utils::filter_format::blocked_format);
+    for (auto& k : keys) {
+        f->add(k);
+    }
+
+    // Rebuild the filter from its bits, as when reading Filter.db.
+    auto& bf = static_cast<utils::filter::bloom_filter&>(*f);
+    BOOST_REQUIRE(bf.format() == utils::filter_format::blocked_format);
+    BOOST_REQUIRE_EQUAL(bf.bits().size() % utils::filter::blocked_bloom_filter::bits_per_block, 0);
+    auto storage = bf.bits().get_storage();
+    large_bitset bs(bf.bits().size(), std::move(storage));
+    auto reloaded = utils::filter::create_filter(bf.num_hashes(), std::move(bs), utils::filter_format::blocked_format);
+    for (auto& k : keys) {
+        BOOST_REQUIRE(reloaded->is_present(k));
+    }
+}
@@ -345,3 +345,38 @@ SEASTAR_THREAD_TEST_CASE(test_invalidation) {
     BOOST_REQUIRE_EQUAL(2, metrics.page_populations);
     BOOST_REQUIRE_EQUAL(0, metrics.page_hits);
 }
+
+SEASTAR_THREAD_TEST_CASE(test_population_of_page_runs) {
+    auto page_size = cached_file::page_size;
+    auto file_size = page_size * 5 + 12;
+    test_file tf = make_test_file(file_size);
+
+    cached_file::metrics metrics;
+    logalloc::region region;
+    cached_file cf(tf.f, metrics, cf_lru, region, file_size);
+
+    using runs_type = std::vector<std::pair<cached_file::page_idx_type, cached_file::page_count_type>>;
+    BOOST_REQUIRE(cf.cached_page_runs().empty());
+
+    BOOST_REQUIRE_EQUAL(tf.contents.substr(page_size * 2, 1), read_to_string(cf, page_size * 2, 1));
+    BOOST_REQUIRE(cf.cached_page_runs() == runs_type({{2, 1}}));
+
+    // Populates pages 1 and 3..5; page 2 is already cached and page 6 is past the end.
+    cf.populate(1, 6, default_priority_class()).get();
+    BOOST_REQUIRE(cf.cached_page_runs() == runs_type({{1, 5}}));
+    BOOST_REQUIRE_EQUAL(page_size * 5, metrics.cached_bytes);
+    BOOST_REQUIRE_EQUAL(5, metrics.page_populations);
+    BOOST_REQUIRE_EQUAL(1, metrics.page_misses);
+
+    // Populated pages serve reads and are evictable.
+    BOOST_REQUIRE_EQUAL(tf.contents.substr(page_size, file_size - page_size), read_to_string(cf, page_size));
+    BOOST_REQUIRE_EQUAL(1, metrics.page_misses);
+    BOOST_REQUIRE_EQUAL(5, metrics.page_hits);
+
+    cf.populate(0, 1, default_priority_class()).get();
+    BOOST_REQUIRE(cf.cached_page_runs() == runs_type({{0, 6}}));
+
+    cf_lru.evict_all();
+    BOOST_REQUIRE(cf.cached_page_runs().empty());
+    BOOST_REQUIRE_EQUAL(0, metrics.cached_bytes);
+}
@@ -54,6 +54,7 @@
 #include "test/lib/data_model.hh"
 #include "test/lib/sstable_utils.hh"
 #include "test/lib/mutation_source_test.hh"
+#include "test/lib/random_utils.hh"
 
 using namespace db;
 
@@ -725,6 +726,80 @@ SEASTAR_TEST_CASE(test_commitlog_add_entries) {
     });
 }
 
+SEASTAR_TEST_CASE(test_commitlog_compression) {
+    commitlog::config cfg;
+    cfg.use_compression = true;
+    return cl_test(cfg, [](commitlog& log) {
+        return seastar::async([&] {
+            // Compressible entries spanning one and several compression blocks,
+            // an incompressible one and one too small to be compressed.
+            std::vector<sstring> entries;
+            for (auto size : { 4 * 1024, 300 * 1024 }) {
+                sstring s;
+                while (s.size() < size_t(size)) {
+                    s += "hej bubba cow ";
+                }
+                entries.push_back(std::move(s));
+            }
+            entries.push_back(tests::random::get_sstring(8 * 1024));
+            entries.push_back("hej bubba cow");
+
+            std::vector<replay_position> rps;
+            auto uuid = utils::UUID_gen::get_time_UUID();
+            for (auto& e : entries) {
+                auto h = log.add_mutation(uuid, e.size(), db::commitlog::force_sync::no, [&e] (db::commitlog::output& dst) {
+                    dst.write(e.data(), e.size());
+                }).get0();
+                rps.push_back(h.release());
+            }
+            log.sync_all_segments().get();
+
+            auto segments = log.get_active_segment_names();
+            BOOST_REQUIRE_EQUAL(segments.size(), 1);
+            BOOST_REQUIRE_EQUAL(commitlog::descriptor(segments.front()).ver, commitlog::descriptor::segment_version_3);
+
+            size_t n = 0;
+            db::commitlog::read_log_file(segments.front(), db::commitlog::descriptor::FILENAME_PREFIX, service::get_local_commitlog_priority(), [&] (db::commitlog::buffer_and_replay_position buf_rp) {
+                auto&& [buf, rp] = buf_rp;
+                BOOST_REQUIRE_LT(n, entries.size());
+                BOOST_REQUIRE_EQUAL(rp, rps[n]);
+                auto linearization_buffer = bytes_ostream();
+                auto in = buf.get_istream();
+                auto str = to_sstring_view(in.read_bytes_view(buf.size_bytes(), linearization_buffer));
+                BOOST_REQUIRE(str == entries[n]);
+                ++n;
+                return make_ready_future<>();
+            }).get();
+            BOOST_REQUIRE_EQUAL(n, entries.size());
+        });
+    });
+}
+
+// Compressed entries take less room in the buffers than was reserved for them
+// in the request controller. Make sure the difference is given back, or
+// writing more than its capacity would block forever.
+SEASTAR_TEST_CASE(test_commitlog_compression_releases_request_controller_units) {
+    commitlog::config cfg;
+    cfg.use_compression = true;
+    cfg.commitlog_segment_size_in_mb = 1;
+    return cl_test(cfg, [](commitlog& log) -> future<> {
+        sstring entry;
+        while (entry.size() < 32 * 1024) {
+            entry += "hej bubba cow ";
+        }
+        auto uuid = utils::UUID_gen::get_time_UUID();
+        // Well over ten times the request controller capacity of a 1MB segment commitlog.
+        for (size_t written = 0; written < 10 * 1024 * 1024; written += entry.size()) {
+            auto timeout = db::timeout_clock::now() + 10s;
+            co_await log.add_mutation(uuid, entry.size(), timeout, db::commitlog::force_sync::no, [&entry] (db::commitlog::output& dst) {
+                dst.write(entry.data(), entry.size());
+            });
+        }
+        co_await log.sync_all_segments();
+        BOOST_REQUIRE_EQUAL(log.get_pending_allocations(), 0);
+    });
+}
+
 SEASTAR_TEST_CASE(test_commitlog_new_segment_odsync){
     commitlog::config cfg;
     cfg.commitlog_segment_size_in_mb = 1;
@@ -56,13 +56,21 @@ class table_listener : public db::data_listener {
         }
     }
 
+    virtual void on_change(const schema_ptr& s, const dht::partition_range& range) override {
+        if (s->cf_name() == _cf_name) {
+            ++change;
+        }
+    }
+
     unsigned read = 0;
     unsigned write = 0;
+    unsigned change = 0;
 };
 
 struct results {
     unsigned read = 0;
     unsigned write = 0;
+    unsigned change = 0;
 };
 
 //---------------------------------------------------------------------------------------------
@@ -92,8 +100,8 @@ results test_data_listeners(cql_test_env& e, sstring cf_name) {
                 if (!db.data_listeners().exists(li)) {
                     continue;
                 }
-                results res{li->read, li->write};
-                testlog.info("uninstalled listener {}: rd={} wr={}", fmt::ptr(li), li->read, li->write);
+                results res{li->read, li->write, li->change};
+                testlog.info("uninstalled listener {}: rd={} wr={} ch={}", fmt::ptr(li), li->read, li->write, li->change);
                 db.data_listeners().uninstall(li);
                 return res;
             }
@@ -103,10 +111,11 @@ results test_data_listeners(cql_test_env& e, sstring cf_name) {
         [] (results res, results li_res) {
             res.read += li_res.read;
             res.write += li_res.write;
+            res.change += li_res.change;
             return res;
         }).get0();
 
-    testlog.info("test_data_listeners: rd={} wr={}", res.read, res.write);
+    testlog.info("test_data_listeners: rd={} wr={} ch={}", res.read, res.write, res.change);
 
     return res;
 }
@@ -116,6 +125,7 @@ SEASTAR_TEST_CASE(test_dlistener_t1) {
         auto res = test_data_listeners(e, "t1");
         BOOST_REQUIRE_EQUAL(3, res.read);
         BOOST_REQUIRE_EQUAL(3, res.write);
+        BOOST_REQUIRE_EQUAL(3, res.change);
     });
 }
 
@@ -124,5 +134,6 @@ SEASTAR_TEST_CASE(test_dlistener_t2) {
         auto res = test_data_listeners(e, "t2");
         BOOST_REQUIRE_EQUAL(0, res.read);
         BOOST_REQUIRE_EQUAL(0, res.write);
+        BOOST_REQUIRE_EQUAL(0, res.change);
     });
 }
@@ -1166,3 +1166,39 @@ SEASTAR_TEST_CASE(test_filtering) {
 
     });
 }
+
+SEASTAR_TEST_CASE(test_filtering_fixed_width_columns_in_blocks) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        cquery_nofail(e, "CREATE TABLE t (p int, c int, i int, b bigint, ts timestamp, u uuid, PRIMARY KEY (p, c));");
+        // Enough rows to span several blocks of rows, with some null and some empty values
+        // in between, which have to be treated exactly like the row-by-row evaluation does.
+        for (int c = 0; c < 150; ++c) {
+            auto i = c % 10 == 0 ? sstring("null") : c % 25 == 1 ? sstring("blobAsInt(0x)") : format("{}", c);
+            cquery_nofail(e, format("INSERT INTO t (p, c, i, b, ts, u) VALUES (1, {}, {}, {}, {}, 00000000-0000-4000-8000-{:012x});",
+                    c, i, (int64_t(c) - 50) * 1000, c, c));
+        }
+        auto require_count = [&] (sstring where, size_t count) {
+            auto msg = cquery_nofail(e, format("SELECT c FROM t WHERE p = 1 AND {} ALLOW FILTERING;", where));
+            assert_that(msg).is_rows().with_size(count);
+        };
+        // c in [101, 149], without nulls (110, 120, 130, 140) and empty values (101, 126).
+        require_count("i > 100", 43);
+        // Empty values compare less than any other value.
+        require_count("i < 3", 7);
+        require_count("i = 77", 1);
+        require_count("i >= 140 AND i <= 145", 5);
+        require_count("b >= 0 AND b < 10000", 10);
+        require_count("b < -49000", 1);
+        require_count("ts <= 4", 5);
+        require_count("u = 00000000-0000-4000-8000-00000000004d", 1);
+        require_count("u > 00000000-0000-4000-8000-00000000008c", 9);
+        require_count("i > 100 AND b <= 70000", 17);
+
+        auto msg = cquery_nofail(e, "SELECT c FROM t WHERE p = 1 AND i > 100 LIMIT 3 ALLOW FILTERING;");
+        assert_that(msg).is_rows().with_rows({
+            {int32_type->decompose(102), int32_type->decompose(102)},
+            {int32_type->decompose(103), int32_type->decompose(103)},
+            {int32_type->decompose(104), int32_type->decompose(104)},
+        });
+    });
+}
@@ -21,8 +21,14 @@
 
 #include <boost/test/unit_test.hpp>
 #include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
 
+#include "db/hints/manager.hh"
 #include "db/hints/sync_point.hh"
+#include "frozen_mutation.hh"
+#include "test/lib/simple_schema.hh"
+
+using hint_sender = db::hints::manager::end_point_hints_manager::sender;
 
 SEASTAR_TEST_CASE(test_hint_sync_point_faithful_reserialization) {
     const unsigned encoded_shard_count = 2;
@@ -77,3 +83,130 @@ SEASTAR_TEST_CASE(test_hint_sync_point_faithful_reserialization) {
 
     return make_ready_future<>();
 }
+
+SEASTAR_THREAD_TEST_CASE(test_hint_batch_merges_hints_of_a_partition) {
+    simple_schema ss;
+    auto s = ss.schema();
+    auto pkeys = ss.make_pkeys(2);
+    auto make_hint = [&] (const dht::decorated_key& dk, int ck) {
+        mutation m(s, dk);
+        ss.add_row(m, ss.make_ckey(ck), format("v{}", ck));
+        return m;
+    };
+
+    hint_sender::hint_batch batch;
+    mutation expected(s, pkeys[0]);
+    for (int i = 0; i < 3; ++i) {
+        auto m = make_hint(pkeys[0], i);
+        frozen_mutation_and_schema hint{freeze(m), s};
+        if (i > 0) {
+            BOOST_REQUIRE(batch.can_add(hint));
+        }
+        expected.apply(m);
+        batch.add(std::move(hint), db::replay_position(0, 1, i), 100);
+    }
+    // A hint of another partition doesn't go into the batch.
+    BOOST_REQUIRE(!batch.can_add(frozen_mutation_and_schema{freeze(make_hint(pkeys[1], 0)), s}));
+    BOOST_REQUIRE_EQUAL(batch.rps.size(), 3);
+    BOOST_REQUIRE_EQUAL(batch.size_bytes, 300);
+
+    auto merged = std::move(batch).merge();
+    BOOST_REQUIRE_EQUAL(merged.fm.unfreeze(merged.s), expected);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_failed_hint_batch_fails_all_its_hints) {
+    std::unordered_map<table_schema_version, column_mapping> column_mappings;
+    hint_sender::send_one_file_ctx ctx(column_mappings);
+
+    const std::vector<db::replay_position> batch_rps{{0, 1, 10}, {0, 1, 20}, {0, 1, 30}};
+    const db::replay_position next_rp{0, 1, 40};
+    for (auto& rp : batch_rps) {
+        ctx.mark_hint_as_in_progress(rp);
+    }
+    ctx.mark_hint_as_in_progress(next_rp);
+
+    ctx.on_hint_send_success(next_rp);
+    ctx.on_hints_send_failure(batch_rps);
+
+    BOOST_REQUIRE(ctx.segment_replay_failed);
+    BOOST_REQUIRE(ctx.in_progress_rps.empty());
+    BOOST_REQUIRE(ctx.first_failed_rp == batch_rps.front());
+    // The segment is replayed again from the first hint of the batch.
+    BOOST_REQUIRE(ctx.get_replayed_bound() == batch_rps.front());
+}
+
+SEASTAR_TEST_CASE(test_hint_send_window_grows_per_window_of_timely_sends) {
+    using send_window = hint_sender::send_window;
+    const auto now = seastar::lowres_clock::time_point(std::chrono::hours(1));
+    const auto fast = std::chrono::milliseconds(1);
+    send_window w;
+    BOOST_REQUIRE_EQUAL(w.size(), send_window::initial_size);
+
+    for (size_t i = 1; i < send_window::initial_size; ++i) {
+        BOOST_REQUIRE_EQUAL(w.on_send(true, fast, 0, now), 0);
+    }
+    BOOST_REQUIRE_EQUAL(w.on_send(true, fast, 0, now), 1);
+    BOOST_REQUIRE_EQUAL(w.size(), send_window::initial_size + 1);
+
+    // The window stops growing at its maximum size.
+    for (size_t i = 0; i < send_window::max_size * send_window::max_size; ++i) {
+        w.on_send(true, fast, 0, now);
+    }
+    BOOST_REQUIRE_EQUAL(w.size(), send_window::max_size);
+    BOOST_REQUIRE_EQUAL(w.on_send(true, fast, 0, now), 0);
+    BOOST_REQUIRE_EQUAL(w.size(), send_window::max_size);
+    return make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(test_hint_send_window_halves_on_overload) {
+    using send_window = hint_sender::send_window;
+    const auto fast = std::chrono::milliseconds(1);
+    const auto period = send_window::slow_send_threshold + std::chrono::milliseconds(1);
+    auto now = seastar::lowres_clock::time_point(std::chrono::hours(1));
+    send_window w;
+
+    // A failed send.
+    BOOST_REQUIRE_EQUAL(w.on_send(false, fast, 0, now), -4);
+    BOOST_REQUIRE_EQUAL(w.size(), 4);
+
+    // A slow send.
+    now += period;
+    BOOST_REQUIRE_EQUAL(w.on_send(true, period, 0, now), -2);
+    BOOST_REQUIRE_EQUAL(w.size(), 2);
+
+    // A destination with a large view update backlog.
+    now += period;
+    BOOST_REQUIRE_EQUAL(w.on_send(true, fast, send_window::max_view_update_backlog, now), 0);
+    BOOST_REQUIRE_EQUAL(w.on_send(true, fast, send_window::max_view_update_backlog + 0.1, now), -1);
+    BOOST_REQUIRE_EQUAL(w.size(), 1);
+
+    // The window never drops below a single send.
+    now += period;
+    BOOST_REQUIRE_EQUAL(w.on_send(false, fast, 0, now), 0);
+    BOOST_REQUIRE_EQUAL(w.size(), 1);
+    return make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(test_hint_send_window_shrinks_once_per_slow_send_period) {
+    using send_window = hint_sender::send_window;
+    const auto fast = std::chrono::milliseconds(1);
+    auto now = seastar::lowres_clock::time_point(std::chrono::hours(1));
+    send_window w;
+
+    BOOST_REQUIRE_EQUAL(w.on_send(false, fast, 0, now), -4);
+    // The other sends in flight when the destination got overloaded fail too,
+    // but they don't shrink the window any further.
+    now += send_window::slow_send_threshold;
+    BOOST_REQUIRE_EQUAL(w.on_send(false, fast, 0, now), 0);
+    BOOST_REQUIRE_EQUAL(w.size(), 4);
+
+    now += std::chrono::milliseconds(1);
+    BOOST_REQUIRE_EQUAL(w.on_send(false, fast, 0, now), -2);
+    BOOST_REQUIRE_EQUAL(w.size(), 2);
+
+    // Growing starts over after each shrink.
+    BOOST_REQUIRE_EQUAL(w.on_send(true, fast, 0, now), 0);
+    BOOST_REQUIRE_EQUAL(w.on_send(true, fast, 0, now), 1);
+    BOOST_REQUIRE_EQUAL(w.size(), 3);
+    return make_ready_future<>();
+}
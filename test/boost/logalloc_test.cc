@@ -1547,6 +1547,75 @@ SEASTAR_THREAD_TEST_CASE(background_reclaim) {
     }
 }
 
+// The background reclaimer compacts until free_segments_target segments are free,
+// refills them after allocations take them, and stops compacting at the target.
+SEASTAR_THREAD_TEST_CASE(test_background_reclaim_free_segments_target) {
+    prime_segment_pool(memory::stats().total_memory(), memory::min_free_memory()).get();
+
+    region reg;
+    std::vector<managed_bytes> objs;
+    auto clean_up = defer([&] () noexcept {
+        with_allocator(reg.allocator(), [&] {
+            objs.clear();
+        });
+    });
+
+    // Fill segments, then free every other object, so that compacting two segments frees one.
+    const size_t obj_size = 1000;
+    with_allocator(reg.allocator(), [&] {
+        for (size_t i = 0; i < 256 * segment_size / obj_size; ++i) {
+            objs.emplace_back(managed_bytes::initialized_later(), obj_size);
+        }
+        for (size_t i = 0; i < objs.size(); i += 2) {
+            objs[i] = managed_bytes();
+        }
+    });
+    shard_tracker().reclaim_all_free_segments();
+    BOOST_REQUIRE_EQUAL(shard_tracker().unreserved_free_segments(), 0);
+
+    auto background_reclaim_scheduling_group = create_scheduling_group("background_reclaim", 100).get0();
+    auto kill_sched_group = defer([&] () noexcept {
+        destroy_scheduling_group(background_reclaim_scheduling_group).get();
+    });
+
+    const size_t free_segments_target = 4;
+    logalloc::tracker::config st_cfg;
+    st_cfg.defragment_on_idle = false;
+    st_cfg.abort_on_lsa_bad_alloc = false;
+    st_cfg.lsa_reclamation_step = 1;
+    st_cfg.free_segments_target = free_segments_target;
+    st_cfg.background_reclaim_sched_group = background_reclaim_scheduling_group;
+    logalloc::shard_tracker().configure(st_cfg);
+    auto stop_lsa_background_reclaim = defer([&] () noexcept {
+        logalloc::shard_tracker().stop().get();
+    });
+
+    auto wait_for_target = [&] {
+        auto deadline = lowres_clock::now() + 10s;
+        while (shard_tracker().unreserved_free_segments() < free_segments_target) {
+            BOOST_REQUIRE(lowres_clock::now() < deadline);
+            sleep(10ms).get();
+        }
+        // Each compaction frees at most one segment, and none is done once the target is reached.
+        BOOST_REQUIRE_EQUAL(shard_tracker().unreserved_free_segments(), free_segments_target);
+        auto compacted = logalloc::memory_compacted();
+        sleep(200ms).get();
+        BOOST_REQUIRE_EQUAL(logalloc::memory_compacted(), compacted);
+        BOOST_REQUIRE_EQUAL(shard_tracker().unreserved_free_segments(), free_segments_target);
+    };
+
+    wait_for_target();
+
+    // Allocations take the free segments, without yielding to the reclaimer.
+    with_allocator(reg.allocator(), [&] {
+        while (shard_tracker().unreserved_free_segments()) {
+            objs.emplace_back(managed_bytes::initialized_later(), obj_size);
+        }
+    });
+
+    wait_for_target();
+}
+
 inline
 bool is_aligned(void* ptr, size_t alignment) {
     return uintptr_t(ptr) % alignment == 0;
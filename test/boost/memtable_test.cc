@@ -38,10 +38,12 @@
 #include "test/lib/mutation_assertions.hh"
 #include "test/lib/flat_mutation_reader_assertions.hh"
 #include "flat_mutation_reader.hh"
+#include "partition_slice_builder.hh"
 #include "test/lib/data_model.hh"
 #include "test/lib/random_utils.hh"
 #include "test/lib/log.hh"
 #include "test/lib/reader_concurrency_semaphore.hh"
+#include "test/lib/simple_schema.hh"
 
 static api::timestamp_type next_timestamp() {
     static thread_local api::timestamp_type next_timestamp = 1;
@@ -89,6 +91,148 @@ SEASTAR_TEST_CASE(test_memtable_conforms_to_mutation_source) {
     });
 }
 
+SEASTAR_TEST_CASE(test_memtable_with_columnar_rows_conforms_to_mutation_source) {
+    return seastar::async([] {
+        dirty_memory_manager mgr;
+        table_stats tbl_stats;
+        run_mutation_source_tests([&] (schema_ptr s, const std::vector<mutation>& partitions) {
+            auto mt = make_lw_shared<memtable>(s, mgr, tbl_stats, nullptr, current_scheduling_group(), true);
+
+            for (auto&& m : partitions) {
+                mt->apply(m);
+            }
+
+            logalloc::shard_tracker().full_compaction();
+
+            return mt->as_data_source();
+        });
+    });
+}
+
+SEASTAR_TEST_CASE(test_memtable_columnar_rows_are_merged_with_other_writes) {
+    return seastar::async([] {
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        simple_schema ss;
+        schema_ptr s = ss.schema();
+        dirty_memory_manager mgr;
+        table_stats tbl_stats;
+        auto mt = make_lw_shared<memtable>(s, mgr, tbl_stats, nullptr, current_scheduling_group(), true);
+
+        auto pk = ss.make_pkey(0);
+        mutation expected(s, pk);
+        auto apply = [&] (mutation m) {
+            expected.apply(m);
+            mt->apply(freeze(m), s);
+        };
+
+        // Appended in order, spanning several chunks.
+        const uint32_t rows = columnar_rows::max_chunk_rows * 2 + 10;
+        for (uint32_t i = 0; i < rows; i += 2) {
+            mutation m(s, pk);
+            ss.add_row(m, ss.make_ckey(i), format("v{}", i));
+            apply(std::move(m));
+        }
+
+        // Written out of order, so stored in the partition_entry.
+        for (uint32_t i : {1u, 10u, rows - 1}) {
+            mutation m(s, pk);
+            ss.add_row(m, ss.make_ckey(i), format("w{}", i));
+            apply(std::move(m));
+        }
+        {
+            mutation m(s, pk);
+            ss.delete_range(m, ss.make_ckey_range(20, 30));
+            apply(std::move(m));
+        }
+
+        assert_that(mt->make_flat_reader(s, semaphore.make_permit()))
+            .produces(expected)
+            .produces_end_of_stream();
+
+        auto range = dht::partition_range::make_singular(pk);
+        auto slice = partition_slice_builder(*s)
+            .with_range(ss.make_ckey_range(5, 40))
+            .build();
+        assert_that(mt->make_flat_reader(s, semaphore.make_permit(), range, slice, default_priority_class(), nullptr,
+                streamed_mutation::forwarding::no, mutation_reader::forwarding::no))
+            .produces(expected.sliced({ss.make_ckey_range(5, 40)}))
+            .produces_end_of_stream();
+
+        assert_that(mt->make_flush_reader(s, semaphore.make_permit(), default_priority_class()))
+            .produces(expected)
+            .produces_end_of_stream();
+
+        // Columnar rows are moved to the partition_entry on schema change.
+        auto s2 = schema_builder(s)
+            .with_column(to_bytes("v2"), bytes_type)
+            .build();
+        mt->set_schema(s2);
+        expected.upgrade(s2);
+        assert_that(mt->make_flat_reader(s2, semaphore.make_permit(), range))
+            .produces(expected)
+            .produces_end_of_stream();
+    });
+}
+
+SEASTAR_TEST_CASE(test_memtable_columnar_rows_reversed_reads) {
+    return seastar::async([] {
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        simple_schema ss;
+        schema_ptr s = ss.schema();
+        schema_ptr rev_s = s->make_reversed();
+        dirty_memory_manager mgr;
+        table_stats tbl_stats;
+        auto mt = make_lw_shared<memtable>(s, mgr, tbl_stats, nullptr, current_scheduling_group(), true);
+
+        auto pk = ss.make_pkey(0);
+        mutation expected(s, pk);
+
+        // Inserted in order, one row at a time, so all rows are in the columnar layout.
+        const uint32_t rows = columnar_rows::max_chunk_rows * 3 + 7;
+        for (uint32_t i = 0; i < rows; ++i) {
+            mutation m(s, pk);
+            ss.add_row(m, ss.make_ckey(i), format("v{}", i));
+            expected.apply(m);
+            mt->apply(m);
+        }
+
+        auto check = [&] (const dht::partition_range& range, const query::clustering_row_ranges& ranges) {
+            // The slice is in the legacy reversed format: the ranges are in clustering order,
+            // and they are listed in reverse order.
+            auto slice = partition_slice_builder(*s)
+                .with_ranges(query::clustering_row_ranges(ranges.rbegin(), ranges.rend()))
+                .with_option<query::partition_slice::option::reversed>()
+                .build();
+            assert_that(mt->make_flat_reader(rev_s, semaphore.make_permit(), range, slice, default_priority_class(), nullptr,
+                    streamed_mutation::forwarding::no, mutation_reader::forwarding::no))
+                .produces(reverse(expected.sliced(ranges)))
+                .produces_end_of_stream();
+        };
+
+        const auto singular = dht::partition_range::make_singular(pk);
+        const auto full = query::full_partition_range;
+        for (auto& range : {singular, full}) {
+            check(range, {query::full_clustering_range});
+            // Within one chunk, across chunks, and two ranges in different chunks.
+            check(range, {ss.make_ckey_range(3, 40)});
+            check(range, {ss.make_ckey_range(100, 300)});
+            check(range, {ss.make_ckey_range(5, 20), ss.make_ckey_range(260, rows + 10)});
+        }
+
+        // Rows in the partition_entry are merged at their place in the reversed stream.
+        for (uint32_t i : {1u, 200u, rows + 3}) {
+            mutation m(s, pk);
+            ss.add_row(m, ss.make_ckey(i), format("w{}", i));
+            expected.apply(m);
+            mt->apply(m);
+        }
+        for (auto& range : {singular, full}) {
+            check(range, {query::full_clustering_range});
+            check(range, {ss.make_ckey_range(100, 300)});
+        }
+    });
+}
+
 SEASTAR_TEST_CASE(test_memtable_with_many_versions_conforms_to_mutation_source) {
     return seastar::async([] {
         tests::reader_concurrency_semaphore_wrapper semaphore;
@@ -204,6 +348,41 @@ SEASTAR_TEST_CASE(test_memtable_flush_reader) {
     });
 }
 
+SEASTAR_TEST_CASE(test_memtable_flush_reader_sub_ranges) {
+    return seastar::async([] {
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        schema_ptr s = schema_builder("ks", "cf")
+            .with_column("pk", bytes_type, column_kind::partition_key)
+            .with_column("col", bytes_type, column_kind::regular_column)
+            .build();
+
+        dirty_memory_manager mgr;
+        table_stats tbl_stats;
+        auto mt = make_lw_shared<memtable>(s, mgr, tbl_stats);
+        std::vector<mutation> ring = make_ring(s, 16);
+        for (auto& m : ring) {
+            mt->apply(m);
+        }
+
+        for (unsigned n : {1, 2, 3, 16, 100}) {
+            testlog.info("Flushing in {} sub-ranges", n);
+            auto ranges = mt->split_for_flush(n);
+            BOOST_REQUIRE_GE(ranges.size(), 1);
+            BOOST_REQUIRE_LE(ranges.size(), n);
+            // Each partition is read by exactly one of the readers, in ring order.
+            auto it = ring.begin();
+            for (auto& range : ranges) {
+                auto rd = assert_that(mt->make_flush_reader(s, semaphore.make_permit(), default_priority_class(), range));
+                while (it != ring.end() && range.contains(it->decorated_key(), dht::ring_position_comparator(*s))) {
+                    rd.produces(*it++);
+                }
+                rd.produces_end_of_stream();
+            }
+            BOOST_REQUIRE(it == ring.end());
+        }
+    });
+}
+
 SEASTAR_TEST_CASE(test_adding_a_column_during_reading_doesnt_affect_read_result) {
     return seastar::async([] {
         auto common_builder = schema_builder("ks", "cf")
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+
+#include "repair/hash_tree.hh"
+#include "test/lib/simple_schema.hh"
+
+static dht::token t(int64_t v) {
+    return dht::token::from_int64(v);
+}
+
+// (start, end]
+static dht::token_range make_range(int64_t start, int64_t end) {
+    return dht::token_range(dht::token_range::bound(t(start), false), dht::token_range::bound(t(end), true));
+}
+
+static bool equal(const dht::token_range& a, const dht::token_range& b) {
+    return a.equal(b, dht::token_comparator());
+}
+
+static void set_all_hashes(repair_hash_tree& tree) {
+    for (size_t i = 0; i < tree.size(); ++i) {
+        tree.at(i).hash = repair_hash(i + 1);
+    }
+}
+
+static std::vector<size_t> invalidated_leaves(repair_hash_tree& tree, const dht::token_range& range) {
+    set_all_hashes(tree);
+    tree.invalidate(range);
+    std::vector<size_t> ret;
+    for (size_t i = 0; i < tree.size(); ++i) {
+        if (!tree.at(i).hash) {
+            ret.push_back(i);
+        }
+    }
+    return ret;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_leaf_ranges) {
+    simple_schema ss;
+    auto version = ss.schema()->version();
+
+    auto tree = repair_hash_tree(make_range(0, 1000), version, 4);
+    BOOST_REQUIRE_EQUAL(tree.size(), 4);
+    BOOST_REQUIRE(equal(tree.leaf_range(0), make_range(0, 250)));
+    BOOST_REQUIRE(equal(tree.leaf_range(1), make_range(250, 500)));
+    BOOST_REQUIRE(equal(tree.leaf_range(2), make_range(500, 750)));
+    BOOST_REQUIRE(equal(tree.leaf_range(3), make_range(750, 1000)));
+
+    // The first and last leaves extend to the bounds of the range, whatever they are.
+    auto full = dht::token_range::make_open_ended_both_sides();
+    auto full_tree = repair_hash_tree(full, version, 8);
+    BOOST_REQUIRE_EQUAL(full_tree.size(), 8);
+    BOOST_REQUIRE(!full_tree.leaf_range(0).start());
+    BOOST_REQUIRE(!full_tree.leaf_range(7).end());
+    for (size_t i = 0; i + 1 < full_tree.size(); ++i) {
+        auto end = *full_tree.leaf_range(i).end();
+        auto next_start = *full_tree.leaf_range(i + 1).start();
+        BOOST_REQUIRE(end.is_inclusive());
+        BOOST_REQUIRE(!next_start.is_inclusive());
+        BOOST_REQUIRE(end.value() == next_start.value());
+    }
+
+    auto closed = dht::token_range::make(t(10), t(20));
+    auto closed_tree = repair_hash_tree(closed, version, 2);
+    BOOST_REQUIRE(equal(closed_tree.leaf_range(0), dht::token_range::make(t(10), t(15))));
+    BOOST_REQUIRE(equal(closed_tree.leaf_range(1), make_range(15, 20)));
+
+    // Ranges narrower than the number of leaves get fewer leaves.
+    auto narrow_tree = repair_hash_tree(make_range(0, 2), version, 4);
+    BOOST_REQUIRE_EQUAL(narrow_tree.size(), 2);
+    BOOST_REQUIRE(equal(narrow_tree.leaf_range(0), make_range(0, 1)));
+    BOOST_REQUIRE(equal(narrow_tree.leaf_range(1), make_range(1, 2)));
+
+    auto singular_tree = repair_hash_tree(dht::token_range::make_singular(t(5)), version, 4);
+    BOOST_REQUIRE_EQUAL(singular_tree.size(), 1);
+    BOOST_REQUIRE(equal(singular_tree.leaf_range(0), dht::token_range::make_singular(t(5))));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_invalidate) {
+    simple_schema ss;
+    auto tree = repair_hash_tree(make_range(0, 1000), ss.schema()->version(), 4);
+    using leaves = std::vector<size_t>;
+
+    // A leaf ends at its split point, inclusive.
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make_singular(t(250))) == leaves({0}));
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make_singular(t(251))) == leaves({1}));
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make_singular(t(1))) == leaves({0}));
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make_singular(t(1000))) == leaves({3}));
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make(t(100), t(600))) == leaves({0, 1, 2}));
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make(t(500), t(501))) == leaves({1, 2}));
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make_ending_with({t(10), true})) == leaves({0}));
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make_starting_with({t(990), true})) == leaves({3}));
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make_open_ended_both_sides()) == leaves({0, 1, 2, 3}));
+
+    // Ranges outside of the tree's range.
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make_singular(t(0))).empty());
+    BOOST_REQUIRE(invalidated_leaves(tree, dht::token_range::make(t(1001), t(2000))).empty());
+
+    // A hash computed while its leaf was invalidated can be told apart by the generation.
+    auto generation = tree.at(2).generation;
+    tree.invalidate(dht::token_range::make_singular(t(600)));
+    BOOST_REQUIRE_EQUAL(tree.at(2).generation, generation + 1);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_find_unsynced_ranges) {
+    simple_schema ss;
+    auto tree = repair_hash_tree(make_range(0, 1000), ss.schema()->version(), 4);
+    auto h = [] (std::initializer_list<uint64_t> v) {
+        std::vector<repair_hash> ret;
+        for (auto x : v) {
+            ret.emplace_back(x);
+        }
+        return ret;
+    };
+
+    auto same = find_unsynced_ranges(tree, {h({1, 2, 3, 4}), h({1, 2, 3, 4}), h({1, 2, 3, 4})});
+    BOOST_REQUIRE(same && same->empty());
+
+    // Adjacent differing leaves make a single range.
+    auto middle = find_unsynced_ranges(tree, {h({1, 2, 3, 4}), h({1, 5, 6, 4}), h({1, 2, 3, 4})});
+    BOOST_REQUIRE(middle && middle->size() == 1);
+    BOOST_REQUIRE(equal(middle->front(), make_range(250, 750)));
+
+    // The first and the last leaves, which reach the bounds of the range.
+    auto edges = find_unsynced_ranges(tree, {h({1, 2, 3, 4}), h({7, 2, 3, 8})});
+    BOOST_REQUIRE(edges && edges->size() == 2);
+    BOOST_REQUIRE(equal((*edges)[0], make_range(0, 250)));
+    BOOST_REQUIRE(equal((*edges)[1], make_range(750, 1000)));
+
+    auto all = find_unsynced_ranges(tree, {h({1, 2, 3, 4}), h({5, 6, 7, 8})});
+    BOOST_REQUIRE(all && all->size() == 1);
+    BOOST_REQUIRE(equal(all->front(), make_range(0, 1000)));
+
+    // A replica which split the range differently, or has no tree.
+    BOOST_REQUIRE(!find_unsynced_ranges(tree, {h({1, 2, 3, 4}), h({1, 2, 3})}));
+    BOOST_REQUIRE(!find_unsynced_ranges(tree, {h({1, 2, 3, 4}), {}}));
+}
+
+SEASTAR_THREAD_TEST_CASE(test_hash_trees_memory_limit) {
+    simple_schema ss;
+    auto& s = *ss.schema();
+    const unsigned nr_leaves = 16;
+    const auto tree_size = repair_hash_tree(make_range(0, 1000), s.version(), nr_leaves).memory_usage();
+    repair_hash_trees trees(tree_size * 2);
+
+    auto a = trees.get(s, make_range(0, 1000), nr_leaves);
+    auto b = trees.get(s, make_range(1000, 2000), nr_leaves);
+    set_all_hashes(*a);
+    set_all_hashes(*b);
+    BOOST_REQUIRE_EQUAL(trees.size(), 2);
+
+    // The tree of a range is kept, with its hashes.
+    BOOST_REQUIRE(trees.get(s, make_range(0, 1000), nr_leaves) == a);
+
+    // b is the least recently used, so it makes room for c.
+    auto c = trees.get(s, make_range(2000, 3000), nr_leaves);
+    BOOST_REQUIRE_EQUAL(trees.size(), 2);
+    BOOST_REQUIRE_LE(trees.memory_usage(), tree_size * 2);
+    BOOST_REQUIRE(trees.get(s, make_range(0, 1000), nr_leaves) == a);
+    auto b2 = trees.get(s, make_range(1000, 2000), nr_leaves);
+    BOOST_REQUIRE(b2 != b);
+    BOOST_REQUIRE(!b2->at(0).hash);
+
+    // A tree replaces the trees it overlaps with.
+    trees.get(s, make_range(500, 1500), nr_leaves);
+    BOOST_REQUIRE_EQUAL(trees.size(), 1);
+    BOOST_REQUIRE_EQUAL(trees.memory_usage(), tree_size);
+
+    // Changes invalidate the leaves of the trees of the table which they touch.
+    auto d = trees.get(s, make_range(500, 1500), nr_leaves);
+    set_all_hashes(*d);
+    auto dk = ss.make_pkey(0);
+    trees.invalidate(s, dht::partition_range::make_singular(dk));
+    auto token = dk.token();
+    for (size_t i = 0; i < d->size(); ++i) {
+        BOOST_REQUIRE_EQUAL(bool(d->at(i).hash), !d->leaf_range(i).contains(token, dht::token_comparator()));
+    }
+}
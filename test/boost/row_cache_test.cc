@@ -37,6 +37,7 @@
 #include "row_cache.hh"
 #include <seastar/core/thread.hh>
 #include "memtable.hh"
+#include "database.hh"
 #include "partition_slice_builder.hh"
 #include "test/lib/memtable_snapshot_source.hh"
 #include "test/lib/log.hh"
@@ -165,6 +166,54 @@ SEASTAR_TEST_CASE(test_cache_works_after_clearing) {
     });
 }
 
+SEASTAR_TEST_CASE(test_hot_partition_tracking) {
+    return seastar::async([] {
+        simple_schema ss;
+        auto s = ss.schema();
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        auto keys = ss.make_pkeys(3);
+
+        auto mt = make_lw_shared<memtable>(s);
+        for (auto& key : keys) {
+            mutation m(s, key);
+            ss.add_row(m, ss.make_ckey(1), "v");
+            mt->apply(m);
+        }
+
+        cache_tracker tracker;
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+        BOOST_REQUIRE(cache.hot_partitions(2).empty());
+        cache.track_hot_partitions(2);
+
+        auto read = [&] (const dht::decorated_key& key, unsigned times) {
+            auto range = dht::partition_range::make_singular(key);
+            for (unsigned i = 0; i < times; ++i) {
+                cache.make_reader(s, semaphore.make_permit(), range).close().get();
+            }
+        };
+        read(keys[2], 8);
+        read(keys[0], 40);
+        read(keys[1], 20);
+
+        // Range scans are not taken into account.
+        for (unsigned i = 0; i < 40; ++i) {
+            cache.make_reader(s, semaphore.make_permit(), query::full_partition_range).close().get();
+        }
+
+        // Neither are the reads which warm up the cache.
+        auto warm_up_slice = s->full_slice();
+        warm_up_slice.options.set<query::partition_slice::option::cache_warm_up>();
+        for (unsigned i = 0; i < 80; ++i) {
+            cache.make_reader(s, semaphore.make_permit(), dht::partition_range::make_singular(keys[2]), warm_up_slice).close().get();
+        }
+
+        auto hot = cache.hot_partitions(2);
+        BOOST_REQUIRE_EQUAL(hot.size(), 2);
+        BOOST_REQUIRE(hot[0].equal(*s, keys[0]));
+        BOOST_REQUIRE(hot[1].equal(*s, keys[1]));
+    });
+}
+
 class partition_counting_reader final : public delegating_reader {
     int& _counter;
     bool _count_fill_buffer = true;
@@ -878,6 +927,162 @@ SEASTAR_TEST_CASE(test_eviction) {
     });
 }
 
+SEASTAR_TEST_CASE(test_second_chance_eviction_keeps_entries_read_again) {
+    return seastar::async([] {
+        auto s = make_schema();
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        auto mt = make_lw_shared<memtable>(s);
+
+        cache_tracker tracker;
+        tracker.set_eviction_policy(eviction_policy::second_chance);
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+
+        auto read = [&] (const dht::decorated_key& key) {
+            auto pr = dht::partition_range::make_singular(key);
+            auto rd = cache.make_reader(s, semaphore.make_permit(), pr);
+            auto close_rd = deferred_close(rd);
+            rd.consume_pausable([] (mutation_fragment) { return stop_iteration::no; }).get();
+        };
+
+        const size_t n = 1000;
+        std::vector<dht::decorated_key> hot_keys;
+        for (size_t i = 0; i < n; i++) {
+            auto m = make_new_mutation(s);
+            hot_keys.emplace_back(m.decorated_key());
+            cache.populate(m);
+        }
+        for (auto&& key : hot_keys) {
+            read(key);
+        }
+        // Entries read only once, as if by a scan, inserted after the hot ones.
+        for (size_t i = 0; i < n; i++) {
+            cache.populate(make_new_mutation(s));
+        }
+
+        while (tracker.partitions() > n) {
+            if (tracker.region().evict_some() == memory::reclaiming_result::reclaimed_nothing) {
+                break;
+            }
+        }
+
+        auto hits_before = tracker.get_stats().partition_hits;
+        for (auto&& key : hot_keys) {
+            read(key);
+        }
+        // Each eviction gives a bounded number of second chances, so the first
+        // evictions may hit hot entries.
+        BOOST_REQUIRE_GE(tracker.get_stats().partition_hits - hits_before, n * 9 / 10);
+    });
+}
+
+SEASTAR_TEST_CASE(test_eviction_down_to_memory_quota) {
+    return seastar::async([] {
+        auto s = make_schema();
+        auto mt = make_lw_shared<memtable>(s);
+
+        cache_tracker tracker;
+        const size_t quota = 1024 * 1024;
+        tracker.set_memory_quota(quota);
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+
+        for (int i = 0; i < 100000; i++) {
+            cache.populate(make_new_mutation(s));
+        }
+
+        // Eviction happens in the background.
+        for (int i = 0; i < 1000 && tracker.region().occupancy().used_space() > quota; ++i) {
+            seastar::sleep(std::chrono::milliseconds(1)).get();
+        }
+
+        BOOST_REQUIRE_LE(tracker.region().occupancy().used_space(), quota);
+        BOOST_REQUIRE_GT(tracker.get_stats().partition_evictions, 0);
+        BOOST_REQUIRE_EQUAL(cache.partition_evictions(), tracker.get_stats().partition_evictions);
+    });
+}
+
+SEASTAR_TEST_CASE(test_scans_populate_only_partitions_read_again) {
+    return seastar::async([] {
+        auto s = make_schema();
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        auto mt = make_lw_shared<memtable>(s);
+
+        std::vector<mutation> partitions;
+        for (int i = 0; i < 3; ++i) {
+            partitions.push_back(make_new_mutation(s));
+            mt->apply(partitions.back());
+        }
+        std::sort(partitions.begin(), partitions.end(), mutation_decorated_key_less_comparator());
+
+        cache_tracker tracker;
+        tracker.set_admission_filter(1024);
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+
+        auto initial = tracker.partitions();
+
+        // A partition read by a single-partition query is always admitted.
+        auto pr = dht::partition_range::make_singular(partitions[0].decorated_key());
+        assert_that(cache.make_reader(s, semaphore.make_permit(), pr))
+            .produces(partitions[0])
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(tracker.partitions(), initial + 1);
+
+        // The first scan reads the other partitions for the first time.
+        assert_that(cache.make_reader(s, semaphore.make_permit(), query::full_partition_range))
+            .produces(partitions)
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(tracker.partitions(), initial + 1);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().admission_rejections, 2);
+
+        // The second scan reads them again, so they are admitted.
+        assert_that(cache.make_reader(s, semaphore.make_permit(), query::full_partition_range))
+            .produces(partitions)
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(tracker.partitions(), initial + 3);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().admission_rejections, 2);
+    });
+}
+
+SEASTAR_TEST_CASE(test_cold_partitions_are_compressed_and_read_back) {
+    return seastar::async([] {
+        simple_schema ss;
+        auto s = ss.schema();
+        tests::reader_concurrency_semaphore_wrapper semaphore;
+        auto mt = make_lw_shared<memtable>(s);
+
+        std::vector<mutation> partitions;
+        for (auto&& pk : ss.make_pkeys(4)) {
+            mutation m(s, pk);
+            for (int i = 0; i < 10; ++i) {
+                ss.add_row(m, ss.make_ckey(i), sstring(100, 'v'));
+            }
+            partitions.push_back(m);
+            mt->apply(m);
+        }
+
+        cache_tracker tracker;
+        tracker.set_cold_partition_compression(true);
+        row_cache cache(s, snapshot_source_from_snapshot(mt->as_data_source()), tracker);
+        for (auto&& m : partitions) {
+            cache.populate(m);
+        }
+
+        // Compression starts in the background when the cache starts evicting.
+        tracker.get_lru().evict();
+        for (int i = 0; i < 1000 && !tracker.get_stats().compressed_partitions; ++i) {
+            seastar::sleep(std::chrono::milliseconds(1)).get();
+        }
+        BOOST_REQUIRE_GT(tracker.get_stats().compressed_partitions, 0);
+        BOOST_REQUIRE_GT(tracker.get_stats().compressed_bytes, 0);
+
+        assert_that(cache.make_reader(s, semaphore.make_permit(), query::full_partition_range))
+            .produces(partitions)
+            .produces_end_of_stream();
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().compressed_partitions, 0);
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().compressed_bytes, 0);
+        BOOST_REQUIRE_GT(tracker.get_stats().partition_decompressions, 0);
+    });
+}
+
 #ifndef SEASTAR_DEFAULT_ALLOCATOR // Depends on eviction, which is absent with the std allocator
 
 SEASTAR_TEST_CASE(test_eviction_from_invalidated) {
@@ -1125,6 +1330,41 @@ SEASTAR_TEST_CASE(test_update) {
     });
 }
 
+SEASTAR_TEST_CASE(test_update_with_columnar_rows) {
+    return seastar::async([] {
+        simple_schema ss;
+        auto s = ss.schema();
+        auto cache_mt = make_lw_shared<memtable>(s);
+
+        cache_tracker tracker;
+        row_cache cache(s, snapshot_source_from_snapshot(cache_mt->as_data_source()), tracker, is_continuous::yes);
+
+        auto keys = ss.make_pkeys(2);
+        mutation in_cache(s, keys[0]);
+        ss.add_row(in_cache, ss.make_ckey(0), "v0");
+        cache.populate(in_cache);
+
+        dirty_memory_manager mgr;
+        table_stats tbl_stats;
+        auto mt = make_lw_shared<memtable>(s, mgr, tbl_stats, nullptr, current_scheduling_group(), true);
+        mutation not_in_cache(s, keys[1]);
+        for (uint32_t i = 1; i < columnar_rows::max_chunk_rows + 10; ++i) {
+            for (auto* m : {&in_cache, &not_in_cache}) {
+                mutation row(s, m->decorated_key());
+                ss.add_row(row, ss.make_ckey(i), format("v{}", i));
+                m->apply(row);
+                mt->apply(row);
+            }
+        }
+
+        cache.update(row_cache::external_updater([] {}), *mt).get();
+
+        // The underlying source is empty, so the rows can only come from the cache.
+        verify_has(cache, in_cache);
+        verify_has(cache, not_in_cache);
+    });
+}
+
 #ifndef SEASTAR_DEFAULT_ALLOCATOR
 
 static inline
@@ -1251,6 +1251,73 @@ SEASTAR_TEST_CASE(tombstone_purge_test) {
     });
 }
 
+SEASTAR_TEST_CASE(tombstone_purge_compaction_test) {
+    BOOST_REQUIRE(smp::count == 1);
+    return test_env::do_with_async([] (test_env& env) {
+        auto builder = schema_builder("tests", "tombstone_purge_compaction")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type);
+        builder.set_gc_grace_seconds(0);
+        auto s = builder.build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, sstables::get_highest_sstable_version(), big);
+        };
+
+        api::timestamp_type next_timestamp = 1;
+        auto make_insert = [&] (partition_key key) {
+            mutation m(s, key);
+            m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), next_timestamp++);
+            return m;
+        };
+        auto make_delete = [&] (partition_key key) {
+            mutation m(s, key);
+            m.partition().apply(tombstone(next_timestamp++, gc_clock::now()));
+            return m;
+        };
+
+        auto alpha = partition_key::from_exploded(*s, {to_bytes("alpha")});
+        auto beta = partition_key::from_exploded(*s, {to_bytes("beta")});
+        auto gamma = partition_key::from_exploded(*s, {to_bytes("gamma")});
+
+        auto alpha_insert = make_insert(alpha);
+        auto alpha_delete = make_delete(alpha);
+        auto beta_delete = make_delete(beta);
+        auto gamma_insert = make_insert(gamma);
+
+        auto old_sst = make_sstable_containing(sst_gen, {alpha_insert});
+        auto sst = make_sstable_containing(sst_gen, {alpha_delete, beta_delete, gamma_insert});
+        sst->set_sstable_level(1);
+        auto run_id = utils::make_random_uuid();
+        sstables::test(sst).set_run_identifier(run_id);
+
+        forward_jump_clocks(std::chrono::seconds(1));
+
+        column_family_for_tests cf(env.manager(), s);
+        auto stop_cf = deferred_stop(cf);
+        column_family_test(cf).add_sstable(old_sst);
+        column_family_test(cf).add_sstable(sst);
+
+        auto desc = sstables::compaction_descriptor({ sst }, cf->get_sstable_set(), default_priority_class(),
+                sst->get_sstable_level(), sstables::compaction_descriptor::default_max_sstable_bytes, sst->run_identifier(),
+                sstables::compaction_type_options::make_purge());
+        auto result = compact_sstables(std::move(desc), *cf, sst_gen).get0().new_sstables;
+
+        // The tombstone of beta is purged, while the one of alpha is kept as it shadows
+        // data in another sstable. The output takes the place of the input in its run.
+        BOOST_REQUIRE_EQUAL(result.size(), 1);
+        BOOST_REQUIRE_EQUAL(result[0]->get_sstable_level(), 1);
+        BOOST_REQUIRE(result[0]->run_identifier() == run_id);
+        auto expected = std::vector<mutation>{alpha_delete, gamma_insert};
+        std::sort(expected.begin(), expected.end(), mutation_decorated_key_less_comparator());
+        assert_that(sstable_reader(result[0], s, env.make_reader_permit()))
+                .produces(expected[0])
+                .produces(expected[1])
+                .produces_end_of_stream();
+    });
+}
+
 SEASTAR_TEST_CASE(sstable_rewrite) {
     BOOST_REQUIRE(smp::count == 1);
     return test_setup::do_with_tmp_directory([] (test_env& env, sstring tmpdir_path) {
@@ -1882,6 +1949,62 @@ SEASTAR_TEST_CASE(size_tiered_beyond_max_threshold_test) {
   });
 }
 
+SEASTAR_TEST_CASE(incremental_compaction_strategy_test) {
+  BOOST_REQUIRE_EQUAL(smp::count, 1);
+  return test_env::do_with([] (test_env& env) {
+    column_family_for_tests cf(env.manager());
+    std::map<sstring, sstring> options = {{"sstable_size_in_mb", "1"}};
+    auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::incremental, options);
+    const uint64_t fragment_size = 1024 * 1024;
+
+    auto keys = token_generation_for_current_shard(12);
+    int64_t gen = 1;
+    std::vector<sstables::shared_sstable> candidates;
+    // Five runs of two disjoint fragments each, and one much larger run in a tier of its own.
+    std::vector<std::vector<sstables::shared_sstable>> runs;
+    for (auto r = 0; r < 6; r++) {
+        auto run_id = utils::make_random_uuid();
+        auto fragments = r < 5 ? 2 : 1;
+        auto size = r < 5 ? fragment_size / 2 : 100 * fragment_size;
+        runs.emplace_back();
+        for (auto f = 0; f < fragments; f++) {
+            auto sst = env.make_sstable(cf->schema(), "", gen++, la, big);
+            sstables::test(sst).set_values_for_leveled_strategy(size, 0, 0, keys[f * 2].first, keys[f * 2 + 1].first);
+            sstables::test(sst).set_run_identifier(run_id);
+            column_family_test(cf).add_sstable(sst);
+            runs.back().push_back(sst);
+            candidates.push_back(sst);
+        }
+    }
+    // A fragment of the first run is being compacted, so the whole run is left out.
+    auto compacting = runs[0][0];
+    candidates.erase(std::find(candidates.begin(), candidates.end(), compacting));
+
+    auto table_s = make_table_state_for_test(cf, env);
+    auto strategy_c = make_strategy_control_for_test(false);
+    auto desc = cs.get_sstables_for_compaction(*table_s, *strategy_c, candidates);
+    BOOST_REQUIRE_EQUAL(desc.sstables.size(), 8);
+    BOOST_REQUIRE_EQUAL(desc.max_sstable_bytes, fragment_size);
+    auto selected = std::unordered_set<sstables::shared_sstable>(desc.sstables.begin(), desc.sstables.end());
+    for (auto r = 1; r < 5; r++) {
+        for (auto& sst : runs[r]) {
+            BOOST_REQUIRE(selected.contains(sst));
+        }
+    }
+
+    // Below min_threshold runs, nothing is compacted.
+    candidates.erase(std::find(candidates.begin(), candidates.end(), runs[1][0]));
+    desc = cs.get_sstables_for_compaction(*table_s, *strategy_c, candidates);
+    BOOST_REQUIRE(desc.sstables.empty());
+
+    // Major compaction writes fragments too, so that it releases its input incrementally.
+    desc = cs.get_major_compaction_job(*table_s, candidates);
+    BOOST_REQUIRE_EQUAL(desc.max_sstable_bytes, fragment_size);
+
+    return cf.stop_and_keep_alive();
+  });
+}
+
 SEASTAR_TEST_CASE(sstable_expired_data_ratio) {
     return test_env::do_with_async([] (test_env& env) {
         auto tmp = tmpdir();
@@ -1985,6 +2108,16 @@ SEASTAR_TEST_CASE(sstable_expired_data_ratio) {
             auto descriptor = cs.get_sstables_for_compaction(*table_s, *strategy_c, { sst });
             BOOST_REQUIRE(descriptor.sstables.size() == 0);
         }
+        // incremental compaction rewrites the fragment into its own run
+        {
+            auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::incremental, options);
+            sstables::test(sst).set_data_file_write_time(db_clock::time_point::min());
+            column_family_test(cf).add_sstable(sst);
+            auto descriptor = cs.get_sstables_for_compaction(*table_s, *strategy_c, { sst });
+            BOOST_REQUIRE(descriptor.sstables.size() == 1);
+            BOOST_REQUIRE(descriptor.sstables.front() == sst);
+            BOOST_REQUIRE(descriptor.run_identifier == sst->run_identifier());
+        }
     });
 }
 
@@ -2101,6 +2234,73 @@ SEASTAR_TEST_CASE(compaction_correctness_with_partitioned_sstable_set) {
     });
 }
 
+SEASTAR_TEST_CASE(compaction_with_sub_range_parallelism_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto builder = schema_builder("tests", "sub_range_parallelism")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type);
+        auto s = builder.build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, sstables::get_highest_sstable_version(), big);
+        };
+
+        auto make_insert = [&] (const std::pair<sstring, dht::token>& p, api::timestamp_type ts) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes(p.first)}));
+            m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(ts)), ts);
+            return m;
+        };
+
+        // Four overlapping sstables, with each key written to two of them.
+        auto keys = token_generation_for_current_shard(64);
+        std::vector<std::vector<mutation>> muts(4);
+        std::vector<mutation> expected;
+        for (size_t i = 0; i < keys.size(); i++) {
+            muts[i % 4].push_back(make_insert(keys[i], 1));
+            muts[(i + 1) % 4].push_back(make_insert(keys[i], 2));
+            expected.push_back(make_insert(keys[i], 2));
+        }
+        std::vector<shared_sstable> ssts;
+        for (auto& m : muts) {
+            ssts.push_back(make_sstable_containing(sst_gen, std::move(m)));
+        }
+
+        column_family_for_tests cf(env.manager(), s);
+        auto close_cf = deferred_stop(cf);
+        auto desc = sstables::compaction_descriptor(std::move(ssts), cf->get_sstable_set(), default_priority_class());
+        desc.parallelism = 4;
+        auto run_id = desc.run_identifier;
+        auto result = compact_sstables(std::move(desc), *cf, sst_gen).get0().new_sstables;
+
+        // Each sub-range was written to an sstable of its own, and together they make up
+        // a single run of disjoint sstables.
+        BOOST_REQUIRE_EQUAL(result.size(), 4);
+        std::sort(result.begin(), result.end(), [&] (const shared_sstable& a, const shared_sstable& b) {
+            return a->get_first_decorated_key().less_compare(*s, b->get_first_decorated_key());
+        });
+        for (size_t i = 0; i < result.size(); i++) {
+            BOOST_REQUIRE(result[i]->run_identifier() == run_id);
+            if (i > 0) {
+                BOOST_REQUIRE(result[i - 1]->get_last_decorated_key().less_compare(*s, result[i]->get_first_decorated_key()));
+            }
+        }
+        std::vector<mutation> actual;
+        for (auto& sst : result) {
+            auto reader = sstable_reader(sst, s, env.make_reader_permit());
+            auto close_reader = deferred_close(reader);
+            while (auto m = read_mutation_from_flat_mutation_reader(reader).get0()) {
+                actual.push_back(std::move(*m));
+            }
+        }
+        std::sort(expected.begin(), expected.end(), mutation_decorated_key_less_comparator());
+        BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            BOOST_REQUIRE_EQUAL(actual[i], expected[i]);
+        }
+    });
+}
+
 SEASTAR_TEST_CASE(sstable_cleanup_correctness_test) {
     return do_with_cql_env([] (auto& e) {
         return test_env::do_with_async([&db = e.local_db()] (test_env& env) {
@@ -4772,3 +4972,108 @@ SEASTAR_TEST_CASE(test_major_does_not_miss_data_in_memtable) {
                 .produces_end_of_stream();
     });
 }
+
+SEASTAR_TEST_CASE(test_mark_sstables_repaired) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto s = schema_builder("tests", "test_mark_sstables_repaired")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type)
+                .set_compaction_strategy(sstables::compaction_strategy_type::leveled)
+                .build();
+
+        auto tmp = tmpdir();
+        column_family_for_tests cf(env.manager(), s, tmp.path().string());
+        auto close_cf = deferred_stop(cf);
+        cf->disable_auto_compaction().get();
+
+        auto keys = boost::copy_range<std::vector<dht::decorated_key>>(make_local_keys(12, s)
+                | boost::adaptors::transformed([&] (const sstring& k) {
+            return dht::decorate_key(*s, partition_key::from_exploded(*s, {to_bytes(k)}));
+        }));
+        std::sort(keys.begin(), keys.end(), dht::decorated_key::less_comparator(s));
+
+        auto make_sstable = [&] (size_t first, size_t last, int level = 0, uint64_t repaired_at = 0) {
+            std::vector<mutation> muts;
+            for (auto i = first; i <= last; ++i) {
+                mutation m(s, keys[i]);
+                m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(i)), api::new_timestamp());
+                muts.push_back(std::move(m));
+            }
+            auto cfg = env.manager().configure_writer();
+            cfg.sstable_level = level;
+            if (repaired_at) {
+                cfg.repaired_at = repaired_at;
+            }
+            auto partitions = muts.size();
+            auto sst = make_sstable_easy(env, tmp.path(), make_flat_mutation_reader_from_mutations(s, env.make_reader_permit(), std::move(muts)),
+                    cfg, column_family_test::calculate_generation_for_new_table(*cf), sstables::get_highest_sstable_version(), partitions);
+            cf->add_sstable_and_update_cache(sst).get();
+            return sst;
+        };
+        auto range = [&] (size_t first, bool first_inclusive, size_t last, bool last_inclusive) {
+            return dht::token_range({{keys[first].token(), first_inclusive}}, {{keys[last].token(), last_inclusive}});
+        };
+        auto repaired_at = [&] (const shared_sstable& sst) {
+            return column_family_test::repaired_at(*cf, *sst);
+        };
+        auto to_ms = [] (db_clock::time_point tp) {
+            return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count());
+        };
+
+        auto before_write = db_clock::now() - std::chrono::hours(1);
+        auto sst_a = make_sstable(0, 2);
+        auto sst_b = make_sstable(3, 5);
+        auto sst_c = make_sstable(6, 8);
+        auto sst_d = make_sstable(9, 11);
+        // The write time of the data file has a granularity of one second.
+        auto after_write = db_clock::now() + std::chrono::seconds(1);
+
+        // Adjacent ranges cover sst_a together; it is repaired as of the oldest of them.
+        cf->mark_repaired(range(0, true, 1, true), after_write + std::chrono::seconds(1)).get();
+        BOOST_REQUIRE(!repaired_at(sst_a));
+        BOOST_REQUIRE(!sst_a->is_repaired());
+        cf->mark_repaired(range(1, false, 2, true), after_write).get();
+        BOOST_REQUIRE(repaired_at(sst_a) == after_write);
+        BOOST_REQUIRE(sst_a->is_repaired());
+        BOOST_REQUIRE_EQUAL(sst_a->get_repaired_at(), to_ms(after_write));
+
+        // Ranges which both exclude the key between them leave a gap.
+        cf->mark_repaired(range(3, true, 4, false), after_write).get();
+        cf->mark_repaired(range(4, false, 5, true), after_write).get();
+        BOOST_REQUIRE(!repaired_at(sst_b));
+        BOOST_REQUIRE(!sst_b->is_repaired());
+        // A range overlapping a recorded one replaces it and closes the gap.
+        cf->mark_repaired(range(4, true, 5, true), after_write).get();
+        BOOST_REQUIRE(repaired_at(sst_b) == after_write);
+        BOOST_REQUIRE(sst_b->is_repaired());
+
+        // A repair which started before the sstable was written may have missed its data.
+        cf->mark_repaired(range(6, true, 8, true), before_write).get();
+        BOOST_REQUIRE(!repaired_at(sst_c));
+        BOOST_REQUIRE(!sst_c->is_repaired());
+        cf->mark_repaired(range(6, true, 8, true), after_write).get();
+        BOOST_REQUIRE(sst_c->is_repaired());
+
+        // Compacting sstables are left alone, their output is marked when the compaction is done.
+        auto cm = compaction_manager_test(cf._data->cm);
+        cm.register_compacting_sstables({sst_d});
+        cf->mark_repaired(range(9, true, 11, true), after_write).get();
+        BOOST_REQUIRE(repaired_at(sst_d));
+        BOOST_REQUIRE(!sst_d->is_repaired());
+        cm.deregister_compacting_sstables({sst_d});
+        cf->mark_repaired(range(9, true, 11, true), after_write).get();
+        BOOST_REQUIRE(sst_d->is_repaired());
+
+        // Repaired and unrepaired sstables are leveled separately: a leveled sstable which
+        // overlaps repaired ones of its level goes back to L0 when it becomes repaired.
+        auto repaired_l1 = make_sstable(0, 5, 1, to_ms(after_write));
+        auto overlapping_l1 = make_sstable(3, 8, 1);
+        auto disjoint_l1 = make_sstable(9, 11, 1);
+        BOOST_REQUIRE(repaired_l1->is_repaired());
+        cf->mark_repaired(range(0, true, 11, true), after_write + std::chrono::seconds(2)).get();
+        BOOST_REQUIRE(overlapping_l1->is_repaired());
+        BOOST_REQUIRE_EQUAL(overlapping_l1->get_sstable_level(), 0);
+        BOOST_REQUIRE(disjoint_l1->is_repaired());
+        BOOST_REQUIRE_EQUAL(disjoint_l1->get_sstable_level(), 1);
+    });
+}
@@ -68,6 +68,7 @@
 #include <boost/range/algorithm.hpp>
 #include <boost/icl/interval_map.hpp>
 #include "test/lib/test_services.hh"
+#include "gms/feature_service.hh"
 #include "test/lib/cql_test_env.hh"
 #include "test/lib/reader_concurrency_semaphore.hh"
 #include "test/lib/sstable_utils.hh"
@@ -320,6 +321,62 @@ SEASTAR_TEST_CASE(datafile_generation_15) {
     return sstable_compression_test(compressor::deflate, 15);
 }
 
+SEASTAR_TEST_CASE(test_zstd_dictionary_compression) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto s = schema_builder(some_keyspace, some_column_family)
+                .with_column("p1", utf8_type, column_kind::partition_key)
+                .with_column("r1", utf8_type)
+                .set_compressor_params(compression_parameters({
+                    {"sstable_compression", "org.apache.cassandra.io.compress.ZstdCompressor"},
+                    {"dictionary_size_in_kb", "4"},
+                }))
+                .build();
+        auto& r1_col = *s->get_column_definition("r1");
+
+        // Many small, similar rows, so that the first chunks give the
+        // dictionary enough to be trained on.
+        std::vector<mutation> mutations;
+        for (auto i = 0; i < 5000; i++) {
+            auto key = partition_key::from_exploded(*s, {to_bytes(format("user-{}", i))});
+            mutation m(s, key);
+            auto value = format("email=user-{}@example.com;country=PL;plan=premium;status=active;created=2021-11-{:02d}", i, i % 28 + 1);
+            m.set_clustered_cell(clustering_key::make_empty(), r1_col, make_atomic_cell(utf8_type, to_bytes(value)));
+            mutations.push_back(std::move(m));
+        }
+        std::sort(mutations.begin(), mutations.end(), mutation_decorated_key_less_comparator());
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = 1] () mutable {
+            return env.make_sstable(s, tmp.path().string(), gen++, sstables::get_highest_sstable_version(), big);
+        };
+
+        // Not all nodes may read a dictionary yet, the sstable is compressed without one.
+        if (!test_feature_service.cluster_supports_zstd_dictionary_compression()) {
+            auto sst = make_sstable_containing(sst_gen, mutations);
+            BOOST_REQUIRE(!sst->has_component(component_type::CompressionDictionary));
+            BOOST_REQUIRE(sst->get_compression().dictionary.data.value.empty());
+            test_feature_service.enable({gms::features::ZSTD_DICTIONARY_COMPRESSION});
+        }
+
+        auto sst = make_sstable_containing(sst_gen, mutations);
+        auto gen = sst->generation();
+        BOOST_REQUIRE(sst->has_component(component_type::CompressionDictionary));
+        BOOST_REQUIRE(!sst->get_compression().dictionary.data.value.empty());
+
+        sst = env.reusable_sst(s, tmp.path().string(), gen).get0();
+        BOOST_REQUIRE(!sst->get_compression().dictionary.data.value.empty());
+        // Readers load the dictionary for uncompression only.
+        auto c = get_sstable_compressor(sst->get_compression());
+        char in[16] = {}, out[128];
+        BOOST_REQUIRE_THROW(c->compress(in, sizeof(in), out, sizeof(out)), std::runtime_error);
+        auto assertions = assert_that(sstable_reader(sst, s, env.make_reader_permit()));
+        for (auto& m : mutations) {
+            assertions.produces(m);
+        }
+        assertions.produces_end_of_stream();
+    });
+}
+
 SEASTAR_TEST_CASE(datafile_generation_16) {
     return test_setup::do_with_tmp_directory([] (test_env& env, sstring tmpdir_path) {
         auto s = uncompressed_schema();
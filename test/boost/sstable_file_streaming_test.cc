@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <seastar/testing/test_case.hh>
+#include <seastar/testing/thread_test_case.hh>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/seastar.hh>
+#include <seastar/util/closeable.hh>
+
+#include "database.hh"
+#include "sstables/sstables.hh"
+#include "streaming/stream_manager.hh"
+#include "streaming/stream_sstable_files.hh"
+#include "streaming/stream_transfer_task.hh"
+#include "test/lib/cql_assertions.hh"
+#include "test/lib/cql_test_env.hh"
+#include "test/lib/simple_schema.hh"
+#include "test/lib/sstable_utils.hh"
+#include "test/lib/tmpdir.hh"
+
+#include <filesystem>
+
+using namespace sstables;
+using streaming::stream_sstable_file_chunk;
+using streaming::stream_sstable_files_cmd;
+
+static std::vector<shared_sstable> sorted(std::vector<shared_sstable> ssts) {
+    std::sort(ssts.begin(), ssts.end(), [] (const shared_sstable& a, const shared_sstable& b) {
+        return a->generation() < b->generation();
+    });
+    return ssts;
+}
+
+SEASTAR_TEST_CASE(test_select_sstables_for_file_streaming) {
+    return test_env::do_with_async([] (test_env& env) {
+        simple_schema ss;
+        auto s = ss.schema();
+        auto dir = tmpdir();
+        auto keys = ss.make_pkeys(10);
+        std::sort(keys.begin(), keys.end(), dht::decorated_key::less_comparator(s));
+
+        unsigned gen = 1;
+        auto make_sstable_with_keys = [&] (size_t first, size_t last) {
+            std::vector<mutation> muts;
+            for (auto i = first; i <= last; ++i) {
+                mutation m(s, keys[i]);
+                ss.add_row(m, ss.make_ckey(1), "v");
+                muts.push_back(std::move(m));
+            }
+            return make_sstable_containing([&] {
+                return env.make_sstable(s, dir.path().string(), gen++, sstables::get_highest_sstable_version(), big);
+            }, std::move(muts));
+        };
+        auto sst_a = make_sstable_with_keys(0, 3);
+        auto sst_b = make_sstable_with_keys(4, 7);
+        auto sst_shared = make_sstable_with_keys(8, 9);
+        sstables::test(sst_shared).set_shards({0, 1});
+        BOOST_REQUIRE(sst_shared->is_shared());
+        sstable_list all{sst_a, sst_b, sst_shared};
+
+        auto range = [&] (size_t first, size_t last) {
+            return dht::token_range::make(keys[first].token(), keys[last].token());
+        };
+
+        // Everything is streamed: only the shared sstable is left for the other shards to send.
+        BOOST_REQUIRE(sorted(select_sstables_for_file_streaming(all, {dht::token_range::make_open_ended_both_sides()}))
+                == sorted({sst_a, sst_b}));
+
+        // sst_b is only partially within the streamed range.
+        BOOST_REQUIRE(select_sstables_for_file_streaming(all, {range(0, 5)}) == std::vector<shared_sstable>{sst_a});
+
+        // sst_b is covered by the ranges together, but not by any single one of them.
+        BOOST_REQUIRE(select_sstables_for_file_streaming(all, {range(0, 5), range(6, 9)}) == std::vector<shared_sstable>{sst_a});
+
+        // Ranges ending exactly at the first and last keys of the sstables still contain them.
+        BOOST_REQUIRE(sorted(select_sstables_for_file_streaming(all, {range(0, 3), range(4, 7), range(8, 9)}))
+                == sorted({sst_a, sst_b}));
+
+        BOOST_REQUIRE(select_sstables_for_file_streaming(all, {range(1, 2)}).empty());
+        BOOST_REQUIRE(select_sstables_for_file_streaming(all, {}).empty());
+    });
+}
+
+using file_stream = std::vector<std::tuple<stream_sstable_file_chunk, stream_sstable_files_cmd>>;
+
+// Reads the component files of the sstables of the table on this shard the way
+// STREAM_SSTABLE_FILES sends them, each file in one chunk, the TOC last.
+static file_stream read_sstable_files(table& cf) {
+    file_stream ret;
+    auto& s = *cf.schema();
+    for (auto& sst : *cf.get_sstables()) {
+        auto components = sst->all_components();
+        std::stable_partition(components.begin(), components.end(), [] (auto& c) { return c.first != component_type::TOC; });
+        for (auto& [type, component] : components) {
+            auto filename = sstable::filename(sst->get_dir(), s.ks_name(), s.cf_name(), sst->get_version(), sst->generation(),
+                    sstable::format_types::big, component);
+            auto in = make_file_input_stream(open_file_dma(filename, open_flags::ro).get0());
+            auto close_in = deferred_close(in);
+            bytes data;
+            while (auto buf = in.read().get0()) {
+                data.append(reinterpret_cast<const bytes::value_type*>(buf.get()), buf.size());
+            }
+            ret.emplace_back(stream_sstable_file_chunk{sst->generation(), to_string(sst->get_version()), component, std::move(data)},
+                    stream_sstable_files_cmd::file_data);
+        }
+    }
+    return ret;
+}
+
+static streaming::stream_sstable_file_source make_source(file_stream chunks) {
+    return [chunks = std::move(chunks), i = size_t(0)] () mutable {
+        using item = std::optional<std::tuple<stream_sstable_file_chunk, stream_sstable_files_cmd>>;
+        if (i == chunks.size()) {
+            return make_ready_future<item>(std::nullopt);
+        }
+        return make_ready_future<item>(std::move(chunks[i++]));
+    };
+}
+
+static size_t count_files(const std::filesystem::path& dir) {
+    if (!std::filesystem::exists(dir)) {
+        return 0;
+    }
+    return std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator());
+}
+
+SEASTAR_TEST_CASE(test_receive_and_load_sstable_files) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE ks.src (p int PRIMARY KEY, v int)").get();
+        e.execute_cql("CREATE TABLE ks.dst (p int PRIMARY KEY, v int)").get();
+        for (int i = 0; i < 10; ++i) {
+            e.execute_cql(format("INSERT INTO ks.src (p, v) VALUES ({}, {})", i, i)).get();
+        }
+        e.db().invoke_on_all([] (database& db) {
+            return db.find_column_family("ks", "src").flush();
+        }).get();
+
+        // Each shard of the sender streams its own sstables.
+        std::vector<file_stream> streams;
+        for (unsigned shard = 0; shard < smp::count; ++shard) {
+            auto stream = smp::submit_to(shard, [&db = e.db()] {
+                return seastar::async([&db] {
+                    return read_sstable_files(db.local().find_column_family("ks", "src"));
+                });
+            }).get0();
+            if (!stream.empty()) {
+                stream.emplace_back(stream_sstable_file_chunk{}, stream_sstable_files_cmd::end_of_stream);
+                streams.push_back(std::move(stream));
+            }
+        }
+        BOOST_REQUIRE(!streams.empty());
+
+        auto& sm = e.stream_manager().local();
+        auto& dst = e.local_db().find_column_family("ks", "dst");
+        auto plan_id = utils::make_random_uuid();
+        auto from = gms::inet_address("127.0.0.2");
+        auto plan_dir = std::filesystem::path(dst.dir()) / sstables::streaming_dir / format("{}-{}", plan_id, from);
+
+        // A transfer which fails partway leaves nothing behind: the sender reports an
+        // error after sending some files...
+        auto failed = streams.front();
+        failed.resize(failed.size() / 2);
+        failed.emplace_back(stream_sstable_file_chunk{}, stream_sstable_files_cmd::error);
+        BOOST_REQUIRE_THROW(sm.receive_sstable_files(plan_id, from, dst, dst.schema(), make_source(std::move(failed))).get(), std::runtime_error);
+        BOOST_REQUIRE_EQUAL(count_files(plan_dir), 0);
+
+        // ...or the stream is cut off before its end.
+        auto truncated = streams.front();
+        truncated.pop_back();
+        BOOST_REQUIRE_THROW(sm.receive_sstable_files(plan_id, from, dst, dst.schema(), make_source(std::move(truncated))).get(), std::runtime_error);
+        BOOST_REQUIRE_EQUAL(count_files(plan_dir), 0);
+
+        sm.load_sstable_files(plan_id, from, dst.schema()->id(), streaming::stream_reason::bootstrap).get();
+        BOOST_REQUIRE(!std::filesystem::exists(plan_dir));
+        assert_that(e.execute_cql("SELECT * FROM ks.dst").get0()).is_rows().is_empty();
+
+        // The same streams, complete this time, are written and then loaded into the table.
+        plan_id = utils::make_random_uuid();
+        plan_dir = std::filesystem::path(dst.dir()) / sstables::streaming_dir / format("{}-{}", plan_id, from);
+        for (auto& stream : streams) {
+            sm.receive_sstable_files(plan_id, from, dst, dst.schema(), make_source(stream)).get();
+        }
+        BOOST_REQUIRE_GT(count_files(plan_dir), 0);
+        sm.load_sstable_files(plan_id, from, dst.schema()->id(), streaming::stream_reason::bootstrap).get();
+        BOOST_REQUIRE(!std::filesystem::exists(plan_dir));
+
+        std::vector<std::vector<bytes_opt>> expected;
+        for (int i = 0; i < 10; ++i) {
+            expected.push_back({int32_type->decompose(i), int32_type->decompose(i)});
+        }
+        assert_that(e.execute_cql("SELECT p, v FROM ks.dst").get0()).is_rows().with_rows_ignore_order(std::move(expected));
+    });
+}
@@ -928,6 +928,129 @@ SEASTAR_TEST_CASE(test_has_partition_key) {
     });
 }
 
+SEASTAR_TEST_CASE(test_skipping_unselected_values) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto s = schema_builder("ks", "cf")
+                .with_column("pk", utf8_type, column_kind::partition_key)
+                .with_column("ck", utf8_type, column_kind::clustering_key)
+                .with_column("s1", utf8_type, column_kind::static_column)
+                .with_column("v1", utf8_type)
+                .with_column("v2", utf8_type)
+                .with_column("v3", int32_type)
+                .build();
+        auto dir = tmpdir();
+        auto pk = partition_key::from_exploded(*s, {to_bytes("key")});
+        auto ck1 = clustering_key::from_exploded(*s, {to_bytes("ck1")});
+        auto ck2 = clustering_key::from_exploded(*s, {to_bytes("ck2")});
+
+        mutation m(s, pk);
+        m.set_static_cell("s1", data_value("static"), 1);
+        m.partition().apply_insert(*s, ck1, 1);
+        m.set_clustered_cell(ck1, "v1", data_value("a"), 1);
+        m.set_clustered_cell(ck1, "v2", data_value(sstring(4096, 'b')), 1);
+        m.set_clustered_cell(ck1, "v3", data_value(int32_t(7)), 1);
+        // No row marker, only an unselected column keeps the row alive.
+        m.set_clustered_cell(ck2, "v2", data_value("c"), 1);
+
+        auto sst = make_sstable_containing([&] {
+            return env.make_sstable(s, dir.path().string(), 1, sstables::get_highest_sstable_version(), big);
+        }, {m});
+
+        auto slice = partition_slice_builder(*s)
+                .with_no_static_columns()
+                .with_regular_column("v1")
+                .build();
+        slice.options.set<query::partition_slice::option::skip_unselected_values>();
+
+        auto pr = dht::partition_range::make_singular(m.decorated_key());
+        auto rd = sst->make_reader(s, env.make_reader_permit(), pr, slice);
+        auto close_rd = deferred_close(rd);
+        auto mo = read_mutation_from_flat_mutation_reader(rd).get0();
+        BOOST_REQUIRE(mo);
+
+        auto& v1 = *s->get_column_definition("v1");
+        auto& v2 = *s->get_column_definition("v2");
+        auto& v3 = *s->get_column_definition("v3");
+        auto& s1 = *s->get_column_definition("s1");
+        auto cell_value = [] (const row& r, const column_definition& def) {
+            auto* c = r.find_cell(def.id);
+            BOOST_REQUIRE(c);
+            auto ac = c->as_atomic_cell(def);
+            BOOST_REQUIRE(ac.is_live());
+            return ac.value().linearize();
+        };
+
+        // Selected cells are intact, unselected ones of a row kept alive by its marker
+        // are kept with their metadata but no value.
+        auto& row1 = mo->partition().clustered_row(*s, ck1);
+        BOOST_REQUIRE(row1.marker().is_live());
+        BOOST_REQUIRE_EQUAL(cell_value(row1.cells(), v1), to_bytes("a"));
+        BOOST_REQUIRE(cell_value(row1.cells(), v2).empty());
+        BOOST_REQUIRE(cell_value(row1.cells(), v3).empty());
+
+        // The liveness of rows without a marker may depend on their cells, which are read in full.
+        BOOST_REQUIRE_EQUAL(cell_value(mo->partition().static_row().get(), s1), to_bytes("static"));
+        auto& row2 = mo->partition().clustered_row(*s, ck2);
+        BOOST_REQUIRE_EQUAL(cell_value(row2.cells(), v2), to_bytes("c"));
+        BOOST_REQUIRE(row2.is_live(*s));
+    });
+}
+
+// Cells with the same timestamp are reconciled by their values before their expiry,
+// so skipping values must not let an expired cell win over a live one.
+SEASTAR_TEST_CASE(test_skipping_unselected_values_keeps_reconciliation) {
+    return test_env::do_with_async([] (test_env& env) {
+        auto s = schema_builder("ks", "cf")
+                .with_column("pk", utf8_type, column_kind::partition_key)
+                .with_column("ck", utf8_type, column_kind::clustering_key)
+                .with_column("v1", utf8_type)
+                .with_column("v2", utf8_type)
+                .build();
+        auto dir = tmpdir();
+        auto pk = partition_key::from_exploded(*s, {to_bytes("key")});
+        auto ck = clustering_key::from_exploded(*s, {to_bytes("ck")});
+        auto& v2 = *s->get_column_definition("v2");
+        const api::timestamp_type ts = 1;
+
+        // Rows without a marker, kept alive only by v2, which isn't selected. The non-expiring
+        // cell has the larger value, so it wins over the expired one.
+        mutation live(s, pk);
+        live.set_clustered_cell(ck, v2, atomic_cell::make_live(*utf8_type, ts, utf8_type->decompose(sstring("b"))));
+        mutation expired(s, pk);
+        expired.set_clustered_cell(ck, v2, atomic_cell::make_live(*utf8_type, ts, utf8_type->decompose(sstring("a")),
+                gc_clock::now() - std::chrono::hours(1), std::chrono::seconds(1)));
+
+        unsigned gen = 1;
+        auto make_sstable = [&] (mutation m) {
+            return make_sstable_containing([&] {
+                return env.make_sstable(s, dir.path().string(), gen++, sstables::get_highest_sstable_version(), big);
+            }, {std::move(m)});
+        };
+        auto sst_live = make_sstable(live);
+        auto sst_expired = make_sstable(expired);
+
+        auto slice = partition_slice_builder(*s)
+                .with_regular_column("v1")
+                .build();
+        slice.options.set<query::partition_slice::option::skip_unselected_values>();
+
+        auto pr = dht::partition_range::make_singular(live.decorated_key());
+        auto permit = env.make_reader_permit();
+        auto rd = make_combined_reader(s, permit,
+                sst_live->make_reader(s, permit, pr, slice),
+                sst_expired->make_reader(s, permit, pr, slice));
+        auto close_rd = deferred_close(rd);
+        auto mo = read_mutation_from_flat_mutation_reader(rd).get0();
+        BOOST_REQUIRE(mo);
+
+        auto& row = mo->partition().clustered_row(*s, ck);
+        BOOST_REQUIRE(row.is_live(*s, tombstone(), gc_clock::now()));
+        auto cell = row.cells().find_cell(v2.id)->as_atomic_cell(v2);
+        BOOST_REQUIRE(!cell.is_live_and_has_ttl());
+        BOOST_REQUIRE_EQUAL(cell.value().linearize(), utf8_type->decompose(sstring("b")));
+    });
+}
+
 static std::unique_ptr<index_reader> get_index_reader(shared_sstable sst, reader_permit permit) {
     return std::make_unique<index_reader>(sst, std::move(permit), default_priority_class(),
                                           tracing::trace_state_ptr(), use_caching::yes);
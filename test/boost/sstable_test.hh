@@ -74,6 +74,10 @@ class column_family_test {
     future<stop_iteration> try_flush_memtable_to_sstable(lw_shared_ptr<memtable> mt) {
         return _cf->try_flush_memtable_to_sstable(mt, sstable_write_permit::unconditional());
     }
+
+    static std::optional<db_clock::time_point> repaired_at(const column_family& cf, const sstables::sstable& sst) {
+        return cf.repaired_at(sst);
+    }
 };
 
 namespace sstables {
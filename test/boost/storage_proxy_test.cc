@@ -112,3 +112,31 @@ SEASTAR_TEST_CASE(test_get_restricted_ranges) {
         });
     });
 }
+
+SEASTAR_TEST_CASE(test_range_scan_concurrency) {
+    using service::range_scan_concurrency;
+
+    // Without an estimate, the caller falls back to its own default.
+    BOOST_REQUIRE(!range_scan_concurrency::ranges_for_rows(100, std::nullopt));
+    // 100 rows at 10 rows per range, plus the 10% margin.
+    BOOST_REQUIRE_EQUAL(*range_scan_concurrency::ranges_for_rows(100, 10.0f), 11);
+    BOOST_REQUIRE_EQUAL(*range_scan_concurrency::ranges_for_rows(1, 1000.0f), 1);
+    BOOST_REQUIRE_EQUAL(*range_scan_concurrency::ranges_for_rows(1000, 0.0f), range_scan_concurrency::max_ranges);
+
+    BOOST_REQUIRE_EQUAL(range_scan_concurrency::next_limit(8, 1.0f), 16);
+    BOOST_REQUIRE_EQUAL(range_scan_concurrency::next_limit(8, 2.5f), 8);
+    BOOST_REQUIRE_EQUAL(range_scan_concurrency::next_limit(8, 5.0f), 4);
+    BOOST_REQUIRE_EQUAL(range_scan_concurrency::next_limit(1, 5.0f), 1);
+    BOOST_REQUIRE_EQUAL(range_scan_concurrency::next_limit(range_scan_concurrency::max_ranges, 1.0f), range_scan_concurrency::max_ranges);
+
+    service::replica_latency_tracker tracker;
+    const auto ep = gms::inet_address("127.0.0.2");
+    BOOST_REQUIRE(!tracker.get(ep));
+    BOOST_REQUIRE_EQUAL(tracker.update(ep, std::chrono::microseconds(100)), 1.0f);
+    BOOST_REQUIRE_EQUAL(tracker.update(ep, std::chrono::microseconds(400)), 4.0f);
+    BOOST_REQUIRE_EQUAL(*tracker.get(ep), 175.0f);
+    tracker.remove(ep);
+    BOOST_REQUIRE(!tracker.get(ep));
+
+    return make_ready_future<>();
+}
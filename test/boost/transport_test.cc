@@ -19,10 +19,19 @@
  * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <numeric>
+
 #include <seastar/testing/thread_test_case.hh>
 
+#include "cql3/column_identifier.hh"
+#include "cql3/column_specification.hh"
+#include "cql3/cql_config.hh"
+#include "cql3/query_options.hh"
+#include "cql3/result_set.hh"
 #include "transport/request.hh"
 #include "transport/response.hh"
+#include "transport/segment.hh"
+#include "utils/buffer_input_stream.hh"
 
 #include "test/lib/random_utils.hh"
 
@@ -165,3 +174,148 @@ SEASTAR_THREAD_TEST_CASE(test_response_request_reader) {
     BOOST_CHECK_EQUAL(req.read_short(), 1);
     BOOST_CHECK_EQUAL(req.read_string(), "zed");
 }
+
+static temporary_buffer<char> linearize(const net::packet& p) {
+    temporary_buffer<char> buf(p.len());
+    auto out = buf.get_write();
+    for (auto& f : p.fragments()) {
+        out = std::copy_n(f.base, f.size, out);
+    }
+    return buf;
+}
+
+SEASTAR_THREAD_TEST_CASE(test_segment_framing) {
+    for (bool compress : {false, true}) {
+        // Small envelopes, which share segments, and one which must be split across segments.
+        std::vector<bytes> envelopes;
+        for (int i = 0; i < 1000; ++i) {
+            envelopes.push_back(bytes(tests::random::get_int<size_t>(9, 300), int8_t(i)));
+        }
+        envelopes.push_back(tests::random::get_bytes(3 * cql_transport::max_segment_payload_size + 17));
+        for (int i = 0; i < 10; ++i) {
+            envelopes.push_back(tests::random::get_bytes(tests::random::get_int<size_t>(9, 300)));
+        }
+
+        auto writer = cql_transport::segment_writer(compress);
+        std::vector<char> expected;
+        for (auto& e : envelopes) {
+            auto data = reinterpret_cast<const char*>(e.data());
+            writer.write(net::packet(data, e.size()));
+            expected.insert(expected.end(), data, data + e.size());
+        }
+        BOOST_REQUIRE_LT(writer.segment_count(), 10);
+        auto wire = linearize(writer.finish());
+
+        auto in = cql_transport::make_segment_input_stream(make_buffer_input_stream(wire.share()), compress);
+        auto received = in.read_exactly(expected.size()).get0();
+        BOOST_REQUIRE(std::equal(expected.begin(), expected.end(), received.begin(), received.end()));
+        BOOST_REQUIRE(in.read().get0().empty());
+        in.close().get();
+
+        for (size_t offset : {size_t(1), wire.size() / 2}) {
+            auto corrupted = temporary_buffer<char>(wire.get(), wire.size());
+            corrupted.get_write()[offset] ^= 0x10;
+            auto in = cql_transport::make_segment_input_stream(make_buffer_input_stream(std::move(corrupted)), compress);
+            BOOST_REQUIRE_THROW(in.read_exactly(expected.size()).get(), exceptions::protocol_exception);
+            in.close().get();
+        }
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_segment_crc_known_answers) {
+    // Computed independently of this code, with the reference CRC24 algorithm of the protocol and zlib.
+    BOOST_REQUIRE_EQUAL(cql_transport::segment_header_crc24(0, 3), 0x7de777);
+    // A self-contained segment of 31 bytes.
+    BOOST_REQUIRE_EQUAL(cql_transport::segment_header_crc24(0x2001f, 3), 0xfcfa53);
+    BOOST_REQUIRE_EQUAL(cql_transport::segment_header_crc24(0x1ffff, 3), 0xfe9138);
+    // A self-contained compressed segment of 20 bytes, which uncompress to 31 bytes.
+    BOOST_REQUIRE_EQUAL(cql_transport::segment_header_crc24(0x4003e0014, 5), 0x12ec23);
+
+    BOOST_REQUIRE_EQUAL(cql_transport::segment_payload_crc32("", 0), 0x44777ed3);
+    BOOST_REQUIRE_EQUAL(cql_transport::segment_payload_crc32("123456789", 9), 0xe2a261a7);
+    std::array<char, 256> all_bytes;
+    std::iota(all_bytes.begin(), all_bytes.end(), 0);
+    BOOST_REQUIRE_EQUAL(cql_transport::segment_payload_crc32(all_bytes.data(), all_bytes.size()), 0x214de79b);
+}
+
+SEASTAR_THREAD_TEST_CASE(test_v5_messages) {
+    static constexpr auto version = 5;
+    auto make_column = [] (sstring name, data_type type) {
+        return make_lw_shared<cql3::column_specification>("ks", "cf", ::make_shared<cql3::column_identifier>(name, true), type);
+    };
+    auto metadata = cql3::metadata({make_column("pk", int32_type), make_column("v", utf8_type)});
+    auto metadata_id = metadata.calculate_metadata_id();
+    BOOST_REQUIRE_EQUAL(metadata_id.size(), 16);
+    BOOST_REQUIRE_EQUAL(cql3::metadata({make_column("pk", int32_type), make_column("v", utf8_type)}).calculate_metadata_id(), metadata_id);
+    BOOST_REQUIRE_NE(cql3::metadata({make_column("pk", int32_type), make_column("v", int32_type)}).calculate_metadata_id(), metadata_id);
+    BOOST_REQUIRE_NE(cql3::metadata({make_column("pk", int32_type)}).calculate_metadata_id(), metadata_id);
+
+    auto read_body = [] (cql_transport::response& res, auto&& read) {
+        auto msg = res.make_message(version, cql_transport::cql_compression::none).release();
+        auto total_length = msg.len();
+        auto fbufs = fragmented_temporary_buffer(msg.release(), total_length);
+        bytes_ostream linearization_buffer;
+        auto req = cql_transport::request_reader(fbufs.get_istream(), linearization_buffer);
+        BOOST_REQUIRE_EQUAL(unsigned(uint8_t(req.read_byte())), version | 0x80);
+        req.read_byte(); // flags
+        req.read_short(); // stream
+        req.read_byte(); // opcode
+        BOOST_REQUIRE_EQUAL(req.read_int() + 9, total_length);
+        read(req);
+    };
+
+    // The body of an EXECUTE: the flags of its options are an [int], and they may carry a keyspace.
+    auto execute = cql_transport::response(1, cql_transport::cql_binary_opcode::EXECUTE, tracing::trace_state_ptr());
+    execute.write_short_bytes(bytes(16, int8_t(1)));
+    execute.write_short_bytes(metadata_id);
+    execute.write_consistency(db::consistency_level::ONE);
+    // VALUES, SKIP_METADATA, PAGE_SIZE and KEYSPACE
+    execute.write_int(0x87);
+    execute.write_short(1);
+    execute.write_value(bytes_opt(int32_type->decompose(7)));
+    execute.write_int(100);
+    execute.write_string("ks");
+    read_body(execute, [&] (cql_transport::request_reader& req) {
+        BOOST_REQUIRE_EQUAL(req.read_short_bytes(), bytes(16, int8_t(1)));
+        BOOST_REQUIRE_EQUAL(req.read_short_bytes(), metadata_id);
+        std::optional<sstring_view> keyspace;
+        auto options = req.read_options(version, cql_serialization_format::latest(), cql3::default_cql_config, &keyspace);
+        BOOST_REQUIRE(options->get_consistency() == db::consistency_level::ONE);
+        BOOST_REQUIRE(options->skip_metadata());
+        BOOST_REQUIRE_EQUAL(options->get_page_size(), 100);
+        BOOST_REQUIRE_EQUAL(options->get_values_count(), 1);
+        BOOST_REQUIRE(keyspace == sstring_view("ks"));
+    });
+
+    // The KEYSPACE and NOW_IN_SECONDS flags don't exist before v5.
+    auto old_execute = cql_transport::response(1, cql_transport::cql_binary_opcode::EXECUTE, tracing::trace_state_ptr());
+    old_execute.write_consistency(db::consistency_level::ONE);
+    old_execute.write_byte(0x80);
+    old_execute.write_string("ks");
+    read_body(old_execute, [&] (cql_transport::request_reader& req) {
+        BOOST_REQUIRE_THROW(req.read_options(4, cql_serialization_format::latest(), cql3::default_cql_config), exceptions::protocol_exception);
+    });
+
+    // Rows whose metadata the client skips, as its copy of it is current.
+    auto rows = cql_transport::response(1, cql_transport::cql_binary_opcode::RESULT, tracing::trace_state_ptr());
+    rows.write(metadata, true);
+    read_body(rows, [&] (cql_transport::request_reader& req) {
+        BOOST_REQUIRE_EQUAL(req.read_int(), 0x4); // NO_METADATA
+        BOOST_REQUIRE_EQUAL(req.read_int(), 2);
+    });
+
+    // Rows whose metadata changed since the client prepared the statement.
+    auto changed_rows = cql_transport::response(1, cql_transport::cql_binary_opcode::RESULT, tracing::trace_state_ptr());
+    changed_rows.write(metadata, false, metadata_id);
+    read_body(changed_rows, [&] (cql_transport::request_reader& req) {
+        BOOST_REQUIRE_EQUAL(req.read_int(), 0x8); // METADATA_CHANGED
+        BOOST_REQUIRE_EQUAL(req.read_int(), 2);
+        BOOST_REQUIRE_EQUAL(req.read_short_bytes(), metadata_id);
+        for (auto name : {"pk", "v"}) {
+            BOOST_REQUIRE_EQUAL(req.read_string(), "ks");
+            BOOST_REQUIRE_EQUAL(req.read_string(), "cf");
+            BOOST_REQUIRE_EQUAL(req.read_string(), name);
+            req.read_short(); // type
+        }
+    });
+}
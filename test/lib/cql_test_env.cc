@@ -142,6 +142,8 @@ class single_node_cql_env : public cql_test_env {
     sharded<qos::service_level_controller>& _sl_controller;
     sharded<service::migration_manager>& _mm;
     sharded<db::batchlog_manager>& _batchlog_manager;
+    sharded<streaming::stream_manager>& _stream_manager;
+    sharded<netw::messaging_service>& _ms;
 private:
     struct core_local_state {
         service::client_state client_state;
@@ -190,7 +192,9 @@ class single_node_cql_env : public cql_test_env {
             sharded<service::migration_notifier>& mnotifier,
             sharded<service::migration_manager>& mm,
             sharded<qos::service_level_controller> &sl_controller,
-            sharded<db::batchlog_manager>& batchlog_manager)
+            sharded<db::batchlog_manager>& batchlog_manager,
+            sharded<streaming::stream_manager>& stream_manager,
+            sharded<netw::messaging_service>& ms)
             : _db(db)
             , _qp(qp)
             , _auth_service(auth_service)
@@ -200,6 +204,8 @@ class single_node_cql_env : public cql_test_env {
             , _sl_controller(sl_controller)
             , _mm(mm)
             , _batchlog_manager(batchlog_manager)
+            , _stream_manager(stream_manager)
+            , _ms(ms)
     {
         adjust_rlimit();
     }
@@ -403,6 +409,14 @@ class single_node_cql_env : public cql_test_env {
         return _batchlog_manager;
     }
 
+    virtual sharded<streaming::stream_manager>& stream_manager() override {
+        return _stream_manager;
+    }
+
+    virtual sharded<netw::messaging_service>& messaging_service() override {
+        return _ms;
+    }
+
     virtual future<> refresh_client_state() override {
         return _core_local.invoke_on_all([] (core_local_state& state) {
             return state.client_state.maybe_update_per_service_level_params();
@@ -794,7 +808,7 @@ class single_node_cql_env : public cql_test_env {
                 // The default user may already exist if this `cql_test_env` is starting with previously populated data.
             }
 
-            single_node_cql_env env(db, qp, auth_service, view_builder, view_update_generator, mm_notif, mm, std::ref(sl_controller), bm);
+            single_node_cql_env env(db, qp, auth_service, view_builder, view_update_generator, mm_notif, mm, std::ref(sl_controller), bm, stream_manager, ms);
             env.start().get();
             auto stop_env = defer([&env] { env.stop().get(); });
 
@@ -48,10 +48,18 @@ namespace db::view {
 class view_builder;
 }
 
+namespace streaming {
+class stream_manager;
+}
+
 namespace auth {
 class service;
 }
 
+namespace netw {
+class messaging_service;
+}
+
 namespace cql3 {
     class query_processor;
 }
@@ -168,6 +176,11 @@ class cql_test_env {
 
     virtual sharded<db::batchlog_manager>& batchlog_manager() = 0;
 
+    virtual sharded<streaming::stream_manager>& stream_manager() = 0;
+
+    // Doesn't listen unless a test starts it, so that tests can run in parallel.
+    virtual sharded<netw::messaging_service>& messaging_service() = 0;
+
     virtual future<> refresh_client_state() = 0;
 
     data_dictionary::database data_dictionary();
@@ -195,6 +195,10 @@ class test {
         _sst->_run_identifier = identifier;
     }
 
+    void set_shards(std::vector<unsigned> shards) {
+        _sst->_shards = std::move(shards);
+    }
+
     future<> store() {
         _sst->_recognized_components.erase(component_type::Index);
         _sst->_recognized_components.erase(component_type::Data);
@@ -360,6 +364,14 @@ class compaction_manager_test {
     sstables::compaction_data& register_compaction(utils::UUID output_run_id = {}, column_family* cf = nullptr);
 
     void deregister_compaction(const sstables::compaction_data& c);
+
+    void register_compacting_sstables(const std::vector<sstables::shared_sstable>& sstables) {
+        _cm.register_compacting_sstables(sstables);
+    }
+
+    void deregister_compacting_sstables(const std::vector<sstables::shared_sstable>& sstables) {
+        _cm.deregister_compacting_sstables(sstables);
+    }
 };
 
 future<compaction_result> compact_sstables(sstables::compaction_descriptor descriptor, column_family& cf,
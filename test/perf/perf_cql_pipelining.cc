@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Measures the throughput of a node serving many small pipelined CQL requests.
+//
+// Opens a number of connections to a running node and keeps a fixed number of
+// requests in flight on each of them, sending a new request on a stream as soon
+// as the response to the previous one arrives. The responses written per socket
+// write can be followed with the node's scylla_transport_responses_written and
+// scylla_transport_response_writes metrics.
+
+#include <boost/range/irange.hpp>
+#include <seastar/core/app-template.hh>
+#include <seastar/core/coroutine.hh>
+#include <seastar/core/reactor.hh>
+#include <seastar/core/unaligned.hh>
+#include <seastar/core/when_all.hh>
+#include <seastar/net/api.hh>
+#include <seastar/net/inet_address.hh>
+#include <seastar/net/byteorder.hh>
+#include "seastarx.hh"
+#include "utils/estimated_histogram.hh"
+
+using clk = std::chrono::steady_clock;
+
+namespace {
+
+constexpr uint8_t cql_version = 0x04;
+constexpr size_t frame_header_size = 9;
+
+enum class opcode : uint8_t {
+    error = 0x00,
+    startup = 0x01,
+    ready = 0x02,
+    authenticate = 0x03,
+    query = 0x07,
+    result = 0x08,
+};
+
+class frame_writer {
+    sstring _body;
+public:
+    void write_short(uint16_t n) {
+        auto v = net::hton(n);
+        _body.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+    void write_int(int32_t n) {
+        auto v = net::hton(n);
+        _body.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+    void write_byte(uint8_t b) {
+        _body.append(reinterpret_cast<const char*>(&b), 1);
+    }
+    void write_string(std::string_view s) {
+        write_short(s.size());
+        _body.append(s.data(), s.size());
+    }
+    void write_long_string(std::string_view s) {
+        write_int(s.size());
+        _body.append(s.data(), s.size());
+    }
+    sstring finish(int16_t stream, opcode op) const {
+        sstring frame = uninitialized_string(frame_header_size + _body.size());
+        auto p = frame.data();
+        *p++ = cql_version;
+        *p++ = 0;
+        auto s = net::hton(uint16_t(stream));
+        p = std::copy_n(reinterpret_cast<const char*>(&s), sizeof(s), p);
+        *p++ = char(op);
+        auto len = net::hton(uint32_t(_body.size()));
+        p = std::copy_n(reinterpret_cast<const char*>(&len), sizeof(len), p);
+        std::copy(_body.begin(), _body.end(), p);
+        return frame;
+    }
+};
+
+struct frame_header {
+    int16_t stream;
+    opcode op;
+    uint32_t length;
+};
+
+frame_header parse_header(const temporary_buffer<char>& buf) {
+    auto p = buf.get();
+    frame_header h;
+    h.stream = int16_t(net::ntoh(read_unaligned<uint16_t>(p + 2)));
+    h.op = opcode(p[4]);
+    h.length = net::ntoh(read_unaligned<uint32_t>(p + 5));
+    return h;
+}
+
+struct stats {
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    utils::estimated_histogram latency;
+};
+
+class connection {
+    connected_socket _socket;
+    input_stream<char> _in;
+    output_stream<char> _out;
+    sstring _query;
+    std::vector<clk::time_point> _sent_at;
+    stats& _stats;
+public:
+    connection(connected_socket socket, sstring query, unsigned depth, stats& st)
+        : _socket(std::move(socket))
+        , _in(_socket.input())
+        , _out(_socket.output())
+        , _query(std::move(query))
+        , _sent_at(depth)
+        , _stats(st)
+    { }
+
+    // Reads a response frame, skipping its body.
+    future<frame_header> read_frame() {
+        auto buf = co_await _in.read_exactly(frame_header_size);
+        if (buf.size() != frame_header_size) {
+            throw std::runtime_error("connection closed by the server");
+        }
+        auto h = parse_header(buf);
+        co_await _in.skip(h.length);
+        co_return h;
+    }
+
+    future<> startup() {
+        frame_writer w;
+        w.write_short(1);
+        w.write_string("CQL_VERSION");
+        w.write_string("3.0.0");
+        co_await _out.write(w.finish(0, opcode::startup));
+        co_await _out.flush();
+        auto h = co_await read_frame();
+        if (h.op == opcode::authenticate) {
+            throw std::runtime_error("the node requires authentication, which is not supported");
+        }
+        if (h.op != opcode::ready) {
+            throw std::runtime_error(format("unexpected response to STARTUP: opcode {}", int(h.op)));
+        }
+    }
+
+    future<> send_query(int16_t stream) {
+        frame_writer w;
+        w.write_long_string(_query);
+        w.write_short(0x0001); // consistency ONE
+        w.write_byte(0);
+        _sent_at[stream] = clk::now();
+        return _out.write(w.finish(stream, opcode::query));
+    }
+
+    future<> run(clk::time_point deadline) {
+        for (auto stream : boost::irange<int16_t>(0, _sent_at.size())) {
+            co_await send_query(stream);
+        }
+        co_await _out.flush();
+        size_t in_flight = _sent_at.size();
+        while (in_flight) {
+            auto h = co_await read_frame();
+            auto now = clk::now();
+            ++_stats.requests;
+            if (h.op != opcode::result) {
+                ++_stats.errors;
+            }
+            _stats.latency.add(std::chrono::duration_cast<std::chrono::microseconds>(now - _sent_at[h.stream]).count());
+            if (now < deadline) {
+                co_await send_query(h.stream);
+                co_await _out.flush();
+            } else {
+                --in_flight;
+            }
+        }
+        co_await _out.close();
+    }
+};
+
+}
+
+static future<> run_test(const boost::program_options::variables_map& cfg) {
+    auto addr = socket_address(net::inet_address(cfg["host"].as<sstring>()), cfg["port"].as<uint16_t>());
+    auto nr_connections = cfg["connections"].as<unsigned>();
+    auto depth = cfg["depth"].as<unsigned>();
+    if (depth == 0 || depth > std::numeric_limits<int16_t>::max()) {
+        throw std::invalid_argument("depth must be between 1 and 32767");
+    }
+    auto query = cfg["query"].as<sstring>();
+    auto duration = std::chrono::seconds(cfg["seconds"].as<unsigned>());
+
+    stats st;
+    std::vector<std::unique_ptr<connection>> connections;
+    for (unsigned i = 0; i < nr_connections; ++i) {
+        auto c = std::make_unique<connection>(co_await connect(addr), query, depth, st);
+        co_await c->startup();
+        connections.push_back(std::move(c));
+    }
+
+    auto start = clk::now();
+    std::vector<future<>> runs;
+    for (auto& c : connections) {
+        runs.push_back(c->run(start + duration));
+    }
+    auto results = co_await when_all(runs.begin(), runs.end());
+    auto elapsed = std::chrono::duration<double>(clk::now() - start).count();
+    for (auto& f : results) {
+        if (f.failed()) {
+            std::cout << format("connection failed: {}\n", f.get_exception());
+        }
+    }
+
+    std::cout << format("connections: {}, depth: {}, requests: {}, errors: {}, throughput: {:.0f} req/s\n",
+            nr_connections, depth, st.requests, st.errors, st.requests / elapsed);
+    std::cout << format("latency [us]: mean: {}, p50: {}, p99: {}, max: {}\n",
+            st.latency.mean(), st.latency.percentile(0.5), st.latency.percentile(0.99), st.latency.max());
+}
+
+int main(int argc, char** argv) {
+    namespace bpo = boost::program_options;
+    app_template app;
+    app.add_options()
+        ("host", bpo::value<sstring>()->default_value("127.0.0.1"), "Address of the node to connect to")
+        ("port", bpo::value<uint16_t>()->default_value(9042), "CQL port of the node")
+        ("connections", bpo::value<unsigned>()->default_value(4), "Number of connections")
+        ("depth", bpo::value<unsigned>()->default_value(128), "Number of requests in flight per connection")
+        ("query", bpo::value<sstring>()->default_value("SELECT release_version FROM system.local"), "Query to send")
+        ("seconds", bpo::value<unsigned>()->default_value(10), "Duration of the test [s]")
+        ;
+
+    return app.run(argc, argv, [&app] {
+        return run_test(app.configuration());
+    });
+}
@@ -67,6 +67,7 @@ void run_test(const sstring& name, schema_ptr s, MutationGenerator&& gen) {
 
         auto prev_compacted = logalloc::memory_compacted();
         auto prev_allocated = logalloc::memory_allocated();
+        auto prev_sync_reclaims = logalloc::sync_segment_reclaims();
         auto prev_rows_processed_from_memtable = tracker.get_stats().rows_processed_from_memtable;
         auto prev_rows_merged_from_memtable = tracker.get_stats().rows_merged_from_memtable;
         auto prev_rows_dropped_from_memtable = tracker.get_stats().rows_dropped_from_memtable;
@@ -111,13 +112,15 @@ void run_test(const sstring& name, schema_ptr s, MutationGenerator&& gen) {
 
         auto compacted = logalloc::memory_compacted() - prev_compacted;
         auto allocated = logalloc::memory_allocated() - prev_allocated;
+        auto sync_reclaims = logalloc::sync_segment_reclaims() - prev_sync_reclaims;
 
-        std::cout << format("update: {:.6f} [ms], preemption: {}, cache: {:d}/{:d} [MB], alloc/comp: {:d}/{:d} [MB] (amp: {:.3f}), pr/me/dr {:d}/{:d}/{:d}\n",
+        std::cout << format("update: {:.6f} [ms], preemption: {}, cache: {:d}/{:d} [MB], alloc/comp: {:d}/{:d} [MB] (amp: {:.3f}), sync reclaims: {:d}, pr/me/dr {:d}/{:d}/{:d}\n",
             d.count() * 1000,
             slm,
             tracker.region().occupancy().used_space() / MB,
             tracker.region().occupancy().total_space() / MB,
             allocated / MB, compacted / MB, float(compacted)/allocated,
+            sync_reclaims,
             tracker.get_stats().rows_processed_from_memtable - prev_rows_processed_from_memtable,
             tracker.get_stats().rows_merged_from_memtable - prev_rows_merged_from_memtable,
             tracker.get_stats().rows_dropped_from_memtable - prev_rows_dropped_from_memtable);
@@ -72,7 +72,7 @@ static void execute_counter_update_for_key(cql_test_env& env, const bytes& key)
 };
 
 struct test_config {
-    enum class run_mode { read, write, del };
+    enum class run_mode { read, write, del, filter };
     enum class frontend_type { cql, alternator };
 
     run_mode mode;
@@ -84,6 +84,7 @@ struct test_config {
     bool counters;
     bool flush_memtables;
     unsigned operations_per_shard = 0;
+    unsigned rows_per_partition = 1;
 };
 
 std::ostream& operator<<(std::ostream& os, const test_config::run_mode& m) {
@@ -91,6 +92,7 @@ std::ostream& operator<<(std::ostream& os, const test_config::run_mode& m) {
         case test_config::run_mode::write: return os << "write";
         case test_config::run_mode::read: return os << "read";
         case test_config::run_mode::del: return os << "delete";
+        case test_config::run_mode::filter: return os << "filter";
     }
     abort();
 }
@@ -110,6 +112,7 @@ std::ostream& operator<<(std::ostream& os, const test_config& cfg) {
            << ", frontend=" << cfg.frontend
            << ", query_single_key=" << (cfg.query_single_key ? "yes" : "no")
            << ", counters=" << (cfg.counters ? "yes" : "no")
+           << ", rows_per_partition=" << cfg.rows_per_partition
            << "}";
 }
 
@@ -146,6 +149,38 @@ static std::vector<perf_result> test_read(cql_test_env& env, test_config& cfg) {
         }, cfg.concurrency, cfg.duration_in_seconds, cfg.operations_per_shard);
 }
 
+static void create_filtering_partitions(cql_test_env& env, test_config& cfg) {
+    std::cout << "Creating " << cfg.partitions << " partitions with " << cfg.rows_per_partition << " rows each..." << std::endl;
+    auto id = env.prepare("INSERT INTO cf (\"KEY\", \"CK\", \"V\", \"W\") VALUES (?, ?, ?, ?)").get0();
+    for (unsigned sequence = 0; sequence < cfg.partitions; ++sequence) {
+        for (unsigned row = 0; row < cfg.rows_per_partition; ++row) {
+            env.execute_prepared(id, {
+                    cql3::raw_value::make_value(make_key(sequence)),
+                    cql3::raw_value::make_value(int32_type->decompose(int32_t(row))),
+                    cql3::raw_value::make_value(long_type->decompose(tests::random::get_int<int64_t>(0, 999))),
+                    cql3::raw_value::make_value(int32_type->decompose(tests::random::get_int<int32_t>(0, 999)))}).get();
+        }
+    }
+
+    if (cfg.flush_memtables) {
+        std::cout << "Flushing partitions..." << std::endl;
+        env.db().invoke_on_all(&database::flush_all_memtables).get();
+    }
+}
+
+// Reads whole partitions, keeping the rows matching restrictions on regular columns
+static std::vector<perf_result> test_filter(cql_test_env& env, test_config& cfg) {
+    create_filtering_partitions(env, cfg);
+    auto id = env.prepare("select \"CK\", \"V\" from cf where \"KEY\" = ? and \"V\" >= ? and \"W\" < ? allow filtering").get0();
+    return time_parallel([&env, &cfg, id] {
+            bytes key = make_random_key(cfg);
+            return env.execute_prepared(id, {
+                    cql3::raw_value::make_value(std::move(key)),
+                    cql3::raw_value::make_value(long_type->decompose(tests::random::get_int<int64_t>(0, 999))),
+                    cql3::raw_value::make_value(int32_type->decompose(tests::random::get_int<int32_t>(0, 999)))}).discard_result();
+        }, cfg.concurrency, cfg.duration_in_seconds, cfg.operations_per_shard);
+}
+
 static std::vector<perf_result> test_write(cql_test_env& env, test_config& cfg) {
     auto id = env.prepare("UPDATE cf SET "
                            "\"C0\" = 0x8f75da6b3dcec90c8a404fb9a5f6b0621e62d39c69ba5758e5f41b78311fbb26cc7a,"
@@ -387,6 +422,8 @@ static std::vector<perf_result> do_alternator_test(std::string isolation_level,
             return test_alternator_write(state, executor, cfg);
         case test_config::run_mode::del:
             return test_alternator_delete(state, std::move(flush_memtables), executor, cfg);
+        case test_config::run_mode::filter:
+            throw std::invalid_argument("filter mode is not supported by the alternator frontend");
         };
     } catch (const alternator::api_error& e) {
         std::cout << "Alternator API error: " << e._msg << std::endl;
@@ -403,6 +440,14 @@ static std::vector<perf_result> do_cql_test(cql_test_env& env, test_config& cfg)
         if (cfg.counters) {
             return *make_counter_schema(ks_name);
         }
+        if (cfg.mode == test_config::run_mode::filter) {
+            return *schema_builder(ks_name, "cf")
+                    .with_column("KEY", bytes_type, column_kind::partition_key)
+                    .with_column("CK", int32_type, column_kind::clustering_key)
+                    .with_column("V", long_type)
+                    .with_column("W", int32_type)
+                    .build();
+        }
         return *schema_builder(ks_name, "cf")
                 .with_column("KEY", bytes_type, column_kind::partition_key)
                 .with_column("C0", bytes_type)
@@ -424,6 +469,8 @@ static std::vector<perf_result> do_cql_test(cql_test_env& env, test_config& cfg)
         }
     case test_config::run_mode::del:
         return test_delete(env, cfg);
+    case test_config::run_mode::filter:
+        return test_filter(env, cfg);
     };
     abort();
 }
@@ -454,6 +501,7 @@ void write_json_result(std::string result_file, const test_config& cfg, perf_res
     case test_config::run_mode::read: test_type = "read"; break;
     case test_config::run_mode::write: test_type = "write"; break;
     case test_config::run_mode::del: test_type = "delete"; break;
+    case test_config::run_mode::filter: test_type = "filter"; break;
     }
     if (cfg.counters) {
         test_type += "_counters";
@@ -494,6 +542,8 @@ int main(int argc, char** argv) {
         ("partitions", bpo::value<unsigned>()->default_value(10000), "number of partitions")
         ("write", "test write path instead of read path")
         ("delete", "test delete path instead of read path")
+        ("filter", "test reading partitions with ALLOW FILTERING on regular columns instead of single rows")
+        ("rows-per-partition", bpo::value<unsigned>()->default_value(100), "number of rows per partition in --filter mode")
         ("duration", bpo::value<unsigned>()->default_value(5), "test duration in seconds")
         ("query-single-key", "test reading with a single key instead of random keys")
         ("concurrency", bpo::value<unsigned>()->default_value(100), "workers per core")
@@ -535,6 +585,9 @@ int main(int argc, char** argv) {
                 cfg.mode = test_config::run_mode::write;
             } else if (app.configuration().contains("delete")) {
                 cfg.mode = test_config::run_mode::del;
+            } else if (app.configuration().contains("filter")) {
+                cfg.mode = test_config::run_mode::filter;
+                cfg.rows_per_partition = app.configuration()["rows-per-partition"].as<unsigned>();
             } else {
                 cfg.mode = test_config::run_mode::read;
             };
@@ -90,6 +90,7 @@ future<> controller::do_start_server() {
         cql_server_config.timeout_config = make_timeout_config(cfg);
         cql_server_config.max_request_size = _mem_limiter.local().total_memory();
         cql_server_config.allow_shard_aware_drivers = cfg.enable_shard_aware_drivers();
+        cql_server_config.allow_protocol_v5 = cfg.check_experimental(db::experimental_features_t::CQL_PROTOCOL_V5);
         cql_server_config.sharding_ignore_msb = cfg.murmur3_partitioner_ignore_msb_bits();
         if (cfg.native_shard_aware_transport_port.is_set()) {
             // Needed for "SUPPORTED" message
@@ -42,6 +42,7 @@ class result_message::prepared : public result_message {
     cql3::statements::prepared_statement::checked_weak_ptr _prepared;
     cql3::prepared_metadata _metadata;
     ::shared_ptr<const cql3::metadata> _result_metadata;
+    bytes _result_metadata_id;
 protected:
     prepared(cql3::statements::prepared_statement::checked_weak_ptr prepared, bool support_lwt_opt)
         : _prepared(std::move(prepared))
@@ -50,6 +51,7 @@ class result_message::prepared : public result_message {
             _prepared->partition_key_bind_indices,
             support_lwt_opt ? _prepared->statement->is_conditional() : false)
         , _result_metadata{extract_result_metadata(_prepared->statement)}
+        , _result_metadata_id{_prepared->result_metadata_id}
     { }
 public:
     cql3::statements::prepared_statement::checked_weak_ptr& get_prepared() {
@@ -64,6 +66,10 @@ class result_message::prepared : public result_message {
         return _result_metadata;
     }
 
+    const bytes& result_metadata_id() const {
+        return _result_metadata_id;
+    }
+
     class cql;
     class thrift;
 private:
@@ -204,7 +204,9 @@ class request_reader {
         PAGING_STATE,
         SERIAL_CONSISTENCY,
         TIMESTAMP,
-        NAMES_FOR_VALUES
+        NAMES_FOR_VALUES,
+        KEYSPACE,
+        NOW_IN_SECONDS
     };
 
     using options_flag_enum = super_enum<options_flag,
@@ -214,10 +216,14 @@ class request_reader {
         options_flag::PAGING_STATE,
         options_flag::SERIAL_CONSISTENCY,
         options_flag::TIMESTAMP,
-        options_flag::NAMES_FOR_VALUES
+        options_flag::NAMES_FOR_VALUES,
+        options_flag::KEYSPACE,
+        options_flag::NOW_IN_SECONDS
     >;
 public:
-    std::unique_ptr<cql3::query_options> read_options(uint8_t version, cql_serialization_format cql_ser_format, const cql3::cql_config& cql_config) {
+    // The keyspace a v5 request may carry is stored into `keyspace`, if given.
+    std::unique_ptr<cql3::query_options> read_options(uint8_t version, cql_serialization_format cql_ser_format, const cql3::cql_config& cql_config,
+            std::optional<sstring_view>* keyspace = nullptr) {
         auto consistency = read_consistency();
         if (version == 1) {
             return std::make_unique<cql3::query_options>(cql_config, consistency, std::nullopt, std::vector<cql3::raw_value_view>{},
@@ -226,7 +232,11 @@ class request_reader {
 
         assert(version >= 2);
 
-        auto flags = enum_set<options_flag_enum>::from_mask(read_byte());
+        // Protocol v5 widened the flags to an [int].
+        auto flags = enum_set<options_flag_enum>::from_mask(version < 5 ? uint8_t(read_byte()) : read_int());
+        if (version < 5 && (flags.contains<options_flag::KEYSPACE>() || flags.contains<options_flag::NOW_IN_SECONDS>())) {
+            throw exceptions::protocol_exception(format("Invalid query flags for protocol version {:d}: {:#x}", version, flags.mask()));
+        }
         std::vector<cql3::raw_value_view> values;
         std::vector<sstring_view> names;
 
@@ -264,6 +274,17 @@ class request_reader {
                 }
             }
 
+            if (flags.contains<options_flag::KEYSPACE>()) {
+                auto ks = read_string_view();
+                if (keyspace) {
+                    *keyspace = ks;
+                }
+            }
+            if (flags.contains<options_flag::NOW_IN_SECONDS>()) {
+                read_int();
+                throw exceptions::invalid_request_exception("Overriding the current time of a request is not supported");
+            }
+
             std::optional<std::vector<sstring_view>> onames;
             if (!names.empty()) {
                 onames = std::move(names);
@@ -88,7 +88,7 @@ class response {
     void write_string_multimap(std::multimap<sstring, sstring> string_map);
     void write_value(bytes_opt value);
     void write_value(std::optional<query::result_bytes_view> value);
-    void write(const cql3::metadata& m, bool skip = false);
+    void write(const cql3::metadata& m, bool skip = false, std::optional<bytes> new_metadata_id = std::nullopt);
     void write(const cql3::prepared_metadata& m, uint8_t version);
 
     // Make a non-owning scattered_message of the response. Remains valid as long
@@ -120,7 +120,7 @@ class response {
     }
 
     sstring make_frame(uint8_t version, size_t length) {
-        if (version > 0x04) {
+        if (version > 0x05) {
             throw exceptions::protocol_exception(format("Invalid or unsupported protocol version: {:d}", version));
         }
 
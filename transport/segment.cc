@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transport/segment.hh"
+
+#include <seastar/core/byteorder.hh>
+#include <seastar/core/coroutine.hh>
+#include "exceptions/exceptions.hh"
+
+#include <lz4.h>
+#include <zlib.h>
+
+namespace cql_transport {
+
+static constexpr uint32_t crc24_init = 0x875060;
+static constexpr uint32_t crc24_poly = 0x1974f0b;
+
+// The payload CRC32 is seeded with these bytes so that an all-zero payload
+// doesn't have a zero checksum.
+static constexpr uint8_t crc32_initial_bytes[] = { 0xfa, 0x2d, 0x55, 0xca };
+
+static constexpr size_t uncompressed_header_size = 6;
+static constexpr size_t compressed_header_size = 8;
+static constexpr size_t crc32_size = 4;
+static constexpr unsigned payload_length_bits = 17;
+static constexpr uint64_t payload_length_mask = (uint64_t(1) << payload_length_bits) - 1;
+
+uint32_t segment_header_crc24(uint64_t header, size_t size) {
+    uint32_t crc = crc24_init;
+    while (size--) {
+        crc ^= (header & 0xff) << 16;
+        header >>= 8;
+        for (int i = 0; i < 8; ++i) {
+            crc <<= 1;
+            if (crc & 0x1000000) {
+                crc ^= crc24_poly;
+            }
+        }
+    }
+    return crc;
+}
+
+uint32_t segment_payload_crc32(const char* data, size_t size) {
+    // The protocol uses the zlib (IEEE) polynomial, not the CRC32C which utils::crc32 computes.
+    auto crc = ::crc32(0, crc32_initial_bytes, sizeof(crc32_initial_bytes));
+    return ::crc32(crc, reinterpret_cast<const Bytef*>(data), size);
+}
+
+static uint64_t read_le_bytes(const char* p, size_t size) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < size; ++i) {
+        v |= uint64_t(uint8_t(p[i])) << (8 * i);
+    }
+    return v;
+}
+
+static void write_le_bytes(char* p, uint64_t v, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        p[i] = char(v >> (8 * i));
+    }
+}
+
+void segment_writer::write(const net::packet& envelope) {
+    const bool self_contained = envelope.len() <= max_segment_payload_size;
+    if (!_payload.empty() && (!self_contained || _payload.size() + envelope.len() > max_segment_payload_size)) {
+        write_segment(true);
+    }
+    for (auto& f : envelope.fragments()) {
+        auto p = f.base;
+        auto size = f.size;
+        while (size) {
+            if (_payload.size() == max_segment_payload_size) {
+                write_segment(false);
+            }
+            auto n = std::min(size, max_segment_payload_size - _payload.size());
+            _payload.insert(_payload.end(), p, p + n);
+            p += n;
+            size -= n;
+        }
+    }
+    if (!self_contained) {
+        write_segment(false);
+    }
+}
+
+net::packet segment_writer::finish() {
+    if (!_payload.empty()) {
+        write_segment(true);
+    }
+    return std::move(_segments);
+}
+
+void segment_writer::write_segment(bool self_contained) {
+    const size_t size = _payload.size();
+    temporary_buffer<char> segment;
+    if (_compress) {
+        const int bound = LZ4_compressBound(size);
+        segment = temporary_buffer<char>(compressed_header_size + bound + crc32_size);
+        auto body = segment.get_write() + compressed_header_size;
+        int compressed_size = LZ4_compress_default(_payload.data(), body, size, bound);
+        uint64_t uncompressed_size = size;
+        if (compressed_size <= 0 || size_t(compressed_size) >= size) {
+            // Not worth it. A zero uncompressed length tells the reader the payload is stored as is.
+            std::copy_n(_payload.data(), size, body);
+            compressed_size = size;
+            uncompressed_size = 0;
+        }
+        uint64_t header = uint64_t(compressed_size) | (uncompressed_size << payload_length_bits)
+                | (uint64_t(self_contained) << (2 * payload_length_bits));
+        header |= uint64_t(segment_header_crc24(header, 5)) << 40;
+        write_le<uint64_t>(segment.get_write(), header);
+        write_le<uint32_t>(body + compressed_size, segment_payload_crc32(body, compressed_size));
+        segment.trim(compressed_header_size + compressed_size + crc32_size);
+    } else {
+        segment = temporary_buffer<char>(uncompressed_header_size + size + crc32_size);
+        uint64_t header = uint64_t(size) | (uint64_t(self_contained) << payload_length_bits);
+        header |= uint64_t(segment_header_crc24(header, 3)) << 24;
+        write_le_bytes(segment.get_write(), header, uncompressed_header_size);
+        auto body = segment.get_write() + uncompressed_header_size;
+        std::copy_n(_payload.data(), size, body);
+        write_le<uint32_t>(body + size, segment_payload_crc32(body, size));
+    }
+    _segments = net::packet(std::move(_segments), std::move(segment));
+    ++_segment_count;
+    _payload.clear();
+}
+
+namespace {
+
+class segment_source final : public data_source_impl {
+    input_stream<char> _in;
+    bool _compressed;
+public:
+    segment_source(input_stream<char> in, bool compressed)
+        : _in(std::move(in))
+        , _compressed(compressed)
+    { }
+
+    virtual future<temporary_buffer<char>> get() override {
+        const size_t header_size = _compressed ? compressed_header_size : uncompressed_header_size;
+        for (;;) {
+            auto header_buf = co_await _in.read_exactly(header_size);
+            if (header_buf.empty()) {
+                co_return std::move(header_buf);
+            }
+            if (header_buf.size() != header_size) {
+                throw exceptions::protocol_exception("CQL segment header truncated");
+            }
+            // The header is followed by a CRC24 of it: 3 bytes for uncompressed segments,
+            // and a 5-byte header padded to 8 bytes for compressed ones.
+            const size_t crc_offset = _compressed ? 5 : 3;
+            auto raw = read_le_bytes(header_buf.get(), header_size);
+            auto header = raw & ((uint64_t(1) << (8 * crc_offset)) - 1);
+            auto crc = (raw >> (_compressed ? 40 : 24)) & 0xffffff;
+            if (crc != segment_header_crc24(header, crc_offset)) {
+                throw exceptions::protocol_exception("CQL segment header CRC mismatch");
+            }
+            size_t payload_size = header & payload_length_mask;
+            size_t uncompressed_size = _compressed ? (header >> payload_length_bits) & payload_length_mask : 0;
+
+            auto payload = co_await _in.read_exactly(payload_size + crc32_size);
+            if (payload.size() != payload_size + crc32_size) {
+                throw exceptions::protocol_exception("CQL segment payload truncated");
+            }
+            if (read_le<uint32_t>(payload.get() + payload_size) != segment_payload_crc32(payload.get(), payload_size)) {
+                throw exceptions::protocol_exception("CQL segment payload CRC mismatch");
+            }
+            payload.trim(payload_size);
+            if (uncompressed_size) {
+                temporary_buffer<char> uncompressed(uncompressed_size);
+                auto ret = LZ4_decompress_safe(payload.get(), uncompressed.get_write(), payload_size, uncompressed_size);
+                if (ret < 0 || size_t(ret) != uncompressed_size) {
+                    throw exceptions::protocol_exception("CQL segment LZ4 uncompression failure");
+                }
+                payload = std::move(uncompressed);
+            }
+            if (!payload.empty()) {
+                co_return std::move(payload);
+            }
+        }
+    }
+
+    virtual future<> close() override {
+        return _in.close();
+    }
+};
+
+}
+
+input_stream<char> make_segment_input_stream(input_stream<char> in, bool compressed) {
+    return input_stream<char>(data_source(std::make_unique<segment_source>(std::move(in), compressed)));
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <seastar/core/iostream.hh>
+#include <seastar/net/packet.hh>
+#include "seastarx.hh"
+
+#include <vector>
+
+namespace cql_transport {
+
+/**
+ * Segment framing of the native protocol v5.
+ *
+ * Once a v5 connection is established (the server answered STARTUP with
+ * READY or AUTHENTICATE), the envelopes exchanged in both directions are
+ * carried in segments. A segment holds up to max_segment_payload_size bytes
+ * of envelope data, optionally LZ4 compressed, and is protected by a CRC24
+ * of its header and a CRC32 of its payload. A self-contained segment holds
+ * one or more complete envelopes, so many small envelopes share a segment
+ * and are compressed together. An envelope which does not fit in a single
+ * segment is split across several segments which are not self-contained.
+ */
+
+constexpr size_t max_segment_payload_size = (1 << 17) - 1;
+
+// CRC24 of the `size` low-order bytes of a segment header.
+uint32_t segment_header_crc24(uint64_t header, size_t size);
+
+// CRC32 of a segment payload.
+uint32_t segment_payload_crc32(const char* data, size_t size);
+
+// Packs envelopes into segments.
+class segment_writer {
+    bool _compress;
+    std::vector<char> _payload;
+    net::packet _segments;
+    size_t _segment_count = 0;
+public:
+    explicit segment_writer(bool compress) : _compress(compress) { }
+
+    void write(const net::packet& envelope);
+
+    size_t segment_count() const { return _segment_count + !_payload.empty(); }
+
+    // Returns the segments holding all envelopes written so far.
+    net::packet finish();
+private:
+    void write_segment(bool self_contained);
+};
+
+// Returns a stream of the envelope bytes carried by the segments read from `in`.
+// Throws exceptions::protocol_exception from reads when a segment is corrupt.
+input_stream<char> make_segment_input_stream(input_stream<char> in, bool compressed);
+
+}
@@ -47,6 +47,7 @@
 #include <seastar/net/byteorder.hh>
 #include <seastar/util/lazy.hh>
 #include <seastar/core/execution_stage.hh>
+#include <seastar/util/later.hh>
 
 #include "enum_set.hh"
 #include "service/query_state.hh"
@@ -68,6 +69,7 @@
 #include "types/user.hh"
 
 #include "transport/cql_protocol_extension.hh"
+#include "transport/segment.hh"
 #include "utils/bit_cast.hh"
 #include "db/config.hh"
 
@@ -212,6 +214,14 @@ cql_server::cql_server(distributed<cql3::query_processor>& qp, auth::service& au
                         sm::description(
                             seastar::format("Holds an incrementing counter with the requests that ever blocked due to reaching the memory quota limit ({}B). "
                                             "The first derivative of this value shows how often we block due to memory exhaustion in the \"CQL transport\" component.", _max_request_size))),
+        sm::make_derive("response_writes", _stats.response_writes,
+                        sm::description("Counts the number of writes of responses to client sockets. Responses which are ready at the same time are written together, "
+                                            "so the ratio of responses_written to this shows how well responses of pipelined requests are batched.")),
+        sm::make_derive("responses_written", _stats.responses_written,
+                        sm::description("Counts the number of responses written to client sockets.")),
+        sm::make_derive("segments_written", _stats.segments_written,
+                        sm::description("Counts the number of protocol v5 segments written to client sockets. "
+                                            "Small responses written together share a segment, and are compressed together.")),
         sm::make_derive("requests_shed", _stats.requests_shed,
                         sm::description("Holds an incrementing counter with the requests that were shed due to overload (threshold configured via max_concurrent_requests_per_shard). "
                                             "The first derivative of this value shows how often we shed requests due to overload in the \"CQL transport\" component.")),
@@ -271,6 +281,11 @@ cql_server::unadvertise_connection(shared_ptr<generic_server::connection> raw_co
     return make_ready_future<>();
 }
 
+cql_protocol_version_type
+cql_server::connection::max_version() const {
+    return _server._config.allow_protocol_v5 ? segmented_version : current_version;
+}
+
 unsigned
 cql_server::connection::frame_size() const {
     if (_version < 3) {
@@ -299,7 +314,8 @@ cql_server::connection::parse_frame(temporary_buffer<char> buf) const {
         break;
     }
     case 3:
-    case 4: {
+    case 4:
+    case 5: {
         cql_binary_frame_v3 raw = read_unaligned<cql_binary_frame_v3>(buf.get());
         v3 = net::ntoh(raw);
         break;
@@ -326,7 +342,7 @@ cql_server::connection::read_frame() {
             }
             _version = buf[0];
             init_cql_serialization_format();
-            if (_version < 1 || _version > current_version) {
+            if (_version < 1 || _version > max_version()) {
                 auto client_version = _version;
                 _version = current_version;
                 throw exceptions::protocol_exception(format("Invalid or unsupported protocol version: {:d}", client_version));
@@ -671,16 +687,27 @@ future<> cql_server::connection::process_request() {
                 _pending_requests_gate.leave();
             });
             auto istream = buf.get_istream();
-            (void)_process_request_stage(this, istream, op, stream, seastar::ref(_client_state), tracing_requested, mem_permit)
-                    .then_wrapped([this, buf = std::move(buf), mem_permit, leave = std::move(leave)] (future<foreign_ptr<std::unique_ptr<cql_server::response>>> response_f) mutable {
+            auto processed = _process_request_stage(this, istream, op, stream, seastar::ref(_client_state), tracing_requested, mem_permit)
+                    .then_wrapped([this, op, buf = std::move(buf), mem_permit, leave = std::move(leave)] (future<foreign_ptr<std::unique_ptr<cql_server::response>>> response_f) mutable {
                 try {
-                    write_response(response_f.get0(), std::move(mem_permit), _compression);
+                    auto response = response_f.get0();
+                    auto res_op = response->opcode();
+                    write_response(std::move(response), std::move(mem_permit), _compression);
                     _ready_to_respond = _ready_to_respond.finally([leave = std::move(leave)] {});
+                    if (op == uint8_t(cql_binary_opcode::STARTUP) && _version >= segmented_version
+                            && (res_op == cql_binary_opcode::READY || res_op == cql_binary_opcode::AUTHENTICATE)) {
+                        enable_segment_framing();
+                    }
                 } catch (...) {
                     clogger.error("request processing failed: {}", std::current_exception());
                 }
             });
 
+            if (op == uint8_t(cql_binary_opcode::STARTUP) && _version >= segmented_version) {
+                // The requests following a successful STARTUP arrive in segments,
+                // so don't read them before the response decides the framing.
+                return processed;
+            }
             return make_ready_future<>();
           });
         });
@@ -709,7 +736,8 @@ void on_compression_buffer_use() {
 future<fragmented_temporary_buffer> cql_server::connection::read_and_decompress_frame(size_t length, uint8_t flags)
 {
     using namespace compression_buffers;
-    if (flags & cql_frame_flags::compression) {
+    // In v5, compression is applied to whole segments rather than to envelopes.
+    if ((flags & cql_frame_flags::compression) && _version < segmented_version) {
         if (_compression == cql_compression::lz4) {
             if (length < 4) {
                 throw std::runtime_error(fmt::format("CQL frame truncated: expected to have at least 4 bytes, got {}", length));
@@ -767,7 +795,7 @@ future<std::unique_ptr<cql_server::response>> cql_server::connection::process_st
          std::transform(compression.begin(), compression.end(), compression.begin(), ::tolower);
          if (compression == "lz4") {
              _compression = cql_compression::lz4;
-         } else if (compression == "snappy") {
+         } else if (compression == "snappy" && _version < segmented_version) {
              _compression = cql_compression::snappy;
          } else {
              throw exceptions::protocol_exception(format("Unknown compression algorithm: {}", compression));
@@ -854,12 +882,22 @@ future<std::unique_ptr<cql_server::response>> cql_server::connection::process_op
 
 void
 cql_server::connection::init_cql_serialization_format() {
-    _cql_serialization_format = cql_serialization_format(_version);
+    // Values are serialized the same way in v5 as in v4.
+    _cql_serialization_format = cql_serialization_format(std::min(_version, current_version));
 }
 
 std::unique_ptr<cql_server::response>
 make_result(int16_t stream, messages::result_message& msg, const tracing::trace_state_ptr& tr_state,
-        cql_protocol_version_type version, bool skip_metadata = false);
+        cql_protocol_version_type version, bool skip_metadata = false, std::optional<bytes> new_metadata_id = std::nullopt);
+
+// Protocol v5 lets QUERY, PREPARE and BATCH name the keyspace of the tables
+// they don't qualify. Only the keyspace the connection uses is supported.
+static void check_request_keyspace(const service::client_state& client_state, std::optional<sstring_view> keyspace) {
+    if (keyspace && *keyspace != client_state.get_raw_keyspace()) {
+        throw exceptions::invalid_request_exception(format("Request keyspace {} differs from the connection keyspace {}, which is not supported",
+                *keyspace, client_state.get_raw_keyspace()));
+    }
+}
 
 template<typename Process>
 future<foreign_ptr<std::unique_ptr<cql_server::response>>>
@@ -914,7 +952,9 @@ process_query_internal(service::client_state& client_state, distributed<cql3::qu
     auto query = in.read_long_string_view();
     auto q_state = std::make_unique<cql_query_state>(client_state, trace_state, std::move(permit));
     auto& query_state = q_state->query_state;
-    q_state->options = in.read_options(version, serialization_format, qp.local().get_cql_config());
+    std::optional<sstring_view> keyspace;
+    q_state->options = in.read_options(version, serialization_format, qp.local().get_cql_config(), &keyspace);
+    check_request_keyspace(client_state, keyspace);
     auto& options = *q_state->options;
     if (!cached_pk_fn_calls.empty()) {
         options.set_cached_pk_function_calls(std::move(cached_pk_fn_calls));
@@ -952,6 +992,12 @@ future<std::unique_ptr<cql_server::response>> cql_server::connection::process_pr
     ++_server._stats.prepare_requests;
 
     auto query = sstring(in.read_long_string_view());
+    if (_version >= segmented_version) {
+        auto flags = in.read_int();
+        if (flags & 0x01) {
+            check_request_keyspace(client_state, in.read_string_view());
+        }
+    }
 
     tracing::add_query(trace_state, query);
     tracing::begin(trace_state, "Preparing CQL3 query", client_state.get_client_address());
@@ -983,6 +1029,10 @@ process_execute_internal(service::client_state& client_state, distributed<cql3::
         service_permit permit, tracing::trace_state_ptr trace_state, bool init_trace, cql3::computed_function_values cached_pk_fn_calls) {
     cql3::prepared_cache_key_type cache_key(in.read_short_bytes());
     auto& id = cql3::prepared_cache_key_type::cql_id(cache_key);
+    std::optional<bytes> result_metadata_id;
+    if (version >= 5) {
+        result_metadata_id = in.read_short_bytes();
+    }
     bool needs_authorization = false;
 
     // First, try to lookup in the cache of already authorized statements. If the corresponding entry is not found there
@@ -1013,6 +1063,12 @@ process_execute_internal(service::client_state& client_state, distributed<cql3::
         options.set_cached_pk_function_calls(std::move(cached_pk_fn_calls));
     }
     auto skip_metadata = options.skip_metadata();
+    // The client's copy of the result metadata is stale, send it the current one.
+    std::optional<bytes> new_metadata_id;
+    if (skip_metadata && result_metadata_id && *result_metadata_id != prepared->result_metadata_id) {
+        skip_metadata = false;
+        new_metadata_id = prepared->result_metadata_id;
+    }
 
     if (init_trace) {
         tracing::set_page_size(trace_state, options.get_page_size());
@@ -1043,12 +1099,14 @@ process_execute_internal(service::client_state& client_state, distributed<cql3::
 
     tracing::trace(trace_state, "Processing a statement");
     return qp.local().execute_prepared(std::move(prepared), std::move(cache_key), query_state, options, needs_authorization)
-            .then([trace_state = query_state.get_trace_state(), skip_metadata, q_state = std::move(q_state), stream, version] (auto msg) {
+            .then([trace_state = query_state.get_trace_state(), skip_metadata, q_state = std::move(q_state), stream, version,
+                   new_metadata_id = std::move(new_metadata_id)] (auto msg) mutable {
         if (msg->move_to_shard()) {
             return process_fn_return_type(dynamic_pointer_cast<messages::result_message::bounce_to_shard>(msg));
         } else {
             tracing::trace(q_state->query_state.get_trace_state(), "Done processing - preparing a result");
-            return process_fn_return_type(make_foreign(make_result(stream, *msg, q_state->query_state.get_trace_state(), version, skip_metadata)));
+            return process_fn_return_type(make_foreign(make_result(stream, *msg, q_state->query_state.get_trace_state(), version, skip_metadata,
+                    std::move(new_metadata_id))));
         }
     });
 }
@@ -1076,6 +1134,7 @@ process_batch_internal(service::client_state& client_state, distributed<cql3::qu
 
     modifications.reserve(n);
     values.reserve(n);
+    bool has_query_strings = false;
 
     if (init_trace) {
         tracing::begin(trace_state, "Execute batch of CQL3 queries", client_state.get_client_address());
@@ -1091,6 +1150,7 @@ process_batch_internal(service::client_state& client_state, distributed<cql3::qu
         switch (kind) {
         case 0: {
             auto query = in.read_long_string_view();
+            has_query_strings = true;
             stmt_ptr = qp.local().get_statement(query, client_state);
             ps = stmt_ptr->checked_weak_from_this();
             if (init_trace) {
@@ -1150,8 +1210,13 @@ process_batch_internal(service::client_state& client_state, distributed<cql3::qu
     auto q_state = std::make_unique<cql_query_state>(client_state, trace_state, std::move(permit));
     auto& query_state = q_state->query_state;
     // #563. CQL v2 encodes query_options in v1 format for batch requests.
+    std::optional<sstring_view> keyspace;
     q_state->options = std::make_unique<cql3::query_options>(cql3::query_options::make_batch_options(std::move(*in.read_options(version < 3 ? 1 : version, serialization_format,
-                                                                     qp.local().get_cql_config())), std::move(values)));
+                                                                     qp.local().get_cql_config(), &keyspace)), std::move(values)));
+    // The keyspace only matters to the statements sent as query strings, prepared ones are already bound to theirs.
+    if (has_query_strings) {
+        check_request_keyspace(client_state, keyspace);
+    }
     auto& options = *q_state->options;
     if (!cached_pk_fn_calls.empty()) {
         options.set_cached_pk_function_calls(std::move(cached_pk_fn_calls));
@@ -1229,6 +1294,17 @@ std::unique_ptr<cql_server::response> cql_server::connection::make_read_timeout_
     return response;
 }
 
+void cql_server::connection::write_failures(cql_server::response& response, int32_t numfailures) const
+{
+    if (_version < segmented_version) {
+        response.write_int(numfailures);
+    } else {
+        // v5 replaced the count with a map of the failure reason of each replica,
+        // which isn't tracked, so the map is left empty.
+        response.write_int(0);
+    }
+}
+
 std::unique_ptr<cql_server::response> cql_server::connection::make_read_failure_error(int16_t stream, exceptions::exception_code err, sstring msg, db::consistency_level cl, int32_t received, int32_t numfailures, int32_t blockfor, bool data_present, const tracing::trace_state_ptr& tr_state) const
 {
     if (_version < 4) {
@@ -1240,7 +1316,7 @@ std::unique_ptr<cql_server::response> cql_server::connection::make_read_failure_
     response->write_consistency(cl);
     response->write_int(received);
     response->write_int(blockfor);
-    response->write_int(numfailures);
+    write_failures(*response, numfailures);
     response->write_byte(data_present);
     return response;
 }
@@ -1268,7 +1344,7 @@ std::unique_ptr<cql_server::response> cql_server::connection::make_mutation_writ
     response->write_consistency(cl);
     response->write_int(received);
     response->write_int(blockfor);
-    response->write_int(numfailures);
+    write_failures(*response, numfailures);
     response->write_string(format("{}", type));
     return response;
 }
@@ -1340,7 +1416,9 @@ std::unique_ptr<cql_server::response> cql_server::connection::make_supported(int
     std::multimap<sstring, sstring> opts;
     opts.insert({"CQL_VERSION", cql3::query_processor::CQL_VERSION});
     opts.insert({"COMPRESSION", "lz4"});
-    opts.insert({"COMPRESSION", "snappy"});
+    if (_version < segmented_version) {
+        opts.insert({"COMPRESSION", "snappy"});
+    }
     if (_server._config.allow_shard_aware_drivers) {
         opts.insert({"SCYLLA_SHARD", format("{:d}", this_shard_id())});
         opts.insert({"SCYLLA_NR_SHARDS", format("{:d}", smp::count)});
@@ -1375,11 +1453,13 @@ class cql_server::fmt_visitor : public messages::result_message::visitor_base {
     uint8_t _version;
     cql_server::response& _response;
     bool _skip_metadata;
+    std::optional<bytes> _new_metadata_id;
 public:
-    fmt_visitor(uint8_t version, cql_server::response& response, bool skip_metadata)
+    fmt_visitor(uint8_t version, cql_server::response& response, bool skip_metadata, std::optional<bytes> new_metadata_id)
         : _version{version}
         , _response{response}
         , _skip_metadata{skip_metadata}
+        , _new_metadata_id{std::move(new_metadata_id)}
     { }
 
     virtual void visit(const messages::result_message::void_message&) override {
@@ -1394,6 +1474,9 @@ class cql_server::fmt_visitor : public messages::result_message::visitor_base {
     virtual void visit(const messages::result_message::prepared::cql& m) override {
         _response.write_int(0x0004);
         _response.write_short_bytes(m.get_id());
+        if (_version >= 5) {
+            _response.write_short_bytes(m.result_metadata_id());
+        }
         _response.write(m.metadata(), _version);
         if (_version > 1) {
             _response.write(*m.result_metadata());
@@ -1417,7 +1500,7 @@ class cql_server::fmt_visitor : public messages::result_message::visitor_base {
     virtual void visit(const messages::result_message::rows& m) override {
         _response.write_int(0x0002);
         auto& rs = m.rs();
-        _response.write(rs.get_metadata(), _skip_metadata);
+        _response.write(rs.get_metadata(), _skip_metadata, std::move(_new_metadata_id));
         auto row_count_plhldr = _response.write_int_placeholder();
 
         class visitor {
@@ -1445,13 +1528,13 @@ class cql_server::fmt_visitor : public messages::result_message::visitor_base {
 
 std::unique_ptr<cql_server::response>
 make_result(int16_t stream, messages::result_message& msg, const tracing::trace_state_ptr& tr_state,
-        cql_protocol_version_type version, bool skip_metadata) {
+        cql_protocol_version_type version, bool skip_metadata, std::optional<bytes> new_metadata_id) {
     auto response = std::make_unique<cql_server::response>(stream, cql_binary_opcode::RESULT, tr_state);
     if (__builtin_expect(!msg.warnings().empty() && version > 3, false)) {
         response->set_frame_flag(cql_frame_flags::warning);
         response->write_string_list(msg.warnings());
     }
-    cql_server::fmt_visitor fmt{version, *response, skip_metadata};
+    cql_server::fmt_visitor fmt{version, *response, skip_metadata, std::move(new_metadata_id)};
     msg.accept(fmt);
     return response;
 }
@@ -1487,15 +1570,66 @@ cql_server::connection::make_schema_change_event(const event::schema_change& eve
 
 void cql_server::connection::write_response(foreign_ptr<std::unique_ptr<cql_server::response>>&& response, service_permit permit, cql_compression compression)
 {
-    _ready_to_respond = _ready_to_respond.then([this, compression, response = std::move(response), permit = std::move(permit)] () mutable {
-        auto message = response->make_message(_version, compression);
-        message.on_delete([response = std::move(response)] { });
-        return _write_buf.write(std::move(message)).then([this] {
-            return _write_buf.flush();
+    if (_version >= segmented_version) {
+        // Envelopes are compressed together, when their segments are written.
+        compression = cql_compression::none;
+    }
+    auto message = response->make_message(_version, compression);
+    message.on_delete([response = std::move(response), permit = std::move(permit)] { });
+    _pending_responses.push_back(std::move(message).release());
+    if (!_responses_flush_scheduled) {
+        _responses_flush_scheduled = true;
+        _ready_to_respond = _ready_to_respond.then([this] {
+            // Requests whose responses are queued still hold the gate. If any other request
+            // is in flight, yield once to let its response join the write if it is ready in
+            // this tick. Otherwise, as with a single request in flight, write right away.
+            if (_pending_requests_gate.get_count() <= _pending_responses.size()) {
+                return flush_responses();
+            }
+            return later().then([this] {
+                return flush_responses();
+            });
+        }).handle_exception([this] (std::exception_ptr ep) {
+            // Nothing is written after a failed write, so drop the responses, and the memory
+            // they hold, instead of letting them pile up until the connection is closed.
+            _responses_flush_scheduled = false;
+            _pending_responses.clear();
+            return make_exception_future<>(std::move(ep));
         });
+    }
+}
+
+future<> cql_server::connection::flush_responses() {
+    _responses_flush_scheduled = false;
+    auto responses = std::exchange(_pending_responses, {});
+    ++_server._stats.response_writes;
+    _server._stats.responses_written += responses.size();
+    auto unframed = _segment_framing ? std::min(std::exchange(_unframed_responses, 0), responses.size()) : responses.size();
+    auto framed = responses.begin() + unframed;
+    net::packet p;
+    for (auto it = responses.begin(); it != framed; ++it) {
+        p.append(std::move(*it));
+    }
+    if (framed != responses.end()) {
+        segment_writer segments(_compression == cql_compression::lz4);
+        for (auto it = framed; it != responses.end(); ++it) {
+            segments.write(*it);
+        }
+        _server._stats.segments_written += segments.segment_count();
+        p.append(segments.finish());
+    }
+    return _write_buf.write(std::move(p)).then([this] {
+        return _write_buf.flush();
     });
 }
 
+void cql_server::connection::enable_segment_framing() {
+    // The response to STARTUP, and everything queued before it, is still written as is.
+    _unframed_responses = _pending_responses.size();
+    _segment_framing = true;
+    _read_buf = make_segment_input_stream(std::move(_read_buf), _compression == cql_compression::lz4);
+}
+
 scattered_message<char> cql_server::response::make_message(uint8_t version, cql_compression compression) {
     if (compression != cql_compression::none) {
         compress(compression);
@@ -1879,7 +2013,7 @@ thread_local const type_codec::type_id_to_type_type type_codec::type_id_to_type
     { inet_addr_type, type_id::INET },
 };
 
-void cql_server::response::write(const cql3::metadata& m, bool no_metadata) {
+void cql_server::response::write(const cql3::metadata& m, bool no_metadata, std::optional<bytes> new_metadata_id) {
     auto flags = m.flags();
     bool global_tables_spec = m.flags().contains<cql3::metadata::flag::GLOBAL_TABLES_SPEC>();
     bool has_more_pages = m.flags().contains<cql3::metadata::flag::HAS_MORE_PAGES>();
@@ -1887,6 +2021,9 @@ void cql_server::response::write(const cql3::metadata& m, bool no_metadata) {
     if (no_metadata) {
         flags.set<cql3::metadata::flag::NO_METADATA>();
     }
+    if (new_metadata_id) {
+        flags.set<cql3::metadata::flag::METADATA_CHANGED>();
+    }
 
     write_int(flags.mask());
     write_int(m.column_count());
@@ -1895,6 +2032,10 @@ void cql_server::response::write(const cql3::metadata& m, bool no_metadata) {
         write_value(m.paging_state()->serialize());
     }
 
+    if (new_metadata_id) {
+        write_short_bytes(std::move(*new_metadata_id));
+    }
+
     if (no_metadata) {
         return;
     }
@@ -32,6 +32,7 @@
 #include <memory>
 #include <boost/intrusive/list.hpp>
 #include <seastar/net/tls.hh>
+#include <seastar/net/packet.hh>
 #include <seastar/core/metrics_registration.hh>
 #include "utils/fragmented_temporary_buffer.hh"
 #include "service_permit.hh"
@@ -130,6 +131,7 @@ struct cql_server_config {
     std::optional<uint16_t> shard_aware_transport_port;
     std::optional<uint16_t> shard_aware_transport_port_ssl;
     bool allow_shard_aware_drivers = true;
+    bool allow_protocol_v5 = false;
     smp_service_group bounce_request_smp_service_group = default_smp_service_group();
 };
 
@@ -143,6 +145,9 @@ class cql_server : public seastar::peering_sharded_service<cql_server>, public g
         uint32_t requests_serving;
         uint64_t requests_blocked_memory;
         uint64_t requests_shed;
+        uint64_t response_writes;
+        uint64_t responses_written;
+        uint64_t segments_written;
 
         // cql message stats
         uint64_t startups;
@@ -160,6 +165,8 @@ class cql_server : public seastar::peering_sharded_service<cql_server>, public g
     class event_notifier;
 
     static constexpr cql_protocol_version_type current_version = cql_serialization_format::latest_version;
+    // The first version which frames envelopes in segments. Only offered with allow_protocol_v5.
+    static constexpr cql_protocol_version_type segmented_version = 5;
 
     distributed<cql3::query_processor>& _query_processor;
     cql_server_config _config;
@@ -188,7 +195,8 @@ class cql_server : public seastar::peering_sharded_service<cql_server>, public g
     class fmt_visitor;
     friend class connection;
     friend std::unique_ptr<cql_server::response> make_result(int16_t stream, messages::result_message& msg,
-            const tracing::trace_state_ptr& tr_state, cql_protocol_version_type version, bool skip_metadata);
+            const tracing::trace_state_ptr& tr_state, cql_protocol_version_type version, bool skip_metadata,
+            std::optional<bytes> new_metadata_id);
 
     class connection : public generic_server::connection {
         cql_server& _server;
@@ -201,6 +209,14 @@ class cql_server : public seastar::peering_sharded_service<cql_server>, public g
         timer<lowres_clock> _shedding_timer;
         bool _shed_incoming_requests = false;
         unsigned _request_cpu = 0;
+        // Responses waiting to be written. The responses which become ready while a write
+        // is in progress, or in the same reactor tick, are written by a single write.
+        std::vector<net::packet> _pending_responses;
+        bool _responses_flush_scheduled = false;
+        // Set once a v5 connection switched to segment framing. The first
+        // _unframed_responses pending responses were queued before the switch.
+        bool _segment_framing = false;
+        size_t _unframed_responses = 0;
 
         enum class tracing_request_type : uint8_t {
             not_requested,
@@ -232,6 +248,7 @@ class cql_server : public seastar::peering_sharded_service<cql_server>, public g
         friend class process_request_executor;
         future<foreign_ptr<std::unique_ptr<cql_server::response>>> process_request_one(fragmented_temporary_buffer::istream buf, uint8_t op, uint16_t stream, service::client_state& client_state, tracing_request_type tracing_request, service_permit permit);
         unsigned frame_size() const;
+        cql_protocol_version_type max_version() const;
         unsigned pick_request_cpu();
         cql_binary_frame_v3 parse_frame(temporary_buffer<char> buf) const;
         future<fragmented_temporary_buffer> read_and_decompress_frame(size_t length, uint8_t flags);
@@ -247,6 +264,7 @@ class cql_server : public seastar::peering_sharded_service<cql_server>, public g
 
         std::unique_ptr<cql_server::response> make_unavailable_error(int16_t stream, exceptions::exception_code err, sstring msg, db::consistency_level cl, int32_t required, int32_t alive, const tracing::trace_state_ptr& tr_state) const;
         std::unique_ptr<cql_server::response> make_read_timeout_error(int16_t stream, exceptions::exception_code err, sstring msg, db::consistency_level cl, int32_t received, int32_t blockfor, bool data_present, const tracing::trace_state_ptr& tr_state) const;
+        void write_failures(cql_server::response& response, int32_t numfailures) const;
         std::unique_ptr<cql_server::response> make_read_failure_error(int16_t stream, exceptions::exception_code err, sstring msg, db::consistency_level cl, int32_t received, int32_t numfailures, int32_t blockfor, bool data_present, const tracing::trace_state_ptr& tr_state) const;
         std::unique_ptr<cql_server::response> make_mutation_write_timeout_error(int16_t stream, exceptions::exception_code err, sstring msg, db::consistency_level cl, int32_t received, int32_t blockfor, db::write_type type, const tracing::trace_state_ptr& tr_state) const;
         std::unique_ptr<cql_server::response> make_mutation_write_failure_error(int16_t stream, exceptions::exception_code err, sstring msg, db::consistency_level cl, int32_t received, int32_t numfailures, int32_t blockfor, db::write_type type, const tracing::trace_state_ptr& tr_state) const;
@@ -274,6 +292,8 @@ class cql_server : public seastar::peering_sharded_service<cql_server>, public g
                 service_permit permit, tracing::trace_state_ptr trace_state, Process process_fn);
 
         void write_response(foreign_ptr<std::unique_ptr<cql_server::response>>&& response, service_permit permit = empty_service_permit(), cql_compression compression = cql_compression::none);
+        future<> flush_responses();
+        void enable_segment_framing();
 
         void init_cql_serialization_format();
 
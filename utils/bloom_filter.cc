@@ -47,9 +47,14 @@
 #include <seastar/core/align.hh>
 #include "utils/large_bitset.hh"
 #include <array>
+#include <cmath>
 #include <cstdlib>
 #include "bloom_filter.hh"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 namespace utils {
 namespace filter {
 
@@ -103,7 +108,99 @@ bool bloom_filter::is_present(const bytes_view& key) {
     return is_present(make_hashed_key(key));
 }
 
+// Odd multipliers deriving the bit position within each word of a block
+// from a single 32-bit hash, as in the split block bloom filter of Parquet.
+alignas(32) static constexpr uint32_t block_salts[blocked_bloom_filter::words_per_block] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+static std::array<uint64_t, blocked_bloom_filter::words_per_block> block_mask(uint32_t h) noexcept {
+    std::array<uint64_t, blocked_bloom_filter::words_per_block> mask;
+    for (size_t i = 0; i < mask.size(); ++i) {
+        mask[i] = uint64_t(1) << ((h * block_salts[i]) >> 26);
+    }
+    return mask;
+}
+
+static bool block_contains_generic(const uint64_t* block, uint32_t h) noexcept {
+    auto mask = block_mask(h);
+#if defined(__SSE4_1__)
+    auto b = reinterpret_cast<const __m128i*>(block);
+    auto m = reinterpret_cast<const __m128i*>(mask.data());
+    __m128i missing = _mm_setzero_si128();
+    for (size_t i = 0; i < mask.size() / 2; ++i) {
+        missing = _mm_or_si128(missing, _mm_andnot_si128(_mm_loadu_si128(b + i), _mm_loadu_si128(m + i)));
+    }
+    return _mm_testz_si128(missing, missing);
+#else
+    uint64_t missing = 0;
+    for (size_t i = 0; i < mask.size(); ++i) {
+        missing |= mask[i] & ~block[i];
+    }
+    return !missing;
+#endif
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// We are built for a baseline without AVX2, so this variant is compiled
+// separately and only chosen at run time on CPUs which support it.
+[[gnu::target("avx2")]]
+static bool block_contains_avx2(const uint64_t* block, uint32_t h) noexcept {
+    auto salts = _mm256_load_si256(reinterpret_cast<const __m256i*>(block_salts));
+    auto shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(h), salts), 26);
+    auto one = _mm256_set1_epi64x(1);
+    auto mask_lo = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shifts)));
+    auto mask_hi = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shifts, 1)));
+    auto b = reinterpret_cast<const __m256i*>(block);
+    // testc returns 1 when all bits set in the mask are also set in the block.
+    return _mm256_testc_si256(_mm256_loadu_si256(b), mask_lo) & _mm256_testc_si256(_mm256_loadu_si256(b + 1), mask_hi);
+}
+
+static bool block_contains(const uint64_t* block, uint32_t h) noexcept {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2 ? block_contains_avx2(block, h) : block_contains_generic(block, h);
+}
+
+#else
+
+static bool block_contains(const uint64_t* block, uint32_t h) noexcept {
+    return block_contains_generic(block, h);
+}
+
+#endif
+
+blocked_bloom_filter::blocked_bloom_filter(bitmap&& bs) noexcept
+    : bloom_filter(hash_count, std::move(bs), filter_format::blocked_format)
+    , _nr_blocks(bits().size() / bits_per_block)
+{
+}
+
+bool blocked_bloom_filter::is_present(hashed_key key) {
+    auto h = key.hash();
+    auto idx = block_index(h[0]);
+    // Blocks never cross a chunk of the bitset's storage, since chunks
+    // hold a power of two of words.
+    return block_contains(&bits().get_storage()[idx * words_per_block], uint32_t(h[1]));
+}
+
+void blocked_bloom_filter::add(const bytes_view& key) {
+    auto h = make_hashed_key(key).hash();
+    auto first_bit = block_index(h[0]) * bits_per_block;
+    for (size_t i = 0; i < words_per_block; ++i) {
+        bits().set(first_bit + i * 64 + ((uint32_t(h[1]) * block_salts[i]) >> 26));
+    }
+}
+
+bool blocked_bloom_filter::is_present(const bytes_view& key) {
+    return is_present(make_hashed_key(key));
+}
+
 filter_ptr create_filter(int hash, large_bitset&& bitset, filter_format format) {
+    if (format == filter_format::blocked_format) {
+        return std::make_unique<blocked_bloom_filter>(std::move(bitset));
+    }
     return std::make_unique<murmur3_bloom_filter>(hash, std::move(bitset), format);
 }
 
@@ -113,5 +210,16 @@ filter_ptr create_filter(int hash, int64_t num_elements, int buckets_per, filter
     large_bitset bitset(num_bits);
     return std::make_unique<murmur3_bloom_filter>(hash, std::move(bitset), format);
 }
+
+filter_ptr create_blocked_filter(int64_t num_elements, double max_false_pos_probability) {
+    // Bits per element for which a classic filter with blocked_bloom_filter::hash_count
+    // hash functions has the requested false-positive rate.
+    constexpr double k = blocked_bloom_filter::hash_count;
+    double bits_per_element = -k / std::log(1 - std::pow(max_false_pos_probability, 1 / k));
+    int64_t num_bits = int64_t(std::ceil(num_elements * bits_per_element)) + bloom_calculations::EXCESS;
+    num_bits = align_up<int64_t>(num_bits, blocked_bloom_filter::bits_per_block);
+    large_bitset bitset(num_bits);
+    return std::make_unique<blocked_bloom_filter>(std::move(bitset));
+}
 }
 }
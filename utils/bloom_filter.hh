@@ -68,6 +68,7 @@ class bloom_filter: public i_filter {
 public:
     int num_hashes() { return _hash_count; }
     bitmap& bits() { return _bitset; }
+    filter_format format() const { return _format; }
 
     bloom_filter(int hashes, bitmap&& bs, filter_format format) noexcept;
     ~bloom_filter() noexcept;
@@ -100,6 +101,42 @@ struct murmur3_bloom_filter: public bloom_filter {
     {}
 };
 
+// Set in the hash count stored in Filter.db to mark a blocked filter. Older
+// versions read such a hash count as negative and treat the filter as always
+// present, instead of misinterpreting its bits.
+constexpr uint32_t blocked_filter_marker = uint32_t(1) << 31;
+
+// A split block bloom filter. All the bits of a key fall into one 64-byte
+// block, one bit in each of the block's eight 64-bit words, so a negative
+// lookup costs a single cache miss instead of one per hash function, and the
+// block is checked with a couple of SIMD instructions when the CPU has them.
+//
+// The hash count is fixed to the number of words in a block. To keep the
+// false-positive rate close to the requested one despite that, and despite
+// keys not being spread evenly across blocks, the filter is sized for eight
+// hash functions rather than for the optimal number.
+class blocked_bloom_filter: public bloom_filter {
+public:
+    static constexpr size_t words_per_block = 8;
+    static constexpr size_t bits_per_block = words_per_block * 64;
+    static constexpr int hash_count = words_per_block;
+private:
+    size_t _nr_blocks;
+
+    size_t block_index(uint64_t hash) const noexcept {
+        // Maps the upper half of the hash onto [0, _nr_blocks) without a division.
+        return ((hash >> 32) * _nr_blocks) >> 32;
+    }
+public:
+    blocked_bloom_filter(bitmap&& bs) noexcept;
+
+    virtual void add(const bytes_view& key) override;
+
+    virtual bool is_present(const bytes_view& key) override;
+
+    virtual bool is_present(hashed_key key) override;
+};
+
 struct always_present_filter: public i_filter {
 
     virtual bool is_present(const bytes_view& key) override {
@@ -123,5 +160,6 @@ struct always_present_filter: public i_filter {
 
 filter_ptr create_filter(int hash, large_bitset&& bitset, filter_format format);
 filter_ptr create_filter(int hash, int64_t num_elements, int buckets_per, filter_format format);
+filter_ptr create_blocked_filter(int64_t num_elements, double max_false_pos_probability);
 }
 }
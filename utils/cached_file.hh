@@ -32,6 +32,7 @@
 #include <seastar/coroutine/maybe_yield.hh>
 
 #include <map>
+#include <vector>
 
 using namespace seastar;
 
@@ -429,6 +430,56 @@ class cached_file {
         return stream(*this, pc, std::move(permit), std::move(trace_state), page_idx, offset, size_hint);
     }
 
+    /// \brief Returns the cached pages as runs of consecutive pages.
+    ///
+    /// Each element is a (first page, page count) pair. Runs are ordered by page index.
+    std::vector<std::pair<page_idx_type, page_count_type>> cached_page_runs() const {
+        std::vector<std::pair<page_idx_type, page_count_type>> runs;
+        for (auto&& cp : _cache) {
+            if (!runs.empty() && runs.back().first + runs.back().second == cp.idx) {
+                ++runs.back().second;
+            } else {
+                runs.emplace_back(cp.idx, 1);
+            }
+        }
+        return runs;
+    }
+
+    /// \brief Populates the cache with pages [idx, idx + count) which are not cached yet.
+    ///
+    /// Pages beyond the end of the file are ignored. Consecutive missing pages are read with
+    /// a single I/O. Populated pages are linked in the LRU right away, as if they were read and released.
+    /// Unlike read(), doesn't count page misses, so that preloading doesn't skew the hit ratio.
+    future<> populate(page_idx_type idx, page_count_type count, const io_priority_class& pc) {
+        auto end = std::min(idx + count, _last_page + 1);
+        while (idx < end) {
+            auto i = _cache.lower_bound(idx);
+            if (i != _cache.end() && i->idx == idx) {
+                ++idx;
+                continue;
+            }
+            auto run_end = i != _cache.end() ? std::min(end, i->idx) : end;
+            size_t size = run_end > _last_page
+                    ? (_last_page_size + (_last_page - idx) * page_size)
+                    : (run_end - idx) * page_size;
+            auto buf = co_await _file.dma_read_exactly<char>(idx * page_size, size, pc);
+            while (buf.size()) {
+                auto this_buf = buf.share();
+                this_buf.trim(std::min(page_size, buf.size()));
+                buf.trim_front(this_buf.size());
+                auto it_and_flag = _cache.emplace(idx, this, idx, std::move(this_buf));
+                ++idx;
+                cached_page& cp = *it_and_flag.first;
+                if (it_and_flag.second) {
+                    ++_metrics.page_populations;
+                    _metrics.cached_bytes += cp.size_in_allocator();
+                    _cached_bytes += cp.size_in_allocator();
+                    cp.share(); // Dropping the only reference links the page in the LRU.
+                }
+            }
+        }
+    }
+
     /// \brief Returns the number of bytes in the area managed by this instance.
     offset_type size() const {
         return _size;
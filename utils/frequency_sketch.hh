@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2021-present ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace utils {
+
+// Estimates how many times each key was recorded recently, in constant space.
+//
+// A count-min sketch: each key maps to one small saturating counter in each of
+// several rows, and the estimate is the minimum of them, so it can be too high,
+// when keys collide in all rows, but never too low. After every
+// window_factor * size records all counters are halved, so keys which are no
+// longer recorded are forgotten.
+//
+// Keys are expected to be well-distributed 64-bit hashes.
+class frequency_sketch {
+public:
+    static constexpr unsigned rows = 4;
+    static constexpr uint8_t max_count = 15;
+    static constexpr size_t window_factor = 10;
+private:
+    std::vector<uint8_t> _counters;
+    size_t _mask;
+    size_t _records = 0;
+    size_t _window;
+private:
+    static uint64_t mix(uint64_t x) noexcept {
+        // The finalizer of splitmix64.
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+    std::array<size_t, rows> indexes(uint64_t key) const noexcept {
+        std::array<size_t, rows> idx;
+        uint64_t h = key;
+        for (unsigned i = 0; i < rows; ++i) {
+            h = mix(h + i);
+            idx[i] = i * (_mask + 1) + (h & _mask);
+        }
+        return idx;
+    }
+    void age() noexcept {
+        for (auto& c : _counters) {
+            c >>= 1;
+        }
+        _records = 0;
+    }
+public:
+    // Allocates rows * size counters, size is rounded up to a power of 2.
+    explicit frequency_sketch(size_t size) {
+        size_t n = 1;
+        while (n < size) {
+            n <<= 1;
+        }
+        _counters.resize(rows * n);
+        _mask = n - 1;
+        _window = window_factor * n;
+    }
+
+    // Records an occurrence of the key and returns the estimated number of its
+    // occurrences in the current window, including this one.
+    unsigned record(uint64_t key) noexcept {
+        if (++_records >= _window) {
+            age();
+        }
+        unsigned estimate = max_count;
+        for (auto i : indexes(key)) {
+            auto& c = _counters[i];
+            if (c < max_count) {
+                ++c;
+            }
+            estimate = std::min<unsigned>(estimate, c);
+        }
+        return estimate;
+    }
+
+    // Returns the estimated number of occurrences of the key in the current window.
+    unsigned estimate(uint64_t key) const noexcept {
+        unsigned estimate = max_count;
+        for (auto i : indexes(key)) {
+            estimate = std::min<unsigned>(estimate, _counters[i]);
+        }
+        return estimate;
+    }
+};
+
+}
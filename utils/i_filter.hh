@@ -51,6 +51,8 @@ using filter_ptr = std::unique_ptr<i_filter>;
 enum class filter_format {
     k_l_format,
     m_format,
+    // Scylla-specific cache-blocked layout, see blocked_bloom_filter.
+    blocked_format,
 };
 
 class hashed_key {
@@ -837,6 +837,14 @@ class tree {
                 return nullptr;
             }
         }
+
+        /*
+         * Returns pointer on the owning tree if this is the end() iterator,
+         * e.g. the one obtained by incrementing an iterator to the last key.
+         */
+        tree_ptr tree_if_end() const noexcept {
+            return is_end() ? _tree : nullptr;
+        }
     };
 
     using iterator_base_const = iterator_base<true>;
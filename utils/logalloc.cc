@@ -375,23 +375,37 @@ static thread_local tracker& tracker_instance = get_tracker_instance();
 
 using clock = std::chrono::steady_clock;
 
+// Runs in the background in its own scheduling group. Its main job is to return
+// memory to the standard allocator when it runs low. Otherwise, it compacts LSA
+// segments so that the number of free segments stays above a target, so that
+// segment allocations don't have to compact synchronously.
 class background_reclaimer {
     scheduling_group _sg;
     noncopyable_function<void (size_t target)> _reclaim;
+    // Returns the number of free segments missing to reach the target, which
+    // compaction can make up for.
+    noncopyable_function<size_t ()> _free_segments_deficit;
+    noncopyable_function<void ()> _replenish_free_segments;
     timer<lowres_clock> _adjust_shares_timer;
     // If engaged, main loop is not running, set_value() to wake it.
     promise<>* _main_loop_wait = nullptr;
     future<> _done;
     bool _stopping = false;
     static constexpr size_t free_memory_threshold = 60'000'000;
+    // Shares of the scheduling group when only replenishing free segments, so that
+    // the work is done mostly when the shard is otherwise idle.
+    static constexpr unsigned replenish_shares = 10;
 private:
-    bool have_work() const {
+    bool have_reclaim_work() const {
 #ifndef SEASTAR_DEFAULT_ALLOCATOR
         return memory::stats().free_memory() < free_memory_threshold;
 #else
         return false;
 #endif
     }
+    bool have_work() const {
+        return have_reclaim_work() || _free_segments_deficit();
+    }
     void main_loop_wake() {
         llogger.debug("background_reclaimer::main_loop_wake: waking {}", bool(_main_loop_wait));
         if (_main_loop_wait) {
@@ -413,14 +427,20 @@ class background_reclaimer {
             if (_stopping) {
                 break;
             }
-            _reclaim(free_memory_threshold - memory::stats().free_memory());
+            if (have_reclaim_work()) {
+                _reclaim(free_memory_threshold - memory::stats().free_memory());
+            } else {
+                _replenish_free_segments();
+            }
             co_await coroutine::maybe_yield();
         }
         llogger.debug("background_reclaimer::main_loop: exit");
     }
     void adjust_shares() {
         if (have_work()) {
-            auto shares = 1 + (1000 * (free_memory_threshold - memory::stats().free_memory())) / free_memory_threshold;
+            auto shares = have_reclaim_work()
+                    ? 1 + (1000 * (free_memory_threshold - memory::stats().free_memory())) / free_memory_threshold
+                    : replenish_shares;
             _sg.set_shares(shares);
             llogger.trace("background_reclaimer::adjust_shares: {}", shares);
             if (_main_loop_wait) {
@@ -429,9 +449,12 @@ class background_reclaimer {
         }
     }
 public:
-    explicit background_reclaimer(scheduling_group sg, noncopyable_function<void (size_t target)> reclaim)
+    explicit background_reclaimer(scheduling_group sg, noncopyable_function<void (size_t target)> reclaim,
+            noncopyable_function<size_t ()> free_segments_deficit, noncopyable_function<void ()> replenish_free_segments)
             : _sg(sg)
             , _reclaim(std::move(reclaim))
+            , _free_segments_deficit(std::move(free_segments_deficit))
+            , _replenish_free_segments(std::move(replenish_free_segments))
             , _adjust_shares_timer(default_scheduling_group(), [this] { adjust_shares(); })
             , _done(with_scheduling_group(_sg, [this] { return main_loop(); })) {
         if (sg != default_scheduling_group()) {
@@ -451,6 +474,7 @@ class tracker::impl {
     seastar::metrics::metric_groups _metrics;
     bool _reclaiming_enabled = true;
     size_t _reclamation_step = 1;
+    size_t _free_segments_target = 0;
     bool _abort_on_bad_alloc = false;
 private:
     // Prevents tracker's reclaimer from running while live. Reclaimer may be
@@ -475,7 +499,10 @@ class tracker::impl {
     ~impl();
     future<> stop() {
         if (_background_reclaimer) {
-            return _background_reclaimer->stop();
+            // Reset, so that the tracker can be configured again, as tests do.
+            return _background_reclaimer->stop().then([this] {
+                _background_reclaimer.reset();
+            });
         } else {
             return make_ready_future<>();
         }
@@ -499,6 +526,15 @@ class tracker::impl {
     // Set the minimum number of segments reclaimed during single reclamation cycle.
     void set_reclamation_step(size_t step_in_segments) { _reclamation_step = step_in_segments; }
     size_t reclamation_step() const { return _reclamation_step; }
+    // Set the number of free segments which the background reclaimer keeps ready.
+    void set_free_segments_target(size_t segments) { _free_segments_target = segments; }
+    size_t free_segments_target() const { return _free_segments_target; }
+    // Returns the number of free segments missing to reach the target, or 0 if
+    // there is no region which can be compacted to make up for them.
+    size_t free_segments_deficit();
+    // Compacts the sparsest segments until the free segment target is reached,
+    // there is nothing left to compact, or the task quota is exhausted.
+    void replenish_free_segments();
     // Abort on allocation failure from LSA
     void enable_abort_on_bad_alloc() { _abort_on_bad_alloc = true; }
     bool should_abort_on_bad_alloc() const { return _abort_on_bad_alloc; }
@@ -506,6 +542,10 @@ class tracker::impl {
         assert(!_background_reclaimer);
         _background_reclaimer.emplace(sg, [this] (size_t target) {
             reclaim(target, is_preemptible::yes);
+        }, [this] {
+            return free_segments_deficit();
+        }, [this] {
+            replenish_free_segments();
         });
     }
 private:
@@ -871,6 +911,9 @@ class segment_pool {
         uint64_t memory_freed;
         uint64_t memory_compacted;
         uint64_t memory_evicted;
+        uint64_t segments_compacted_in_background;
+        uint64_t sync_segment_reclaims;
+        uint64_t sync_std_reclaims;
     };
 private:
     stats _stats{};
@@ -880,6 +923,8 @@ class segment_pool {
     void on_memory_allocation(size_t size);
     void on_memory_deallocation(size_t size);
     void on_memory_eviction(size_t size);
+    void on_background_segment_compaction() { _stats.segments_compacted_in_background++; }
+    void on_sync_std_reclaim() { _stats.sync_std_reclaims++; }
     size_t unreserved_free_segments() const { return _free_segments - std::min(_free_segments, _emergency_reserve_max); }
     size_t free_segments() const { return _free_segments; }
 };
@@ -951,6 +996,13 @@ segment* segment_pool::allocate_segment(size_t reserve)
     // 3. Finally, the algorithm ties to compact and evict data stored in LSA
     //    memory in order to reclaim enough segments.
     //
+    bool reclaimed = false;
+    auto compact_and_evict = [&] {
+        if (!std::exchange(reclaimed, true)) {
+            _stats.sync_segment_reclaims++;
+        }
+        return shard_tracker().get_impl().compact_and_evict(reserve, shard_tracker().reclamation_step() * segment::size, is_preemptible::no);
+    };
     do {
         tracker_reclaimer_lock rl;
         if (_free_segments > reserve) {
@@ -972,7 +1024,7 @@ segment* segment_pool::allocate_segment(size_t reserve)
             _lsa_owned_segments_bitmap.set(idx);
             return seg;
         }
-    } while (shard_tracker().get_impl().compact_and_evict(reserve, shard_tracker().reclamation_step() * segment::size, is_preemptible::no));
+    } while (compact_and_evict());
     return nullptr;
 }
 
@@ -1918,6 +1970,10 @@ bool tracker::should_abort_on_bad_alloc() {
     return _impl->should_abort_on_bad_alloc();
 }
 
+size_t tracker::unreserved_free_segments() const {
+    return shard_segment_pool.unreserved_free_segments();
+}
+
 void tracker::configure(const config& cfg) {
     if (cfg.defragment_on_idle) {
         engine().set_idle_cpu_handler([this] (reactor::work_waiting_on_reactor check_for_work) {
@@ -1926,6 +1982,7 @@ void tracker::configure(const config& cfg) {
     }
 
     _impl->set_reclamation_step(cfg.lsa_reclamation_step);
+    _impl->set_free_segments_target(cfg.free_segments_target);
     if (cfg.abort_on_lsa_bad_alloc) {
         _impl->enable_abort_on_bad_alloc();
     }
@@ -1934,6 +1991,7 @@ void tracker::configure(const config& cfg) {
 }
 
 memory::reclaiming_result tracker::reclaim(seastar::memory::reclaimer::request r) {
+    shard_segment_pool.on_sync_std_reclaim();
     return reclaim(std::max(r.bytes_to_reclaim, _impl->reclamation_step() * segment::size))
            ? memory::reclaiming_result::reclaimed_something
            : memory::reclaiming_result::reclaimed_nothing;
@@ -2251,6 +2309,43 @@ idle_cpu_handler_result tracker::impl::compact_on_idle(work_waiting_on_reactor c
     return idle_cpu_handler_result::interrupted_by_higher_priority_task;
 }
 
+size_t tracker::impl::free_segments_deficit() {
+    auto free = shard_segment_pool.unreserved_free_segments();
+    if (free >= _free_segments_target || !_reclaiming_enabled) {
+        return 0;
+    }
+    reclaiming_lock rl(*this);
+    bool compactible = std::any_of(_regions.begin(), _regions.end(), [] (region::impl* r) {
+        return r->is_compactible();
+    });
+    return compactible ? _free_segments_target - free : 0;
+}
+
+void tracker::impl::replenish_free_segments() {
+    if (!_reclaiming_enabled) {
+        return;
+    }
+    reclaiming_lock rl(*this);
+    segment_pool::reservation_goal open_emergency_pool(shard_segment_pool, 0);
+
+    while (shard_segment_pool.unreserved_free_segments() < _free_segments_target) {
+        region::impl* sparsest = nullptr;
+        for (region::impl* r : _regions) {
+            if (r->is_compactible() && (!sparsest || r->min_occupancy() < sparsest->min_occupancy())) {
+                sparsest = r;
+            }
+        }
+        if (!sparsest) {
+            break;
+        }
+        sparsest->compact();
+        shard_segment_pool.on_background_segment_compaction();
+        if (need_preempt()) {
+            break;
+        }
+    }
+}
+
 size_t tracker::impl::reclaim(size_t memory_to_release, is_preemptible preempt) {
     if (!_reclaiming_enabled) {
         return 0;
@@ -2462,6 +2557,18 @@ tracker::impl::impl() {
 
         sm::make_derive("memory_freed", [] { return shard_segment_pool.statistics().memory_freed; },
                         sm::description("Counts number of bytes which were requested to be freed in LSA.")),
+
+        sm::make_derive("segments_compacted_in_background", [] { return shard_segment_pool.statistics().segments_compacted_in_background; },
+                        sm::description("Counts a number of segments compacted in the background to keep free segments ready.")),
+
+        sm::make_derive("sync_segment_reclaims", [] { return shard_segment_pool.statistics().sync_segment_reclaims; },
+                        sm::description("Counts segment allocations which found no free segment and had to compact or evict synchronously.")),
+
+        sm::make_derive("sync_std_reclaims", [] { return shard_segment_pool.statistics().sync_std_reclaims; },
+                        sm::description("Counts standard allocator allocations which had to reclaim LSA memory synchronously.")),
+
+        sm::make_gauge("free_segments_target", [this] { return _free_segments_target; },
+                       sm::description("Holds a number of free segments which are kept ready by compacting in the background.")),
     });
 }
 
@@ -2723,6 +2830,10 @@ uint64_t memory_evicted() {
     return shard_segment_pool.statistics().memory_evicted;
 }
 
+uint64_t sync_segment_reclaims() {
+    return shard_segment_pool.statistics().sync_segment_reclaims;
+}
+
 occupancy_stats lsa_global_occupancy_stats() {
     return occupancy_stats(shard_segment_pool.total_free_memory(), shard_segment_pool.total_memory_in_use());
 }
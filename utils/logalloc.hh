@@ -435,6 +435,9 @@ class tracker {
         bool abort_on_lsa_bad_alloc;
         bool sanitizer_report_backtrace = false; // Better reports but slower
         size_t lsa_reclamation_step;
+        // Number of free segments which the background reclaimer keeps ready by
+        // compacting, so that allocations don't have to compact synchronously.
+        size_t free_segments_target = 0;
         scheduling_group background_reclaim_sched_group;
     };
 
@@ -478,6 +481,10 @@ class tracker {
     // Returns amount of allocated memory not managed by LSA
     size_t non_lsa_used_space() const;
 
+    // Returns the number of free segments, beyond the emergency reserve,
+    // which allocations can take without compacting.
+    size_t unreserved_free_segments() const;
+
     impl& get_impl() { return *_impl; }
 
     // Returns the minimum number of segments reclaimed during single reclamation cycle.
@@ -840,6 +847,8 @@ uint64_t memory_allocated();
 uint64_t memory_freed();
 uint64_t memory_compacted();
 uint64_t memory_evicted();
+// Number of segment allocations which had to compact or evict synchronously.
+uint64_t sync_segment_reclaims();
 
 occupancy_stats lsa_global_occupancy_stats();
 
@@ -25,15 +25,42 @@
 // which are available only when the library is linked statically.
 #define ZSTD_STATIC_LINKING_ONLY
 #include "zstd.h"
+#define ZDICT_STATIC_LINKING_ONLY
+#include "zdict.h"
 
 #include "compress.hh"
 #include "utils/class_registrator.hh"
 
 static const sstring COMPRESSION_LEVEL = "compression_level";
+static const sstring DICTIONARY_SIZE_KB = "dictionary_size_in_kb";
 static const sstring COMPRESSOR_NAME = compressor::namespace_prefix + "ZstdCompressor";
 
+// Largest dictionary we allow to be trained per sstable. Every shard which
+// reads the sstable digests it, so it should stay small compared to the data.
+// It is trained on a sample of 16 times its size, of at most 1MB.
+static constexpr size_t max_dictionary_size = 64 * 1024;
+
+struct cdict_deleter {
+    void operator()(ZSTD_CDict* d) const noexcept { ZSTD_freeCDict(d); }
+};
+
+struct ddict_deleter {
+    void operator()(ZSTD_DDict* d) const noexcept { ZSTD_freeDDict(d); }
+};
+
+struct cctx_deleter {
+    void operator()(ZSTD_CCtx* c) const noexcept { ZSTD_freeCCtx(c); }
+};
+
+struct dctx_deleter {
+    void operator()(ZSTD_DCtx* d) const noexcept { ZSTD_freeDCtx(d); }
+};
+
 class zstd_processor : public compressor {
     int _compression_level = 3;
+    int _chunk_len;
+    // Size of the dictionary to train for each sstable, 0 if disabled.
+    size_t _dictionary_size = 0;
 
     // Manages memory for the compression context.
     std::unique_ptr<char[], free_deleter> _cctx_raw;
@@ -44,8 +71,18 @@ class zstd_processor : public compressor {
     std::unique_ptr<char[], free_deleter> _dctx_raw;
     // Decompression context. Observer of _dctx_raw.
     ZSTD_DCtx* _dctx;
+
+    // Set only for processors created by with_dictionary(), which build
+    // either the compression or the uncompression half. The statically
+    // sized contexts above are not guaranteed to be large enough for the
+    // parameters a dictionary implies, so dynamically sized ones are used.
+    std::unique_ptr<ZSTD_CDict, cdict_deleter> _cdict;
+    std::unique_ptr<ZSTD_DDict, ddict_deleter> _ddict;
+    std::unique_ptr<ZSTD_CCtx, cctx_deleter> _dict_cctx;
+    std::unique_ptr<ZSTD_DCtx, dctx_deleter> _dict_dctx;
 public:
     zstd_processor(const opt_getter&);
+    zstd_processor(const zstd_processor& base, bytes_view dictionary, dictionary_usage usage);
 
     size_t uncompress(const char* input, size_t input_len, char* output,
                     size_t output_len) const override;
@@ -55,6 +92,10 @@ class zstd_processor : public compressor {
 
     std::set<sstring> option_names() const override;
     std::map<sstring, sstring> options() const override;
+
+    size_t dictionary_max_size() const override;
+    bytes train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes) const override;
+    shared_ptr<compressor> with_dictionary(bytes_view dictionary, dictionary_usage usage) const override;
 };
 
 zstd_processor::zstd_processor(const opt_getter& opts)
@@ -80,13 +121,27 @@ zstd_processor::zstd_processor(const opt_getter& opts)
     if (!chunk_len_kb) {
         chunk_len_kb = opts(compression_parameters::CHUNK_LENGTH_KB_ERR);
     }
-    auto chunk_len = chunk_len_kb
+    _chunk_len = chunk_len_kb
        // This parameter has already been validated.
        ? std::stoi(*chunk_len_kb) * 1024
        : compression_parameters::DEFAULT_CHUNK_LENGTH;
 
+    auto dictionary_size_kb = opts(DICTIONARY_SIZE_KB);
+    if (dictionary_size_kb) {
+        try {
+            _dictionary_size = size_t(std::stoul(*dictionary_size_kb)) * 1024;
+        } catch (const std::exception& e) {
+            throw exceptions::syntax_exception(
+                format("Invalid integer value {} for {}", *dictionary_size_kb, DICTIONARY_SIZE_KB));
+        }
+        if (_dictionary_size > max_dictionary_size) {
+            throw exceptions::configuration_exception(
+                format("{} must be between 0 and {}, got {}", DICTIONARY_SIZE_KB, max_dictionary_size / 1024, *dictionary_size_kb));
+        }
+    }
+
     // We assume that the uncompressed input length is always <= chunk_len.
-    auto cparams = ZSTD_getCParams(_compression_level, chunk_len, 0);
+    auto cparams = ZSTD_getCParams(_compression_level, _chunk_len, 0);
     auto cctx_size = ZSTD_estimateCCtxSize_usingCParams(cparams);
     // According to the ZSTD documentation, pointer to the context buffer must be 8-bytes aligned.
     _cctx_raw = allocate_aligned_buffer<char>(cctx_size, 8);
@@ -103,8 +158,37 @@ zstd_processor::zstd_processor(const opt_getter& opts)
     }
 }
 
+zstd_processor::zstd_processor(const zstd_processor& base, bytes_view dictionary, dictionary_usage usage)
+    : compressor(COMPRESSOR_NAME)
+    , _compression_level(base._compression_level)
+    , _chunk_len(base._chunk_len)
+    , _dictionary_size(base._dictionary_size)
+    , _cctx(nullptr)
+    , _dctx(nullptr) {
+    if (usage == dictionary_usage::compress) {
+        _cdict.reset(ZSTD_createCDict(dictionary.data(), dictionary.size(), _compression_level));
+        _dict_cctx.reset(ZSTD_createCCtx());
+    } else {
+        // Readers only need the digested dictionary for decompression, which
+        // is much smaller than the one for compression at the same level.
+        _ddict.reset(ZSTD_createDDict(dictionary.data(), dictionary.size()));
+        _dict_dctx.reset(ZSTD_createDCtx());
+    }
+    if (!_cdict && !_ddict) {
+        throw std::runtime_error("Unable to load ZSTD compression dictionary");
+    }
+    if (!_dict_cctx && !_dict_dctx) {
+        throw std::runtime_error("Unable to initialize ZSTD compression context");
+    }
+}
+
 size_t zstd_processor::uncompress(const char* input, size_t input_len, char* output, size_t output_len) const {
-    auto ret = ZSTD_decompressDCtx(_dctx, output, output_len, input, input_len);
+    if (_cdict) {
+        throw std::runtime_error("ZSTD dictionary was loaded for compression only");
+    }
+    auto ret = _ddict
+        ? ZSTD_decompress_usingDDict(_dict_dctx.get(), output, output_len, input, input_len, _ddict.get())
+        : ZSTD_decompressDCtx(_dctx, output, output_len, input, input_len);
     if (ZSTD_isError(ret)) {
         throw std::runtime_error( format("ZSTD decompression failure: {}", ZSTD_getErrorName(ret)));
     }
@@ -113,7 +197,12 @@ size_t zstd_processor::uncompress(const char* input, size_t input_len, char* out
 
 
 size_t zstd_processor::compress(const char* input, size_t input_len, char* output, size_t output_len) const {
-    auto ret = ZSTD_compressCCtx(_cctx, output, output_len, input, input_len, _compression_level);
+    if (_ddict) {
+        throw std::runtime_error("ZSTD dictionary was loaded for uncompression only");
+    }
+    auto ret = _cdict
+        ? ZSTD_compress_usingCDict(_dict_cctx.get(), output, output_len, input, input_len, _cdict.get())
+        : ZSTD_compressCCtx(_cctx, output, output_len, input, input_len, _compression_level);
     if (ZSTD_isError(ret)) {
         throw std::runtime_error( format("ZSTD compression failure: {}", ZSTD_getErrorName(ret)));
     }
@@ -125,11 +214,51 @@ size_t zstd_processor::compress_max_size(size_t input_len) const {
 }
 
 std::set<sstring> zstd_processor::option_names() const {
-    return {COMPRESSION_LEVEL};
+    return {COMPRESSION_LEVEL, DICTIONARY_SIZE_KB};
 }
 
 std::map<sstring, sstring> zstd_processor::options() const {
-    return {{COMPRESSION_LEVEL, std::to_string(_compression_level)}};
+    std::map<sstring, sstring> opts{{COMPRESSION_LEVEL, std::to_string(_compression_level)}};
+    if (_dictionary_size) {
+        opts.emplace(DICTIONARY_SIZE_KB, std::to_string(_dictionary_size / 1024));
+    }
+    return opts;
+}
+
+size_t zstd_processor::dictionary_max_size() const {
+    return _dictionary_size;
+}
+
+bytes zstd_processor::train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes) const {
+    if (!_dictionary_size || sample_sizes.empty()) {
+        return bytes();
+    }
+    // Use fixed fastCover parameters instead of letting zstd search for the
+    // best ones, which is an order of magnitude slower. Training runs on the
+    // shard, so the frequency table (2^f counters) is kept small too.
+    ZDICT_fastCover_params_t params{};
+    params.k = 200;
+    params.d = 8;
+    params.f = 16;
+    params.steps = 1;
+    params.accel = 1;
+    params.splitPoint = 1.0;
+    params.zParams.compressionLevel = _compression_level;
+
+    bytes dictionary(bytes::initialized_later(), _dictionary_size);
+    auto ret = ZDICT_trainFromBuffer_fastCover(dictionary.data(), dictionary.size(),
+            samples.data(), sample_sizes.data(), sample_sizes.size(), params);
+    if (ZDICT_isError(ret)) {
+        // Typically there was not enough data to train on; the sstable is
+        // then compressed without a dictionary.
+        return bytes();
+    }
+    dictionary.resize(ret);
+    return dictionary;
+}
+
+shared_ptr<compressor> zstd_processor::with_dictionary(bytes_view dictionary, dictionary_usage usage) const {
+    return seastar::make_shared<zstd_processor>(*this, dictionary, usage);
 }
 
 static const class_registrator<compressor, zstd_processor, const compressor::opt_getter&>